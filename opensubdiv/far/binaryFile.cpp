@@ -0,0 +1,145 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/binaryFile.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+void
+BinaryFile::SwapBytes(void * data, int count) {
+
+    unsigned char * bytes = (unsigned char *)data;
+    for (int i=0; i<count; ++i, bytes+=4) {
+        std::swap(bytes[0], bytes[3]);
+        std::swap(bytes[1], bytes[2]);
+    }
+}
+
+bool
+BinaryFile::WritePadded(FILE * fp, void const * data, size_t size,
+    size_t paddedSize) {
+
+    static char const zeros[16] = { 0 };
+
+    assert(paddedSize>=size and paddedSize-size<16);
+    return (size==0 or fwrite(data, size, 1, fp)==1) and
+           (paddedSize==size or fwrite(zeros, paddedSize-size, 1, fp)==1);
+}
+
+bool
+BinaryFile::ReadAt(FILE * fp, size_t offset, void * data, size_t size) {
+
+    return size==0 or
+           (fseek(fp, (long)offset, SEEK_SET)==0 and fread(data, size, 1, fp)==1);
+}
+
+size_t
+BinaryFile::GetSize(FILE * fp) {
+
+    if (fseek(fp, 0, SEEK_END)!=0) {
+        return 0;
+    }
+    long size = ftell(fp);
+    return size>0 ? (size_t)size : 0;
+}
+
+//------------------------------------------------------------------------------
+
+FileMapping *
+FileMapping::Open(char const * filename) {
+
+    void * mapping = 0;
+    size_t mappingSize = 0;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file==INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) and fileSize.QuadPart>0) {
+        mappingSize = (size_t)fileSize.QuadPart;
+
+        // The view keeps the mapping alive once the handles are closed
+        HANDLE fileMapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+        if (fileMapping) {
+            mapping = MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(fileMapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd<0) {
+        return 0;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st)==0 and st.st_size>0) {
+        mappingSize = (size_t)st.st_size;
+        mapping = mmap(0, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping==MAP_FAILED) {
+            mapping = 0;
+        }
+    }
+    // The mapping remains valid once the file is closed
+    close(fd);
+#endif
+
+    if (not mapping) {
+        return 0;
+    }
+    return new FileMapping((unsigned char const *)mapping, mappingSize);
+}
+
+FileMapping::~FileMapping() {
+
+#if defined(_WIN32)
+    UnmapViewOfFile(_data);
+#else
+    munmap(const_cast<unsigned char *>(_data), _size);
+#endif
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
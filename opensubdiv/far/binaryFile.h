@@ -0,0 +1,105 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_BINARY_FILE_H
+#define FAR_BINARY_FILE_H
+
+#include "../version.h"
+
+#include <cstddef>
+#include <cstdio>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+//
+// Internal helpers shared by the binary formats of the Far tables
+// (see StencilTablesSerializer and PatchTablesSerializer)
+//
+class BinaryFile {
+
+public:
+
+    // Sections of the files start on 16 bytes boundaries
+    static size_t Align(size_t offset) {
+        return (offset + 15) & ~(size_t)15;
+    }
+
+    // Swaps the bytes of an array of 32 bits elements
+    static void SwapBytes(void * data, int count);
+
+    // Writes 'size' bytes followed by zeros up to 'paddedSize'
+    static bool WritePadded(FILE * fp, void const * data, size_t size, size_t paddedSize);
+
+    // Reads 'size' bytes at 'offset' from the start of the file
+    static bool ReadAt(FILE * fp, size_t offset, void * data, size_t size);
+
+    // Returns the size of the file in bytes (0 if it cannot be determined)
+    static size_t GetSize(FILE * fp);
+};
+
+//
+// Read-only memory mapping of a whole file
+//
+class FileMapping {
+
+public:
+
+    // Returns the mapping or 0 if the file could not be mapped
+    static FileMapping * Open(char const * filename);
+
+    // Unmaps the file
+    ~FileMapping();
+
+    unsigned char const * GetData() const {
+        return _data;
+    }
+
+    size_t GetSize() const {
+        return _size;
+    }
+
+private:
+
+    FileMapping(unsigned char const * data, size_t size) :
+        _data(data), _size(size) { }
+
+    // Non-copyable (owns the mapping)
+    FileMapping(FileMapping const &);
+    FileMapping & operator=(FileMapping const &);
+
+    unsigned char const * _data;
+    size_t _size;
+};
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // FAR_BINARY_FILE_H
@@ -0,0 +1,234 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_COMPACT_STENCILTABLES_H
+#define FAR_COMPACT_STENCILTABLES_H
+
+#include "../version.h"
+
+#include "../far/stencilTables.h"
+
+#include <cstring>
+#include <vector>
+
+#if defined(__F16C__)
+    #include <immintrin.h>
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+/// \brief Half precision (IEEE 754 binary16) floating point value
+///
+/// Only provides storage and conversions from and to float: arithmetic is
+/// done after conversion, in single precision.
+///
+class Half {
+
+public:
+
+    /// \brief Default constructor (uninitialized value)
+    Half() { }
+
+    /// \brief Converts a float (rounding to the nearest half)
+    explicit Half(float f) : _bits(fromFloat(f)) { }
+
+    /// \brief Converts to float (exact)
+    operator float() const {
+        return toFloat(_bits);
+    }
+
+    /// \brief Returns the binary16 representation
+    unsigned short GetBits() const {
+        return _bits;
+    }
+
+private:
+
+    static unsigned short fromFloat(float f);
+
+    static float toFloat(unsigned short h);
+
+    unsigned short _bits;
+};
+
+/// \brief StencilTables with compact storage of indices and weights
+///
+/// Stencils evaluation is limited by memory bandwidth: storing the control
+/// vertex indices on 16 bits (for meshes with less than 65536 control
+/// vertices) and the weights in half precision halves the size of the
+/// tables. Weights are always accumulated in single precision.
+///
+/// Compact tables are created from StencilTables with
+/// StencilTablesFactory::CreateCompact().
+///
+/// @tparam INDEX   Type of the control vertex indices (int or unsigned short)
+///
+/// @tparam WEIGHT  Type of the weights (float or Half)
+///
+template <class INDEX, class WEIGHT> class CompactStencilTables {
+
+public:
+
+    typedef INDEX  IndexType;
+    typedef WEIGHT WeightType;
+
+    /// \brief Returns the number of stencils in the table
+    int GetNumStencils() const {
+        return (int)_sizes.size();
+    }
+
+    int GetNumControlVertices() const {
+        return _numControlVertices;
+    }
+
+    /// \brief Returns the number of control vertices of each stencil in the table
+    std::vector<unsigned char> const & GetSizes() const {
+        return _sizes;
+    }
+
+    /// \brief Returns the offset to a given stencil
+    std::vector<int> const & GetOffsets() const {
+        return _offsets;
+    }
+
+    /// \brief Returns the indices of the control vertices
+    std::vector<INDEX> const & GetControlIndices() const {
+        return _indices;
+    }
+
+    /// \brief Returns the stencil interpolation weights
+    std::vector<WEIGHT> const & GetWeights() const {
+        return _weights;
+    }
+
+    /// \brief Updates point values based on the control values
+    ///
+    /// @param controlValues  Buffer with primvar data for the control vertices
+    ///
+    /// @param values         Destination buffer for the interpolated primvar
+    ///                       data
+    ///
+    /// @param start          (skip to )index of first value to update
+    ///
+    /// @param end            Index of last value to update
+    ///
+    template <class T>
+    void UpdateValues(T const *controlValues, T *values, int start=-1, int end=-1) const {
+
+        StencilTables::_UpdateTables(controlValues, values, &_sizes.at(0),
+            &_offsets.at(0), &_indices.at(0), &_weights.at(0),
+                GetNumStencils(), start, end);
+    }
+
+private:
+
+    friend class StencilTablesFactory;
+
+    int _numControlVertices;              // number of control vertices
+
+    std::vector<unsigned char> _sizes;    // number of coeffiecient for each stencil
+    std::vector<int>           _offsets;  // offset to the start of each stencil
+    std::vector<INDEX>         _indices;  // indices of contributing coarse vertices
+    std::vector<WEIGHT>        _weights;  // stencil weight coefficients
+};
+
+
+// Round to nearest even, overflows to infinity
+inline unsigned short
+Half::fromFloat(float f) {
+
+#if defined(__F16C__)
+    return (unsigned short)_cvtss_sh(f, 0);
+#else
+    unsigned int bits;
+    memcpy(&bits, &f, sizeof(float));
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    bits &= 0x7fffffff;
+
+    unsigned short result;
+    if (bits >= 0x47800000) {
+        // too large for a half : infinity (or NaN)
+        result = (unsigned short)(bits > 0x7f800000 ? 0x7e00 : 0x7c00);
+    } else if (bits < 0x38800000) {
+        // denormal half (or zero) : let the FPU round the mantissa
+        float magic, value;
+        unsigned int magicBits = 0x3f000000; // 0.5f
+        memcpy(&magic, &magicBits, sizeof(float));
+        memcpy(&value, &bits, sizeof(float));
+        value += magic;
+        memcpy(&bits, &value, sizeof(float));
+        result = (unsigned short)(bits - magicBits);
+    } else {
+        // normal half : rebias the exponent and round the mantissa
+        unsigned int odd = (bits >> 13) & 1;
+        bits += 0xc8000fff + odd;
+        result = (unsigned short)(bits >> 13);
+    }
+    return (unsigned short)(result | sign);
+#endif
+}
+
+inline float
+Half::toFloat(unsigned short h) {
+
+#if defined(__F16C__)
+    return _cvtsh_ss(h);
+#else
+    unsigned int bits = (unsigned int)(h & 0x7fff) << 13,
+                 exponent = bits & 0x0f800000;
+
+    bits += 0x38000000; // rebias the exponent
+    if (exponent==0x0f800000) {
+        // infinity or NaN
+        bits += 0x38000000;
+    } else if (exponent==0) {
+        // denormal : renormalize with the FPU
+        bits += 0x00800000;
+        float f, magic;
+        unsigned int magicBits = 0x38800000; // 2^-14
+        memcpy(&f, &bits, sizeof(float));
+        memcpy(&magic, &magicBits, sizeof(float));
+        f -= magic;
+        memcpy(&bits, &f, sizeof(float));
+    }
+    bits |= (unsigned int)(h & 0x8000) << 16;
+
+    float result;
+    memcpy(&result, &bits, sizeof(float));
+    return result;
+#endif
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // FAR_COMPACT_STENCILTABLES_H
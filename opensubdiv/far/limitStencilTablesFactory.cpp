@@ -0,0 +1,1183 @@
+//
+//   Copyright 2014 DreamWorks Animation LLC.
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/limitStencilTablesFactory.h"
+#include "../far/patchMap.h"
+#include "../far/patchTables.h"
+#include "../far/patchTablesFactory.h"
+#include "../far/stencilTablesFactory.h"
+#include "../far/topologyRefiner.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+namespace {
+
+//
+// Patch basis functions
+//
+// The patches are evaluated with the same conventions as the Osd CPU limit
+// kernels (see osd/cpuEvalLimitKernel.cpp), so that the stencils interpolate
+// the same limit values.
+//
+
+// Cubic B-spline basis (and derivative) at 't'
+inline void
+getBSplineWeights(float t, float B[4], float D[4]) {
+
+    float s = 1.0f - t;
+
+    float A0 =                      s * (0.5f * s);
+    float A1 = t * (s + 0.5f * t) + s * (0.5f * s + t);
+    float A2 = t * (    0.5f * t);
+
+    B[0] =                                     1.f/3.f * s                * A0;
+    B[1] = (2.f/3.f * s +           t) * A0 + (2.f/3.f * s + 1.f/3.f * t) * A1;
+    B[2] = (1.f/3.f * s + 2.f/3.f * t) * A1 + (          s + 2.f/3.f * t) * A2;
+    B[3] =                1.f/3.f * t  * A2;
+
+    D[0] =    - A0;
+    D[1] = A0 - A1;
+    D[2] = A1 - A2;
+    D[3] = A2;
+}
+
+// Cubic Bezier basis (and derivative) at 't'
+inline void
+getBezierWeights(float t, float B[4], float D[4]) {
+
+    float s = 1.0f - t;
+
+    float A0 = s * s;
+    float A1 = 2 * s * t;
+    float A2 = t * t;
+
+    B[0] = s * A0;
+    B[1] = t * A0 + s * A1;
+    B[2] = t * A1 + s * A2;
+    B[3] = t * A2;
+
+    D[0] =    - A0;
+    D[1] = A0 - A1;
+    D[2] = A1 - A2;
+    D[3] = A2;
+}
+
+// Tensor product weights of the 16 points of a bicubic patch (point i+j*4
+// is weighted by Bu[j] * Bv[i])
+inline void
+getTensorWeights(float const Bu[4], float const Du[4],
+    float const Bv[4], float const Dv[4],
+        float wP[16], float wDu[16], float wDv[16]) {
+
+    for (int i=0; i<4; ++i) {
+        for (int j=0; j<4; ++j) {
+            wP [i+j*4] = Bu[j] * Bv[i];
+            wDu[i+j*4] = Du[j] * Bv[i];
+            wDv[i+j*4] = Bu[j] * Dv[i];
+        }
+    }
+}
+
+//
+// PatchWeights
+//
+// Weights (and derivative weights) of the control vertices of a patch.
+//
+struct PatchWeights {
+
+    void Clear(int size) {
+        _size = size;
+        memset(_wP, 0, size*sizeof(float));
+        memset(_wDu, 0, size*sizeof(float));
+        memset(_wDv, 0, size*sizeof(float));
+    }
+
+    // Add the weights of bicubic point 'point' to control vertex 'cv'
+    void Add(int cv, float scale, int point) {
+        assert(cv<_size);
+        _wP [cv] += scale * _tP [point];
+        _wDu[cv] += scale * _tDu[point];
+        _wDv[cv] += scale * _tDv[point];
+    }
+
+    int _size;
+
+    float _tP[16], _tDu[16], _tDv[16];  // weights of the bicubic points
+
+    float _wP[16], _wDu[16], _wDv[16];  // weights of the control vertices
+};
+
+// Regular patch : the 16 control vertices are the B-spline points
+void
+getRegularWeights(float u, float v, PatchWeights & weights) {
+
+    float Bu[4], Du[4], Bv[4], Dv[4];
+    getBSplineWeights(u, Bu, Du);
+    getBSplineWeights(v, Bv, Dv);
+    getTensorWeights(Bu, Du, Bv, Dv, weights._tP, weights._tDu, weights._tDv);
+
+    weights.Clear(16);
+    for (int i=0; i<16; ++i) {
+        weights.Add(i, 1.0f, i);
+    }
+}
+
+// Boundary patch : the missing row of B-spline points is mirrored
+//
+//  M0 -- M1 -- M2 -- M3    M : mirrored
+//   |     |     |     |
+//  v0 -- v1 -- v2 -- v3    v : original Cv
+//   |.....|.....|.....|
+//  v4 -- v5 -- v6 -- v7
+//   |.....|.....|.....|
+//  v8 -- v9 -- v10-- v11
+//
+void
+getBoundaryWeights(float u, float v, PatchWeights & weights) {
+
+    float Bu[4], Du[4], Bv[4], Dv[4];
+    getBSplineWeights(u, Bu, Du);
+    getBSplineWeights(v, Bv, Dv);
+    getTensorWeights(Bu, Du, Bv, Dv, weights._tP, weights._tDu, weights._tDv);
+
+    weights.Clear(12);
+    for (int i=0; i<4; ++i) {
+        // Mi = 2*vi - v(i+4)
+        weights.Add(i,    2.0f, i);
+        weights.Add(i+4, -1.0f, i);
+        for (int j=1; j<4; ++j) {
+            weights.Add(i+(j-1)*4, 1.0f, i+j*4);
+        }
+    }
+}
+
+// Corner patch : the missing row and column of B-spline points are mirrored
+//
+//  M0 -- M1 -- M2 -- M3    M : mirrored
+//   |     |     |     |
+//  v0 -- v1 -- v2 -- M4    v : original Cv
+//   |.....|.....|     |
+//  v3.--.v4.--.v5 -- M5
+//   |.....|.....|     |
+//  v6 -- v7 -- v8 -- M6
+//
+void
+getCornerWeights(float u, float v, PatchWeights & weights) {
+
+    float Bu[4], Du[4], Bv[4], Dv[4];
+    getBSplineWeights(u, Bu, Du);
+    getBSplineWeights(v, Bv, Dv);
+    getTensorWeights(Bu, Du, Bv, Dv, weights._tP, weights._tDu, weights._tDv);
+
+    weights.Clear(9);
+
+    // M0 = 2*v0 - v3, M1 = 2*v1 - v4, M2 = 2*v2 - v5
+    for (int i=0; i<3; ++i) {
+        weights.Add(i,    2.0f, i);
+        weights.Add(i+3, -1.0f, i);
+    }
+
+    // M3 = 2*M2 - M1
+    weights.Add(2,  4.0f, 3);
+    weights.Add(5, -2.0f, 3);
+    weights.Add(1, -2.0f, 3);
+    weights.Add(4,  1.0f, 3);
+
+    // M4 = 2*v2 - v1, M5 = 2*v5 - v4, M6 = 2*v8 - v7
+    for (int j=1; j<4; ++j) {
+        weights.Add(j*3-1,  2.0f, 3+j*4);
+        weights.Add(j*3-2, -1.0f, 3+j*4);
+    }
+
+    for (int i=0; i<3; ++i) {
+        for (int j=1; j<4; ++j) {
+            weights.Add(i+(j-1)*3, 1.0f, i+j*4);
+        }
+    }
+}
+
+//
+// GregoryBasis
+//
+// The 20 control points of a Gregory patch are computed from the 1-rings of
+// its 4 corner vertices. Since the computation is linear, it is carried out
+// on the unit vectors of a local basis of the 1-ring vertices : each control
+// point is then a set of weights over the local vertices. The control points
+// are kept until a location on another patch is evaluated.
+//
+
+static float const ef[27] = {
+    0.812816f, 0.500000f, 0.363644f, 0.287514f,
+    0.238688f, 0.204544f, 0.179229f, 0.159657f,
+    0.144042f, 0.131276f, 0.120632f, 0.111614f,
+    0.103872f, 0.09715f, 0.0912559f, 0.0860444f,
+    0.0814022f, 0.0772401f, 0.0734867f, 0.0700842f,
+    0.0669851f, 0.0641504f, 0.0615475f, 0.0591488f,
+    0.0569311f, 0.0548745f, 0.0529621f
+};
+
+inline float
+csf(unsigned int n, unsigned int j) {
+    if (j%2 == 0) {
+        return cosf((2.0f * float(M_PI) * float(float(j-0)/2.0f))/(float(n)+3.0f));
+    } else {
+        return sinf((2.0f * float(M_PI) * float(float(j-1)/2.0f))/(float(n)+3.0f));
+    }
+}
+
+class GregoryBasis {
+
+public:
+
+    GregoryBasis() : _patchIdx(-1) { }
+
+    // Compute the control points of the patch (unless they are current)
+    void Compute(int patchIdx, unsigned int const * cvs,
+        int const * vertexValenceBuffer, unsigned int const * quadOffsets,
+            int maxValence);
+
+    // Evaluate the weights of the local vertices at (u,v)
+    void Evaluate(float u, float v);
+
+    int GetNumVertices() const {
+        return (int)_vertices.size();
+    }
+
+    int const * GetVertices() const {
+        return &_vertices[0];
+    }
+
+    // Weights of the local vertices (and derivative weights) evaluated last
+    float const * GetWeights() const {
+        return &_weights[0];
+    }
+
+    float const * GetDuWeights() const {
+        return &_weights[GetNumVertices()];
+    }
+
+    float const * GetDvWeights() const {
+        return &_weights[2*GetNumVertices()];
+    }
+
+private:
+
+    // Returns the unit vector of a vertex of the local basis
+    float const * getVertex(int vertex) const {
+        int n = GetNumVertices();
+        for (int i=0; i<n; ++i) {
+            if (_vertices[i]==vertex) {
+                return &_identity[i*n];
+            }
+        }
+        assert(0);
+        return 0;
+    }
+
+    void addVertex(int vertex) {
+        if (std::find(_vertices.begin(), _vertices.end(), vertex)==_vertices.end()) {
+            _vertices.push_back(vertex);
+        }
+    }
+
+private:
+
+    int _patchIdx;                // patch of the current control points
+
+    std::vector<int>   _vertices; // vertices of the local basis
+
+    std::vector<float> _identity, // unit vectors of the local vertices
+                       _scratch,
+                       _points,   // the 20 control points
+                       _weights;  // evaluated weights
+};
+
+// Control Vertices based on :
+// "Approximating Subdivision Surfaces with Gregory Patches for Hardware Tessellation"
+// Loop, Schaefer, Ni, Castafio (ACM ToG Siggraph Asia 2009)
+//
+//  P3         e3-      e2+         E2
+//     O--------O--------O--------O
+//     |        |        |        |
+//     |        |        |        |
+//     |        | f3-    | f2+    |
+//     |        O        O        |
+// e3+ O------O            O------O e2-
+//     |     f3+          f2-     |
+//     |                          |
+//     |                          |
+//     |      f0-         f1+     |
+// e0- O------O            O------O e1+
+//     |        O        O        |
+//     |        | f0+    | f1-    |
+//     |        |        |        |
+//     |        |        |        |
+//     O--------O--------O--------O
+//  P0         e0+      e1-         E1
+//
+// The boundary rules reduce to the interior ones when all the corners are
+// interior, so both types of Gregory patches are handled here.
+//
+void
+GregoryBasis::Compute(int patchIdx, unsigned int const * cvs,
+    int const * vertexValenceBuffer, unsigned int const * quadOffsets,
+        int maxValence) {
+
+    if (patchIdx==_patchIdx) {
+        return;
+    }
+    _patchIdx = patchIdx;
+
+    int valenceStride = 2*maxValence+1;
+
+    // gather the local basis : the corners and their 1-ring vertices
+    _vertices.clear();
+    for (int vid=0; vid<4; ++vid) {
+        int const * valenceTable = vertexValenceBuffer + cvs[vid]*valenceStride;
+        addVertex(cvs[vid]);
+        for (int i=0; i<2*abs(*valenceTable); ++i) {
+            addVertex(valenceTable[i+1]);
+        }
+    }
+
+    int length = GetNumVertices();
+
+    _identity.assign(length*length, 0.0f);
+    for (int i=0; i<length; ++i) {
+        _identity[i*length+i] = 1.0f;
+    }
+
+    _scratch.assign((maxValence*5 + 4*8 + 2)*length, 0.0f);
+
+    float * r     = &_scratch[0],
+          * f     = r + maxValence*4*length,
+          * e0    = f + maxValence*length,
+          * e1    = e0 + 4*length,
+          * org   = e1 + 4*length,
+          * opos  = org + 4*length,
+          * Ep    = opos + 4*length,
+          * Em    = Ep + 4*length,
+          * Fp    = Em + 4*length,
+          * Fm    = Fp + 4*length,
+          * Em_ip = Fm + 4*length,
+          * Ep_im = Em_ip + length;
+
+    int valences[4], zerothNeighbors[4];
+
+    for (int vid=0; vid<4; ++vid) {
+
+        int vertexID = cvs[vid];
+
+        int const * valenceTable = vertexValenceBuffer + vertexID*valenceStride;
+        int valence = *valenceTable,
+            ivalence = abs(valence);
+
+        assert(ivalence<=maxValence);
+        valences[vid] = valence;
+
+        int vofs = vid * length;
+
+        float * pos = org + vofs;
+        memcpy(pos, getVertex(vertexID), length*sizeof(float));
+
+        int boundaryEdgeNeighbors[2] = { vertexID, vertexID };
+        unsigned int currNeighbor = 0,
+                     ibefore = 0,
+                     zerothNeighbor = 0;
+
+        float * rp = r + vid*maxValence*length;
+
+        for (int i=0; i<ivalence; ++i) {
+            unsigned int im = (i+ivalence-1)%ivalence,
+                         ip = (i+1)%ivalence;
+
+            int idx_neighbor   = valenceTable[2*i  + 0 + 1];
+            int idx_diagonal   = valenceTable[2*i  + 1 + 1];
+            int idx_neighbor_p = valenceTable[2*ip + 0 + 1];
+            int idx_neighbor_m = valenceTable[2*im + 0 + 1];
+            int idx_diagonal_m = valenceTable[2*im + 1 + 1];
+
+            int valenceNeighbor = vertexValenceBuffer[idx_neighbor * valenceStride];
+            if (valenceNeighbor < 0) {
+
+                if (currNeighbor<2) {
+                    boundaryEdgeNeighbors[currNeighbor] = idx_neighbor;
+                }
+                currNeighbor++;
+
+                if (currNeighbor == 1) {
+                    ibefore = i;
+                    zerothNeighbor = i;
+                } else {
+                    if (i-ibefore == 1) {
+                        std::swap(boundaryEdgeNeighbors[0], boundaryEdgeNeighbors[1]);
+                        zerothNeighbor = i;
+                    }
+                }
+            }
+
+            float const * neighbor   = getVertex(idx_neighbor),
+                        * diagonal   = getVertex(idx_diagonal),
+                        * neighbor_p = getVertex(idx_neighbor_p),
+                        * neighbor_m = getVertex(idx_neighbor_m),
+                        * diagonal_m = getVertex(idx_diagonal_m);
+
+            float * fp = f+i*length;
+
+            for (int k=0; k<length; ++k) {
+                fp[k] = (pos[k]*float(ivalence) + (neighbor_p[k]+neighbor[k])*2.0f + diagonal[k])/(float(ivalence)+5.0f);
+
+                opos[vofs+k] += fp[k];
+                rp[i*length+k] = (neighbor_p[k]-neighbor_m[k])/3.0f + (diagonal[k]-diagonal_m[k])/6.0f;
+            }
+        }
+
+        for (int k=0; k<length; ++k) {
+            opos[vofs+k] /= ivalence;
+        }
+
+        zerothNeighbors[vid] = zerothNeighbor;
+
+        if (currNeighbor == 1) {
+            boundaryEdgeNeighbors[1] = boundaryEdgeNeighbors[0];
+        }
+
+        if (valence>0) {
+
+            for (int i=0; i<ivalence; ++i) {
+                unsigned int im = (i+ivalence-1)%ivalence;
+                for (int k=0; k<length; ++k) {
+                    float e = 0.5f*(f[i*length+k]+f[im*length+k]);
+                    e0[vofs+k] += csf(ivalence-3, 2*i  ) * e;
+                    e1[vofs+k] += csf(ivalence-3, 2*i+1) * e;
+                }
+            }
+
+            for (int k=0; k<length; ++k) {
+                e0[vofs+k] *= ef[ivalence-3];
+                e1[vofs+k] *= ef[ivalence-3];
+            }
+        } else {
+
+            float const * edge0 = getVertex(boundaryEdgeNeighbors[0]),
+                        * edge1 = getVertex(boundaryEdgeNeighbors[1]);
+
+            if (ivalence>2) {
+                for (int k=0; k<length; ++k) {
+                    opos[vofs+k] = (edge0[k] + edge1[k] + 4.0f*pos[k])/6.0f;
+                }
+            } else {
+                memcpy(opos+vofs, pos, length*sizeof(float));
+            }
+
+            float k = float(float(ivalence) - 1.0f);    //k is the number of faces
+            float c = cosf(float(M_PI)/k);
+            float s = sinf(float(M_PI)/k);
+            float gamma = -(4.0f*s)/(3.0f*k+c);
+            float alpha_0k = -((1.0f+2.0f*c)*sqrtf(1.0f+c))/((3.0f*k+c)*sqrtf(1.0f-c));
+            float beta_0 = s/(3.0f*k + c);
+
+            int idx_diagonal = valenceTable[2*zerothNeighbor + 1 + 1];
+            assert(idx_diagonal>0);
+            float const * diagonal = getVertex(idx_diagonal);
+
+            for (int j=0; j<length; ++j) {
+                e0[vofs+j] = (edge0[j] - edge1[j])/6.0f;
+
+                e1[vofs+j] = gamma * pos[j] + beta_0 * diagonal[j] +
+                            (edge0[j] + edge1[j]) * alpha_0k;
+            }
+
+            for (int x=1; x<ivalence-1; ++x) {
+                unsigned int curri = ((x + zerothNeighbor)%ivalence);
+                float alpha = (4.0f*sinf((float(M_PI) * float(x))/k))/(3.0f*k+c);
+                float beta = (sinf((float(M_PI) * float(x))/k) + sinf((float(M_PI) * float(x+1))/k))/(3.0f*k+c);
+
+                int idx_neighbor = valenceTable[2*curri + 0 + 1];
+                    idx_diagonal = valenceTable[2*curri + 1 + 1];
+                assert( idx_neighbor>0 and idx_diagonal>0 );
+
+                float const * neighbor = getVertex(idx_neighbor);
+                              diagonal = getVertex(idx_diagonal);
+
+                for (int j=0; j<length; ++j) {
+                    e1[vofs+j] += alpha*neighbor[j] + beta*diagonal[j];
+                }
+            }
+
+            for (int j=0; j<length; ++j) {
+                e1[vofs+j] /= 3.0f;
+            }
+        }
+    }
+
+    for (int vid=0; vid<4; ++vid) {
+
+        unsigned int ip = (vid+1)%4,
+                     im = (vid+3)%4,
+                     n = abs(valences[vid]),
+                     ivalence = n;
+
+        int vofs = vid * length;
+
+        unsigned int   start =  quadOffsets[vid] & 0x00ff,
+                        prev = (quadOffsets[vid] & 0xff00) / 256,
+                          np = abs(valences[ip]),
+                          nm = abs(valences[im]),
+                     start_m =  quadOffsets[im] & 0x00ff,
+                      prev_p = (quadOffsets[ip] & 0xff00) / 256;
+
+        if (valences[ip]<-2) {
+            unsigned int j = (np + prev_p - zerothNeighbors[ip]) % np;
+            for (int k=0, ipofs=ip*length; k<length; ++k, ++ipofs) {
+                Em_ip[k] = opos[ipofs] + cosf((float(M_PI)*j)/float(np-1))*e0[ipofs] + sinf((float(M_PI)*j)/float(np-1))*e1[ipofs];
+            }
+        } else {
+            for (int k=0, ipofs=ip*length; k<length; ++k, ++ipofs) {
+                Em_ip[k] = opos[ipofs] + e0[ipofs]*csf(np-3,2*prev_p)  + e1[ipofs]*csf(np-3,2*prev_p+1);
+            }
+        }
+
+        if (valences[im]<-2) {
+            unsigned int j = (nm + start_m - zerothNeighbors[im]) % nm;
+            for (int k=0, imofs=im*length; k<length; ++k, ++imofs) {
+                Ep_im[k] = opos[imofs] + cosf((float(M_PI)*j)/float(nm-1))*e0[imofs] + sinf((float(M_PI)*j)/float(nm-1))*e1[imofs];
+            }
+        } else {
+            for (int k=0, imofs=im*length; k<length; ++k, ++imofs) {
+                Ep_im[k] = opos[imofs] + e0[imofs]*csf(nm-3,2*start_m) + e1[imofs]*csf(nm-3,2*start_m+1);
+            }
+        }
+
+        if (valences[vid] < 0) {
+            n = (n-1)*2;
+        }
+        if (valences[im] < 0) {
+            nm = (nm-1)*2;
+        }
+        if (valences[ip] < 0) {
+            np = (np-1)*2;
+        }
+
+        float const * rp = r + vid*maxValence*length;
+
+        if (valences[vid] > 2) {
+            float s1 = 3.0f - 2.0f*csf(n-3,2)-csf(np-3,2),
+                  s2 = 2.0f*csf(n-3,2),
+                  s3 = 3.0f -2.0f*cosf(2.0f*float(M_PI)/float(n)) - cosf(2.0f*float(M_PI)/float(nm));
+
+            for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                Ep[ofs] = opos[ofs] + e0[ofs] * csf(n-3, 2*start) + e1[ofs]*csf(n-3, 2*start +1);
+                Em[ofs] = opos[ofs] + e0[ofs] * csf(n-3, 2*prev ) + e1[ofs]*csf(n-3, 2*prev + 1);
+                Fp[ofs] = (csf(np-3,2)*opos[ofs] + s1*Ep[ofs] + s2*Em_ip[k] + rp[start*length+k])/3.0f;
+                Fm[ofs] = (csf(nm-3,2)*opos[ofs] + s3*Em[ofs] + s2*Ep_im[k] - rp[prev*length+k])/3.0f;
+            }
+        } else if (valences[vid] < -2) {
+            unsigned int jp = (ivalence + start - zerothNeighbors[vid]) % ivalence,
+                         jm = (ivalence + prev  - zerothNeighbors[vid]) % ivalence;
+
+            float s1 = 3-2*csf(n-3,2)-csf(np-3,2),
+                  s2 = 2*csf(n-3,2),
+                  s3 = 3.0f-2.0f*cosf(2.0f*float(M_PI)/n)-cosf(2.0f*float(M_PI)/nm);
+
+            for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                Ep[ofs] = opos[ofs] + cosf((float(M_PI)*jp)/float(ivalence-1))*e0[ofs] + sinf((float(M_PI)*jp)/float(ivalence-1))*e1[ofs];
+                Em[ofs] = opos[ofs] + cosf((float(M_PI)*jm)/float(ivalence-1))*e0[ofs] + sinf((float(M_PI)*jm)/float(ivalence-1))*e1[ofs];
+                Fp[ofs] = (csf(np-3,2)*opos[ofs] + s1*Ep[ofs] + s2*Em_ip[k] + rp[start*length+k])/3.0f;
+                Fm[ofs] = (csf(nm-3,2)*opos[ofs] + s3*Em[ofs] + s2*Ep_im[k] - rp[prev*length+k])/3.0f;
+            }
+
+            if (valences[im]<0) {
+                s1=3-2*csf(n-3,2)-csf(np-3,2);
+                for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                    Fp[ofs] = Fm[ofs] = (csf(np-3,2)*opos[ofs] + s1*Ep[ofs] + s2*Em_ip[k] + rp[start*length+k])/3.0f;
+                }
+            } else if (valences[ip]<0) {
+                s1 = 3.0f-2.0f*cosf(2.0f*float(M_PI)/n)-cosf(2.0f*float(M_PI)/nm);
+                for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                    Fm[ofs] = Fp[ofs] = (csf(nm-3,2)*opos[ofs] + s1*Em[ofs] + s2*Ep_im[k] - rp[prev*length+k])/3.0f;
+                }
+            }
+        } else if (valences[vid]==-2) {
+            int ipofs = ip*length,
+                imofs = im*length,
+                dofs = ((vid+2)%4)*length;
+            for (int k=0, ofs=vofs; k<length; ++k, ++ofs) {
+                Ep[ofs] = (2.0f * org[ofs] + org[ipofs+k])/3.0f;
+                Em[ofs] = (2.0f * org[ofs] + org[imofs+k])/3.0f;
+                Fp[ofs] = Fm[ofs] = (4.0f * org[ofs] + org[dofs+k] + 2.0f * org[ipofs+k] + 2.0f * org[imofs+k])/9.0f;
+            }
+        }
+    }
+
+    // store the control points in the order of the patch (P, Ep, Em, Fp, Fm
+    // for each corner)
+    _points.resize(20*length);
+    for (int vid=0; vid<4; ++vid) {
+        int vofs = vid * length;
+        memcpy(&_points[(vid*5+0)*length], opos+vofs, length*sizeof(float));
+        memcpy(&_points[(vid*5+1)*length],   Ep+vofs, length*sizeof(float));
+        memcpy(&_points[(vid*5+2)*length],   Em+vofs, length*sizeof(float));
+        memcpy(&_points[(vid*5+3)*length],   Fp+vofs, length*sizeof(float));
+        memcpy(&_points[(vid*5+4)*length],   Fm+vofs, length*sizeof(float));
+    }
+}
+
+// Evaluate the weights of the local vertices at (u,v) : the 16 points of the
+// bicubic Bezier patch are the control points, except for the 4 interior
+// ones, which are blended from the face points Fp & Fm
+void
+GregoryBasis::Evaluate(float u, float v) {
+
+    float U = 1-u, V=1-v;
+#ifdef __INTEL_COMPILER // remark #1572: floating-point equality and inequality comparisons are unreliable
+#pragma warning disable 1572
+#endif
+    float d11 = u+v; if(u+v==0.0f) d11 = 1.0f;
+    float d12 = U+v; if(U+v==0.0f) d12 = 1.0f;
+    float d21 = u+V; if(u+V==0.0f) d21 = 1.0f;
+    float d22 = U+V; if(U+V==0.0f) d22 = 1.0f;
+#ifdef __INTEL_COMPILER
+#pragma warning enable 1572
+#endif
+
+    float Bu[4], Du[4], Bv[4], Dv[4], tP[16], tDu[16], tDv[16];
+    getBezierWeights(u, Bu, Du);
+    getBezierWeights(v, Bv, Dv);
+    getTensorWeights(Bu, Du, Bv, Dv, tP, tDu, tDv);
+
+    // (bezier point, control point) pairs
+    static int const pointMap[20][2] = {
+        { 0,  0}, { 1,  1}, { 4,  2}, { 5,  3}, { 5,  4},
+        { 3,  5}, { 7,  6}, { 2,  7}, { 6,  8}, { 6,  9},
+        {15, 10}, {14, 11}, {11, 12}, {10, 13}, {10, 14},
+        {12, 15}, { 8, 16}, {13, 17}, { 9, 18}, { 9, 19} };
+
+    float scales[20];
+    for (int i=0; i<20; ++i) {
+        scales[i] = 1.0f;
+    }
+    scales[ 3] = u/d11; scales[ 4] = v/d11;
+    scales[ 9] = U/d12; scales[ 8] = v/d12;
+    scales[19] = u/d21; scales[18] = V/d21;
+    scales[13] = U/d22; scales[14] = V/d22;
+
+    int length = GetNumVertices();
+
+    _weights.assign(3*length, 0.0f);
+
+    float * wP  = &_weights[0],
+          * wDu = wP + length,
+          * wDv = wDu + length;
+
+    for (int i=0; i<20; ++i) {
+
+        int point = pointMap[i][1],
+            bezier = pointMap[i][0];
+
+        float sP  = scales[point] * tP [bezier],
+              sDu = scales[point] * tDu[bezier],
+              sDv = scales[point] * tDv[bezier];
+
+        float const * weights = &_points[point*length];
+        for (int k=0; k<length; ++k) {
+            wP [k] += sP  * weights[k];
+            wDu[k] += sDu * weights[k];
+            wDv[k] += sDv * weights[k];
+        }
+    }
+}
+
+//
+// LimitWeightAccumulator
+//
+// Accumulates the limit weights of the control vertices, using a small open
+// addressing hash table to locate the vertex indices.
+//
+class LimitWeightAccumulator {
+
+public:
+
+    LimitWeightAccumulator() : _mask(0) {
+        resizeTable(64);
+    }
+
+    // Add weights to the weights of vertex 'index'
+    void Add(int index, float wP, float wDu, float wDv);
+
+    void Clear();
+
+    int GetSize() const {
+        return (int)_indices.size();
+    }
+
+    int const * GetIndices() const {
+        return &_indices[0];
+    }
+
+    float const * GetWeights() const {
+        return &_weights[0];
+    }
+
+    float const * GetDuWeights() const {
+        return &_duWeights[0];
+    }
+
+    float const * GetDvWeights() const {
+        return &_dvWeights[0];
+    }
+
+private:
+
+    int findSlot(int index) const {
+        int slot = (int)(((unsigned int)index * 2654435761u) & _mask);
+        while (_table[slot]>=0 and _indices[_table[slot]]!=index) {
+            slot = (slot+1) & _mask;
+        }
+        return slot;
+    }
+
+    void resizeTable(int size);
+
+private:
+
+    unsigned int _mask;
+
+    std::vector<int> _table;     // slot -> position in _indices (or -1)
+    std::vector<int> _slots;     // position in _indices -> slot
+
+    std::vector<int>   _indices;
+    std::vector<float> _weights,
+                       _duWeights,
+                       _dvWeights;
+};
+
+void
+LimitWeightAccumulator::resizeTable(int size) {
+
+    _table.assign(size, -1);
+    _mask = size-1;
+    for (int i=0; i<(int)_indices.size(); ++i) {
+        _slots[i] = findSlot(_indices[i]);
+        _table[_slots[i]] = i;
+    }
+}
+
+inline void
+LimitWeightAccumulator::Add(int index, float wP, float wDu, float wDv) {
+
+    int slot = findSlot(index);
+    if (_table[slot]<0) {
+        _table[slot] = (int)_indices.size();
+        _slots.push_back(slot);
+        _indices.push_back(index);
+        _weights.push_back(wP);
+        _duWeights.push_back(wDu);
+        _dvWeights.push_back(wDv);
+
+        // keep the table at most half full
+        if (2*_indices.size() > _table.size()) {
+            resizeTable(2*(int)_table.size());
+        }
+    } else {
+        int i = _table[slot];
+        _weights[i] += wP;
+        _duWeights[i] += wDu;
+        _dvWeights[i] += wDv;
+    }
+}
+
+void
+LimitWeightAccumulator::Clear() {
+
+    for (int i=0; i<(int)_slots.size(); ++i) {
+        _table[_slots[i]] = -1;
+    }
+    _slots.clear();
+    _indices.clear();
+    _weights.clear();
+    _duWeights.clear();
+    _dvWeights.clear();
+}
+
+//
+// Kernel computing the limit stencils of ranges of chunks of locations --
+// each chunk accumulates its stencils in its own buffer and the buffers are
+// then concatenated in order.
+//
+struct LimitStencilChunk {
+
+    LimitStencilChunk() : overflow(false) { }
+
+    void Release() {
+        std::vector<int>().swap(indices);
+        std::vector<float>().swap(weights);
+        std::vector<float>().swap(duWeights);
+        std::vector<float>().swap(dvWeights);
+    }
+
+    std::vector<int>   indices;
+    std::vector<float> weights,
+                       duWeights,
+                       dvWeights;
+
+    bool overflow;   // a stencil exceeds 255 control vertices
+};
+
+class ComputeLimitStencilsKernel : public Vtr::ParallelKernel {
+
+public:
+
+    ComputeLimitStencilsKernel(PatchTables const & patchTables,
+        PatchMap const & patchMap, StencilTables const & cvStencils,
+            int const * cvOffsets, int numPtexFaces,
+                LimitStencilTablesFactory::LocationArrayVec const & locationArrays,
+                    std::vector<int> const & arrayOffsets, int chunkSize,
+                        unsigned char * sizes, std::vector<LimitStencilChunk> & chunks) :
+        _patchTables(patchTables), _patchMap(patchMap), _cvStencils(cvStencils),
+            _cvOffsets(cvOffsets), _numPtexFaces(numPtexFaces),
+                _locationArrays(locationArrays), _arrayOffsets(arrayOffsets),
+                    _chunkSize(chunkSize), _sizes(sizes), _chunks(chunks) { }
+
+    virtual void operator()(int chunkBegin, int chunkEnd) const;
+
+private:
+
+    // Add the weights of a vertex of the patch tables (control vertex or
+    // refined vertex)
+    void addVertex(LimitWeightAccumulator & dst, int vertex,
+        float wP, float wDu, float wDv) const;
+
+    // Accumulate the weights of the location (returns false if the
+    // location does not resolve to a patch)
+    bool computeLocation(int ptexIdx, float u, float v,
+        PatchWeights & patchWeights, GregoryBasis & gregoryBasis,
+            LimitWeightAccumulator & dst) const;
+
+private:
+
+    PatchTables const & _patchTables;
+    PatchMap const & _patchMap;
+
+    StencilTables const & _cvStencils;
+    int const * _cvOffsets;
+
+    int _numPtexFaces;
+
+    LimitStencilTablesFactory::LocationArrayVec const & _locationArrays;
+    std::vector<int> const & _arrayOffsets;
+
+    int _chunkSize;
+
+    unsigned char * _sizes;
+
+    std::vector<LimitStencilChunk> & _chunks;
+};
+
+inline void
+ComputeLimitStencilsKernel::addVertex(LimitWeightAccumulator & dst,
+    int vertex, float wP, float wDu, float wDv) const {
+
+    if (wP==0.0f and wDu==0.0f and wDv==0.0f) {
+        return;
+    }
+
+    int ncvs = _cvStencils.GetNumControlVertices();
+    if (vertex<ncvs) {
+        dst.Add(vertex, wP, wDu, wDv);
+    } else {
+        int stencil = vertex - ncvs,
+            ofs = _cvOffsets[stencil];
+
+        int const * indices = &_cvStencils.GetControlIndices()[ofs];
+        float const * weights = &_cvStencils.GetWeights()[ofs];
+
+        for (int i=0; i<_cvStencils.GetSizes()[stencil]; ++i) {
+            dst.Add(indices[i], wP*weights[i], wDu*weights[i], wDv*weights[i]);
+        }
+    }
+}
+
+bool
+ComputeLimitStencilsKernel::computeLocation(int ptexIdx, float u, float v,
+    PatchWeights & patchWeights, GregoryBasis & gregoryBasis,
+        LimitWeightAccumulator & dst) const {
+
+    if (ptexIdx<0 or ptexIdx>=_numPtexFaces or
+        not (u>=0.0f and u<=1.0f and v>=0.0f and v<=1.0f)) {
+        return false;
+    }
+
+    PatchMap::Handle const * handle = _patchMap.FindPatch(ptexIdx, u, v);
+    if (not handle) {
+        return false;
+    }
+
+    // normalize & rotate (u,v) to the sub-patch
+    PatchParam::BitField bits =
+        _patchTables.GetPatchParamTable()[handle->patchIdx].bitField;
+    bits.Normalize(u, v);
+    bits.Rotate(u, v);
+
+    PatchTables::PatchArray const & parray =
+        _patchTables.GetPatchArrayVector()[handle->patchArrayIdx];
+
+    unsigned int const * cvs =
+        &_patchTables.GetPatchTable()[parray.GetVertIndex() + handle->vertexOffset];
+
+    // the patches are evaluated at (v,u) (see CpuEvalLimitController)
+    switch (parray.GetDescriptor().GetType()) {
+
+        case PatchTables::REGULAR  : getRegularWeights(v, u, patchWeights); break;
+
+        case PatchTables::BOUNDARY : getBoundaryWeights(v, u, patchWeights); break;
+
+        case PatchTables::CORNER   : getCornerWeights(v, u, patchWeights); break;
+
+        case PatchTables::GREGORY  :
+        case PatchTables::GREGORY_BOUNDARY : {
+
+            gregoryBasis.Compute(handle->patchIdx, cvs,
+                &_patchTables.GetVertexValenceTable()[0],
+                &_patchTables.GetQuadOffsetTable()[parray.GetQuadOffsetIndex() + handle->vertexOffset],
+                _patchTables.GetMaxValence());
+
+            gregoryBasis.Evaluate(v, u);
+
+            int const * vertices = gregoryBasis.GetVertices();
+            for (int i=0; i<gregoryBasis.GetNumVertices(); ++i) {
+                addVertex(dst, vertices[i], gregoryBasis.GetWeights()[i],
+                    gregoryBasis.GetDuWeights()[i], gregoryBasis.GetDvWeights()[i]);
+            }
+            return true;
+        }
+
+        default:
+            assert(0);
+            return false;
+    }
+
+    for (int i=0; i<patchWeights._size; ++i) {
+        addVertex(dst, cvs[i], patchWeights._wP[i], patchWeights._wDu[i],
+            patchWeights._wDv[i]);
+    }
+    return true;
+}
+
+void
+ComputeLimitStencilsKernel::operator()(int chunkBegin, int chunkEnd) const {
+
+    int nlocations = _arrayOffsets.back();
+
+    PatchWeights patchWeights;
+    GregoryBasis gregoryBasis;
+    LimitWeightAccumulator stencil;
+
+    for (int chunk=chunkBegin; chunk<chunkEnd; ++chunk) {
+
+        LimitStencilChunk & dst = _chunks[chunk];
+
+        int locBegin = chunk * _chunkSize,
+            locEnd = std::min(locBegin + _chunkSize, nlocations);
+
+        // array containing the first location of the chunk
+        int array = (int)(std::upper_bound(_arrayOffsets.begin(),
+            _arrayOffsets.end(), locBegin) - _arrayOffsets.begin()) - 1;
+
+        for (int loc=locBegin; loc<locEnd; ++loc) {
+
+            while (loc>=_arrayOffsets[array+1]) {
+                ++array;
+            }
+
+            LimitStencilTablesFactory::LocationArray const & locations =
+                _locationArrays[array];
+
+            int i = loc - _arrayOffsets[array];
+
+            stencil.Clear();
+            computeLocation(locations.ptexIdx, locations.u[i], locations.v[i],
+                patchWeights, gregoryBasis, stencil);
+
+            int size = stencil.GetSize();
+            if (size>255) {
+                dst.overflow = true;
+                size = 0;
+            }
+            _sizes[loc] = (unsigned char)size;
+
+            if (size>0) {
+                dst.indices.insert(dst.indices.end(), stencil.GetIndices(), stencil.GetIndices()+size);
+                dst.weights.insert(dst.weights.end(), stencil.GetWeights(), stencil.GetWeights()+size);
+                dst.duWeights.insert(dst.duWeights.end(), stencil.GetDuWeights(), stencil.GetDuWeights()+size);
+                dst.dvWeights.insert(dst.dvWeights.end(), stencil.GetDvWeights(), stencil.GetDvWeights()+size);
+            }
+        }
+    }
+}
+
+// Number of locations computed by each task
+const int limitChunkSize = 1024;
+
+} // end namespace unnamed
+
+LimitStencilTables const *
+LimitStencilTablesFactory::Create(TopologyRefiner const & refiner,
+    LocationArrayVec const & locationArrays, StencilTables const * cvStencilsIn,
+        PatchTables const * patchTablesIn, Options options) {
+
+    // there is no limit with uniform subdivision
+    if (refiner.IsUniform() or refiner.GetMaxLevel()<1) {
+        return 0;
+    }
+
+    ThreadingType threading = (ThreadingType)options.threading;
+
+    // Stencils of the refined vertices (the vertex indices of the patches
+    // locate the control vertices followed by the vertices of each level)
+    StencilTables const * cvStencils = cvStencilsIn;
+    if (not cvStencils) {
+        StencilTablesFactory::Options stencilOptions;
+        stencilOptions.generateAllLevels = true;
+        stencilOptions.generateOffsets = true;
+        stencilOptions.threading = threading;
+        cvStencils = StencilTablesFactory::Create(refiner, stencilOptions);
+    }
+
+    PatchTables const * patchTables = patchTablesIn;
+    if (not patchTables) {
+        PatchTablesFactory::Options patchOptions;
+        patchOptions.threading = threading;
+        patchTables = PatchTablesFactory::Create(refiner, patchOptions);
+    }
+
+    LimitStencilTables * result = 0;
+
+    if (patchTables->IsFeatureAdaptive() and
+        cvStencils->GetNumControlVertices()==refiner.GetNumVertices(0) and
+        cvStencils->GetNumStencils()==refiner.GetNumVerticesTotal()-refiner.GetNumVertices(0)) {
+
+        // The offsets are optional in StencilTables
+        std::vector<int> offsets;
+        int const * cvOffsets = 0;
+        if ((int)cvStencils->GetOffsets().size()==cvStencils->GetNumStencils()) {
+            cvOffsets = cvStencils->GetOffsets().empty() ? 0 : &cvStencils->GetOffsets()[0];
+        } else {
+            offsets.resize(cvStencils->GetNumStencils());
+            for (int i=0, ofs=0; i<(int)offsets.size(); ++i) {
+                offsets[i] = ofs;
+                ofs += cvStencils->GetSizes()[i];
+            }
+            cvOffsets = &offsets[0];
+        }
+
+        PatchMap patchMap(*patchTables);
+
+        std::vector<int> arrayOffsets(locationArrays.size()+1, 0);
+        for (int i=0; i<(int)locationArrays.size(); ++i) {
+            arrayOffsets[i+1] = arrayOffsets[i] + locationArrays[i].numLocations;
+        }
+
+        int nstencils = arrayOffsets.back(),
+            nchunks = (nstencils + limitChunkSize - 1) / limitChunkSize;
+
+        result = new LimitStencilTables;
+
+        result->_numControlVertices = refiner.GetNumVertices(0);
+
+        result->_sizes.resize(nstencils);
+
+        std::vector<LimitStencilChunk> chunks(nchunks);
+
+        if (nstencils>0) {
+            Vtr::parallelFor((Vtr::ThreadingType)threading, 0, nchunks, 1,
+                ComputeLimitStencilsKernel(*patchTables, patchMap, *cvStencils,
+                    cvOffsets, refiner.GetNumPtexFaces(), locationArrays,
+                        arrayOffsets, limitChunkSize, &result->_sizes[0], chunks));
+        }
+
+        // Concatenate the chunks
+
+        int nelems = 0;
+        bool overflow = false;
+        for (int i=0; i<nchunks; ++i) {
+            nelems += (int)chunks[i].indices.size();
+            overflow |= chunks[i].overflow;
+        }
+
+        if (overflow) {
+            delete result;
+            result = 0;
+        } else {
+
+            result->_indices.resize(nelems);
+            result->_weights.resize(nelems);
+            result->_duWeights.resize(nelems);
+            result->_dvWeights.resize(nelems);
+
+            for (int i=0, ofs=0; i<nchunks; ++i) {
+                int size = (int)chunks[i].indices.size();
+                if (size>0) {
+                    memcpy(&result->_indices[ofs], &chunks[i].indices[0], size*sizeof(int));
+                    memcpy(&result->_weights[ofs], &chunks[i].weights[0], size*sizeof(float));
+                    memcpy(&result->_duWeights[ofs], &chunks[i].duWeights[0], size*sizeof(float));
+                    memcpy(&result->_dvWeights[ofs], &chunks[i].dvWeights[0], size*sizeof(float));
+                }
+                ofs += size;
+
+                // release the chunk as soon as it is copied
+                chunks[i].Release();
+            }
+
+            result->_offsets.resize(nstencils);
+            for (int i=0, ofs=0; i<nstencils; ++i) {
+                result->_offsets[i] = ofs;
+                ofs += result->_sizes[i];
+            }
+        }
+    }
+
+    if (cvStencils!=cvStencilsIn) {
+        delete cvStencils;
+    }
+    if (patchTables!=patchTablesIn) {
+        delete patchTables;
+    }
+    return result;
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
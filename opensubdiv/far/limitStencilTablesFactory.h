@@ -0,0 +1,128 @@
+//
+//   Copyright 2014 DreamWorks Animation LLC.
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_LIMIT_STENCILTABLES_FACTORY_H
+#define FAR_LIMIT_STENCILTABLES_FACTORY_H
+
+#include "../version.h"
+
+#include "../far/stencilTables.h"
+#include "../far/types.h"
+
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+class PatchTables;
+class TopologyRefiner;
+
+/// \brief A specialized factory for LimitStencilTables
+///
+/// Limit stencils interpolate the limit surface (and its first derivatives)
+/// at arbitrary parametric locations directly from the coarse control
+/// vertices. Each location is resolved to the feature adaptive patch that
+/// contains it with a PatchMap, and the basis weights of the patch are
+/// composed with the stencils of its control vertices.
+///
+/// The values (and derivatives) interpolated by the stencils match those
+/// returned by Osd::CpuEvalLimitController::EvalLimitSample() for the same
+/// locations (up to round-off) : in particular, the derivatives are relative
+/// to the parameterization of the sub-patch that contains each location.
+///
+class LimitStencilTablesFactory {
+
+public:
+
+    /// \brief Descriptor for a set of limit locations on a ptex face
+    struct LocationArray {
+
+        LocationArray() : ptexIdx(-1), numLocations(0), u(0), v(0) { }
+
+        int ptexIdx,       ///< ptex face index
+            numLocations;  ///< number of (u,v) locations in the arrays
+
+        float const * u,   ///< array of u parametric coordinates
+                    * v;   ///< array of v parametric coordinates
+    };
+
+    typedef std::vector<LocationArray> LocationArrayVec;
+
+    struct Options {
+
+        Options() : threading(THREADING_SERIAL) { }
+
+        unsigned int threading : 2; ///< threading backend (see ThreadingType)
+    };
+
+    /// \brief Instantiates LimitStencilTables from a TopologyRefiner that has
+    ///        been refined adaptively.
+    ///
+    /// One stencil is created for each location, in the order of the
+    /// location arrays. Locations that do not resolve to a patch (holes,
+    /// invalid ptex faces or parametric coordinates outside [0,1]) are
+    /// given empty stencils, which interpolate zero values.
+    ///
+    /// @param refiner         The TopologyRefiner containing the adaptively
+    ///                        refined topology
+    ///
+    /// @param locationArrays  The arrays of limit locations
+    ///
+    /// @param cvStencils      Optional stencils of the refined vertices :
+    ///                        the tables must interpolate all the levels
+    ///                        ('generateAllLevels'), in their original order.
+    ///                        Created internally if null.
+    ///
+    /// @param patchTables     Optional patch tables created from 'refiner'.
+    ///                        Created internally if null.
+    ///
+    /// @param options         Options controlling the creation of the tables
+    ///
+    /// @return                The limit stencil tables (with offsets) or 0 if
+    ///                        the refiner was not refined adaptively, the
+    ///                        tables do not match the refiner or a stencil
+    ///                        exceeds 255 control vertices
+    ///
+    /// \note When a threading backend is selected, the locations are
+    ///       distributed in chunks across threads. The resulting tables are
+    ///       identical to those created serially.
+    ///
+    static LimitStencilTables const * Create(TopologyRefiner const & refiner,
+        LocationArrayVec const & locationArrays,
+        StencilTables const * cvStencils=0,
+        PatchTables const * patchTables=0,
+        Options options=Options());
+};
+
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // FAR_LIMIT_STENCILTABLES_FACTORY_H
@@ -29,6 +29,7 @@
 
 #include "../far/patchTables.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace OpenSubdiv {
@@ -46,6 +47,11 @@ namespace Far {
 /// parametric location, can efficiently return a handle to the sub-patch that
 /// contains this location.
 ///
+/// The nodes of the quadtree are stored in a single flat array in breadth-first
+/// order : the root nodes of the coarse faces come first, and the child nodes
+/// of any given node are contiguous, so that the nodes visited by lookups of
+/// nearby locations share cache lines.
+///
 class PatchMap {
 public:
 
@@ -76,7 +82,36 @@ public:
     ///                limit surface is tagged as a hole at the given location
     ///
     Handle const * FindPatch( int faceid, float u, float v ) const;
-    
+
+    /// \brief Returns handles to the sub-patches of a batch of locations.
+    ///
+    /// The quadtrees of several locations are walked together, one depth at
+    /// a time, so that the resolution of the quadrants (and the (u,v)
+    /// transforms) can be vectorized and the memory accesses of independent
+    /// walks overlap. The handles returned are identical to those of
+    /// successive calls to FindPatch().
+    ///
+    /// @param faceids  The indices of the faces (see FindPatch())
+    ///
+    /// @param u        Local u parameters
+    ///
+    /// @param v        Local v parameters
+    ///
+    /// @param count    The number of locations
+    ///
+    /// @param handles  The patch handles of the locations (NULL if a face
+    ///                 does not exist or the location is tagged as a hole)
+    ///
+    /// @return         The number of patches found
+    ///
+    int FindPatches( int const * faceids, float const * u, float const * v,
+                     int count, Handle const ** handles ) const;
+
+    /// \brief Returns the number of coarse faces (root nodes) in the map
+    int GetNumFaces() const {
+        return _numFaces;
+    }
+
 private:
     inline void initialize( PatchTables const & patchTables );
 
@@ -119,13 +154,20 @@ private:
     //
     template <class T> static int resolveQuadrant(T & median, T & u, T & v);
 
+    // re-orders the nodes of the quadtree breadth-first
+    static void flatten( QuadTree const & quadtree, int nfaces, QuadTree & result );
+
+    // number of locations resolved together by FindPatches()
+    enum { FIND_PATCHES_BATCH_SIZE = 64 };
+
+    int                   _numFaces; // number of root nodes
     std::vector<Handle>   _handles;  // all the patches in the PatchTable
-    std::vector<QuadNode> _quadtree; // quadtree nodes
+    std::vector<QuadNode> _quadtree; // quadtree nodes (breadth-first)
 };
 
 // Constructor
 inline
-PatchMap::PatchMap( PatchTables const & patchTables ) {
+PatchMap::PatchMap( PatchTables const & patchTables ) : _numFaces(0) {
     initialize( patchTables );
 }
 
@@ -186,7 +228,7 @@ PatchMap::resolveQuadrant(T & median, T & u, T & v) {
 inline PatchMap::Handle const * 
 PatchMap::FindPatch( int faceid, float u, float v ) const {
     
-    if (faceid>=(int)_quadtree.size())
+    if (faceid<0 or faceid>=_numFaces)
         return NULL;
 
     assert( (u>=0.0f) and (u<=1.0f) and (v>=0.0f) and (v<=1.0f) );
@@ -220,6 +262,111 @@ PatchMap::FindPatch( int faceid, float u, float v ) const {
     return 0;
 }
 
+/// Returns handles to the sub-patches of a batch of locations.
+inline int
+PatchMap::FindPatches( int const * faceids, float const * u, float const * v,
+                       int count, Handle const ** handles ) const {
+
+    int const batchSize = FIND_PATCHES_BATCH_SIZE;
+
+    int nfound = 0;
+
+    for (int first=0; first<count; first+=batchSize) {
+
+        int n = std::min(batchSize, count-first);
+
+        // the locations still walking down the quadtrees are kept compacted
+        // at the front of the arrays
+        int nodes[batchSize], indices[batchSize], nactive = 0;
+        float lu[batchSize], lv[batchSize];
+
+        for (int i=0; i<n; ++i) {
+            int faceid = faceids[first+i];
+            handles[first+i] = NULL;
+            if (faceid<0 or faceid>=_numFaces)
+                continue;
+            assert( (u[first+i]>=0.0f) and (u[first+i]<=1.0f) and
+                    (v[first+i]>=0.0f) and (v[first+i]<=1.0f) );
+            nodes[nactive] = faceid;
+            indices[nactive] = first+i;
+            lu[nactive] = u[first+i];
+            lv[nactive] = v[first+i];
+            ++nactive;
+        }
+
+        float half = 0.5f;
+
+        // 0xFF : we should never have depths greater than k_InfinitelySharp
+        for (int depth=0; nactive>0 and depth<0xFF; ++depth) {
+
+            // branchless quadrant resolution : all the active locations are
+            // at the same depth (same indexing & arithmetic as resolveQuadrant())
+            int quadrants[batchSize];
+            for (int i=0; i<nactive; ++i) {
+                int qu = lu[i]>=half,
+                    qv = lv[i]>=half;
+                quadrants[i] = (qu*3) ^ qv;
+                lu[i] -= half * (float)qu;
+                lv[i] -= half * (float)qv;
+            }
+
+            // step down the quadtrees & compact the locations that have not
+            // reached a leaf (or a hole) yet
+            int nnext = 0;
+            for (int i=0; i<nactive; ++i) {
+
+                QuadNode::Child const & child =
+                    _quadtree[nodes[i]].children[quadrants[i]];
+
+                if (child.isSet and child.isLeaf) {
+                    handles[indices[i]] = &_handles[child.idx];
+                    ++nfound;
+                }
+
+                nodes[nnext] = child.idx;
+                indices[nnext] = indices[i];
+                lu[nnext] = lu[i];
+                lv[nnext] = lv[i];
+                nnext += (child.isSet and not child.isLeaf);
+            }
+            nactive = nnext;
+
+            half *= 0.5f;
+        }
+        assert(nactive==0);
+    }
+    return nfound;
+}
+
+// re-orders the nodes of the quadtree breadth-first
+inline void
+PatchMap::flatten( QuadTree const & quadtree, int nfaces, QuadTree & result ) {
+
+    result.resize(quadtree.size());
+
+    // the root nodes keep their indices
+    std::copy(quadtree.begin(), quadtree.begin()+nfaces, result.begin());
+
+    // each node is visited once, in breadth-first order, and its child nodes
+    // are appended (consecutively) at the back of the result
+    int next = nfaces;
+    for (int i=0; i<next; ++i) {
+
+        QuadNode & node = result[i];
+
+        for (int quadrant=0; quadrant<4; ++quadrant) {
+
+            QuadNode::Child & child = node.children[quadrant];
+
+            if (child.isSet and not child.isLeaf) {
+                result[next] = quadtree[child.idx];
+                child.idx = next++;
+            }
+        }
+    }
+    assert(next==(int)quadtree.size());
+}
+
 // Constructor
 inline void
 PatchMap::initialize( PatchTables const & patchTables ) {
@@ -323,8 +470,11 @@ PatchMap::initialize( PatchTables const & patchTables ) {
         }
     }
 
-    // copy the resulting quadtree to eliminate un-unused vector capacity
-    _quadtree = quadtree;
+    // copy the resulting quadtree breadth-first (also eliminates the
+    // un-used vector capacity)
+    flatten(quadtree, nfaces, _quadtree);
+
+    _numFaces = nfaces;
 }
 
 } // end namespace Far
@@ -369,6 +369,16 @@ public:
     /// \brief Returns a PatchParamTable for each type of patch
     PatchParamTable const & GetPatchParamTable() const { return _paramTable; }
 
+    /// \brief Moves the vertices referenced by the tables to new locations
+    ///
+    /// Replaces every vertex index of the patches (and of the vertex valence
+    /// table, whose entries are permuted accordingly) by its new location.
+    ///
+    /// @param vertexRemap  The new location of each vertex, indexed by its
+    ///                     current location (see StencilTablesFactory::Reorder())
+    ///
+    void RemapVertices(std::vector<int> const & vertexRemap);
+
     /// \brief Ringsize of Regular Patches in table.
     static short GetRegularPatchRingsize() { return 16; }
 
@@ -420,6 +430,7 @@ public:
 
     private:
         friend class PatchTablesFactory;
+        friend class PatchTablesSerializer;
 
         struct Channel {
             friend class PatchTablesFactory;
@@ -463,6 +474,7 @@ public:
 private:
 
     friend class PatchTablesFactory;
+    friend class PatchTablesSerializer;
 
     // Returns the array of patches of type "desc", or NULL if there aren't any in the primitive
     inline PatchArray * findPatchArray( Descriptor desc );
@@ -718,6 +730,41 @@ PatchTables::Descriptor::GetNumFVarControlVertices( PatchTables::Type type ) {
     }
 }
 
+// Moves the vertices referenced by the tables to new locations
+inline void
+PatchTables::RemapVertices(std::vector<int> const & vertexRemap) {
+
+    for (int i=0; i<(int)_patches.size(); ++i) {
+        assert(_patches[i] < vertexRemap.size());
+        _patches[i] = vertexRemap[_patches[i]];
+    }
+
+    if (not _vertexValenceTable.empty()) {
+
+        // one entry of 2*maxValence+1 ints per vertex : the valence (negative
+        // on boundaries) followed by the one-ring vertices
+        int entrySize = 2*_maxValence + 1,
+            nverts = (int)_vertexValenceTable.size() / entrySize;
+
+        assert(nverts==(int)vertexRemap.size());
+
+        VertexValenceTable table(_vertexValenceTable.size(), 0);
+        for (int vert=0; vert<nverts; ++vert) {
+
+            int const * src = &_vertexValenceTable[vert*entrySize];
+            int * dst = &table[vertexRemap[vert]*entrySize];
+
+            int valence = src[0],
+                ringSize = 2 * (valence<0 ? -valence : valence);
+            dst[0] = valence;
+            for (int i=1; i<=ringSize; ++i) {
+                dst[i] = vertexRemap[src[i]];
+            }
+        }
+        _vertexValenceTable.swap(table);
+    }
+}
+
 // Returns a pointer to the PatchArry of uniformly subdivided faces at 'level'
 inline PatchTables::PatchArray const *
 PatchTables::GetPatchArray(int level) const {
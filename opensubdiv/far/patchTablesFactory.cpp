@@ -26,8 +26,11 @@
 #include "../far/topologyRefiner.h"
 #include "../vtr/level.h"
 #include "../vtr/refinement.h"
+#include "../vtr/parallel.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
 
 
@@ -67,6 +70,23 @@ struct PatchTypes {
         return R[0];
     }
 
+    TYPE const & getValue( PatchTables::Descriptor desc ) const {
+        return const_cast<PatchTypes *>(this)->getValue(desc);
+    }
+
+    // Adds the values of each type of patch of 'other' (counters only)
+    void add( PatchTypes const & other ) {
+        for (int i=0; i<NUM_TRANSITIONS; ++i) {
+            R[i] += other.R[i];
+            for (int j=0; j<NUM_ROTATIONS; ++j) {
+                B[i][j] += other.B[i][j];
+                C[i][j] += other.C[i][j];
+            }
+        }
+        G += other.G;
+        GB += other.GB;
+    }
+
     // Counts the number of arrays required to store each type of patch used
     // in the primitive
     int getNumPatchArrays() const {
@@ -305,6 +325,243 @@ public:
 
 typedef std::vector<PatchFaceTag>   PatchTagVector;
 
+//
+//  A range of faces of a level tagged and populated as a unit -- the counters hold the
+//  number of patches of each type identified in the range, and once all ranges have been
+//  reduced, the index of the first patch of each type of the range in its patch array
+//
+struct PatchFaceChunk {
+    int level,
+        faceBegin,
+        faceEnd,
+        tagOffset,   // offset of the tags of the faces of the level
+        vertOffset;  // offset of the vertices of the level
+
+    PatchCounters counts;
+};
+
+typedef std::vector<PatchFaceChunk> PatchChunkVector;
+
+//  Number of faces in a chunk (the unit of work of the parallel kernels)
+static const int patchChunkSize = 1024;
+
+//
+//  The previous tables of an update (see PatchTablesFactory::Update()).
+//
+//  The patches of each patch array are sorted by level and face, and sparse refinement
+//  orders the child faces of each level by parent face and child index : the faces of a
+//  level are thus ordered by Ptex face and by their path from the coarse face, which are
+//  recovered from their PatchParam (see comparePatchParams()).  The previous patches of
+//  the faces of a chunk are matched walking the previous patch array of each type in that
+//  order, from a cursor located by binary search for the first patch of the chunk.
+//
+struct PatchUpdateContext {
+
+    PatchUpdateContext(PatchTables const & prevTables, std::vector<Index> const & vertexOrigins,
+        std::vector<Index> & patchOrigins);
+
+    //  Returns the previous patch array of a type of patch (or -1)
+    int findPrevPatchArray(PatchTables::Descriptor desc) const;
+
+    //  Remaps the control vertices of the previous patch of a new patch, whose PatchParam
+    //  was computed, returning false if there is none or if any of its vertices was not
+    //  carried over -- the previous patch is recorded as the origin of the new patch
+    bool carryPatch(int prevArray, PatchParam const * param, unsigned int * cvs, int & cursor) const;
+
+    //  Records the previous patch of a new Gregory patch if its control vertices and their
+    //  one-rings were all carried over
+    void matchGregoryPatch(int prevArray, PatchParam const * param, unsigned int const * cvs,
+        int & cursor) const;
+
+    //  Remaps the one-ring of the previous vertex of a vertex in the vertex valence table,
+    //  returning false if the previous vertex has none or if any of its vertices was not
+    //  carried over
+    bool carryVertexValence(Index vert, int * vTableEntry) const;
+
+    PatchTables const & prevTables;
+
+    Index const *      vertexOrigins;   // previous index of each vertex (or -1)
+    std::vector<Index> vertexImages;    // new index of each previous vertex (or -1)
+
+    std::vector<Index> & patchOrigins;
+    PatchParam const *   paramTable;    // parameterization of the new patches
+
+private:
+    //  Returns the previous patch of the array matching a new patch (or -1)
+    int findPrevPatch(int prevArray, PatchParam const & param, int & cursor) const;
+
+    bool isRingCarried(Index prevVert) const;
+};
+
+namespace {
+    //  Orders patches by level, Ptex face and path of their face from the coarse face
+    inline int
+    comparePatchParams(PatchParam const & a, PatchParam const & b) {
+
+        PatchParam::BitField const & fa = a.bitField,
+                                   & fb = b.bitField;
+
+        if (fa.GetDepth() != fb.GetDepth()) return fa.GetDepth() < fb.GetDepth() ? -1 : 1;
+
+        if (a.faceIndex != b.faceIndex) return a.faceIndex < b.faceIndex ? -1 : 1;
+
+        //  The u,v bits of each level below the Ptex face select the child face (see
+        //  computePatchParam())
+        static const unsigned int childIndices[4] = { 0, 1, 3, 2 };
+
+        for (int k = fa.GetDepth() - (fa.NonQuadRoot() ? 2 : 1); k >= 0; --k) {
+            unsigned int childA = childIndices[((fa.GetU() >> k) & 1) | (((fa.GetV() >> k) & 1) << 1)],
+                         childB = childIndices[((fb.GetU() >> k) & 1) | (((fb.GetV() >> k) & 1) << 1)];
+            if (childA != childB) return childA < childB ? -1 : 1;
+        }
+        return 0;
+    }
+}
+
+PatchUpdateContext::PatchUpdateContext(PatchTables const & prevTables_,
+    std::vector<Index> const & vertexOrigins_, std::vector<Index> & patchOrigins_) :
+        prevTables(prevTables_), vertexOrigins(&vertexOrigins_[0]),
+            patchOrigins(patchOrigins_), paramTable(0) {
+
+    //  Invert the vertex origins
+    Index numPrevVertices = 0;
+    for (int i = 0; i < (int)vertexOrigins_.size(); ++i) {
+        numPrevVertices = std::max(numPrevVertices, vertexOrigins_[i] + 1);
+    }
+    vertexImages.resize(numPrevVertices, Vtr::INDEX_INVALID);
+    for (int i = 0; i < (int)vertexOrigins_.size(); ++i) {
+        if (vertexOrigins_[i] >= 0) {
+            vertexImages[vertexOrigins_[i]] = i;
+        }
+    }
+}
+
+int
+PatchUpdateContext::findPrevPatchArray(PatchTables::Descriptor desc) const {
+
+    PatchTables::PatchArrayVector const & parrays = prevTables.GetPatchArrayVector();
+    for (int i = 0; i < (int)parrays.size(); ++i) {
+        if (parrays[i].GetDescriptor() == desc) return i;
+    }
+    return -1;
+}
+
+int
+PatchUpdateContext::findPrevPatch(int prevArray, PatchParam const & param, int & cursor) const {
+
+    if (prevArray < 0) return -1;
+
+    PatchTables::PatchArray const & parray = prevTables.GetPatchArrayVector()[prevArray];
+
+    PatchParam const * params = &prevTables.GetPatchParamTable()[parray.GetPatchIndex()];
+
+    int numPatches = (int)parray.GetNumPatches();
+
+    if (cursor < 0) {
+        //  Locate the first patch of the chunk
+        int begin = 0, end = numPatches;
+        while (begin < end) {
+            int mid = begin + (end - begin) / 2;
+            if (comparePatchParams(params[mid], param) < 0) {
+                begin = mid + 1;
+            } else {
+                end = mid;
+            }
+        }
+        cursor = begin;
+    } else {
+        while ((cursor < numPatches) and (comparePatchParams(params[cursor], param) < 0)) {
+            ++cursor;
+        }
+    }
+
+    if ((cursor == numPatches) or (params[cursor].faceIndex != param.faceIndex) or
+        (params[cursor].bitField.field != param.bitField.field)) {
+        return -1;
+    }
+    return cursor++;
+}
+
+bool
+PatchUpdateContext::carryPatch(int prevArray, PatchParam const * param, unsigned int * cvs,
+    int & cursor) const {
+
+    int prevPatch = findPrevPatch(prevArray, *param, cursor);
+    if (prevPatch < 0) return false;
+
+    PatchTables::PatchArray const & parray = prevTables.GetPatchArrayVector()[prevArray];
+
+    int ncvs = parray.GetDescriptor().GetNumControlVertices();
+
+    unsigned int const * prevCVs = &prevTables.GetPatchTable()[parray.GetVertIndex()] + prevPatch * ncvs;
+    for (int i = 0; i < ncvs; ++i) {
+        if ((prevCVs[i] >= vertexImages.size()) or (vertexImages[prevCVs[i]] < 0)) {
+            return false;
+        }
+        cvs[i] = vertexImages[prevCVs[i]];
+    }
+    patchOrigins[param - paramTable] = parray.GetPatchIndex() + prevPatch;
+    return true;
+}
+
+bool
+PatchUpdateContext::isRingCarried(Index prevVert) const {
+
+    PatchTables::VertexValenceTable const & prevVTable = prevTables.GetVertexValenceTable();
+
+    const int SizePerVertex = 2*prevTables.GetMaxValence() + 1;
+
+    if ((prevVert + 1) * SizePerVertex > (int)prevVTable.size()) return false;
+
+    int const * prevEntry = &prevVTable[prevVert * SizePerVertex];
+    if (prevEntry[0] == 0) return false;
+
+    int ringSize = 2 * std::abs(prevEntry[0]);
+    for (int i = 1; i <= ringSize; ++i) {
+        if ((prevEntry[i] >= (int)vertexImages.size()) or (vertexImages[prevEntry[i]] < 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+PatchUpdateContext::matchGregoryPatch(int prevArray, PatchParam const * param,
+    unsigned int const * cvs, int & cursor) const {
+
+    int prevPatch = findPrevPatch(prevArray, *param, cursor);
+    if (prevPatch < 0) return;
+
+    PatchTables::PatchArray const & parray = prevTables.GetPatchArrayVector()[prevArray];
+
+    unsigned int const * prevCVs = &prevTables.GetPatchTable()[parray.GetVertIndex()] + prevPatch * 4;
+    for (int i = 0; i < 4; ++i) {
+        if ((prevCVs[i] >= vertexImages.size()) or (vertexImages[prevCVs[i]] != (Index)cvs[i]) or
+            (not isRingCarried(prevCVs[i]))) {
+            return;
+        }
+    }
+    patchOrigins[param - paramTable] = parray.GetPatchIndex() + prevPatch;
+}
+
+bool
+PatchUpdateContext::carryVertexValence(Index vert, int * vTableEntry) const {
+
+    Index prevVert = vertexOrigins[vert];
+    if ((prevVert < 0) or (not isRingCarried(prevVert))) return false;
+
+    const int SizePerVertex = 2*prevTables.GetMaxValence() + 1;
+
+    int const * prevEntry = &prevTables.GetVertexValenceTable()[prevVert * SizePerVertex];
+
+    int ringSize = 2 * std::abs(prevEntry[0]);
+
+    vTableEntry[0] = prevEntry[0];
+    for (int i = 1; i <= ringSize; ++i) {
+        vTableEntry[i] = vertexImages[prevEntry[i]];
+    }
+    return true;
+}
 
 //
 //  Trivial anonymous helper functions:
@@ -526,10 +783,34 @@ PatchTablesFactory::Create( TopologyRefiner const & refiner, Options options ) {
     if (refiner.IsUniform()) {
         return createUniform(refiner, options);
     } else {
-        return createAdaptive(refiner, options);
+        return createAdaptive(refiner, options, 0);
     }
 }
 
+//
+//  The previous tables of an update can only be matched against adaptive tables of the
+//  same control mesh -- other updates simply create the tables, carrying no patch.
+//
+PatchTables *
+PatchTablesFactory::Update( TopologyRefiner const & refiner, PatchTables const & prevTables,
+                            std::vector<Index> const & vertexOrigins,
+                            std::vector<Index> & patchOrigins, Options options ) {
+
+    if (refiner.IsUniform() or (not prevTables.IsFeatureAdaptive()) or
+        (prevTables.GetMaxValence() != refiner.getLevel(0).getMaxValence()) or
+        (prevTables.GetNumPtexFaces() != refiner.GetNumPtexFaces()) or
+        ((int)vertexOrigins.size() != refiner.GetNumVerticesTotal())) {
+
+        PatchTables * tables = Create(refiner, options);
+        patchOrigins.assign(tables->GetNumPatches(), Vtr::INDEX_INVALID);
+        return tables;
+    }
+
+    PatchUpdateContext update(prevTables, vertexOrigins, patchOrigins);
+
+    return createAdaptive(refiner, options, &update);
+}
+
 static void
 gatherFVarPatchVertices(TopologyRefiner const & refiner,
     int level, int faceIndex, int rotation, int const * levelOffsets, unsigned int ** fptrs) {
@@ -682,18 +963,22 @@ PatchTablesFactory::createUniform( TopologyRefiner const & refiner, Options opti
 }
 
 PatchTables *
-PatchTablesFactory::createAdaptive( TopologyRefiner const & refiner, Options options ) {
+PatchTablesFactory::createAdaptive( TopologyRefiner const & refiner, Options options,
+                                    PatchUpdateContext * update ) {
 
     assert(not refiner.IsUniform());
 
+    ThreadingType threading = (ThreadingType)options.threading;
+
     //
     //  First identify the patches -- accumulating the inventory patches for all of the
     //  different types and information about the patch for each face:
     //
     PatchCounters             patchInventory;
     std::vector<PatchFaceTag> patchTags;
+    PatchChunkVector          patchChunks;
 
-    identifyAdaptivePatches(refiner, patchInventory, patchTags);
+    identifyAdaptivePatches(refiner, patchInventory, patchTags, patchChunks, threading);
 
     //
     //  Create the instance of the tables and allocate and initialize its members based on
@@ -728,206 +1013,332 @@ PatchTablesFactory::createAdaptive( TopologyRefiner const & refiner, Options opt
         tables->_quadOffsetTable.resize( patchInventory.G*4 + patchInventory.GB*4 );
     }
 
+    if (update) {
+        update->patchOrigins.assign(tables->GetNumPatches(), Vtr::INDEX_INVALID);
+        update->paramTable = tables->_paramTable.empty() ? 0 : &tables->_paramTable[0];
+    }
+
     //
     //  Now populate the patches:
     //
-    populateAdaptivePatches(refiner, patchInventory, patchTags, tables);
+    populateAdaptivePatches(refiner, patchInventory, patchTags, patchChunks, tables, update, threading);
 
     return tables;
 }
 
+//
+//  Parallel kernels identifying and populating the patches of ranges of faces (see
+//  PatchFaceChunk), and gathering the vertex valences of ranges of vertices
+//
+class PatchTablesFactory::IdentifyPatchesKernel : public Vtr::ParallelKernel {
+public:
+    IdentifyPatchesKernel(TopologyRefiner const & refiner,
+        PatchChunkVector & chunks, PatchFaceTag * patchTags) :
+            _refiner(refiner), _chunks(chunks), _patchTags(patchTags) { }
+
+    virtual void operator()(Vtr::Index begin, Vtr::Index end) const {
+        for (int i=begin; i<end; ++i) {
+            identifyAdaptivePatchesInRange(_refiner, _chunks[i], _patchTags);
+        }
+    }
+
+private:
+    TopologyRefiner const & _refiner;
+    PatchChunkVector &      _chunks;
+    PatchFaceTag *          _patchTags;
+};
+
+class PatchTablesFactory::PopulatePatchesKernel : public Vtr::ParallelKernel {
+public:
+    PopulatePatchesKernel(TopologyRefiner const & refiner,
+        PatchChunkVector const & chunks, PatchFaceTag const * patchTags,
+            PatchTypes<PatchTables::PatchArray const *> const & patchArrays,
+                PatchTables * tables, PatchUpdateContext const * update) :
+        _refiner(refiner), _chunks(chunks), _patchTags(patchTags),
+            _patchArrays(patchArrays), _tables(tables), _update(update) { }
+
+    virtual void operator()(Vtr::Index begin, Vtr::Index end) const {
+        for (int i=begin; i<end; ++i) {
+            populateAdaptivePatchesInRange(_refiner, _chunks[i], _patchTags,
+                _patchArrays, _tables, _update);
+        }
+    }
+
+private:
+    TopologyRefiner const &  _refiner;
+    PatchChunkVector const & _chunks;
+    PatchFaceTag const *     _patchTags;
+
+    PatchTypes<PatchTables::PatchArray const *> const & _patchArrays;
+
+    PatchTables * _tables;
+
+    PatchUpdateContext const * _update;
+};
+
+class PatchTablesFactory::VertexValencesKernel : public Vtr::ParallelKernel {
+public:
+    VertexValencesKernel(TopologyRefiner const & refiner, int level, int vertexOffset,
+        PatchTables * tables, PatchUpdateContext const * update) :
+            _refiner(refiner), _level(level), _vertexOffset(vertexOffset), _tables(tables),
+                _update(update) { }
+
+    virtual void operator()(Vtr::Index begin, Vtr::Index end) const {
+        populateVertexValencesInRange(_refiner, _level, _vertexOffset, begin, end, _tables, _update);
+    }
+
+private:
+    TopologyRefiner const &    _refiner;
+    int                        _level;
+    int                        _vertexOffset;
+    PatchTables *              _tables;
+    PatchUpdateContext const * _update;
+};
+
 //
 //  Identify all patches required for faces at all levels -- accumulating the number of patches
 //  for each type, and retaining enough information for the patch for each face to populate it
 //  later with no additional analysis.
 //
+//  The faces of each level are split in chunks that are tagged independently, the counts of
+//  the chunks being then reduced in order into the inventory.
+//
 void
 PatchTablesFactory::identifyAdaptivePatches( TopologyRefiner const & refiner,
                                                 PatchCounters &         patchInventory,
-                                                PatchTagVector &        patchTags ) {
+                                                PatchTagVector &        patchTags,
+                                                PatchChunkVector &      patchChunks,
+                                                ThreadingType           threading ) {
 
     //
     //  Iterate through the levels of refinement to inspect and tag components with information
     //  relative to patch generation.  We allocate all of the tags locally and use them to
     //  populate the patches once a complete inventory has been taken and all tables appropriately
     //  allocated and initialized:
+    //
+    patchTags.resize(refiner.GetNumFacesTotal());
+
+    patchChunks.clear();
+
+    int tagOffset = 0,
+        vertOffset = 0;
+
+    for (int i = 0; i < (int)refiner.getNumLevels(); ++i) {
+        Vtr::Level const & level = refiner.getLevel(i);
+
+        int nfaces = level.getNumFaces();
+        for (int face = 0; face < nfaces; face += patchChunkSize) {
+            PatchFaceChunk chunk;
+            chunk.level = i;
+            chunk.faceBegin = face;
+            chunk.faceEnd = std::min(face + patchChunkSize, nfaces);
+            chunk.tagOffset = tagOffset;
+            chunk.vertOffset = vertOffset;
+            patchChunks.push_back(chunk);
+        }
+        tagOffset += nfaces;
+        vertOffset += level.getNumVertices();
+    }
+
+    if (patchChunks.empty()) {
+        return;
+    }
+
+    Vtr::parallelFor((Vtr::ThreadingType)threading, 0, (int)patchChunks.size(), 1,
+        IdentifyPatchesKernel(refiner, patchChunks, &patchTags[0]));
+
+    //
+    //  Reduce the counts of the chunks into the inventory, leaving each chunk with the index
+    //  of its first patch of each type:
+    //
+    for (int i = 0; i < (int)patchChunks.size(); ++i) {
+        PatchCounters counts = patchChunks[i].counts;
+        patchChunks[i].counts = patchInventory;
+        patchInventory.add(counts);
+    }
+}
+
+void
+PatchTablesFactory::identifyAdaptivePatchesInRange( TopologyRefiner const & refiner,
+                                                       PatchFaceChunk &        chunk,
+                                                       PatchFaceTag *          patchTags ) {
+
     //
     //  The first Level may have no Refinement if it is the only level -- similarly the last Level
     //  has no Refinement, so a single level is effectively the last, but with less information
     //  available in some cases, as it was not generated by refinement.
     //
-    patchTags.resize(refiner.GetNumFacesTotal());
+    int i = chunk.level;
 
-    PatchFaceTag * levelPatchTags = &patchTags[0];
+    Vtr::Level const * level = &refiner.getLevel(i);
 
-    for (int i = 0; i < (int)refiner.getNumLevels(); ++i) {
-        Vtr::Level const * level = &refiner.getLevel(i);
+    PatchFaceTag * levelPatchTags = patchTags + chunk.tagOffset;
+
+    PatchCounters & patchInventory = chunk.counts;
+
+    //
+    //  Given components at Level[i], we need to be looking at Refinement[i] -- and not
+    //  [i-1] -- because the Refinement has transitional information for its parent edges
+    //  and faces.  But we also need to be looking at Refinement[i-1] to know about the
+    //  ancestry of the components, i.e. are they "complete" wrt their ancestors (if not,
+    //  they are supporting components
+    //
+    //  For components in this level, we want to determine:
+    //    - what Edges are "transitional" (already done in Refinement for parent)
+    //    - what Faces are "transitional" (already done in Refinement for parent)
+    //    - what Faces are "complete" (done for child vertices in Refinement)
+    //
+    bool isLevelFirst = (i == 0);
+    bool isLevelLast  = (i == ((int)refiner.getNumLevels() - 1));
+
+    Vtr::Refinement const * refinePrev = isLevelFirst ? 0 : &refiner.getRefinement(i-1);
+    Vtr::Refinement const * refineNext = isLevelLast  ? 0 : &refiner.getRefinement(i);
+
+    Vtr::Refinement::SparseTag const * vtrFaceTags = refineNext ? &refineNext->_parentFaceTag[0] : 0;
+
+    for (int faceIndex = chunk.faceBegin; faceIndex < chunk.faceEnd; ++faceIndex) {
+        Vtr::Refinement::SparseTag vtrFaceTag = vtrFaceTags ? vtrFaceTags[faceIndex] : Vtr::Refinement::SparseTag();
+        PatchFaceTag&            patchTag   = levelPatchTags[faceIndex];
+
+        patchTag.clear();
+        patchTag._hasPatch = false;
 
         //
-        //  Given components at Level[i], we need to be looking at Refinement[i] -- and not
-        //  [i-1] -- because the Refinement has transitional information for its parent edges
-        //  and faces.  But we also need to be looking at Refinement[i-1] to know about the
-        //  ancestry of the components, i.e. are they "complete" wrt their ancestors (if not,
-        //  they are supporting components
+        //  This face does not warrant a patch under the following conditions:
         //
-        //  For components in this level, we want to determine:
-        //    - what Edges are "transitional" (already done in Refinement for parent)
-        //    - what Faces are "transitional" (already done in Refinement for parent)
-        //    - what Faces are "complete" (done for child vertices in Refinement)
+        //      - the face was fully refined into child faces
+        //      - the face is not a quad (should have been refined, so assert)
+        //      - the face is not "complete"
         //
-        bool isLevelFirst = (i == 0);
-        bool isLevelLast  = (i == ((int)refiner.getNumLevels() - 1));
-
-        Vtr::Refinement const * refinePrev = isLevelFirst ? 0 : &refiner.getRefinement(i-1);
-        Vtr::Refinement const * refineNext = isLevelLast  ? 0 : &refiner.getRefinement(i);
-
-        Vtr::Refinement::SparseTag const * vtrFaceTags = refineNext ? &refineNext->_parentFaceTag[0] : 0;
-
-        for (int faceIndex = 0; faceIndex < level->getNumFaces(); ++faceIndex) {
-            Vtr::Refinement::SparseTag vtrFaceTag = vtrFaceTags ? vtrFaceTags[faceIndex] : Vtr::Refinement::SparseTag();
-            PatchFaceTag&            patchTag   = levelPatchTags[faceIndex];
-
-            patchTag.clear();
-            patchTag._hasPatch = false;
-
-            //
-            //  This face does not warrant a patch under the following conditions:
-            //
-            //      - the face was fully refined into child faces
-            //      - the face is not a quad (should have been refined, so assert)
-            //      - the face is not "complete"
-            //
-            //  The first is trivially determined, and the second is really redundant.  The
-            //  last -- "incompleteness" -- indicates a face that exists to support the limit
-            //  of some neighboring component, and which does not have its own neighborhood
-            //  fully defined for its limit.  If any child vertex of a vertex of this face is
-            //  "incomplete", the face must be "incomplete" (note all faces in level 0 are
-            //  complete and do not warrant closer inspection).
-            //
-            if (vtrFaceTag._selected) {
-                continue;
-            }
+        //  The first is trivially determined, and the second is really redundant.  The
+        //  last -- "incompleteness" -- indicates a face that exists to support the limit
+        //  of some neighboring component, and which does not have its own neighborhood
+        //  fully defined for its limit.  If any child vertex of a vertex of this face is
+        //  "incomplete", the face must be "incomplete" (note all faces in level 0 are
+        //  complete and do not warrant closer inspection).
+        //
+        if (vtrFaceTag._selected) {
+            continue;
+        }
 
-            Vtr::IndexArray const& fVerts = level->getFaceVertices(faceIndex);
-            assert(fVerts.size() == 4);
+        Vtr::IndexArray const& fVerts = level->getFaceVertices(faceIndex);
+        assert(fVerts.size() == 4);
 
-            if (!isLevelFirst and (refinePrev->_childVertexTag[fVerts[0]]._incomplete or
-                                   refinePrev->_childVertexTag[fVerts[1]]._incomplete or
-                                   refinePrev->_childVertexTag[fVerts[2]]._incomplete or
-                                   refinePrev->_childVertexTag[fVerts[3]]._incomplete)) {
-                continue;
-            }
+        if (!isLevelFirst and (refinePrev->_childVertexTag[fVerts[0]]._incomplete or
+                               refinePrev->_childVertexTag[fVerts[1]]._incomplete or
+                               refinePrev->_childVertexTag[fVerts[2]]._incomplete or
+                               refinePrev->_childVertexTag[fVerts[3]]._incomplete)) {
+            continue;
+        }
 
-            //
-            //  We have a quad that will be represented as a B-spline or Gregory patch.  Use
-            //  the "composite" tag for the face that combines tags for all face-verts -- we
-            //  can use it to quickly determine if any vertex is irregular or on a boundary.
-            //
-            //  Inspect the edges for boundaries and transitional edges and pack results into
-            //  4-bit masks.  We detect boundary edges rather than vertices as we hope to
-            //  replace the mask in future with one for infinitely sharp edges -- allowing
-            //  us to detect regular patches and avoid isolation.  We still need to account
-            //  for the irregular/xordinary case when a corner vertex is a boundary but there
-            //  are no boundary edges.
-            //
-            //  As for transition detection, assign the transition properties (even if 0) as
-            //  their rotations override boundary rotations (when no transition)
-            //
-            //  NOTE on non-manifold support:
-            //      Patches from non-manifold verts are not yet supported -- the extraction
-            //  of patch points at corners currently assumes manifold.  Supporting interior
-            //  hard edges (below) will allow non-manifold patches with inf sharp boundaries.
-            //
-            //  NOTE on infinitely sharp (hard) edges:
-            //      We should be able to adapt this later to detect hard (inf-sharp) edges
-            //  rather than just boundary edges -- there is a similar tag per edge.  That
-            //  should allow us to generate regular patches for interior hard features.
-            //
-            Vtr::Level::VTag compFaceVertTag = level->getFaceCompositeVTag(fVerts);
-
-            //  Patches for non-manifold faces not yet supported (see above note)
-            assert(!compFaceVertTag._nonManifold);
-
-            patchTag._hasPatch  = true;
-            patchTag._isRegular = !compFaceVertTag._xordinary;
-
-            int boundaryEdgeMask = 0;
-
-            bool hasBoundaryVertex = compFaceVertTag._boundary;
-            if (hasBoundaryVertex) {
-                Vtr::IndexArray const& fEdges = level->getFaceEdges(faceIndex);
-
-                boundaryEdgeMask = ((level->_edgeTags[fEdges[0]]._boundary) << 0) |
-                                   ((level->_edgeTags[fEdges[1]]._boundary) << 1) |
-                                   ((level->_edgeTags[fEdges[2]]._boundary) << 2) |
-                                   ((level->_edgeTags[fEdges[3]]._boundary) << 3);
-
-                if (boundaryEdgeMask) {
-                    patchTag.assignBoundaryPropertiesFromEdgeMask(boundaryEdgeMask);
-                } else {
-                    int boundaryVertMask = ((level->_vertTags[fVerts[0]]._boundary) << 0) |
-                                           ((level->_vertTags[fVerts[1]]._boundary) << 1) |
-                                           ((level->_vertTags[fVerts[2]]._boundary) << 2) |
-                                           ((level->_vertTags[fVerts[3]]._boundary) << 3);
+        //
+        //  We have a quad that will be represented as a B-spline or Gregory patch.  Use
+        //  the "composite" tag for the face that combines tags for all face-verts -- we
+        //  can use it to quickly determine if any vertex is irregular or on a boundary.
+        //
+        //  Inspect the edges for boundaries and transitional edges and pack results into
+        //  4-bit masks.  We detect boundary edges rather than vertices as we hope to
+        //  replace the mask in future with one for infinitely sharp edges -- allowing
+        //  us to detect regular patches and avoid isolation.  We still need to account
+        //  for the irregular/xordinary case when a corner vertex is a boundary but there
+        //  are no boundary edges.
+        //
+        //  As for transition detection, assign the transition properties (even if 0) as
+        //  their rotations override boundary rotations (when no transition)
+        //
+        //  NOTE on non-manifold support:
+        //      Patches from non-manifold verts are not yet supported -- the extraction
+        //  of patch points at corners currently assumes manifold.  Supporting interior
+        //  hard edges (below) will allow non-manifold patches with inf sharp boundaries.
+        //
+        //  NOTE on infinitely sharp (hard) edges:
+        //      We should be able to adapt this later to detect hard (inf-sharp) edges
+        //  rather than just boundary edges -- there is a similar tag per edge.  That
+        //  should allow us to generate regular patches for interior hard features.
+        //
+        Vtr::Level::VTag compFaceVertTag = level->getFaceCompositeVTag(fVerts);
 
-                    patchTag.assignBoundaryPropertiesFromVertexMask(boundaryVertMask);
-                }
+        //  Patches for non-manifold faces not yet supported (see above note)
+        assert(!compFaceVertTag._nonManifold);
+
+        patchTag._hasPatch  = true;
+        patchTag._isRegular = !compFaceVertTag._xordinary;
+
+        int boundaryEdgeMask = 0;
+
+        bool hasBoundaryVertex = compFaceVertTag._boundary;
+        if (hasBoundaryVertex) {
+            Vtr::IndexArray const& fEdges = level->getFaceEdges(faceIndex);
+
+            boundaryEdgeMask = ((level->_edgeTags[fEdges[0]]._boundary) << 0) |
+                               ((level->_edgeTags[fEdges[1]]._boundary) << 1) |
+                               ((level->_edgeTags[fEdges[2]]._boundary) << 2) |
+                               ((level->_edgeTags[fEdges[3]]._boundary) << 3);
+
+            if (boundaryEdgeMask) {
+                patchTag.assignBoundaryPropertiesFromEdgeMask(boundaryEdgeMask);
+            } else {
+                int boundaryVertMask = ((level->_vertTags[fVerts[0]]._boundary) << 0) |
+                                       ((level->_vertTags[fVerts[1]]._boundary) << 1) |
+                                       ((level->_vertTags[fVerts[2]]._boundary) << 2) |
+                                       ((level->_vertTags[fVerts[3]]._boundary) << 3);
+
+                patchTag.assignBoundaryPropertiesFromVertexMask(boundaryVertMask);
             }
-            patchTag.assignTransitionPropertiesFromEdgeMask(vtrFaceTag._transitional);
-
-            //
-            //  This treatment may become optional in future -- consider approximating smooth
-            //  corners with regular B-spline patches instead of Gregory.  The smooth corner
-            //  must be properly isolated from any other irregular vertices, otherwise the
-            //  Gregory patch is necessary.
-            //
-            bool approxSmoothCornerWithRegularPatch = true;
-            if (approxSmoothCornerWithRegularPatch) {
-                if (!patchTag._isRegular && (patchTag._boundaryCount == 2)) {
-                    //  We may have a sharp corner opposite/adjacent an xordinary vertex --
-                    //  need to make sure there is only one xordinary vertex and that it
-                    //  is the corner vertex.
-                    int xordCorner = 0;
-                    int xordCount = 0;
-                    if (level->_vertTags[fVerts[0]]._xordinary) { xordCount++; xordCorner = 0; }
-                    if (level->_vertTags[fVerts[1]]._xordinary) { xordCount++; xordCorner = 1; }
-                    if (level->_vertTags[fVerts[2]]._xordinary) { xordCount++; xordCorner = 2; }
-                    if (level->_vertTags[fVerts[3]]._xordinary) { xordCount++; xordCorner = 3; }
-
-                    if (xordCount == 1) {
-                        //  The two boundary edges must be either side of the corner vertex:
-                        int const expectedCornerEdgeMask[4] = { 8+1, 1+2, 2+4, 4+8 };
-                        if (boundaryEdgeMask == expectedCornerEdgeMask[xordCorner]) {
-                            patchTag._isRegular = true;
-                        }
+        }
+        patchTag.assignTransitionPropertiesFromEdgeMask(vtrFaceTag._transitional);
+
+        //
+        //  This treatment may become optional in future -- consider approximating smooth
+        //  corners with regular B-spline patches instead of Gregory.  The smooth corner
+        //  must be properly isolated from any other irregular vertices, otherwise the
+        //  Gregory patch is necessary.
+        //
+        bool approxSmoothCornerWithRegularPatch = true;
+        if (approxSmoothCornerWithRegularPatch) {
+            if (!patchTag._isRegular && (patchTag._boundaryCount == 2)) {
+                //  We may have a sharp corner opposite/adjacent an xordinary vertex --
+                //  need to make sure there is only one xordinary vertex and that it
+                //  is the corner vertex.
+                int xordCorner = 0;
+                int xordCount = 0;
+                if (level->_vertTags[fVerts[0]]._xordinary) { xordCount++; xordCorner = 0; }
+                if (level->_vertTags[fVerts[1]]._xordinary) { xordCount++; xordCorner = 1; }
+                if (level->_vertTags[fVerts[2]]._xordinary) { xordCount++; xordCorner = 2; }
+                if (level->_vertTags[fVerts[3]]._xordinary) { xordCount++; xordCorner = 3; }
+
+                if (xordCount == 1) {
+                    //  The two boundary edges must be either side of the corner vertex:
+                    int const expectedCornerEdgeMask[4] = { 8+1, 1+2, 2+4, 4+8 };
+                    if (boundaryEdgeMask == expectedCornerEdgeMask[xordCorner]) {
+                        patchTag._isRegular = true;
                     }
                 }
             }
+        }
 
-            //
-            //  Identify and increment counts for regular patches (both non-transitional and
-            //  transitional) and extra-ordinary patches (always non-transitional):
-            //
-            if (patchTag._isRegular) {
-                int transIndex = patchTag._transitionType;
-                int transRot   = patchTag._transitionRot;
-
-                if (patchTag._boundaryCount == 0) {
-                    patchInventory.R[transIndex]++;
-                } else if (patchTag._boundaryCount == 1) {
-                    patchInventory.B[transIndex][transRot]++;
-                } else {
-                    patchInventory.C[transIndex][transRot]++;
-                }
+        //
+        //  Identify and increment counts for regular patches (both non-transitional and
+        //  transitional) and extra-ordinary patches (always non-transitional):
+        //
+        if (patchTag._isRegular) {
+            int transIndex = patchTag._transitionType;
+            int transRot   = patchTag._transitionRot;
+
+            if (patchTag._boundaryCount == 0) {
+                patchInventory.R[transIndex]++;
+            } else if (patchTag._boundaryCount == 1) {
+                patchInventory.B[transIndex][transRot]++;
             } else {
-                if (patchTag._boundaryCount == 0) {
-                    patchInventory.G++;
-                } else {
-                    patchInventory.GB++;
-                }
+                patchInventory.C[transIndex][transRot]++;
+            }
+        } else {
+            if (patchTag._boundaryCount == 0) {
+                patchInventory.G++;
+            } else {
+                patchInventory.GB++;
             }
         }
-        levelPatchTags += level->getNumFaces();
     }
 }
 
@@ -940,245 +1351,336 @@ void
 PatchTablesFactory::populateAdaptivePatches( TopologyRefiner const & refiner,
                                                 PatchCounters const &   patchInventory,
                                                 PatchTagVector const &  patchTags,
-                                                PatchTables *        tables ) {
+                                                PatchChunkVector const & patchChunks,
+                                                PatchTables *        tables,
+                                                PatchUpdateContext const * update,
+                                                ThreadingType           threading ) {
+
+    //
+    //  Locate the patch arrays of each type once for all the chunks
+    //
+    PatchTypes<PatchTables::PatchArray const *> patchArrays;
+
+    for (Descriptor::iterator it=Descriptor::begin(Descriptor::FEATURE_ADAPTIVE_CATMARK); it!=Descriptor::end(); ++it) {
+        patchArrays.getValue( *it ) = tables->findPatchArray(*it);
+    }
+
+    //
+    //  Now iterate through the faces for all levels and populate the patches -- each chunk
+    //  writes its patches from the offsets computed with the inventory:
+    //
+    if (not patchChunks.empty()) {
+        Vtr::parallelFor((Vtr::ThreadingType)threading, 0, (int)patchChunks.size(), 1,
+            PopulatePatchesKernel(refiner, patchChunks, &patchTags[0], patchArrays, tables, update));
+    }
+
+    //
+    //  Now deal with the "vertex valence" table for Gregory patches -- this table contains the one-ring
+    //  of vertices around each vertex.  Currently it is extremely wasteful for the following reasons:
+    //      - it allocates 2*maxvalence+1 for ALL vertices
+    //      - it initializes the one-ring for ALL vertices of the last level
+    //  We use the full size expected (not sure what else relies on that), but only the vertices of the
+    //  last level are gathered -- along with those of the Gregory patches of lower levels, which
+    //  sparse refinement (see TopologyRefiner::RefineSparse()) does not isolate to the last level.
+    //
+    bool hasGregoryPatches = (patchInventory.G > 0) or (patchInventory.GB > 0);
+    if (hasGregoryPatches) {
+        const int SizePerVertex = 2*tables->_maxValence + 1;
+
+        PatchTables::VertexValenceTable & vTable = tables->_vertexValenceTable;
+        vTable.resize(refiner.GetNumVerticesTotal() * SizePerVertex);
+
+        int levelLast = (int)refiner.getNumLevels() - 1;
+
+        std::vector<int> levelVertOffsets(levelLast + 2, 0);
+        for (int i = 0; i <= levelLast; ++i) {
+            levelVertOffsets[i+1] = levelVertOffsets[i] + refiner.getLevel(i).getNumVertices();
+        }
+        int vOffset = levelVertOffsets[levelLast];
+
+        Vtr::parallelFor((Vtr::ThreadingType)threading, 0,
+            refiner.getLevel(levelLast).getNumVertices(), patchChunkSize,
+                VertexValencesKernel(refiner, levelLast, vOffset, tables, update));
+
+        PatchTables::PatchArray const * gregoryArrays[2] = { patchArrays.G, patchArrays.GB };
+        for (int i = 0; i < 2; ++i) {
+            if (not gregoryArrays[i]) continue;
+
+            unsigned int const * patchVerts = &tables->_patches[gregoryArrays[i]->GetVertIndex()];
+            int numPatchVerts = (int)gregoryArrays[i]->GetNumPatches() * 4;
+            for (int j = 0; j < numPatchVerts; ++j) {
+                int vert = (int)patchVerts[j];
+                if ((vert >= vOffset) or (vTable[vert * SizePerVertex] != 0)) continue;
+
+                int level = (int)(std::upper_bound(levelVertOffsets.begin(), levelVertOffsets.end(), vert) -
+                                  levelVertOffsets.begin()) - 1;
+
+                populateVertexValencesInRange(refiner, level, levelVertOffsets[level],
+                    vert - levelVertOffsets[level], vert - levelVertOffsets[level] + 1, tables, update);
+            }
+        }
+    }
+}
+
+void
+PatchTablesFactory::populateAdaptivePatchesInRange( TopologyRefiner const & refiner,
+                                                       PatchFaceChunk const &  chunk,
+                                                       PatchFaceTag const *    patchTags,
+                                                       PatchTypes<PatchTables::PatchArray const *> const & patchArrays,
+                                                       PatchTables *           tables,
+                                                       PatchUpdateContext const * update ) {
 
     //
-    //  Setup convenience pointers at the beginning of each patch array for each
-    // table (patches, ptex)
+    //  Setup convenience pointers at the first patch of the chunk in each patch array for
+    //  each table (patches, ptex)
     //
     PatchCVPointers    iptrs;
     PatchParamPointers pptrs;
     PatchFVarPointers  fptrs;
 
+    int nchannels = tables->_fvarPatchTables ? refiner.GetNumFVarChannels() : 0;
+
+    //  Previous patch array of each type of patch, and cursor of the chunk in it (see
+    //  PatchUpdateContext)
+    PatchTypes<int> prevArrays,
+                    prevCursors;
+
     for (Descriptor::iterator it=Descriptor::begin(Descriptor::FEATURE_ADAPTIVE_CATMARK); it!=Descriptor::end(); ++it) {
-        PatchTables::PatchArray * pa = tables->findPatchArray(*it);
+        PatchTables::PatchArray const * pa = patchArrays.getValue( *it );
 
         if (not pa) continue;
 
-        iptrs.getValue( *it ) = &tables->_patches[pa->GetVertIndex()];
-        pptrs.getValue( *it ) = &tables->_paramTable[pa->GetPatchIndex()];
+        if (update) {
+            prevArrays.getValue( *it ) = update->findPrevPatchArray( *it );
+            prevCursors.getValue( *it ) = -1;
+        }
+
+        int patchIndex = pa->GetPatchIndex() + chunk.counts.getValue( *it );
+
+        iptrs.getValue( *it ) = &tables->_patches[0] + pa->GetVertIndex() +
+            chunk.counts.getValue( *it ) * pa->GetDescriptor().GetNumControlVertices();
+        pptrs.getValue( *it ) = &tables->_paramTable[0] + patchIndex;
 
-        if (tables->_fvarPatchTables) {
-            int nchannels = refiner.GetNumFVarChannels(),
-                ncvs = pa->GetDescriptor().GetNumFVarControlVertices(); // XXXX manuelk this will break with bi-cubic fvar interp !!!
+        if (nchannels) {
+            int ncvs = pa->GetDescriptor().GetNumFVarControlVertices(); // XXXX manuelk this will break with bi-cubic fvar interp !!!
 
             unsigned int ** fptr = (unsigned int **)alloca(nchannels*sizeof(unsigned int *));
             for (int channel=0; channel<nchannels; ++channel) {
 
                 fptr[channel] = (unsigned int *)&tables->_fvarPatchTables->
-                    _channels[channel].patchVertIndices[pa->GetPatchIndex()*ncvs];
+                    _channels[channel].patchVertIndices[0] + patchIndex*ncvs;
             }
             fptrs.getValue( *it ) = fptr;
         }
     }
 
-    PatchTables::QuadOffsetTable::value_type *quad_G_C0_P = patchInventory.G>0 ? &tables->_quadOffsetTable[0] : 0;
-    PatchTables::QuadOffsetTable::value_type *quad_G_C1_P = patchInventory.GB>0 ? &tables->_quadOffsetTable[patchInventory.G*4] : 0;
+    //  The quad-offsets of the Gregory boundary patches follow those of the Gregory patches
+    int numGregoryPatches = patchArrays.G ? patchArrays.G->GetNumPatches() : 0;
 
-    std::vector<unsigned char> gregoryVertexFlags;
+    PatchTables::QuadOffsetTable::value_type *quad_G_C0_P = patchArrays.G ?
+        &tables->_quadOffsetTable[0] + chunk.counts.G*4 : 0;
+    PatchTables::QuadOffsetTable::value_type *quad_G_C1_P = patchArrays.GB ?
+        &tables->_quadOffsetTable[0] + (numGregoryPatches + chunk.counts.GB)*4 : 0;
 
     //
-    //  To avoid gathering vertex neighborhoods for all vertices, identify vertices involved in
-    //  gregory patches as the faces are traversed, to be gathered later:
+    //  Offsets of the vertices (and face-varying values) of the level of the chunk:
     //
-    bool hasGregoryPatches = (patchInventory.G > 0) or (patchInventory.GB > 0);
-    if (hasGregoryPatches) {
-        gregoryVertexFlags.resize(refiner.GetNumVerticesTotal(), false);
-    }
+    int i = chunk.level;
 
-    //
-    //  Now iterate through the faces for all levels and populate the patches:
-    //
-    int levelFaceOffset = 0;
-    int levelVertOffset = 0;
+    int levelVertOffset = chunk.vertOffset;
     int * levelFVarVertOffsets = 0;
-    if (tables->_fvarPatchTables) {
-         levelFVarVertOffsets = (int *)alloca(refiner.GetNumFVarChannels());
-         memset(levelFVarVertOffsets, 0, refiner.GetNumFVarChannels()*sizeof(int));
+    if (nchannels) {
+        levelFVarVertOffsets = (int *)alloca(nchannels*sizeof(int));
+        for (int channel=0; channel<nchannels; ++channel) {
+            levelFVarVertOffsets[channel] = 0;
+            for (int j = 0; j < i; ++j) {
+                levelFVarVertOffsets[channel] += refiner.GetNumFVarValues(j, channel);
+            }
+        }
     }
 
-    for (int i = 0; i < (int)refiner.getNumLevels(); ++i) {
-        Vtr::Level const * level = &refiner.getLevel(i);
+    Vtr::Level const * level = &refiner.getLevel(i);
 
-        const PatchFaceTag * levelPatchTags = &patchTags[levelFaceOffset];
+    const PatchFaceTag * levelPatchTags = patchTags + chunk.tagOffset;
 
-        for (int faceIndex = 0; faceIndex < level->getNumFaces(); ++faceIndex) {
-            const PatchFaceTag& patchTag = levelPatchTags[faceIndex];
+    for (int faceIndex = chunk.faceBegin; faceIndex < chunk.faceEnd; ++faceIndex) {
+        const PatchFaceTag& patchTag = levelPatchTags[faceIndex];
 
-            if (!patchTag._hasPatch) continue;
+        if (!patchTag._hasPatch) continue;
 
-            if (patchTag._isRegular) {
-                unsigned int   patchVerts[16];
+        if (patchTag._isRegular) {
+            unsigned int   patchVerts[16];
 
-                int tIndex = patchTag._transitionType;
-                int rIndex = patchTag._transitionRot;
-                int bIndex = patchTag._boundaryIndex;
+            int tIndex = patchTag._transitionType;
+            int rIndex = patchTag._transitionRot;
+            int bIndex = patchTag._boundaryIndex;
 
-                if (patchTag._boundaryCount == 0) {
-                    unsigned int const permuteInterior[16] = { 5, 6, 7, 8, 4, 0, 1, 9, 15, 3, 2, 10, 14, 13, 12, 11 };
+            if (patchTag._boundaryCount == 0) {
+                unsigned int const permuteInterior[16] = { 5, 6, 7, 8, 4, 0, 1, 9, 15, 3, 2, 10, 14, 13, 12, 11 };
 
+                PatchParam const * param = pptrs.R[tIndex];
+                pptrs.R[tIndex] = computePatchParam(refiner, i, faceIndex, rIndex, pptrs.R[tIndex]);
+
+                if (not (update and update->carryPatch(prevArrays.R[tIndex],
+                                                       param, iptrs.R[tIndex],
+                                                       prevCursors.R[tIndex]))) {
                     level->gatherQuadRegularInteriorPatchVertices(faceIndex, patchVerts, rIndex);
                     offsetAndPermuteIndices(patchVerts, 16, levelVertOffset, permuteInterior, iptrs.R[tIndex]);
+                }
+                iptrs.R[tIndex] += 16;
 
-                    iptrs.R[tIndex] += 16;
-                    pptrs.R[tIndex] = computePatchParam(refiner, i, faceIndex, rIndex, pptrs.R[tIndex]);
+                if (nchannels) {
+                    gatherFVarPatchVertices(refiner, i, faceIndex, rIndex, levelFVarVertOffsets, fptrs.R[tIndex]);
+                }
+            } else {
+                //  For the boundary and corner cases, the Hbr code makes some adjustments to the
+                //  rotations here from the way they were defined earlier.  That raises questions
+                //  as to the purpose of the earlier assignments and their naming.  I'd prefer to
+                //  label the sets of rotations for their intended purpose, and to compute and
+                //  assign them earlier for use here with no adjustment.
+                //
+                //  Non-transition case:
+                //      rot = 0;  // outside switch
+                //      f->_adaptiveFlags.brots = (f->_adaptiveFlags.rots + 1) % 4;
+                //  Transition case:
+                //      rot = f->_adaptiveFlags.brots;  //  is this now same as transition rots?
+                //
+                //  Both cases of "rot" above are now handled with the "transition rotation" -- still
+                //  not clear what the purpose of the other is.  Need to look into usage of these
+                //  adaptive-flag rotations in:
+                //      getOneRing, computePatchParam, computeFVarData
+                //  It may be that a separate "face rotation" flag is warranted if we need something
+                //  else dependent on the boundary orientation.
+                //
+                if (patchTag._boundaryCount == 1) {
+                    unsigned int const permuteBoundary[12] = { 11, 3, 0, 4, 10, 2, 1, 5, 9, 8, 7, 6 };
+
+                    PatchParam const * param = pptrs.B[tIndex][rIndex];
+                    pptrs.B[tIndex][rIndex] = computePatchParam(refiner, i, faceIndex, bIndex, pptrs.B[tIndex][rIndex]);
+
+                    if (not (update and update->carryPatch(prevArrays.B[tIndex][rIndex],
+                                                           param, iptrs.B[tIndex][rIndex],
+                                                           prevCursors.B[tIndex][rIndex]))) {
+                        level->gatherQuadRegularBoundaryPatchVertices(faceIndex, patchVerts, bIndex);
+                        offsetAndPermuteIndices(patchVerts, 12, levelVertOffset, permuteBoundary, iptrs.B[tIndex][rIndex]);
+                    }
+                    iptrs.B[tIndex][rIndex] += 12;
 
-                    if (tables->_fvarPatchTables) {
-                        gatherFVarPatchVertices(refiner, i, faceIndex, rIndex, levelFVarVertOffsets, fptrs.R[tIndex]);
+                    if (nchannels) {
+                        gatherFVarPatchVertices(refiner, i, faceIndex, bIndex, levelFVarVertOffsets, fptrs.B[tIndex][rIndex]);
                     }
                 } else {
-                    //  For the boundary and corner cases, the Hbr code makes some adjustments to the
-                    //  rotations here from the way they were defined earlier.  That raises questions
-                    //  as to the purpose of the earlier assignments and their naming.  I'd prefer to
-                    //  label the sets of rotations for their intended purpose, and to compute and
-                    //  assign them earlier for use here with no adjustment.
-                    //
-                    //  Non-transition case:
-                    //      rot = 0;  // outside switch
-                    //      f->_adaptiveFlags.brots = (f->_adaptiveFlags.rots + 1) % 4;
-                    //  Transition case:
-                    //      rot = f->_adaptiveFlags.brots;  //  is this now same as transition rots?
-                    //
-                    //  Both cases of "rot" above are now handled with the "transition rotation" -- still
-                    //  not clear what the purpose of the other is.  Need to look into usage of these
-                    //  adaptive-flag rotations in:
-                    //      getOneRing, computePatchParam, computeFVarData
-                    //  It may be that a separate "face rotation" flag is warranted if we need something
-                    //  else dependent on the boundary orientation.
-                    //
-                    if (patchTag._boundaryCount == 1) {
-                        unsigned int const permuteBoundary[12] = { 11, 3, 0, 4, 10, 2, 1, 5, 9, 8, 7, 6 };
+                    unsigned int const permuteCorner[9] = { 8, 3, 0, 7, 2, 1, 6, 5, 4 };
 
-                        level->gatherQuadRegularBoundaryPatchVertices(faceIndex, patchVerts, bIndex);
-                        offsetAndPermuteIndices(patchVerts, 12, levelVertOffset, permuteBoundary, iptrs.B[tIndex][rIndex]);
+                    int cornerIndex = bIndex;
 
-                        iptrs.B[tIndex][rIndex] += 12;
-                        pptrs.B[tIndex][rIndex] = computePatchParam(refiner, i, faceIndex, bIndex, pptrs.B[tIndex][rIndex]);
+                    bIndex = (bIndex+3)%4;
 
-                        if (tables->_fvarPatchTables) {
-                            gatherFVarPatchVertices(refiner, i, faceIndex, bIndex, levelFVarVertOffsets, fptrs.B[tIndex][rIndex]);
-                        }
-                    } else {
-                        unsigned int const permuteCorner[9] = { 8, 3, 0, 7, 2, 1, 6, 5, 4 };
+                    PatchParam const * param = pptrs.C[tIndex][rIndex];
+                    pptrs.C[tIndex][rIndex] = computePatchParam(refiner, i, faceIndex, bIndex, pptrs.C[tIndex][rIndex]);
 
-                        level->gatherQuadRegularCornerPatchVertices(faceIndex, patchVerts, bIndex);
+                    if (not (update and update->carryPatch(prevArrays.C[tIndex][rIndex],
+                                                           param, iptrs.C[tIndex][rIndex],
+                                                           prevCursors.C[tIndex][rIndex]))) {
+                        level->gatherQuadRegularCornerPatchVertices(faceIndex, patchVerts, cornerIndex);
                         offsetAndPermuteIndices(patchVerts, 9, levelVertOffset, permuteCorner, iptrs.C[tIndex][rIndex]);
+                    }
+                    iptrs.C[tIndex][rIndex] += 9;
 
-                        bIndex = (bIndex+3)%4;
-
-                        iptrs.C[tIndex][rIndex] += 9;
-                        pptrs.C[tIndex][rIndex] = computePatchParam(refiner, i, faceIndex, bIndex, pptrs.C[tIndex][rIndex]);
-
-                        if (tables->_fvarPatchTables) {
-                            gatherFVarPatchVertices(refiner, i, faceIndex, bIndex, levelFVarVertOffsets, fptrs.C[tIndex][rIndex]);
-                        }
+                    if (nchannels) {
+                        gatherFVarPatchVertices(refiner, i, faceIndex, bIndex, levelFVarVertOffsets, fptrs.C[tIndex][rIndex]);
                     }
                 }
-            } else {
-                if (patchTag._boundaryCount == 0) {
-                    // Gregory Regular Patch (4 CVs + quad-offsets / valence tables)
-                    Vtr::IndexArray const faceVerts = level->getFaceVertices(faceIndex);
-                    for (int j = 0; j < 4; ++j) {
-                        iptrs.G[j] = faceVerts[j] + levelVertOffset;
-                        gregoryVertexFlags[iptrs.G[j]] = true;
-                    }
-                    iptrs.G += 4;
+            }
+        } else {
+            if (patchTag._boundaryCount == 0) {
+                // Gregory Regular Patch (4 CVs + quad-offsets / valence tables)
+                Vtr::IndexArray const faceVerts = level->getFaceVertices(faceIndex);
+                for (int j = 0; j < 4; ++j) {
+                    iptrs.G[j] = faceVerts[j] + levelVertOffset;
+                }
 
-                    getQuadOffsets(*level, faceIndex, quad_G_C0_P);
-                    quad_G_C0_P += 4;
+                getQuadOffsets(*level, faceIndex, quad_G_C0_P);
+                quad_G_C0_P += 4;
 
-                    pptrs.G = computePatchParam(refiner, i, faceIndex, 0, pptrs.G);
+                PatchParam const * param = pptrs.G;
+                pptrs.G = computePatchParam(refiner, i, faceIndex, 0, pptrs.G);
 
-                    if (tables->_fvarPatchTables) {
-                        gatherFVarPatchVertices(refiner, i, faceIndex, 0, levelFVarVertOffsets, fptrs.G);
-                    }
-                } else {
-                    // Gregory Boundary Patch (4 CVs + quad-offsets / valence tables)
-                    Vtr::IndexArray const faceVerts = level->getFaceVertices(faceIndex);
-                    for (int j = 0; j < 4; ++j) {
-                        iptrs.GB[j] = faceVerts[j] + levelVertOffset;
-                        gregoryVertexFlags[iptrs.GB[j]] = true;
-                    }
-                    iptrs.GB += 4;
+                if (update) {
+                    update->matchGregoryPatch(prevArrays.G, param, iptrs.G, prevCursors.G);
+                }
+                iptrs.G += 4;
 
-                    getQuadOffsets(*level, faceIndex, quad_G_C1_P);
-                    quad_G_C1_P += 4;
+                if (nchannels) {
+                    gatherFVarPatchVertices(refiner, i, faceIndex, 0, levelFVarVertOffsets, fptrs.G);
+                }
+            } else {
+                // Gregory Boundary Patch (4 CVs + quad-offsets / valence tables)
+                Vtr::IndexArray const faceVerts = level->getFaceVertices(faceIndex);
+                for (int j = 0; j < 4; ++j) {
+                    iptrs.GB[j] = faceVerts[j] + levelVertOffset;
+                }
 
-                    int bIndex = (patchTag._boundaryIndex+1)%4;
+                getQuadOffsets(*level, faceIndex, quad_G_C1_P);
+                quad_G_C1_P += 4;
 
-                    pptrs.GB = computePatchParam(refiner, i, faceIndex, bIndex, pptrs.GB);
+                int bIndex = (patchTag._boundaryIndex+1)%4;
 
-                    if (tables->_fvarPatchTables) {
-                        gatherFVarPatchVertices(refiner, i, faceIndex, 0, levelFVarVertOffsets, fptrs.GB);
-                    }
+                PatchParam const * param = pptrs.GB;
+                pptrs.GB = computePatchParam(refiner, i, faceIndex, bIndex, pptrs.GB);
+
+                if (update) {
+                    update->matchGregoryPatch(prevArrays.GB, param, iptrs.GB, prevCursors.GB);
+                }
+                iptrs.GB += 4;
+
+                if (nchannels) {
+                    gatherFVarPatchVertices(refiner, i, faceIndex, 0, levelFVarVertOffsets, fptrs.GB);
                 }
-            }
-        }
-        levelFaceOffset += level->getNumFaces();
-        levelVertOffset += level->getNumVertices();
-        if (tables->_fvarPatchTables) {
-            int nchannels = refiner.GetNumFVarChannels();
-            for (int channel=0; channel<nchannels; ++channel) {
-                levelFVarVertOffsets[channel] += refiner.GetNumFVarValues(i, channel);
             }
         }
     }
+}
 
-    //
-    //  Now deal with the "vertex valence" table for Gregory patches -- this table contains the one-ring
-    //  of vertices around each vertex.  Currently it is extremely wasteful for the following reasons:
-    //      - it allocates 2*maxvalence+1 for ALL vertices
-    //      - it initializes the one-ring for ALL vertices
-    //  We use the full size expected (not sure what else relies on that) but we avoiding initializing
-    //  the vast majority of vertices that are not associated with gregory patches -- by having previously
-    //  marked those that are associated above and skipping all others.
-    //
-    if (hasGregoryPatches) {
-        const int SizePerVertex = 2*tables->_maxValence + 1;
-
-        PatchTables::VertexValenceTable & vTable = tables->_vertexValenceTable;
-        vTable.resize(refiner.GetNumVerticesTotal() * SizePerVertex);
+void
+PatchTablesFactory::populateVertexValencesInRange( TopologyRefiner const & refiner,
+                                                      int levelIndex, int vOffset, int begin, int end,
+                                                      PatchTables * tables,
+                                                      PatchUpdateContext const * update ) {
 
-        int vOffset = 0;
-        int levelLast = (int)refiner.getNumLevels() - 1;
-        for (int i = 0; i <= levelLast; ++i) {
+    Vtr::Level const * level = &refiner.getLevel(levelIndex);
 
-            Vtr::Level const * level = &refiner.getLevel(i);
+    const int SizePerVertex = 2*tables->_maxValence + 1;
 
-            if (i == levelLast) {
+    int vTableOffset = (vOffset + begin) * SizePerVertex;
 
-                int vTableOffset = vOffset * SizePerVertex;
+    for (int vIndex = begin; vIndex < end; ++vIndex) {
+        int* vTableEntry = &tables->_vertexValenceTable[vTableOffset];
 
-                for (int vIndex = 0; vIndex < level->getNumVertices(); ++vIndex) {
-                    int* vTableEntry = &vTable[vTableOffset];
+        if (update and update->carryVertexValence(vOffset + vIndex, vTableEntry)) {
+            vTableOffset += SizePerVertex;
+            continue;
+        }
 
-                    //
-                    //  If not marked as a vertex of a gregory patch, just set to 0 to ignore.  Otherwise
-                    //  gather the one-ring around the vertex and set its resulting size (note the negative
-                    //  size used to distinguish between boundary/interior):
-                    //
-                    //if (!gregoryVertexFlags[vIndex + vOffset]) {
-                        vTableEntry[0] = 0;
-                    //} else {
+        //
+        //  Gather the one-ring around the vertex and set its resulting size (note the negative
+        //  size used to distinguish between boundary/interior):
+        //
+        vTableEntry[0] = 0;
 
-                        int * ringDest = vTableEntry + 1,
-                              ringSize = level->gatherManifoldVertexRingFromIncidentQuads(vIndex, vOffset, ringDest);
+        int * ringDest = vTableEntry + 1,
+              ringSize = level->gatherManifoldVertexRingFromIncidentQuads(vIndex, vOffset, ringDest);
 
-                        if (ringSize & 1) {
-                            // boundary vertex : duplicate boundary vertex index
-                            // and store negative valence.
-                            ringSize++;
-                            vTableEntry[ringSize]=vTableEntry[ringSize-1];
-                            vTableEntry[0] = -ringSize/2;
-                        } else {
-                            vTableEntry[0] = ringSize/2;
-                        }
-                    //}
-                    vTableOffset += SizePerVertex;
-                }
-            }
-            vOffset += level->getNumVertices();
+        if (ringSize & 1) {
+            // boundary vertex : duplicate boundary vertex index
+            // and store negative valence.
+            ringSize++;
+            vTableEntry[ringSize]=vTableEntry[ringSize-1];
+            vTableEntry[0] = -ringSize/2;
+        } else {
+            vTableEntry[0] = ringSize/2;
         }
+        vTableOffset += SizePerVertex;
     }
 }
 
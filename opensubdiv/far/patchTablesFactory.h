@@ -40,6 +40,8 @@ namespace Far {
 class TopologyRefiner;
 template <typename T> struct PatchTypes;
 struct PatchFaceTag;
+struct PatchFaceChunk;
+struct PatchUpdateContext;
 
 
 /// \brief A specialized factory for feature adaptive PatchTables
@@ -55,11 +57,16 @@ public:
 
         Options() : generateAllLevels(false),
                     triangulateQuads(false),
-                    generateFVarTables(false) { }
+                    generateFVarTables(false),
+                    threading(THREADING_SERIAL) { }
 
         int generateAllLevels : 1,  ///< Include levels from 'firstLevel' to 'maxLevel' (Uniform mode only)
             triangulateQuads  : 1,  ///< Triangulate 'QUADS' primitives (Uniform mode only)
             generateFVarTables : 1; ///< Generate face-varying patch tables
+
+        unsigned int threading : 2; ///< threading backend (see ThreadingType,
+                                    ///< adaptive mode only : the tables are
+                                    ///< identical to the serial ones)
     };
 
     /// \brief Factory constructor for PatchTables
@@ -72,6 +79,39 @@ public:
     ///
     static PatchTables * Create(TopologyRefiner const & refiner, Options options=Options());
 
+    /// \brief Updates the PatchTables of a sparsely refined mesh after its
+    ///        refinement was updated with TopologyRefiner::UpdateSparse()
+    ///
+    /// Patches are identified as with Create() and the resulting tables are
+    /// identical, but the patches found in 'prevTables' (same Ptex face and
+    /// parameterization, same type) whose control vertices were all carried
+    /// over by the refiner update are not gathered again : their control
+    /// vertices are remapped instead. The tables are created from scratch
+    /// (see Create()) for uniform refiners, or when 'prevTables' or
+    /// 'vertexOrigins' do not match the refiner.
+    ///
+    /// @param refiner       The updated TopologyRefiner
+    ///
+    /// @param prevTables    PatchTables created for the refiner before its update
+    ///
+    /// @param vertexOrigins Index of the previous vertex of each vertex of the
+    ///                      refiner (or -1), as returned by UpdateSparse()
+    ///
+    /// @param patchOrigins  Returned index of the previous patch of each patch
+    ///                      of the new tables whose limit surface is unchanged
+    ///                      (same control vertices, including the one-rings of
+    ///                      Gregory patches), or -1 for added or modified
+    ///                      patches. The previous patches missing from it were
+    ///                      removed.
+    ///
+    /// @param options       Options controlling the creation of the tables
+    ///
+    /// @return              A new instance of PatchTables
+    ///
+    static PatchTables * Update(TopologyRefiner const & refiner,
+        PatchTables const & prevTables, std::vector<Index> const & vertexOrigins,
+            std::vector<Index> & patchOrigins, Options options=Options());
+
 private:
 
     typedef PatchTables::Descriptor Descriptor;
@@ -79,17 +119,48 @@ private:
 
     static PatchTables * createUniform( TopologyRefiner const & refiner, Options options );
 
-    static PatchTables * createAdaptive( TopologyRefiner const & refiner, Options options );
+    static PatchTables * createAdaptive( TopologyRefiner const & refiner, Options options,
+                                         PatchUpdateContext * update );
 
     //  High-level methods for identifying and populating patches associated with faces:
-    static void identifyAdaptivePatches( TopologyRefiner const &     refiner,
-                                         PatchTypes<int> &           patchInventory,
-                                         std::vector<PatchFaceTag> & patchTags);
-
-    static void populateAdaptivePatches( TopologyRefiner const &           refiner,
-                                         PatchTypes<int> const &           patchInventory,
-                                         std::vector<PatchFaceTag> const & patchTags,
-                                         PatchTables *                  tables);
+    static void identifyAdaptivePatches( TopologyRefiner const &       refiner,
+                                         PatchTypes<int> &             patchInventory,
+                                         std::vector<PatchFaceTag> &   patchTags,
+                                         std::vector<PatchFaceChunk> & patchChunks,
+                                         ThreadingType                 threading);
+
+    static void populateAdaptivePatches( TopologyRefiner const &             refiner,
+                                         PatchTypes<int> const &             patchInventory,
+                                         std::vector<PatchFaceTag> const &   patchTags,
+                                         std::vector<PatchFaceChunk> const & patchChunks,
+                                         PatchTables *                       tables,
+                                         PatchUpdateContext const *          update,
+                                         ThreadingType                       threading);
+
+    //  Identify (resp. populate) the patches of a range of faces of a level
+    static void identifyAdaptivePatchesInRange( TopologyRefiner const & refiner,
+                                                PatchFaceChunk &        chunk,
+                                                PatchFaceTag *          patchTags);
+
+    static void populateAdaptivePatchesInRange( TopologyRefiner const &   refiner,
+                                                PatchFaceChunk const &    chunk,
+                                                PatchFaceTag const *      patchTags,
+                                                PatchTypes<PatchTables::PatchArray const *> const & patchArrays,
+                                                PatchTables *             tables,
+                                                PatchUpdateContext const * update);
+
+    //  Gather the one-rings of a range of vertices of a level in the vertex
+    //  valence table of Gregory patches (remapping the carried one-rings of
+    //  the previous tables of an update)
+    static void populateVertexValencesInRange( TopologyRefiner const & refiner,
+                                               int level, int vertexOffset, int begin, int end,
+                                               PatchTables * tables,
+                                               PatchUpdateContext const * update);
+
+    //  Parallel kernels applying the above to ranges of faces or vertices
+    class IdentifyPatchesKernel;
+    class PopulatePatchesKernel;
+    class VertexValencesKernel;
 
     //  Methods for allocating and managing the patch table data arrays:
     static void allocateTables( PatchTables * tables, int nlevels );
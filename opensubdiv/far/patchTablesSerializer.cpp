@@ -0,0 +1,562 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/patchTablesSerializer.h"
+#include "../far/binaryFile.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using OpenSubdiv::Far::BinaryFile;
+using OpenSubdiv::Far::PatchParam;
+using OpenSubdiv::Far::PatchTables;
+
+//
+// File layout: a fixed size header followed by the patch arrays, the sizes
+// of the face-varying channels, the patch vertices, patch params, vertex
+// valences and quad offsets, and the vertices of each face-varying channel,
+// each aligned on 16 bytes
+//
+char const fileMagic[8] = { 'O', 'S', 'D', 'P', 'A', 'T', 'C', 'H' };
+
+unsigned int const byteOrderTag = 0x01020304,
+                   swappedByteOrderTag = 0x04030201;
+
+struct FileHeader {
+    char         magic[8];
+    unsigned int byteOrder;          // byteOrderTag as written by the writer
+    unsigned int version;
+    int          numPatchArrays,
+                 numPatchVertices,
+                 numPatchParams,
+                 numVertexValences,
+                 numQuadOffsets,
+                 numFVarChannels,
+                 maxValence,
+                 numPtexFaces,
+                 reserved[4];
+};
+
+int const numHeaderWords = (sizeof(FileHeader) - sizeof(fileMagic)) / 4;
+
+// Patch arrays are stored with their descriptor packed in a single word
+struct PatchArrayRecord {
+    unsigned int descriptor,
+                 vertIndex,
+                 patchIndex,
+                 npatches,
+                 quadOffsetIndex;
+};
+
+int const numRecordWords = sizeof(PatchArrayRecord) / 4;
+
+PatchArrayRecord
+encodePatchArray(PatchTables::PatchArray const & parray) {
+
+    PatchTables::Descriptor desc = parray.GetDescriptor();
+
+    PatchArrayRecord record;
+    record.descriptor = (unsigned int)desc.GetType() |
+                        ((unsigned int)desc.GetPattern() << 4) |
+                        ((unsigned int)desc.GetRotation() << 8);
+    record.vertIndex = parray.GetVertIndex();
+    record.patchIndex = parray.GetPatchIndex();
+    record.npatches = parray.GetNumPatches();
+    record.quadOffsetIndex = parray.GetQuadOffsetIndex();
+    return record;
+}
+
+PatchTables::PatchArray
+decodePatchArray(PatchArrayRecord const & record) {
+
+    PatchTables::Descriptor desc(record.descriptor & 0xf,
+        (record.descriptor >> 4) & 0x7, (record.descriptor >> 8) & 0x3);
+
+    return PatchTables::PatchArray(desc, record.vertIndex, record.patchIndex,
+        record.npatches, record.quadOffsetIndex);
+}
+
+struct FileLayout {
+
+    // The offsets of the face-varying channels are only computed if the
+    // sizes of the channels are given
+    FileLayout(FileHeader const & header, int const * fvarSizes) {
+
+        arraysOffset      = align(sizeof(FileHeader));
+        fvarSizesOffset   = align(arraysOffset +
+            header.numPatchArrays*sizeof(PatchArrayRecord));
+        patchesOffset     = align(fvarSizesOffset +
+            header.numFVarChannels*sizeof(int));
+        paramsOffset      = align(patchesOffset +
+            header.numPatchVertices*sizeof(unsigned int));
+        valencesOffset    = align(paramsOffset +
+            header.numPatchParams*sizeof(PatchParam));
+        quadOffsetsOffset = align(valencesOffset +
+            header.numVertexValences*sizeof(int));
+        fileSize          = quadOffsetsOffset +
+            header.numQuadOffsets*sizeof(unsigned int);
+
+        if (fvarSizes) {
+            fvarOffsets.resize(header.numFVarChannels);
+            for (int i=0; i<header.numFVarChannels; ++i) {
+                fvarOffsets[i] = align(fileSize);
+                fileSize = fvarOffsets[i] + fvarSizes[i]*sizeof(unsigned int);
+            }
+        }
+    }
+
+    static size_t align(size_t offset) {
+        return BinaryFile::Align(offset);
+    }
+
+    size_t arraysOffset,
+           fvarSizesOffset,
+           patchesOffset,
+           paramsOffset,
+           valencesOffset,
+           quadOffsetsOffset,
+           fileSize;
+
+    std::vector<size_t> fvarOffsets;
+};
+
+// Returns true if the header is valid (byte-swapping it if needed)
+bool
+validateHeader(FileHeader & header, bool * swapped) {
+
+    if (memcmp(header.magic, fileMagic, sizeof(fileMagic))!=0) {
+        return false;
+    }
+
+    *swapped = (header.byteOrder==swappedByteOrderTag);
+    if (*swapped) {
+        BinaryFile::SwapBytes(&header.byteOrder, numHeaderWords);
+    }
+
+    return header.byteOrder==byteOrderTag and
+           header.version==OpenSubdiv::Far::PatchTablesSerializer::FORMAT_VERSION and
+           header.numPatchArrays>=0 and header.numPatchVertices>=0 and
+           header.numPatchParams>=0 and header.numVertexValences>=0 and
+           header.numQuadOffsets>=0 and header.numFVarChannels>=0;
+}
+
+// Returns true if the patch arrays have valid descriptors and only reference
+// patch vertices, patch params and quad offsets of the tables
+bool
+validatePatchArrays(PatchArrayRecord const * records, FileHeader const & header) {
+
+    typedef unsigned long long Size;
+
+    std::vector<PatchTables::Descriptor> const & descs =
+        PatchTables::Descriptor::GetAllValidDescriptors();
+
+    for (int i=0; i<header.numPatchArrays; ++i) {
+
+        PatchArrayRecord const & record = records[i];
+
+        PatchTables::Descriptor desc = decodePatchArray(record).GetDescriptor();
+        if (std::find(descs.begin(), descs.end(), desc)==descs.end() or
+            desc.GetNumControlVertices()<=0) {
+            return false;
+        }
+
+        Size npatches = record.npatches;
+        if (record.vertIndex + npatches*desc.GetNumControlVertices() >
+                (Size)header.numPatchVertices or
+            record.patchIndex + npatches > (Size)header.numPatchParams) {
+            return false;
+        }
+
+        // only the Gregory patches have quad offsets
+        PatchTables::Type type = desc.GetType();
+        if ((type==PatchTables::GREGORY or type==PatchTables::GREGORY_BOUNDARY) and
+            record.quadOffsetIndex + 4*npatches > (Size)header.numQuadOffsets) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+validateFVarSizes(int const * sizes, int nchannels) {
+
+    for (int i=0; i<nchannels; ++i) {
+        if (sizes[i]<0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // end namespace unnamed
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+bool
+PatchTablesSerializer::Write(PatchTables const & tables,
+    char const * filename) {
+
+    assert(sizeof(PatchParam)==2*sizeof(unsigned int));
+
+    PatchTables::PatchArrayVector const & parrays = tables._patchArrays;
+
+    std::vector<PatchArrayRecord> records(parrays.size());
+    for (int i=0; i<(int)parrays.size(); ++i) {
+        records[i] = encodePatchArray(parrays[i]);
+    }
+
+    PatchTables::FVarPatchTables const * fvarTables = tables._fvarPatchTables;
+
+    int nchannels = fvarTables ? fvarTables->GetNumChannels() : 0;
+
+    std::vector<int> fvarSizes(nchannels);
+    for (int i=0; i<nchannels; ++i) {
+        fvarSizes[i] = (int)fvarTables->GetPatchVertices(i).size();
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(FileHeader));
+    memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.byteOrder = byteOrderTag;
+    header.version = FORMAT_VERSION;
+    header.numPatchArrays = (int)records.size();
+    header.numPatchVertices = (int)tables._patches.size();
+    header.numPatchParams = (int)tables._paramTable.size();
+    header.numVertexValences = (int)tables._vertexValenceTable.size();
+    header.numQuadOffsets = (int)tables._quadOffsetTable.size();
+    header.numFVarChannels = nchannels;
+    header.maxValence = tables._maxValence;
+    header.numPtexFaces = tables._numPtexFaces;
+
+    FileLayout layout(header, nchannels ? &fvarSizes[0] : 0);
+
+    FILE * fp = fopen(filename, "wb");
+    if (not fp) {
+        return false;
+    }
+
+    bool success =
+        BinaryFile::WritePadded(fp, &header, sizeof(FileHeader),
+            layout.arraysOffset) and
+        BinaryFile::WritePadded(fp, records.empty() ? 0 : &records[0],
+            records.size()*sizeof(PatchArrayRecord),
+            layout.fvarSizesOffset-layout.arraysOffset) and
+        BinaryFile::WritePadded(fp, nchannels ? &fvarSizes[0] : 0,
+            nchannels*sizeof(int),
+            layout.patchesOffset-layout.fvarSizesOffset) and
+        BinaryFile::WritePadded(fp,
+            header.numPatchVertices ? &tables._patches[0] : 0,
+            header.numPatchVertices*sizeof(unsigned int),
+            layout.paramsOffset-layout.patchesOffset) and
+        BinaryFile::WritePadded(fp,
+            header.numPatchParams ? &tables._paramTable[0] : 0,
+            header.numPatchParams*sizeof(PatchParam),
+            layout.valencesOffset-layout.paramsOffset) and
+        BinaryFile::WritePadded(fp,
+            header.numVertexValences ? &tables._vertexValenceTable[0] : 0,
+            header.numVertexValences*sizeof(int),
+            layout.quadOffsetsOffset-layout.valencesOffset);
+
+    // The quad offsets and each face-varying channel are padded up to the
+    // start of the next channel
+    size_t end = layout.quadOffsetsOffset +
+        header.numQuadOffsets*sizeof(unsigned int);
+    success = success and
+        BinaryFile::WritePadded(fp,
+            header.numQuadOffsets ? &tables._quadOffsetTable[0] : 0,
+            header.numQuadOffsets*sizeof(unsigned int),
+            (nchannels ? layout.fvarOffsets[0] : end)-layout.quadOffsetsOffset);
+
+    for (int i=0; success and i<nchannels; ++i) {
+        std::vector<unsigned int> const & verts = fvarTables->GetPatchVertices(i);
+        end = layout.fvarOffsets[i] + verts.size()*sizeof(unsigned int);
+        success = BinaryFile::WritePadded(fp, verts.empty() ? 0 : &verts[0],
+            verts.size()*sizeof(unsigned int),
+            (i+1<nchannels ? layout.fvarOffsets[i+1] : end)-layout.fvarOffsets[i]);
+    }
+
+    return (fclose(fp)==0) and success;
+}
+
+PatchTables const *
+PatchTablesSerializer::Read(char const * filename) {
+
+    FILE * fp = fopen(filename, "rb");
+    if (not fp) {
+        return 0;
+    }
+
+    FileHeader header;
+    bool swapped = false;
+    if (fread(&header, sizeof(FileHeader), 1, fp)!=1 or
+        not validateHeader(header, &swapped)) {
+        fclose(fp);
+        return 0;
+    }
+
+    int narrays = header.numPatchArrays,
+        nchannels = header.numFVarChannels;
+
+    // Make sure the file holds the tables declared by the header before
+    // allocating them (a truncated or corrupt header would otherwise trigger
+    // arbitrarily large allocations) : the face-varying channels are checked
+    // once their sizes are known
+    FileLayout arraysLayout(header, 0);
+
+    size_t fileSize = BinaryFile::GetSize(fp);
+    if (fileSize<arraysLayout.fileSize) {
+        fclose(fp);
+        return 0;
+    }
+
+    // Read the patch arrays and the sizes of the face-varying channels first
+    // to locate the channels in the file
+    std::vector<PatchArrayRecord> records(narrays);
+    std::vector<int> fvarSizes(nchannels);
+
+    bool success =
+        BinaryFile::ReadAt(fp, arraysLayout.arraysOffset,
+            narrays ? &records[0] : 0, narrays*sizeof(PatchArrayRecord)) and
+        BinaryFile::ReadAt(fp, arraysLayout.fvarSizesOffset,
+            nchannels ? &fvarSizes[0] : 0, nchannels*sizeof(int));
+
+    if (success and swapped) {
+        if (narrays) {
+            BinaryFile::SwapBytes(&records[0], narrays*numRecordWords);
+        }
+        if (nchannels) {
+            BinaryFile::SwapBytes(&fvarSizes[0], nchannels);
+        }
+    }
+
+    if (not success or
+        not validatePatchArrays(narrays ? &records[0] : 0, header) or
+        not validateFVarSizes(nchannels ? &fvarSizes[0] : 0, nchannels)) {
+        fclose(fp);
+        return 0;
+    }
+
+    FileLayout layout(header, nchannels ? &fvarSizes[0] : 0);
+    if (fileSize<layout.fileSize) {
+        fclose(fp);
+        return 0;
+    }
+
+    PatchTables * result = new PatchTables(header.maxValence);
+    result->_numPtexFaces = header.numPtexFaces;
+
+    result->_patchArrays.reserve(narrays);
+    for (int i=0; i<narrays; ++i) {
+        result->_patchArrays.push_back(decodePatchArray(records[i]));
+    }
+
+    result->_patches.resize(header.numPatchVertices);
+    result->_paramTable.resize(header.numPatchParams);
+    result->_vertexValenceTable.resize(header.numVertexValences);
+    result->_quadOffsetTable.resize(header.numQuadOffsets);
+
+    success =
+        BinaryFile::ReadAt(fp, layout.patchesOffset,
+            header.numPatchVertices ? &result->_patches[0] : 0,
+            header.numPatchVertices*sizeof(unsigned int)) and
+        BinaryFile::ReadAt(fp, layout.paramsOffset,
+            header.numPatchParams ? &result->_paramTable[0] : 0,
+            header.numPatchParams*sizeof(PatchParam)) and
+        BinaryFile::ReadAt(fp, layout.valencesOffset,
+            header.numVertexValences ? &result->_vertexValenceTable[0] : 0,
+            header.numVertexValences*sizeof(int)) and
+        BinaryFile::ReadAt(fp, layout.quadOffsetsOffset,
+            header.numQuadOffsets ? &result->_quadOffsetTable[0] : 0,
+            header.numQuadOffsets*sizeof(unsigned int));
+
+    PatchTables::FVarPatchTables * fvarTables = 0;
+    if (nchannels) {
+        fvarTables = new PatchTables::FVarPatchTables;
+        fvarTables->_channels.resize(nchannels);
+        result->_fvarPatchTables = fvarTables;
+    }
+    for (int i=0; success and i<nchannels; ++i) {
+        std::vector<unsigned int> & verts =
+            fvarTables->_channels[i].patchVertIndices;
+        verts.resize(fvarSizes[i]);
+        success = BinaryFile::ReadAt(fp, layout.fvarOffsets[i],
+            verts.empty() ? 0 : &verts[0], verts.size()*sizeof(unsigned int));
+    }
+    fclose(fp);
+
+    if (not success) {
+        delete result;
+        return 0;
+    }
+
+    if (swapped) {
+        if (header.numPatchVertices) {
+            BinaryFile::SwapBytes(&result->_patches[0], header.numPatchVertices);
+        }
+        if (header.numPatchParams) {
+            BinaryFile::SwapBytes(&result->_paramTable[0], 2*header.numPatchParams);
+        }
+        if (header.numVertexValences) {
+            BinaryFile::SwapBytes(&result->_vertexValenceTable[0],
+                header.numVertexValences);
+        }
+        if (header.numQuadOffsets) {
+            BinaryFile::SwapBytes(&result->_quadOffsetTable[0],
+                header.numQuadOffsets);
+        }
+        for (int i=0; i<nchannels; ++i) {
+            std::vector<unsigned int> & verts =
+                fvarTables->_channels[i].patchVertIndices;
+            if (not verts.empty()) {
+                BinaryFile::SwapBytes(&verts[0], (int)verts.size());
+            }
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+
+MappedPatchTables::MappedPatchTables() :
+    _mapping(0), _maxValence(0), _numPtexFaces(0) {
+}
+
+MappedPatchTables::~MappedPatchTables() {
+    delete _mapping;
+}
+
+MappedPatchTables const *
+MappedPatchTables::Open(char const * filename) {
+
+    FileMapping * mapping = FileMapping::Open(filename);
+    if (not mapping) {
+        return 0;
+    }
+
+    // Validate the header (the byte order must be the host's to use the
+    // tables in place) and the size of the file
+    FileHeader header;
+    bool swapped = false;
+    if (mapping->GetSize()<sizeof(FileHeader)) {
+        delete mapping;
+        return 0;
+    }
+    memcpy(&header, mapping->GetData(), sizeof(FileHeader));
+    if (not validateHeader(header, &swapped) or swapped) {
+        delete mapping;
+        return 0;
+    }
+
+    unsigned char const * data = mapping->GetData();
+
+    int narrays = header.numPatchArrays,
+        nchannels = header.numFVarChannels;
+
+    FileLayout arraysLayout(header, 0);
+
+    PatchArrayRecord const * records =
+        (PatchArrayRecord const *)(data + arraysLayout.arraysOffset);
+    int const * fvarSizes = (int const *)(data + arraysLayout.fvarSizesOffset);
+    if (mapping->GetSize()<arraysLayout.patchesOffset or
+        not validatePatchArrays(records, header) or
+        not validateFVarSizes(fvarSizes, nchannels)) {
+        delete mapping;
+        return 0;
+    }
+
+    FileLayout layout(header, fvarSizes);
+    if (mapping->GetSize()<layout.fileSize) {
+        delete mapping;
+        return 0;
+    }
+
+    MappedPatchTables * result = new MappedPatchTables;
+    result->_mapping = mapping;
+    result->_maxValence = header.maxValence;
+    result->_numPtexFaces = header.numPtexFaces;
+
+    result->_patchArrays.reserve(narrays);
+    for (int i=0; i<narrays; ++i) {
+        result->_patchArrays.push_back(decodePatchArray(records[i]));
+    }
+
+    result->_patches = PTable(
+        (unsigned int const *)(data + layout.patchesOffset),
+        header.numPatchVertices);
+    result->_paramTable = PatchParamTable(
+        (PatchParam const *)(data + layout.paramsOffset),
+        header.numPatchParams);
+    result->_vertexValenceTable = VertexValenceTable(
+        (int const *)(data + layout.valencesOffset),
+        header.numVertexValences);
+    result->_quadOffsetTable = QuadOffsetTable(
+        (unsigned int const *)(data + layout.quadOffsetsOffset),
+        header.numQuadOffsets);
+
+    result->_fvarChannels.resize(nchannels);
+    for (int i=0; i<nchannels; ++i) {
+        result->_fvarChannels[i] = ConstArray<unsigned int>(
+            (unsigned int const *)(data + layout.fvarOffsets[i]), fvarSizes[i]);
+    }
+    return result;
+}
+
+int
+MappedPatchTables::GetNumPatches() const {
+
+    int result=0;
+    for (int i=0; i<(int)_patchArrays.size(); ++i) {
+        result += _patchArrays[i].GetNumPatches();
+    }
+    return result;
+}
+
+bool
+MappedPatchTables::IsFeatureAdaptive() const {
+
+    // same test as PatchTables::IsFeatureAdaptive()
+    if (not _vertexValenceTable.empty())
+        return true;
+
+    for (int i=0; i<(int)_patchArrays.size(); ++i) {
+
+        PatchTables::Type type = _patchArrays[i].GetDescriptor().GetType();
+        if (type >= PatchTables::REGULAR and type <= PatchTables::GREGORY_BOUNDARY)
+            return true;
+    }
+    return false;
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
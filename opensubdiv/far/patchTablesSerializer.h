@@ -0,0 +1,210 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_PATCHTABLES_SERIALIZER_H
+#define FAR_PATCHTABLES_SERIALIZER_H
+
+#include "../version.h"
+
+#include "../far/patchTables.h"
+
+#include <vector>
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+class FileMapping;
+
+/// \brief Binary serialization of PatchTables
+///
+/// The tables are stored as a small header followed by the patch arrays and
+/// the raw tables of patch vertices, patch params, Gregory vertex valences
+/// and quad offsets, and face-varying patch vertices. As with
+/// StencilTablesSerializer, the header records a format version and the byte
+/// order of the writer, and each table starts on a 16 bytes boundary of the
+/// file so that it can be used in place (see MappedPatchTables).
+///
+class PatchTablesSerializer {
+
+public:
+
+    /// \brief Version of the binary format written
+    enum { FORMAT_VERSION = 1 };
+
+    /// \brief Writes the tables to a binary file
+    ///
+    /// @param tables    The tables to serialize
+    ///
+    /// @param filename  Path of the file to (over)write
+    ///
+    /// @return          False if the file could not be written
+    ///
+    static bool Write(PatchTables const & tables, char const * filename);
+
+    /// \brief Reads tables from a binary file into a new PatchTables
+    ///
+    /// @param filename  Path of the file to read
+    ///
+    /// @return          The tables or 0 if the file could not be read or is
+    ///                  not a valid patch tables file
+    ///
+    static PatchTables const * Read(char const * filename);
+};
+
+/// \brief Read-only array of elements stored in a MappedPatchTables
+///
+/// Exposes the subset of the std::vector interface used by the consumers of
+/// the PatchTables, so that code templated on the tables (such as the Osd
+/// draw contexts) accepts both.
+///
+template <class T> class ConstArray {
+
+public:
+
+    typedef T value_type;
+
+    ConstArray(T const * data=0, int size=0) : _data(data), _size(size) { }
+
+    int size() const { return _size; }
+
+    bool empty() const { return _size==0; }
+
+    T const & operator[](int i) const { return _data[i]; }
+
+    T const * begin() const { return _data; }
+
+    T const * end() const { return _data + _size; }
+
+private:
+
+    T const * _data;
+    int       _size;
+};
+
+/// \brief Read-only PatchTables mapped in memory from a binary file
+///
+/// The tables are used in place from the mapped file: only the (few) patch
+/// array descriptors are decoded when the file is opened. The accessors
+/// mirror those of PatchTables.
+///
+class MappedPatchTables {
+
+public:
+
+    typedef ConstArray<unsigned int> PTable;
+    typedef ConstArray<int>          VertexValenceTable;
+    typedef ConstArray<unsigned int> QuadOffsetTable;
+    typedef ConstArray<PatchParam>   PatchParamTable;
+
+    /// \brief Maps the tables written by PatchTablesSerializer::Write()
+    ///
+    /// @param filename  Path of the file to map
+    ///
+    /// @return          The mapped tables or 0 if the file could not be
+    ///                  mapped, is not a valid patch tables file or was
+    ///                  written with a different byte order
+    ///
+    static MappedPatchTables const * Open(char const * filename);
+
+    /// \brief Destructor (unmaps the file)
+    ~MappedPatchTables();
+
+    /// \brief Returns all arrays of patches
+    PatchTables::PatchArrayVector const & GetPatchArrayVector() const {
+        return _patchArrays;
+    }
+
+    /// \brief Get the table of patch control vertices
+    PTable GetPatchTable() const { return _patches; }
+
+    /// \brief Returns a vertex valence table used by Gregory patches
+    VertexValenceTable GetVertexValenceTable() const { return _vertexValenceTable; }
+
+    /// \brief Returns a quad offsets table used by Gregory patches
+    QuadOffsetTable GetQuadOffsetTable() const { return _quadOffsetTable; }
+
+    /// \brief Returns a PatchParamTable for each type of patch
+    PatchParamTable GetPatchParamTable() const { return _paramTable; }
+
+    /// \brief Returns the total number of patches stored in the tables
+    int GetNumPatches() const;
+
+    /// \brief Returns the total number of control vertex indices in the tables
+    int GetNumControlVertices() const { return _patches.size(); }
+
+    /// \brief Returns max vertex valence
+    int GetMaxValence() const { return _maxValence; }
+
+    /// \brief True if the patches are of feature adaptive types
+    bool IsFeatureAdaptive() const;
+
+    /// \brief Returns the total number of ptex faces in the mesh
+    int GetNumPtexFaces() const { return _numPtexFaces; }
+
+    /// \brief Returns the number of face-varying primvar channels
+    int GetNumFVarChannels() const { return (int)_fvarChannels.size(); }
+
+    /// \brief Returns the face-varying patches vertex indices
+    ///
+    /// @param channel  Then face-varying primvar channel index
+    ///
+    ConstArray<unsigned int> GetFVarPatchVertices(int channel) const {
+        return _fvarChannels[channel];
+    }
+
+private:
+
+    MappedPatchTables();
+
+    // Non-copyable (owns the mapping)
+    MappedPatchTables(MappedPatchTables const &);
+    MappedPatchTables & operator=(MappedPatchTables const &);
+
+private:
+
+    FileMapping * _mapping;  // the mapped file
+
+    PatchTables::PatchArrayVector _patchArrays; // decoded from the file
+
+    PTable             _patches;            // tables within the mapped file
+    VertexValenceTable _vertexValenceTable;
+    QuadOffsetTable    _quadOffsetTable;
+    PatchParamTable    _paramTable;
+
+    std::vector<ConstArray<unsigned int> > _fvarChannels;
+
+    int _maxValence,
+        _numPtexFaces;
+};
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // FAR_PATCHTABLES_SERIALIZER_H
@@ -27,6 +27,7 @@
 
 #include "../version.h"
 
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -35,6 +36,8 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Far {
 
+template <class INDEX, class WEIGHT> class CompactStencilTables;
+
 /// \brief Vertex stencil descriptor
 ///
 /// Allows access and manipulation of a single stencil in a StencilTables.
@@ -147,6 +150,77 @@ public:
         return _weights;
     }
 
+    /// \brief Returns the number of leading control vertices of each stencil
+    ///        that also have a varying weight (fused tables only, see
+    ///        StencilTablesFactory::CreateFused())
+    ///
+    /// The stencils of fused tables interpolate both vertex and varying
+    /// primvar data : the first GetVaryingSizes()[i] control vertices of
+    /// stencil 'i' are also blended with varying weights.
+    ///
+    std::vector<unsigned char> const & GetVaryingSizes() const {
+        return _varyingSizes;
+    }
+
+    /// \brief Returns the offset to the varying weights of each stencil
+    ///        (fused tables only)
+    std::vector<int> const & GetVaryingOffsets() const {
+        return _varyingOffsets;
+    }
+
+    /// \brief Returns the varying interpolation weights (fused tables only)
+    std::vector<float> const & GetVaryingWeights() const {
+        return _varyingWeights;
+    }
+
+    /// \brief Returns the offset to the dependent stencils of each control
+    ///        vertex, followed by their total number (factory may leave empty)
+    std::vector<int> const & GetDependentOffsets() const {
+        return _dependentOffsets;
+    }
+
+    /// \brief Returns the stencils depending on each control vertex, in
+    ///        increasing order (factory may leave empty)
+    std::vector<int> const & GetDependentStencils() const {
+        return _dependentStencils;
+    }
+
+    /// \brief Returns the stencils depending on a set of control vertices
+    ///
+    /// Only these stencils need to be updated after editing the control
+    /// vertices. All the stencils are returned if the factory did not
+    /// generate the dependent stencils.
+    ///
+    /// @param controlVertices     Indices of the control vertices
+    ///
+    /// @param numControlVertices  Number of control vertices
+    ///
+    /// @param ranges              Returns the disjoint ranges of stencils
+    ///                            ([start, end) pairs), in increasing order
+    ///
+    void GetDependentStencilRanges(int const * controlVertices,
+        int numControlVertices, std::vector<int> & ranges) const;
+
+    /// \brief Returns the stencils of the vertices that are not carried over
+    ///        by an incremental refinement (see StencilTablesFactory::Update())
+    ///
+    /// Only these stencils need to be applied once the vertex data of the
+    /// other vertices has been copied from the previous buffers.
+    ///
+    /// @param vertexOrigins  The origins of the vertices returned by
+    ///                       TopologyRefiner::UpdateSparse()
+    ///
+    /// @param ranges         Returns the disjoint ranges of stencils
+    ///                       ([start, end) pairs), in increasing order
+    ///
+    /// @param start          (skip to )index of first stencil to search
+    ///
+    /// @param end            index of last stencil to search
+    ///                       (default = -1 : all the remaining stencils)
+    ///
+    void GetUpdatedStencilRanges(std::vector<int> const & vertexOrigins,
+        std::vector<int> & ranges, int start=0, int end=-1) const;
+
     /// \brief Updates point values based on the control values
     ///
     /// \note The destination buffers ('uderivs' & 'vderivs') are assumed to
@@ -167,15 +241,43 @@ public:
         _Update(controlValues, values, _weights, start, end);
     }
 
-private:
+    /// \brief Updates varying point values based on the control values
+    ///        (fused tables only, see GetVaryingSizes())
+    ///
+    /// @param controlValues  Buffer with varying primvar data for the control
+    ///                       vertices
+    ///
+    /// @param values         Destination buffer for the interpolated varying
+    ///                       primvar data
+    ///
+    /// @param start          (skip to )index of first value to update
+    ///
+    /// @param end            Index of last value to update
+    ///
+    template <class T>
+    void UpdateVaryingValues(T const *controlValues, T *values, int start=-1, int end=-1) const;
+
+protected:
 
     // Update values by appling cached stencil weights to new control values
     template <class T> void _Update( T const *controlValues, T *values,
         std::vector<float> const & valueWeights, int start, int end) const;
 
+    // Update values from raw tables (shared with MappedStencilTables and
+    // CompactStencilTables)
+    template <class T, class INDEX, class WEIGHT> static void _UpdateTables(
+        T const *controlValues, T *values, unsigned char const * sizes,
+            int const * offsets, INDEX const * indices, WEIGHT const * weights,
+                int numStencils, int start, int end);
+
 private:
 
     friend class StencilTablesFactory;
+    friend class LimitStencilTablesFactory;
+    friend class LimitStencilTables;
+    friend class StencilTablesSerializer;
+    friend class MappedStencilTables;
+    template <class INDEX, class WEIGHT> friend class CompactStencilTables;
 
     int _numControlVertices;              // number of control vertices
 
@@ -183,6 +285,13 @@ private:
     std::vector<int>           _offsets,  // offset to the start of each stencil
                                _indices;  // indices of contributing coarse vertices
     std::vector<float>         _weights;  // stencil weight coefficients
+
+    std::vector<unsigned char> _varyingSizes;   // number of varying coefficients for each stencil (fused tables)
+    std::vector<int>           _varyingOffsets; // offset to the varying coefficients of each stencil
+    std::vector<float>         _varyingWeights; // varying weight coefficients
+
+    std::vector<int>           _dependentOffsets,  // offset to the dependent stencils of each control vertex
+                               _dependentStencils; // stencils depending on each control vertex
 };
 
 
@@ -281,30 +390,171 @@ public:
         _Update(controlValues, vderivs, _dvWeights, start, end);
     }
 
+    /// \brief Updates point and derivative values based on the control values
+    ///
+    /// Equivalent to UpdateValues() followed by UpdateDerivs(), but the
+    /// stencil indices are traversed (and the control values gathered) only
+    /// once.
+    ///
+    /// \note The destination buffers are assumed to have allocated at least
+    ///       \c GetNumStencils() elements.
+    ///
+    /// @param controlValues  Buffer with primvar data for the control vertices
+    ///
+    /// @param values         Destination buffer for the interpolated primvar
+    ///                       data
+    ///
+    /// @param uderivs        Destination buffer for the interpolated 'u'
+    ///                       derivative primvar data
+    ///
+    /// @param vderivs        Destination buffer for the interpolated 'v'
+    ///                       derivative primvar data
+    ///
+    /// @param start          (skip to )index of first value to update
+    ///
+    /// @param end            Index of last value to update
+    ///
+    template <class T>
+    void UpdateValuesAndDerivs(T const *controlValues, T *values,
+        T *uderivs, T *vderivs, int start=-1, int end=-1) const;
+
 
 private:
+
+    friend class LimitStencilTablesFactory;
+
     std::vector<float>  _duWeights,  // u derivative limit stencil weights
                         _dvWeights;  // v derivative limit stencil weights
 };
 
 
+// Returns the stencils depending on a set of control vertices
+inline void
+StencilTables::GetDependentStencilRanges(int const * controlVertices,
+    int numControlVertices, std::vector<int> & ranges) const {
+
+    ranges.clear();
+
+    if (_dependentOffsets.empty()) {
+        if (GetNumStencils()>0) {
+            ranges.push_back(0);
+            ranges.push_back(GetNumStencils());
+        }
+        return;
+    }
+
+    // gather the (sorted) lists of stencils of the control vertices
+    std::vector<int> stencils, bounds(1, 0);
+    for (int i=0; i<numControlVertices; ++i) {
+        int vert = controlVertices[i];
+        assert(vert>=0 and vert<_numControlVertices);
+        stencils.insert(stencils.end(),
+            _dependentStencils.begin() + _dependentOffsets[vert],
+            _dependentStencils.begin() + _dependentOffsets[vert+1]);
+        bounds.push_back((int)stencils.size());
+    }
+
+    // merge the lists pairwise
+    while (bounds.size()>2) {
+        int n = 0;
+        for (int i=0; i+2<(int)bounds.size(); i+=2) {
+            std::inplace_merge(stencils.begin() + bounds[i],
+                stencils.begin() + bounds[i+1], stencils.begin() + bounds[i+2]);
+            bounds[++n] = bounds[i+2];
+        }
+        if (bounds.size()%2==0) {
+            // odd number of lists : the last one is merged in the next pass
+            bounds[++n] = bounds.back();
+        }
+        bounds.resize(n+1);
+    }
+
+    // coalesce consecutive stencils (duplicates included)
+    for (int i=0; i<(int)stencils.size(); ++i) {
+        if (ranges.empty() or stencils[i] > ranges.back()) {
+            ranges.push_back(stencils[i]);
+            ranges.push_back(stencils[i]+1);
+        } else if (stencils[i]==ranges.back()) {
+            ++ranges.back();
+        }
+    }
+}
+
+// Returns the stencils of the vertices not carried over by an update
+inline void
+StencilTables::GetUpdatedStencilRanges(std::vector<int> const & vertexOrigins,
+    std::vector<int> & ranges, int start, int end) const {
+
+    ranges.clear();
+
+    if (end<start or end<0) {
+        end = GetNumStencils();
+    }
+    start = std::max(0, start);
+    end = std::min(end, GetNumStencils());
+
+    for (int i=start, vert=_numControlVertices+start; i<end; ++i, ++vert) {
+        if (vert<(int)vertexOrigins.size() and vertexOrigins[vert]>=0) {
+            continue;
+        }
+        if (ranges.empty() or i > ranges.back()) {
+            ranges.push_back(i);
+            ranges.push_back(i+1);
+        } else {
+            ++ranges.back();
+        }
+    }
+}
+
+// Update varying values by appling the varying weights of fused tables
+template <class T> void
+StencilTables::UpdateVaryingValues(T const *controlValues, T *values,
+    int start, int end) const {
+
+    assert(not _varyingSizes.empty());
+
+    if (end<start or end<0) {
+        end = GetNumStencils();
+    }
+
+    for (int i=std::max(0, start); i<end; ++i) {
+
+        int const * indices = &_indices[_offsets[i]];
+        float const * weights = &_varyingWeights[_varyingOffsets[i]];
+
+        values[i].Clear();
+        for (int j=0; j<_varyingSizes[i]; ++j) {
+            values[i].AddWithWeight(controlValues[indices[j]], weights[j]);
+        }
+    }
+}
+
 // Update values by appling cached stencil weights to new control values
 template <class T> void
 StencilTables::_Update(T const *controlValues, T *values,
     std::vector<float> const &valueWeights, int start, int end) const {
 
-    int const * indices = &_indices.at(0);
-    float const * weights = &valueWeights.at(0);
+    _UpdateTables(controlValues, values, &_sizes.at(0),
+        _offsets.empty() ? 0 : &_offsets[0], &_indices.at(0),
+            &valueWeights.at(0), GetNumStencils(), start, end);
+}
+
+// Update values from raw tables (weights are accumulated as floats)
+template <class T, class INDEX, class WEIGHT> void
+StencilTables::_UpdateTables(T const *controlValues, T *values,
+    unsigned char const * sizes, int const * offsets, INDEX const * indices,
+        WEIGHT const * weights, int numStencils, int start, int end) {
 
     if (start>0) {
-        assert(start<(int)_offsets.size());
-        indices += _offsets[start];
-        weights += _offsets[start];
+        assert(offsets and start<numStencils);
+        sizes += start;
+        indices += offsets[start];
+        weights += offsets[start];
         values += start;
     }
 
     if (end<start or end<0) {
-        end = GetNumStencils();
+        end = numStencils;
     }
 
     int nstencils = end - std::max(0, start);
@@ -314,12 +564,61 @@ StencilTables::_Update(T const *controlValues, T *values,
         values[i].Clear();
 
         // For each element in the array, add the coefs contribution
-        for (int j=0; j<_sizes[i]; ++j, ++indices, ++weights) {
-            values[i].AddWithWeight( controlValues[*indices], *weights );
+        for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
+            values[i].AddWithWeight( controlValues[*indices], (float)*weights );
         }
     }
 }
 
+// Update values and derivatives in a single traversal of the stencils
+template <class T> void
+LimitStencilTables::UpdateValuesAndDerivs(T const *controlValues, T *values,
+    T *uderivs, T *vderivs, int start, int end) const {
+
+    unsigned char const * sizes = &_sizes.at(0);
+    int const * indices = &_indices.at(0);
+    float const * weights = &_weights.at(0),
+                * duWeights = &_duWeights.at(0),
+                * dvWeights = &_dvWeights.at(0);
+
+    if (start>0) {
+        assert(not _offsets.empty() and start<GetNumStencils());
+        int offset = _offsets[start];
+        sizes += start;
+        indices += offset;
+        weights += offset;
+        duWeights += offset;
+        dvWeights += offset;
+        values += start;
+        uderivs += start;
+        vderivs += start;
+    }
+
+    if (end<start or end<0) {
+        end = GetNumStencils();
+    }
+
+    int nstencils = end - std::max(0, start);
+    for (int i=0; i<nstencils; ++i) {
+
+        values[i].Clear();
+        uderivs[i].Clear();
+        vderivs[i].Clear();
+
+        for (int j=0; j<sizes[i]; ++j) {
+            T const & src = controlValues[indices[j]];
+            values[i].AddWithWeight(src, weights[j]);
+            uderivs[i].AddWithWeight(src, duWeights[j]);
+            vderivs[i].AddWithWeight(src, dvWeights[j]);
+        }
+
+        indices += sizes[i];
+        weights += sizes[i];
+        duWeights += sizes[i];
+        dvWeights += sizes[i];
+    }
+}
+
 // Returns a Stencil at index i in the table
 inline Stencil
 StencilTables::GetStencil(int i) const {
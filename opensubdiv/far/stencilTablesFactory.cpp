@@ -27,11 +27,11 @@
 #include "../far/topologyRefiner.h"
 
 #include <cassert>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
 #include <vector>
-#include <map>
 
 namespace {
 
@@ -56,6 +56,12 @@ public:
     // Set stencil weights to 0.0
     void Clear();
 
+    // Lock the stencil : it is then left unchanged by Clear() and the weighted
+    // adds (used for the stencils carried over by an update)
+    void Lock() {
+        _locked = true;
+    }
+
     // Weighted add for coarse vertices (size=1, weight=1.0f)
     void AddWithWeight(int, float weight);
 
@@ -96,6 +102,7 @@ private:
 
     int _ID;                   // Stencil ID in allocator
     StencilAllocator * _alloc; // Pool allocator
+    bool _locked;              // Stencil carried over (not interpolated)
 };
 
 typedef std::vector<Stencil> StencilVec;
@@ -107,6 +114,11 @@ typedef std::vector<Stencil> StencilVec;
 // slightly above average. For the (rare) stencils that require more support
 // vertices, switch to (slow) heap allocation.
 //
+// Each stencil only ever accesses its own slots in the pool and in the table
+// of heap allocated stencils, so the stencils of a level can be interpolated
+// by concurrent threads without locking, as long as each stencil is written
+// by a single thread (which TopologyRefiner::Interpolate() guarantees).
+//
 class StencilAllocator {
 
 public:
@@ -138,9 +150,6 @@ public:
     // Allocate enough memory to hold 'numStencils' Stencils
     void Resize(int numStencils);
 
-    // Returns the number of stencil vertices that have been pushed back
-    int GetNumVertices() const;
-
 private:
 
     friend class Stencil;
@@ -195,9 +204,10 @@ private:
         std::vector<float> weights;
     };
 
-    typedef std::map<int, BigStencil *> BigStencilMap;
+    // Heap allocated stencils indexed by stencil ID (null if pool allocated)
+    typedef std::vector<BigStencil *> BigStencilVec;
 
-    BigStencilMap _bigstencils;
+    BigStencilVec _bigstencils;
 };
 
 // Find the location of vertex 'vertex' in the stencil indices.
@@ -217,6 +227,9 @@ Stencil::findVertex(int vertex) {
 // Set stencil weights to 0.0
 void
 Stencil::Clear() {
+    if (_locked) {
+        return;
+    }
     for (int i=0; i<*_alloc->getSize(*this); ++i) {
         float * weights = _alloc->getWeights(*this);
         weights[i]=0.0f;
@@ -227,7 +240,7 @@ Stencil::Clear() {
 inline void
 Stencil::AddWithWeight(int vertIndex, float weight) {
 
-    if (weight==0.0f) {
+    if (weight==0.0f or _locked) {
         return;
     }
 
@@ -245,7 +258,7 @@ Stencil::AddWithWeight(int vertIndex, float weight) {
 inline void
 Stencil::AddWithWeight(Stencil const & src, float weight) {
 
-    if (weight==0.0f) {
+    if (weight==0.0f or _locked) {
         return;
     }
 
@@ -349,8 +362,8 @@ StencilAllocator::StencilAllocator(
 // Destructor
 StencilAllocator::~StencilAllocator() {
 
-    for (BigStencilMap::iterator it=_bigstencils.begin(); it!=_bigstencils.end(); ++it) {
-        delete it->second;
+    for (int i=0; i<(int)_bigstencils.size(); ++i) {
+        delete _bigstencils[i];
     }
 }
 
@@ -367,6 +380,9 @@ StencilAllocator::Resize(int numStencils) {
         _stencils[i]._ID = i;
         _stencils[i]._alloc = this;
     }
+    for (int i=0; i<numStencils; ++i) {
+        _stencils[i]._locked = false;
+    }
 
     int nelems = numStencils * _maxsize;
     _sizes.clear();
@@ -374,10 +390,11 @@ StencilAllocator::Resize(int numStencils) {
     _indices.resize(nelems);
     _weights.resize(nelems);
 
-    for (BigStencilMap::iterator it=_bigstencils.begin(); it!=_bigstencils.end(); ++it) {
-        delete it->second;
+    for (int i=0; i<(int)_bigstencils.size(); ++i) {
+        delete _bigstencils[i];
     }
     _bigstencils.clear();
+    _bigstencils.resize(numStencils, 0);
 }
 
 // Append a support vertex of index 'index' and weight 'weight' to the
@@ -405,10 +422,9 @@ StencilAllocator::PushBackVertex(Stencil & stencil, int index, float weight) {
         // Is this stencil already a BigStencil or do we need a new one ?
         if (*size==(_maxsize-1)) {
             dst = new BigStencil(*size, indices, weights);
-            assert(_bigstencils.find(stencil.GetID())==_bigstencils.end());
+            assert(_bigstencils[stencil.GetID()]==0);
             _bigstencils[stencil.GetID()]=dst;
         } else {
-            assert(_bigstencils.find(stencil.GetID())!=_bigstencils.end());
             dst = _bigstencils[stencil.GetID()];
         }
         assert(dst);
@@ -420,56 +436,548 @@ StencilAllocator::PushBackVertex(Stencil & stencil, int index, float weight) {
     ++(*size);
 }
 
-// Returns the number of stencil vertices that have been pushed back
-int
-StencilAllocator::GetNumVertices() const {
+//
+// Kernel copying a range of stencils into the tables -- the offsets of the
+// stencils in the tables are known, so ranges can be copied concurrently.
+//
+class CopyStencilsKernel : public OpenSubdiv::Vtr::ParallelKernel {
+
+public:
+
+    CopyStencilsKernel(StencilVec const & src, int const * offsets,
+        int * indices, float * weights) :
+            _src(src), _offsets(offsets), _indices(indices), _weights(weights) { }
+
+    virtual void operator()(int begin, int end) const {
+
+        for (int i=begin; i<end; ++i) {
+
+            Stencil const & stencil = _src[i];
+
+            int size = stencil.GetSize(),
+                ofs = _offsets[i];
+
+            memcpy(_indices+ofs, stencil.GetIndices(), size*sizeof(int));
+            memcpy(_weights+ofs, stencil.GetWeights(), size*sizeof(float));
+        }
+    }
+
+private:
+
+    StencilVec const & _src;
+    int const * _offsets;
+    int       * _indices;
+    float     * _weights;
+};
+
+// Number of stencils copied by each task
+const int copyGrainSize = 4096;
+
+//
+// FactorMatrix
+//
+// Sparse (compressed rows) weights of the vertices of a refinement level
+// relative to the vertices of its parent level. The stencils of the highest
+// level are the product of the matrices of all the levels.
+//
+class FactorMatrix {
+
+public:
+
+    // Compact the stencils interpolated from the vertices of the parent level
+    void Assign(StencilVec const & stencils);
+
+    int GetNumRows() const {
+        return (int)_offsets.size()-1;
+    }
 
-    int nverts=0;
-    for (int i=0; i<(int)_stencils.size(); ++i) {
-        nverts+=_stencils[i].GetSize();
+    int GetRowSize(int row) const {
+        return _offsets[row+1]-_offsets[row];
+    }
+
+    int const * GetRowIndices(int row) const {
+        return &_indices[_offsets[row]];
+    }
+
+    float const * GetRowWeights(int row) const {
+        return &_weights[_offsets[row]];
+    }
+
+private:
+
+    std::vector<int>   _offsets;
+    std::vector<int>   _indices;
+    std::vector<float> _weights;
+};
+
+void
+FactorMatrix::Assign(StencilVec const & stencils) {
+
+    int nrows = (int)stencils.size();
+
+    _offsets.resize(nrows+1);
+    _offsets[0] = 0;
+    for (int i=0; i<nrows; ++i) {
+        _offsets[i+1] = _offsets[i] + stencils[i].GetSize();
+    }
+
+    _indices.resize(_offsets[nrows]);
+    _weights.resize(_offsets[nrows]);
+    for (int i=0; i<nrows; ++i) {
+        int size = stencils[i].GetSize();
+        if (size>0) {
+            memcpy(&_indices[_offsets[i]], stencils[i].GetIndices(), size*sizeof(int));
+            memcpy(&_weights[_offsets[i]], stencils[i].GetWeights(), size*sizeof(float));
+        }
     }
-    return nverts;
 }
 
-} // end namespace unnamed
+//
+// WeightAccumulator
+//
+// Accumulates the weights of a composed stencil row, using a small open
+// addressing hash table to locate the vertex indices (composed rows are
+// small, but still too large for a linear search).
+//
+class WeightAccumulator {
 
-//------------------------------------------------------------------------------
+public:
 
-namespace OpenSubdiv {
-namespace OPENSUBDIV_VERSION {
+    WeightAccumulator() : _mask(0) {
+        resizeTable(64);
+    }
 
-namespace Far {
+    // Add 'weight' to the weight of vertex 'index'
+    void Add(int index, float weight);
 
-// Copy a stencil into StencilTables
-template <> void
-StencilTablesFactory::copyStencil(::Stencil const & src, Stencil & dst) {
+    // Remove the weights below 'epsilon' and renormalize the remainder
+    void Prune(float epsilon);
+
+    void Clear();
+
+    int GetSize() const {
+        return (int)_indices.size();
+    }
+
+    int const * GetIndices() const {
+        return &_indices[0];
+    }
+
+    float const * GetWeights() const {
+        return &_weights[0];
+    }
+
+private:
+
+    int findSlot(int index) const {
+        int slot = (int)(((unsigned int)index * 2654435761u) & _mask);
+        while (_table[slot]>=0 and _indices[_table[slot]]!=index) {
+            slot = (slot+1) & _mask;
+        }
+        return slot;
+    }
+
+    void resizeTable(int size);
+
+private:
+
+    unsigned int _mask;
+
+    std::vector<int> _table;     // slot -> position in _indices (or -1)
+    std::vector<int> _slots;     // position in _indices -> slot
+
+    std::vector<int>   _indices;
+    std::vector<float> _weights;
+};
 
-    unsigned char size = (unsigned char)src.GetSize();
-    int const * indices = src.GetIndices();
-    float const * weights = src.GetWeights();
+void
+WeightAccumulator::resizeTable(int size) {
 
-    *dst._size = size;
-    for (unsigned char i=0; i<size; ++i) {
-        memcpy(dst._indices, indices, size*sizeof(int));
-        memcpy(dst._weights, weights, size*sizeof(float));
+    _table.assign(size, -1);
+    _mask = size-1;
+    for (int i=0; i<(int)_indices.size(); ++i) {
+        _slots[i] = findSlot(_indices[i]);
+        _table[_slots[i]] = i;
     }
 }
 
-// (Sort &) Copy a vector of stencils into StencilTables
-template <> void
-StencilTablesFactory::copyStencils(::StencilVec & src,
-    Stencil & dst, bool sortBySize) {
+inline void
+WeightAccumulator::Add(int index, float weight) {
+
+    int slot = findSlot(index);
+    if (_table[slot]<0) {
+        _table[slot] = (int)_indices.size();
+        _slots.push_back(slot);
+        _indices.push_back(index);
+        _weights.push_back(weight);
+
+        // keep the table at most half full
+        if (2*_indices.size() > _table.size()) {
+            resizeTable(2*(int)_table.size());
+        }
+    } else {
+        _weights[_table[slot]] += weight;
+    }
+}
 
-    if (sortBySize) {
-        std::sort(src.begin(), src.end(), ::Stencil::CompareSize);
+void
+WeightAccumulator::Prune(float epsilon) {
+
+    if (epsilon<=0.0f) {
+        return;
     }
 
-    for (int i=0; i<(int)src.size(); ++i) {
-        copyStencil(src[i], dst);
-        dst.Next();
+    float sum = 0.0f, prunedSum = 0.0f;
+    int n = 0;
+    for (int i=0; i<(int)_indices.size(); ++i) {
+        sum += _weights[i];
+        if (_weights[i]>=epsilon) {
+            _indices[n] = _indices[i];
+            _weights[n] = _weights[i];
+            prunedSum += _weights[i];
+            ++n;
+        }
+    }
+
+    if (n<(int)_indices.size() and n>0) {
+        _slots.resize(n);
+        _indices.resize(n);
+        _weights.resize(n);
+
+        float scale = sum / prunedSum;
+        for (int i=0; i<n; ++i) {
+            _weights[i] *= scale;
+        }
+        resizeTable((int)_table.size());
     }
 }
 
+void
+WeightAccumulator::Clear() {
+
+    for (int i=0; i<(int)_slots.size(); ++i) {
+        _table[_slots[i]] = -1;
+    }
+    _slots.clear();
+    _indices.clear();
+    _weights.clear();
+}
+
+//
+// Kernel composing the factor matrices for ranges of chunks of vertices of
+// the highest level -- each chunk accumulates its stencils in its own buffer
+// and the buffers are then concatenated in order.
+//
+struct StencilChunk {
+    std::vector<int>   indices;
+    std::vector<float> weights;
+};
+
+class ComposeStencilsKernel : public OpenSubdiv::Vtr::ParallelKernel {
+
+public:
+
+    ComposeStencilsKernel(std::vector<FactorMatrix> const & factors,
+        float epsilon, int chunkSize, unsigned char * sizes,
+            std::vector<StencilChunk> & chunks) :
+        _factors(factors), _epsilon(epsilon), _chunkSize(chunkSize),
+            _sizes(sizes), _chunks(chunks) { }
+
+    virtual void operator()(int chunkBegin, int chunkEnd) const;
+
+private:
+
+    std::vector<FactorMatrix> const & _factors;
+
+    float _epsilon;
+
+    int _chunkSize;
+
+    unsigned char * _sizes;
+
+    std::vector<StencilChunk> & _chunks;
+};
+
+void
+ComposeStencilsKernel::operator()(int chunkBegin, int chunkEnd) const {
+
+    FactorMatrix const & finest = _factors.back();
+
+    int nrows = finest.GetNumRows();
+
+    WeightAccumulator row, composed;
+
+    for (int chunk=chunkBegin; chunk<chunkEnd; ++chunk) {
+
+        StencilChunk & dst = _chunks[chunk];
+
+        int rowBegin = chunk * _chunkSize,
+            rowEnd = std::min(rowBegin + _chunkSize, nrows);
+
+        for (int vert=rowBegin; vert<rowEnd; ++vert) {
+
+            // Weights relative to the vertices of the parent level
+            row.Clear();
+            for (int i=0; i<finest.GetRowSize(vert); ++i) {
+                row.Add(finest.GetRowIndices(vert)[i], finest.GetRowWeights(vert)[i]);
+            }
+
+            // Compose down to the control vertices
+            for (int level=(int)_factors.size()-2; level>=0; --level) {
+
+                FactorMatrix const & factor = _factors[level];
+
+                composed.Clear();
+                for (int i=0; i<row.GetSize(); ++i) {
+
+                    int src = row.GetIndices()[i];
+                    float weight = row.GetWeights()[i];
+
+                    int const * indices = factor.GetRowIndices(src);
+                    float const * weights = factor.GetRowWeights(src);
+                    for (int j=0; j<factor.GetRowSize(src); ++j) {
+                        composed.Add(indices[j], weight * weights[j]);
+                    }
+                }
+                composed.Prune(_epsilon);
+
+                std::swap(row, composed);
+            }
+
+            assert(row.GetSize()>0 and row.GetSize()<256);
+            _sizes[vert] = (unsigned char)row.GetSize();
+
+            dst.indices.insert(dst.indices.end(), row.GetIndices(), row.GetIndices()+row.GetSize());
+            dst.weights.insert(dst.weights.end(), row.GetWeights(), row.GetWeights()+row.GetSize());
+        }
+    }
+}
+
+// Number of vertices composed by each task
+const int composeChunkSize = 1024;
+
+// Sort the stencils of the tables by size
+struct CompareStencilSize {
+
+    CompareStencilSize(std::vector<unsigned char> const & sizes) : _sizes(sizes) { }
+
+    bool operator()(int a, int b) const {
+        return _sizes[a] < _sizes[b];
+    }
+
+    std::vector<unsigned char> const & _sizes;
+};
+
+// Sort vertices by degree (then by index)
+struct CompareVertexDegree {
+
+    CompareVertexDegree(std::vector<int> const & degrees) : _degrees(degrees) { }
+
+    bool operator()(int a, int b) const {
+        return _degrees[a] < _degrees[b] or
+            (_degrees[a]==_degrees[b] and a < b);
+    }
+
+    std::vector<int> const & _degrees;
+};
+
+// Sort stencils by key (then by index)
+struct CompareStencilKey {
+
+    CompareStencilKey(std::vector<int> const & keys) : _keys(keys) { }
+
+    bool operator()(int a, int b) const {
+        return _keys[a] < _keys[b] or (_keys[a]==_keys[b] and a < b);
+    }
+
+    std::vector<int> const & _keys;
+};
+
+// Cuthill-McKee traversal of the coarse vertices connected to 'root' :
+// appends the vertices to 'order' breadth-first, the neighbors of each
+// vertex by increasing degree. The vertices traversed are tagged with 'tag'.
+void
+cuthillMcKee(OpenSubdiv::Far::TopologyRefiner const & refiner, int root,
+    std::vector<int> const & degrees, std::vector<int> & tags, int tag,
+        std::vector<int> & order) {
+
+    std::vector<int> neighbors;
+
+    tags[root] = tag;
+    order.push_back(root);
+
+    for (int i=(int)order.size()-1; i<(int)order.size(); ++i) {
+
+        int vert = order[i];
+
+        OpenSubdiv::Far::IndexArray const edges = refiner.GetVertexEdges(0, vert);
+
+        neighbors.clear();
+        for (int j=0; j<edges.size(); ++j) {
+            OpenSubdiv::Far::IndexArray const everts =
+                refiner.GetEdgeVertices(0, edges[j]);
+            int neighbor = everts[0]==vert ? everts[1] : everts[0];
+            if (tags[neighbor]!=tag) {
+                tags[neighbor] = tag;
+                neighbors.push_back(neighbor);
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end(), CompareVertexDegree(degrees));
+
+        order.insert(order.end(), neighbors.begin(), neighbors.end());
+    }
+}
+
+// Returns the reverse Cuthill-McKee order of the coarse vertices
+void
+reverseCuthillMcKee(OpenSubdiv::Far::TopologyRefiner const & refiner,
+    std::vector<int> & order) {
+
+    int nverts = refiner.GetNumVertices(0);
+
+    std::vector<int> degrees(nverts), seeds(nverts);
+    for (int i=0; i<nverts; ++i) {
+        degrees[i] = refiner.GetVertexEdges(0, i).size();
+        seeds[i] = i;
+    }
+    std::sort(seeds.begin(), seeds.end(), CompareVertexDegree(degrees));
+
+    // 0 : not ordered yet, 1 : probed, 2 : ordered
+    std::vector<int> tags(nverts, 0), probe;
+
+    order.clear();
+    order.reserve(nverts);
+
+    for (int i=0; i<nverts; ++i) {
+
+        int seed = seeds[i];
+        if (tags[seed]==2) {
+            continue;
+        }
+
+        // start each component from a pseudo-peripheral vertex : the last
+        // one reached from the seed of lowest degree
+        probe.clear();
+        cuthillMcKee(refiner, seed, degrees, tags, 1, probe);
+
+        cuthillMcKee(refiner, probe.back(), degrees, tags, 2, order);
+    }
+    assert((int)order.size()==nverts);
+
+    std::reverse(order.begin(), order.end());
+}
+
+// Marks the stencils of the vertices of a parent face (if 'markParent'),
+// and that of its child vertex
+void
+markFaceSupport(OpenSubdiv::Far::TopologyRefiner const & refiner,
+    int parent, OpenSubdiv::Far::Index face, bool markParent,
+        int parentOffset, int childOffset, std::vector<bool> & supporting) {
+
+    if (markParent) {
+        OpenSubdiv::Far::IndexArray const fVerts =
+            refiner.GetFaceVertices(parent, face);
+        for (int i=0; i<fVerts.size(); ++i) {
+            supporting[parentOffset+fVerts[i]] = true;
+        }
+    }
+    OpenSubdiv::Far::Index cVert = refiner.GetFaceChildVertex(parent, face);
+    if (cVert>=0) {
+        supporting[childOffset+cVert] = true;
+    }
+}
+
+// Marks the stencils of the vertices that the interpolation of the vertices
+// of 'level' that are not carried over by an update reads : the vertices of
+// the parent level, and the child vertices of the parent faces, around their
+// parent components (see TopologyRefiner::Interpolate()). The stencils are
+// indexed from the first vertex of level 1, 'levelOffsets' holding the index
+// of the first stencil of each level.
+void
+markSupportingStencils(OpenSubdiv::Far::TopologyRefiner const & refiner,
+    int level, std::vector<int> const & levelOffsets,
+        std::vector<int> const & origins, std::vector<bool> & supporting) {
+
+    typedef OpenSubdiv::Far::Index Index;
+    typedef OpenSubdiv::Far::IndexArray IndexArray;
+
+    int parent = level-1,
+        parentOffset = levelOffsets[parent],
+        childOffset = levelOffsets[level];
+
+    // the control vertices have no stencils
+    bool markParent = parent>0;
+
+    for (Index face=0; markParent and face<refiner.GetNumFaces(parent); ++face) {
+        Index cVert = refiner.GetFaceChildVertex(parent, face);
+        if (cVert<0 or origins[childOffset+cVert]>=0) {
+            continue;
+        }
+        IndexArray const fVerts = refiner.GetFaceVertices(parent, face);
+        for (int i=0; i<fVerts.size(); ++i) {
+            supporting[parentOffset+fVerts[i]] = true;
+        }
+    }
+
+    for (Index edge=0; edge<refiner.GetNumEdges(parent); ++edge) {
+        Index cVert = refiner.GetEdgeChildVertex(parent, edge);
+        if (cVert<0 or origins[childOffset+cVert]>=0) {
+            continue;
+        }
+        if (markParent) {
+            IndexArray const eVerts = refiner.GetEdgeVertices(parent, edge);
+            supporting[parentOffset+eVerts[0]] = true;
+            supporting[parentOffset+eVerts[1]] = true;
+        }
+        IndexArray const eFaces = refiner.GetEdgeFaces(parent, edge);
+        for (int i=0; i<eFaces.size(); ++i) {
+            markFaceSupport(refiner, parent, eFaces[i], markParent,
+                parentOffset, childOffset, supporting);
+        }
+    }
+
+    for (Index vert=0; vert<refiner.GetNumVertices(parent); ++vert) {
+        Index cVert = refiner.GetVertexChildVertex(parent, vert);
+        if (cVert<0 or origins[childOffset+cVert]>=0) {
+            continue;
+        }
+        if (markParent) {
+            supporting[parentOffset+vert] = true;
+
+            IndexArray const vEdges = refiner.GetVertexEdges(parent, vert);
+            for (int i=0; i<vEdges.size(); ++i) {
+                IndexArray const eVerts = refiner.GetEdgeVertices(parent, vEdges[i]);
+                supporting[parentOffset+eVerts[0]] = true;
+                supporting[parentOffset+eVerts[1]] = true;
+            }
+        }
+        IndexArray const vFaces = refiner.GetVertexFaces(parent, vert);
+        for (int i=0; i<vFaces.size(); ++i) {
+            markFaceSupport(refiner, parent, vFaces[i], markParent,
+                parentOffset, childOffset, supporting);
+        }
+    }
+}
+
+} // end namespace unnamed
+
+//------------------------------------------------------------------------------
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+// Copy a vector of stencils into StencilTables at the given offsets
+template <> void
+StencilTablesFactory::copyStencils(::StencilVec const & src,
+    int const * offsets, int * indices, float * weights,
+        ThreadingType threading) {
+
+    Vtr::parallelFor((Vtr::ThreadingType)threading, 0, (int)src.size(),
+        copyGrainSize, CopyStencilsKernel(src, offsets, indices, weights));
+}
+
 //
 // StencilTables factory
 //
@@ -477,15 +985,116 @@ StencilTables const *
 StencilTablesFactory::Create(TopologyRefiner const & refiner,
     Options options) {
 
+    // Loop refiners cannot be refined yet (see TopologyRefiner::RefineUniform())
+    if (refiner.GetSchemeType()==Sdc::TYPE_LOOP) {
+        return 0;
+    }
 
     int maxlevel = refiner.GetMaxLevel();
 
     if (maxlevel==0) {
-        return new StencilTables;
+        StencilTables * result = new StencilTables;
+        result->_numControlVertices = refiner.GetNumVertices(0);
+        return result;
     }
 
+    if (options.factorizeLevels and not options.generateAllLevels) {
+        return createFactorized(refiner, options);
+    }
+
+    return create(refiner, options, 0, 0);
+}
+
+StencilTables const *
+StencilTablesFactory::Update(TopologyRefiner const & refiner,
+    StencilTables const & prevTables, std::vector<Index> const & vertexOrigins,
+        Options options) {
+
+    // The stencils of each level must be found in the tables in vertex order
+    if (not options.generateAllLevels or options.sortBySize or
+        refiner.GetSchemeType()==Sdc::TYPE_LOOP or refiner.GetMaxLevel()==0) {
+        return Create(refiner, options);
+    }
+
+    int nverts = refiner.GetNumVerticesTotal(),
+        ncontrolverts = refiner.GetNumVertices(0),
+        nprevverts = ncontrolverts + prevTables.GetNumStencils();
+
+    if ((int)vertexOrigins.size()!=nverts or
+        prevTables.GetNumControlVertices()!=ncontrolverts or
+        (int)prevTables._sizes.size()!=prevTables.GetNumStencils()) {
+        return Create(refiner, options);
+    }
+    for (int i=0; i<nverts; ++i) {
+        if (vertexOrigins[i]>=nprevverts) {
+            return Create(refiner, options);
+        }
+    }
+    return create(refiner, options, &prevTables, &vertexOrigins[0]);
+}
+
+StencilTables const *
+StencilTablesFactory::create(TopologyRefiner const & refiner,
+    Options options, StencilTables const * prevTables, Index const * vertexOrigins) {
+
+    int maxlevel = refiner.GetMaxLevel();
+
     Mode mode = (Mode)options.interpolationMode;
 
+    ThreadingType threading = (ThreadingType)options.threading;
+
+    int ncontrolverts = refiner.GetNumVertices(0);
+
+    // Stencils carried over from the previous tables : their origins
+    // (relative to the first stencil) and the offsets of the previous
+    // stencils. A level is only interpolated if some of its stencils are not
+    // carried over, and only the levels it is interpolated from are loaded
+    // in allocators.
+    std::vector<int> origins, levelOffsets, prevOffsets;
+    std::vector<bool> levelCarried(maxlevel+2, false), supporting;
+    if (prevTables) {
+        assert(options.generateAllLevels and vertexOrigins);
+
+        int nstencils = refiner.GetNumVerticesTotal() - ncontrolverts;
+
+        origins.resize(nstencils);
+        for (int i=0; i<nstencils; ++i) {
+            Index origin = vertexOrigins[ncontrolverts+i];
+            origins[i] = origin<0 ? -1 : origin-ncontrolverts;
+        }
+
+        levelOffsets.resize(maxlevel+2, 0);
+        for (int level=1; level<=maxlevel; ++level) {
+            levelOffsets[level+1] = levelOffsets[level] + refiner.GetNumVertices(level);
+
+            bool carried = true;
+            for (int i=levelOffsets[level]; carried and i<levelOffsets[level+1]; ++i) {
+                carried = origins[i]>=0;
+            }
+            levelCarried[level] = carried;
+        }
+
+        // only the stencils carried over that support the interpolation of
+        // the others are loaded in the allocators
+        supporting.resize(nstencils, false);
+        for (int level=1; level<=maxlevel; ++level) {
+            if (not levelCarried[level]) {
+                markSupportingStencils(refiner, level, levelOffsets, origins, supporting);
+            }
+        }
+
+        if (prevTables->_offsets.empty()) {
+            prevOffsets.resize(prevTables->GetNumStencils());
+            for (int i=0, ofs=0; i<(int)prevOffsets.size(); ++i) {
+                prevOffsets[i] = ofs;
+                ofs += prevTables->_sizes[i];
+            }
+        }
+    }
+    int const * prevStencilOffsets = not prevTables ? 0 :
+        (prevOffsets.empty() ? (prevTables->_offsets.empty() ? 0 :
+            &prevTables->_offsets[0]) : &prevOffsets[0]);
+
     std::vector<StencilAllocator> allocators(
         options.generateAllLevels ? maxlevel : 2,
             StencilAllocator(refiner, mode));
@@ -502,34 +1111,65 @@ StencilTablesFactory::Create(TopologyRefiner const & refiner,
     // Interpolate stencils for each refinement level using
     // TopologyRefiner::InterpolateLevel<>()
 
-    for (int level=1;level<=maxlevel; ++level) {
+    for (int level=1, first=0; level<=maxlevel; ++level) {
 
-        dstAlloc->Resize(refiner.GetNumVertices(level));
+        int nverts = refiner.GetNumVertices(level);
+
+        bool interpolate = not levelCarried[level],
+             load = interpolate or
+                 (level<maxlevel and not levelCarried[level+1]);
+
+        if (load) {
+            dstAlloc->Resize(nverts);
+        }
+
+        // stencils carried over are locked to skip their interpolation (and
+        // copied from the previous tables if others are interpolated from them)
+        if (prevTables and load) {
+            for (int i=0; i<nverts; ++i) {
+                int origin = origins[first+i];
+                if (origin<0) {
+                    continue;
+                }
+
+                ::Stencil & stencil = dstAlloc->GetStencils()[i];
+
+                if (supporting[first+i]) {
+                    int size = prevTables->_sizes[origin],
+                        ofs = prevStencilOffsets[origin];
+                    for (int j=0; j<size; ++j) {
+                        dstAlloc->PushBackVertex(stencil,
+                            prevTables->_indices[ofs+j], prevTables->_weights[ofs+j]);
+                    }
+                }
+                stencil.Lock();
+            }
+        }
 
-        if (level==1) {
+        if (interpolate and level==1) {
 
             // coarse vertices have a single index and a weight of 1.0f
-            int * srcStencils = new int[refiner.GetNumVertices(0)];
-            for (int i=0; i<refiner.GetNumVertices(0); ++i) {
+            int * srcStencils = new int[ncontrolverts];
+            for (int i=0; i<ncontrolverts; ++i) {
                 srcStencils[i]=i;
             }
 
             ::Stencil * dstStencils = &(dstAlloc->GetStencils()).at(0);
 
             if (mode==INTERPOLATE_VERTEX) {
-                refiner.Interpolate(level, srcStencils, dstStencils);
+                refiner.Interpolate(level, srcStencils, dstStencils, threading);
             } else {
                 refiner.InterpolateVarying(level, srcStencils, dstStencils);
             }
 
             delete [] srcStencils;
-        } else {
+        } else if (interpolate) {
 
             ::Stencil * srcStencils = &(srcAlloc->GetStencils()).at(0),
                       * dstStencils = &(dstAlloc->GetStencils()).at(0);
 
             if (mode==INTERPOLATE_VERTEX) {
-                refiner.Interpolate(level, srcStencils, dstStencils);
+                refiner.Interpolate(level, srcStencils, dstStencils, threading);
             } else {
                 refiner.InterpolateVarying(level, srcStencils, dstStencils);
             }
@@ -543,60 +1183,505 @@ StencilTablesFactory::Create(TopologyRefiner const & refiner,
         } else {
             std::swap(srcAlloc, dstAlloc);
         }
+        first += nverts;
     }
 
     // Sort & Copy stencils into tables
 
     StencilTables * result = new StencilTables;
     {
-        result->_numControlVertices = refiner.GetNumVertices(0);
+        result->_numControlVertices = ncontrolverts;
 
-        // Add total number of stencils, weights & indices
-        int nelems = 0, nstencils=0;
+        // Gather the stencils to copy (sorted within each level if requested)
+        // -- the stencils carried over are copied from the previous tables
+        std::vector<StencilVec *> levelStencils;
         if (options.generateAllLevels) {
-
             for (int level=0; level<maxlevel; ++level) {
-                nstencils += (int)allocators[level].GetStencils().size();
-                nelems += allocators[level].GetNumVertices();
+                levelStencils.push_back(&allocators[level].GetStencils());
+            }
+        } else {
+            levelStencils.push_back(&srcAlloc->GetStencils());
+        }
+
+        if (options.sortBySize) {
+            for (int i=0; i<(int)levelStencils.size(); ++i) {
+                std::sort(levelStencils[i]->begin(), levelStencils[i]->end(),
+                    ::Stencil::CompareSize);
             }
+        }
+
+        // Add total number of stencils, weights & indices
+        int nstencils = 0;
+        if (options.generateAllLevels) {
+            nstencils = refiner.GetNumVerticesTotal() - ncontrolverts;
         } else {
             nstencils = (int)srcAlloc->GetStencils().size();
-            nelems = srcAlloc->GetNumVertices();
         }
 
+        result->_sizes.resize(nstencils);
+        if (options.generateOffsets) {
+            result->_offsets.resize(nstencils);
+        }
 
-        { // Allocate
-            result->_sizes.resize(nstencils);
-            if (options.generateOffsets) {
-                result->_offsets.resize(nstencils);
+        // Assign the sizes & offsets of the stencils in the tables
+        std::vector<int> offsets;
+        if (not options.generateOffsets) {
+            offsets.resize(nstencils);
+        }
+        int * stencilOffsets = nstencils==0 ? 0 : options.generateOffsets ?
+            &result->_offsets.at(0) : &offsets.at(0);
+
+        // The stencils interpolated when updating tables (copied in parallel)
+        StencilVec interpolated;
+        std::vector<int> interpolatedOffsets;
+
+        int nelems = 0;
+        for (int i=0, n=0; i<(int)levelStencils.size(); ++i) {
+
+            StencilVec const & stencils = *levelStencils[i];
+
+            int nverts = options.generateAllLevels ?
+                refiner.GetNumVertices(i+1) : (int)stencils.size();
+
+            for (int j=0; j<nverts; ++j, ++n) {
+                int origin = prevTables ? origins[n] : -1;
+                if (origin>=0) {
+                    result->_sizes[n] = prevTables->_sizes[origin];
+                } else {
+                    result->_sizes[n] = (unsigned char)stencils[j].GetSize();
+                    if (prevTables) {
+                        interpolated.push_back(stencils[j]);
+                        interpolatedOffsets.push_back(nelems);
+                    }
+                }
+                stencilOffsets[n] = nelems;
+                assert(result->_sizes[n]!=0);
+                nelems+=result->_sizes[n];
             }
-            result->_indices.resize(nelems);
-            result->_weights.resize(nelems);
         }
 
-        // Copy stencils
-        Stencil dst(&result->_sizes.at(0),
-            &result->_indices.at(0), &result->_weights.at(0));
+        result->_indices.resize(nelems);
+        result->_weights.resize(nelems);
 
-        bool doSort = options.sortBySize!=0;
+        if (not prevTables) {
 
-        if (options.generateAllLevels) {
-            for (int level=0; level<maxlevel; ++level) {
-                copyStencils(allocators[level].GetStencils(), dst, doSort);
+            // Copy stencils
+            for (int i=0, n=0; i<(int)levelStencils.size(); ++i) {
+
+                copyStencils(*levelStencils[i], stencilOffsets+n,
+                    &result->_indices.at(0), &result->_weights.at(0), threading);
+
+                n += (int)levelStencils[i]->size();
             }
         } else {
-            copyStencils(srcAlloc->GetStencils(), dst, doSort);
+
+            // Copy the stencils carried over (by runs of consecutive stencils)
+            for (int n=0; n<nstencils;) {
+                int origin = origins[n];
+                if (origin<0) {
+                    ++n;
+                    continue;
+                }
+                int count = 1;
+                while (n+count<nstencils and origins[n+count]==origin+count) {
+                    ++count;
+                }
+                int ofs = prevStencilOffsets[origin],
+                    size = prevStencilOffsets[origin+count-1] +
+                        prevTables->_sizes[origin+count-1] - ofs;
+
+                memcpy(&result->_indices[stencilOffsets[n]],
+                    &prevTables->_indices[ofs], size*sizeof(int));
+                memcpy(&result->_weights[stencilOffsets[n]],
+                    &prevTables->_weights[ofs], size*sizeof(float));
+                n += count;
+            }
+
+            // Copy the stencils interpolated
+            if (not interpolated.empty()) {
+                copyStencils(interpolated, &interpolatedOffsets[0],
+                    &result->_indices.at(0), &result->_weights.at(0), threading);
+            }
         }
+    }
 
-        if (options.generateOffsets) {
-            for (int i=0, ofs=0; i<nstencils; ++i ) {
-                result->_offsets[i]=ofs;
-                assert(result->_sizes[i]!=0 and
-                    result->_sizes[i]<(int)result->_weights.size());
-                ofs+=result->_sizes[i];
+    if (options.generateDependentStencils) {
+        createDependentStencils(*result);
+    }
+    return result;
+}
+
+//
+// Factorized StencilTables factory
+//
+StencilTables const *
+StencilTablesFactory::createFactorized(TopologyRefiner const & refiner,
+    Options options) {
+
+    int maxlevel = refiner.GetMaxLevel();
+
+    Mode mode = (Mode)options.interpolationMode;
+
+    ThreadingType threading = (ThreadingType)options.threading;
+
+    // Interpolate the weights of each level relative to its parent level:
+    // the parent vertices are the "control vertices" of each level, so the
+    // stencils only ever hold the local masks.
+
+    std::vector<FactorMatrix> factors(maxlevel);
+    {
+        // The parents of all levels are indexed from the same buffer : sparse
+        // levels do not necessarily grow, so size it for the largest one
+        int maxParentVerts = 0;
+        for (int level=0; level<maxlevel; ++level) {
+            maxParentVerts = std::max(maxParentVerts, refiner.GetNumVertices(level));
+        }
+
+        std::vector<int> parentVerts(maxParentVerts);
+        for (int i=0; i<(int)parentVerts.size(); ++i) {
+            parentVerts[i]=i;
+        }
+
+        StencilAllocator alloc(refiner, mode);
+
+        for (int level=1; level<=maxlevel; ++level) {
+
+            alloc.Resize(refiner.GetNumVertices(level));
+
+            ::Stencil * dstStencils = &(alloc.GetStencils()).at(0);
+
+            if (mode==INTERPOLATE_VERTEX) {
+                refiner.Interpolate(level, &parentVerts[0], dstStencils, threading);
+            } else {
+                refiner.InterpolateVarying(level, &parentVerts[0], dstStencils);
             }
+
+            factors[level-1].Assign(alloc.GetStencils());
         }
     }
+
+    // Compose the weights of each vertex of the highest level
+
+    StencilTables * result = new StencilTables;
+
+    result->_numControlVertices = refiner.GetNumVertices(0);
+
+    int nstencils = refiner.GetNumVertices(maxlevel),
+        nchunks = (nstencils + composeChunkSize - 1) / composeChunkSize;
+
+    if (nstencils==0) {
+        return result;
+    }
+
+    result->_sizes.resize(nstencils);
+
+    std::vector<StencilChunk> chunks(nchunks);
+
+    Vtr::parallelFor((Vtr::ThreadingType)threading, 0, nchunks, 1,
+        ComposeStencilsKernel(factors, options.weightEpsilon, composeChunkSize,
+            &result->_sizes.at(0), chunks));
+
+    factors.clear();
+
+    // Concatenate the chunks (sorting by size if requested)
+
+    int nelems = 0;
+    for (int i=0; i<nchunks; ++i) {
+        nelems += (int)chunks[i].indices.size();
+    }
+
+    result->_indices.resize(nelems);
+    result->_weights.resize(nelems);
+
+    for (int i=0, ofs=0; i<nchunks; ++i) {
+        int size = (int)chunks[i].indices.size();
+        if (size) {
+            memcpy(&result->_indices[ofs], &chunks[i].indices[0], size*sizeof(int));
+            memcpy(&result->_weights[ofs], &chunks[i].weights[0], size*sizeof(float));
+        }
+        ofs += size;
+
+        // release the chunk as soon as it is copied
+        StencilChunk().indices.swap(chunks[i].indices);
+        StencilChunk().weights.swap(chunks[i].weights);
+    }
+
+    if (options.sortBySize) {
+
+        std::vector<int> offsets(nstencils);
+        for (int i=0, ofs=0; i<nstencils; ++i) {
+            offsets[i] = ofs;
+            ofs += result->_sizes[i];
+        }
+
+        std::vector<int> order(nstencils);
+        for (int i=0; i<nstencils; ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(),
+            CompareStencilSize(result->_sizes));
+
+        std::vector<unsigned char> sizes(nstencils);
+        std::vector<int>           indices(nelems);
+        std::vector<float>         weights(nelems);
+
+        for (int i=0, ofs=0; i<nstencils; ++i) {
+            int src = order[i],
+                size = result->_sizes[src];
+            sizes[i] = (unsigned char)size;
+            memcpy(&indices[ofs], &result->_indices[offsets[src]], size*sizeof(int));
+            memcpy(&weights[ofs], &result->_weights[offsets[src]], size*sizeof(float));
+            ofs += size;
+        }
+        result->_sizes.swap(sizes);
+        result->_indices.swap(indices);
+        result->_weights.swap(weights);
+    }
+
+    if (options.generateOffsets) {
+        result->_offsets.resize(nstencils);
+        for (int i=0, ofs=0; i<nstencils; ++i ) {
+            result->_offsets[i]=ofs;
+            ofs+=result->_sizes[i];
+        }
+    }
+
+    if (options.generateDependentStencils) {
+        createDependentStencils(*result);
+    }
+    return result;
+}
+
+//
+// Control vertex -> stencils index
+//
+void
+StencilTablesFactory::createDependentStencils(StencilTables & tables) {
+
+    int ncvs = tables._numControlVertices,
+        nstencils = tables.GetNumStencils();
+
+    std::vector<int> & offsets = tables._dependentOffsets,
+                     & stencils = tables._dependentStencils;
+
+    // Count the stencils of each control vertex
+    offsets.assign(ncvs+1, 0);
+    for (int i=0; i<(int)tables._indices.size(); ++i) {
+        ++offsets[tables._indices[i]+1];
+    }
+    for (int i=0; i<ncvs; ++i) {
+        offsets[i+1] += offsets[i];
+    }
+
+    // Fill in the stencils (in increasing order)
+    stencils.resize(offsets[ncvs]);
+
+    std::vector<int> counts(offsets.begin(), offsets.end()-1);
+
+    int const * indices = tables._indices.empty() ? 0 : &tables._indices[0];
+    for (int i=0; i<nstencils; ++i) {
+        for (int j=0; j<tables._sizes[i]; ++j, ++indices) {
+            stencils[counts[*indices]++] = i;
+        }
+    }
+}
+
+//
+// Reorder stencils & control vertices
+//
+StencilTables const *
+StencilTablesFactory::Reorder(TopologyRefiner const & refiner,
+    StencilTables const & tables, std::vector<int> & vertexRemap) {
+
+    int ncvs = tables.GetNumControlVertices(),
+        nstencils = tables.GetNumStencils();
+
+    assert(ncvs==refiner.GetNumVertices(0));
+
+    std::vector<int> order;
+    reverseCuthillMcKee(refiner, order);
+
+    vertexRemap.resize(ncvs+nstencils);
+    for (int i=0; i<ncvs; ++i) {
+        vertexRemap[order[i]] = i;
+    }
+
+    std::vector<int> offsets(nstencils);
+    for (int i=0, ofs=0; i<nstencils; ++i) {
+        offsets[i] = ofs;
+        ofs += tables._sizes[i];
+    }
+
+    // Key each stencil with the new location of its control vertex of
+    // highest weight
+    std::vector<int> keys(nstencils);
+    for (int i=0; i<nstencils; ++i) {
+        int const * indices = &tables._indices[offsets[i]];
+        float const * weights = &tables._weights[offsets[i]];
+        int best = 0;
+        for (int j=1; j<tables._sizes[i]; ++j) {
+            if (std::abs(weights[j]) > std::abs(weights[best])) {
+                best = j;
+            }
+        }
+        keys[i] = vertexRemap[indices[best]];
+    }
+
+    // Sort the stencils of each level (if the tables hold all of them, the
+    // highest level otherwise) so that the levels stay contiguous
+    std::vector<int> levelSizes;
+    if (nstencils==refiner.GetNumVerticesTotal()-ncvs) {
+        for (int level=1; level<=refiner.GetMaxLevel(); ++level) {
+            levelSizes.push_back(refiner.GetNumVertices(level));
+        }
+    } else {
+        levelSizes.push_back(nstencils);
+    }
+
+    order.resize(nstencils);
+    for (int i=0; i<nstencils; ++i) {
+        order[i] = i;
+    }
+    for (int i=0, first=0; i<(int)levelSizes.size(); ++i) {
+        std::sort(order.begin()+first, order.begin()+first+levelSizes[i],
+            CompareStencilKey(keys));
+        first += levelSizes[i];
+    }
+
+    for (int i=0; i<nstencils; ++i) {
+        vertexRemap[ncvs+order[i]] = ncvs+i;
+    }
+
+    // Copy the stencils in their new order
+    StencilTables * result = new StencilTables;
+
+    result->_numControlVertices = ncvs;
+    result->_sizes.resize(nstencils);
+    result->_indices.resize(tables._indices.size());
+    result->_weights.resize(tables._weights.size());
+    if (not tables._varyingSizes.empty()) {
+        result->_varyingSizes.resize(nstencils);
+        result->_varyingOffsets.resize(nstencils);
+        result->_varyingWeights.resize(tables._varyingWeights.size());
+    }
+    if (not tables._offsets.empty()) {
+        result->_offsets.resize(nstencils);
+    }
+
+    for (int i=0, ofs=0, varyingOffset=0; i<nstencils; ++i) {
+
+        int src = order[i],
+            size = tables._sizes[src];
+
+        result->_sizes[i] = (unsigned char)size;
+        if (not result->_offsets.empty()) {
+            result->_offsets[i] = ofs;
+        }
+
+        int const * indices = &tables._indices[offsets[src]];
+        for (int j=0; j<size; ++j) {
+            result->_indices[ofs+j] = vertexRemap[indices[j]];
+        }
+        memcpy(&result->_weights[ofs], &tables._weights[offsets[src]],
+            size*sizeof(float));
+
+        if (not tables._varyingSizes.empty()) {
+            int varyingSize = tables._varyingSizes[src];
+            result->_varyingSizes[i] = (unsigned char)varyingSize;
+            result->_varyingOffsets[i] = varyingOffset;
+            memcpy(&result->_varyingWeights[varyingOffset],
+                &tables._varyingWeights[tables._varyingOffsets[src]],
+                    varyingSize*sizeof(float));
+            varyingOffset += varyingSize;
+        }
+
+        ofs += size;
+    }
+
+    if (not tables._dependentOffsets.empty()) {
+        createDependentStencils(*result);
+    }
+    return result;
+}
+
+//
+// Fuse vertex & varying stencils
+//
+StencilTables const *
+StencilTablesFactory::CreateFused(StencilTables const & vertexTables,
+    StencilTables const & varyingTables) {
+
+    int nstencils = vertexTables.GetNumStencils();
+
+    if (varyingTables.GetNumStencils()!=nstencils or
+        varyingTables.GetNumControlVertices()!=vertexTables.GetNumControlVertices()) {
+        return 0;
+    }
+
+    StencilTables * result = new StencilTables;
+
+    result->_numControlVertices = vertexTables._numControlVertices;
+    result->_sizes.resize(nstencils);
+    result->_offsets.resize(nstencils);
+    result->_indices.reserve(vertexTables._indices.size());
+    result->_weights.reserve(vertexTables._weights.size());
+    result->_varyingSizes = varyingTables._sizes;
+    result->_varyingOffsets.resize(nstencils);
+    result->_varyingWeights = varyingTables._weights;
+
+    std::vector<int> & indices = result->_indices;
+    std::vector<float> & weights = result->_weights;
+
+    int const * vertexIndices = vertexTables._indices.empty() ? 0 : &vertexTables._indices[0],
+              * varyingIndices = varyingTables._indices.empty() ? 0 : &varyingTables._indices[0];
+
+    float const * vertexWeights = vertexTables._weights.empty() ? 0 : &vertexTables._weights[0];
+
+    for (int i=0, varyingOffset=0; i<nstencils; ++i) {
+
+        int ofs = (int)indices.size(),
+            vertexSize = vertexTables._sizes[i],
+            varyingSize = varyingTables._sizes[i];
+
+        // the control vertices of the varying stencil first, with their
+        // vertex weight (in practice varying stencils only use control
+        // vertices of the vertex stencil)
+        for (int j=0; j<varyingSize; ++j) {
+            indices.push_back(varyingIndices[j]);
+            int const * it = std::find(vertexIndices, vertexIndices+vertexSize,
+                varyingIndices[j]);
+            weights.push_back(it==vertexIndices+vertexSize ?
+                0.0f : vertexWeights[it-vertexIndices]);
+        }
+
+        // then the other control vertices of the vertex stencil
+        for (int j=0; j<vertexSize; ++j) {
+            if (std::find(varyingIndices, varyingIndices+varyingSize,
+                vertexIndices[j])==varyingIndices+varyingSize) {
+                indices.push_back(vertexIndices[j]);
+                weights.push_back(vertexWeights[j]);
+            }
+        }
+
+        int size = (int)indices.size() - ofs;
+        if (size>255) {
+            // does not fit the stencil sizes
+            delete result;
+            return 0;
+        }
+        result->_sizes[i] = (unsigned char)size;
+        result->_offsets[i] = ofs;
+        result->_varyingOffsets[i] = varyingOffset;
+
+        vertexIndices += vertexSize;
+        vertexWeights += vertexSize;
+        varyingIndices += varyingSize;
+        varyingOffset += varyingSize;
+    }
+
+    if (not vertexTables._dependentOffsets.empty()) {
+        createDependentStencils(*result);
+    }
     return result;
 }
 
@@ -27,15 +27,19 @@
 
 #include "../version.h"
 
+#include "../far/compactStencilTables.h"
 #include "../far/kernelBatch.h"
+#include "../far/stencilTables.h"
+#include "../far/types.h"
+
+#include <limits>
+#include <vector>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 namespace Far {
 
-class Stencil;
-class StencilTables;
 class TopologyRefiner;
 
 /// \brief A specialized factory for StencilTables
@@ -44,7 +48,8 @@ class TopologyRefiner;
 ///       TopologyRefiner need to be remapped to their new location in the
 ///       vertex buffer.
 ///
-//        XXXX manuelk remap table creation not implemented yet !
+//        XXXX manuelk remap table creation not implemented yet for
+//        'sortBySize' : Reorder() returns its remap table.
 //
 class StencilTablesFactory {
 
@@ -60,12 +65,22 @@ public:
         Options() : interpolationMode(INTERPOLATE_VERTEX),
                     generateOffsets(false),    
                     generateAllLevels(true),   
-                    sortBySize(false) { }
+                    sortBySize(false),
+                    factorizeLevels(false),
+                    generateDependentStencils(false),
+                    threading(THREADING_SERIAL),
+                    weightEpsilon(0.0f) { }
     
         int interpolationMode : 2, ///< interpolation mode
             generateOffsets   : 1, ///< populate optional "_offsets" field          
             generateAllLevels : 1, ///< vertices at all levels or highest only
-            sortBySize        : 1; ///< sort stencils by size (within a level)
+            sortBySize        : 1, ///< sort stencils by size (within a level)
+            factorizeLevels   : 1, ///< compose per-level weights (highest level only)
+            generateDependentStencils : 1; ///< populate the optional control vertex -> stencils index
+
+        unsigned int threading : 2; ///< threading backend (see ThreadingType)
+
+        float weightEpsilon;        ///< prune factorized weights below epsilon
     };
 
     /// \brief Instantiates StencilTables from TopologyRefiner that have been
@@ -75,13 +90,146 @@ public:
     ///       been refined in the TopologyRefiner. Use RefineUniform() or
     ///       RefineAdaptive() before constructing the stencils.
     ///
+    /// \note Only Bilinear and Catmark refiners are supported : 0 is returned
+    ///       for Loop refiners.
+    ///
     /// @param refiner  The TopologyRefiner containing the refined topology
     ///
     /// @param options    Options controlling the creation of the tables
     ///
+    /// \note When a threading backend is selected, the stencils of each level
+    ///       are interpolated across threads and the interpolated stencils are
+    ///       copied into the tables in parallel. The resulting tables are
+    ///       identical to those created serially.
+    ///
+    /// \note With 'factorizeLevels' (and 'generateAllLevels' disabled), the
+    ///       stencils of the intermediate levels are never created: only the
+    ///       sparse weights of each level relative to its parent are, and
+    ///       those are composed for each vertex of the highest level. Weights
+    ///       smaller than 'weightEpsilon' are pruned after each composition
+    ///       (and the remaining weights renormalized), so the results may
+    ///       differ from the non-factorized stencils by round-off (or by the
+    ///       pruned weights).
+    ///
     static StencilTables const * Create(TopologyRefiner const & refiner,
         Options options = Options());
 
+    /// \brief Updates StencilTables after an incremental refinement (see
+    ///        TopologyRefiner::UpdateSparse())
+    ///
+    /// The stencils of the vertices carried over by the incremental refinement
+    /// are copied from 'prevTables' and only those of the other vertices are
+    /// interpolated. The tables remain in vertex order, so the vertex data of
+    /// the carried over vertices can be copied from the previous buffers (see
+    /// StencilTables::GetUpdatedStencilRanges() to apply the other stencils).
+    ///
+    /// Only tables generating all the levels, without sorting the stencils by
+    /// size, can be updated : the tables are created from scratch (as with
+    /// Create()) for other options, or if 'prevTables' and 'vertexOrigins' do
+    /// not match the refiner.
+    ///
+    /// @param refiner        The TopologyRefiner after the incremental
+    ///                       refinement
+    ///
+    /// @param prevTables     The stencil tables created from the refiner before
+    ///                       the incremental refinement, with the same options
+    ///
+    /// @param vertexOrigins  The origins of the vertices returned by the
+    ///                       incremental refinement
+    ///
+    /// @param options        Options controlling the creation of the tables
+    ///
+    static StencilTables const * Update(TopologyRefiner const & refiner,
+        StencilTables const & prevTables, std::vector<Index> const & vertexOrigins,
+            Options options = Options());
+
+    /// \brief Instantiates CompactStencilTables from StencilTables
+    ///
+    /// @tparam INDEX   Type of the control vertex indices (int or
+    ///                 unsigned short)
+    ///
+    /// @tparam WEIGHT  Type of the weights (float or Half)
+    ///
+    /// @param tables   The stencil tables to convert
+    ///
+    /// @return         The compact tables (with offsets) or 0 if some
+    ///                 control vertex indices cannot be represented by INDEX
+    ///
+    template <class INDEX, class WEIGHT>
+    static CompactStencilTables<INDEX, WEIGHT> const * CreateCompact(
+        StencilTables const & tables);
+
+    /// \brief Instantiates CompactStencilTables from TopologyRefiner
+    ///
+    /// Same as Create() followed by a conversion to compact storage.
+    ///
+    /// @param refiner  The TopologyRefiner containing the refined topology
+    ///
+    /// @param options  Options controlling the creation of the tables
+    ///
+    template <class INDEX, class WEIGHT>
+    static CompactStencilTables<INDEX, WEIGHT> const * CreateCompact(
+        TopologyRefiner const & refiner, Options options = Options());
+
+    /// \brief Reorders stencils & control vertices for the locality of the
+    ///        control vertex gathers
+    ///
+    /// Control vertices are sorted in reverse Cuthill-McKee order over the
+    /// edges of the coarse mesh. The stencils of each level are then sorted
+    /// by the new location of their most heavily weighted control vertex, so
+    /// that consecutive stencils gather nearby control vertices. The
+    /// weights of each stencil are kept in their order : the reordered
+    /// tables interpolate exactly the same values.
+    ///
+    /// The vertex buffer is assumed to hold the control vertices followed by
+    /// the interpolated vertices, one per stencil (as for the vertex indices
+    /// of PatchTables created from the same refiner, with the same
+    /// 'generateAllLevels' option). The control vertex data must be stored
+    /// at the new locations, and the vertex indices of PatchTables (see
+    /// PatchTables::RemapVertices()) or TopologyRefiner (offset by the number
+    /// of vertices of the previous levels) replaced by 'vertexRemap[index]'.
+    ///
+    /// @param refiner      The TopologyRefiner the tables were created from
+    ///
+    /// @param tables       The stencil tables to reorder
+    ///
+    /// @param vertexRemap  Returns the new location of each vertex of the
+    ///                     vertex buffer, indexed by its current location
+    ///
+    /// @return             The reordered tables (with offsets and dependent
+    ///                     stencils if 'tables' has them)
+    ///
+    static StencilTables const * Reorder(TopologyRefiner const & refiner,
+        StencilTables const & tables, std::vector<int> & vertexRemap);
+
+    /// \brief Fuses vertex and varying stencil tables
+    ///
+    /// The fused tables share a single stream of control vertex indices
+    /// between two streams of weights (see StencilTables::GetVaryingSizes()),
+    /// so that vertex and varying primvar data can be interpolated in a
+    /// single pass, reading the indices once. Each stencil starts with the
+    /// control vertices of the varying stencil (in the same order, with their
+    /// vertex weight or zero), followed by the other control vertices of the
+    /// vertex stencil. The varying weights are not changed, but the vertex
+    /// weights are blended in a different order : vertex values may differ
+    /// from those of 'vertexTables' by round-off.
+    ///
+    /// \note StencilTablesSerializer and CompactStencilTables do not support
+    ///       the varying weights of fused tables.
+    ///
+    /// @param vertexTables   The tables used for vertex interpolation
+    ///
+    /// @param varyingTables  The tables used for varying interpolation,
+    ///                       created from the same refiner with the same
+    ///                       options
+    ///
+    /// @return               The fused tables (with offsets, and dependent
+    ///                       stencils if 'vertexTables' has them) or 0 if
+    ///                       the tables do not match
+    ///
+    static StencilTables const * CreateFused(StencilTables const & vertexTables,
+        StencilTables const & varyingTables);
+
     /// \brief Returns a KernelBatch applying all the stencil in the tables
     ///        to primvar data.
     ///
@@ -91,16 +239,81 @@ public:
 
 private:
 
-    // Copy a stencil into StencilTables
-    template <class T> static void copyStencil(T const & src, Stencil & dst);
+    // Create the stencils of the levels (those of the vertices with a valid
+    // origin being copied from 'prevTables')
+    static StencilTables const * create(TopologyRefiner const & refiner,
+        Options options, StencilTables const * prevTables, Index const * vertexOrigins);
+
+    // Create the stencils of the highest level by composing the weights of
+    // each level
+    static StencilTables const * createFactorized(
+        TopologyRefiner const & refiner, Options options);
 
-    // (Sort &) Copy a vector of stencils into StencilTables
-    template <class T> static void copyStencils(std::vector<T> & src,
-        Stencil & dst, bool sortBySize);
+    // Populate the stencils depending on each control vertex
+    static void createDependentStencils(StencilTables & tables);
+
+    // Copy a vector of stencils into StencilTables at the given offsets
+    template <class T> static void copyStencils(std::vector<T> const & src,
+        int const * offsets, int * indices, float * weights,
+            ThreadingType threading);
         
     std::vector<int> _remap;
 };
 
+template <class INDEX, class WEIGHT> CompactStencilTables<INDEX, WEIGHT> const *
+StencilTablesFactory::CreateCompact(StencilTables const & tables) {
+
+    int nstencils = tables.GetNumStencils(),
+        nelems = (int)tables.GetControlIndices().size();
+
+    if (tables.GetNumControlVertices()>0 and
+        (long long)(tables.GetNumControlVertices()-1) >
+            (long long)std::numeric_limits<INDEX>::max()) {
+        return 0;
+    }
+
+    CompactStencilTables<INDEX, WEIGHT> * result =
+        new CompactStencilTables<INDEX, WEIGHT>;
+
+    result->_numControlVertices = tables.GetNumControlVertices();
+    result->_sizes = tables.GetSizes();
+
+    // The offsets are optional in StencilTables
+    if ((int)tables.GetOffsets().size()==nstencils) {
+        result->_offsets = tables.GetOffsets();
+    } else {
+        result->_offsets.resize(nstencils);
+        for (int i=0, ofs=0; i<nstencils; ++i) {
+            result->_offsets[i] = ofs;
+            ofs += tables.GetSizes()[i];
+        }
+    }
+
+    std::vector<int> const & indices = tables.GetControlIndices();
+    std::vector<float> const & weights = tables.GetWeights();
+
+    result->_indices.resize(nelems);
+    result->_weights.resize(nelems);
+    for (int i=0; i<nelems; ++i) {
+        result->_indices[i] = (INDEX)indices[i];
+        result->_weights[i] = (WEIGHT)weights[i];
+    }
+    return result;
+}
+
+template <class INDEX, class WEIGHT> CompactStencilTables<INDEX, WEIGHT> const *
+StencilTablesFactory::CreateCompact(TopologyRefiner const & refiner,
+    Options options) {
+
+    StencilTables const * tables = Create(refiner, options);
+
+    CompactStencilTables<INDEX, WEIGHT> const * result =
+        CreateCompact<INDEX, WEIGHT>(*tables);
+
+    delete tables;
+    return result;
+}
+
 
 } // end namespace Far
 
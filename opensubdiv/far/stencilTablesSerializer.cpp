@@ -0,0 +1,324 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../far/stencilTablesSerializer.h"
+#include "../far/binaryFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+using OpenSubdiv::Far::BinaryFile;
+
+//
+// File layout: a fixed size header followed by the arrays of sizes, offsets,
+// indices and weights, each aligned on 16 bytes
+//
+char const fileMagic[8] = { 'O', 'S', 'D', 'S', 'T', 'N', 'C', 'L' };
+
+unsigned int const byteOrderTag = 0x01020304,
+                   swappedByteOrderTag = 0x04030201;
+
+struct FileHeader {
+    char         magic[8];
+    unsigned int byteOrder;          // byteOrderTag as written by the writer
+    unsigned int version;
+    int          numStencils,
+                 numControlVertices,
+                 numElements,        // number of indices (and weights)
+                 reserved;
+};
+
+struct FileLayout {
+
+    FileLayout(int numStencils, int numElements) {
+        sizesOffset   = align(sizeof(FileHeader));
+        offsetsOffset = align(sizesOffset + numStencils);
+        indicesOffset = align(offsetsOffset + numStencils*sizeof(int));
+        weightsOffset = align(indicesOffset + numElements*sizeof(int));
+        fileSize      = weightsOffset + numElements*sizeof(float);
+    }
+
+    static size_t align(size_t offset) {
+        return BinaryFile::Align(offset);
+    }
+
+    size_t sizesOffset,
+           offsetsOffset,
+           indicesOffset,
+           weightsOffset,
+           fileSize;
+};
+
+// Returns true if the header is valid (byte-swapping it if needed)
+bool
+validateHeader(FileHeader & header, bool * swapped) {
+
+    if (memcmp(header.magic, fileMagic, sizeof(fileMagic))!=0) {
+        return false;
+    }
+
+    *swapped = (header.byteOrder==swappedByteOrderTag);
+    if (*swapped) {
+        BinaryFile::SwapBytes(&header.byteOrder, 6);
+    }
+
+    return header.byteOrder==byteOrderTag and
+           header.version==OpenSubdiv::Far::StencilTablesSerializer::FORMAT_VERSION and
+           header.numStencils>=0 and header.numControlVertices>=0 and
+           header.numElements>=0;
+}
+
+// Returns true if the stencils only reference elements of the tables and
+// existing control vertices
+bool
+validateStencils(unsigned char const * sizes, int const * offsets,
+    int const * indices, int numStencils, int numElements,
+        int numControlVertices) {
+
+    for (int i=0; i<numStencils; ++i) {
+        if (offsets[i]<0 or offsets[i]>numElements-sizes[i]) {
+            return false;
+        }
+    }
+    for (int i=0; i<numElements; ++i) {
+        if (indices[i]<0 or indices[i]>=numControlVertices) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // end namespace unnamed
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+bool
+StencilTablesSerializer::Write(StencilTables const & tables,
+    char const * filename) {
+
+    if (not tables._varyingSizes.empty()) {
+        return false;
+    }
+
+    int nstencils = tables.GetNumStencils(),
+        nelems = (int)tables._indices.size();
+
+    // The offsets are optional in the tables, but always stored
+    std::vector<int> offsets;
+    int const * stencilOffsets = 0;
+    if ((int)tables._offsets.size()==nstencils) {
+        stencilOffsets = nstencils ? &tables._offsets[0] : 0;
+    } else {
+        offsets.resize(nstencils);
+        for (int i=0, ofs=0; i<nstencils; ++i) {
+            offsets[i] = ofs;
+            ofs += tables._sizes[i];
+        }
+        stencilOffsets = nstencils ? &offsets[0] : 0;
+    }
+
+    FileHeader header;
+    memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.byteOrder = byteOrderTag;
+    header.version = FORMAT_VERSION;
+    header.numStencils = nstencils;
+    header.numControlVertices = tables.GetNumControlVertices();
+    header.numElements = nelems;
+    header.reserved = 0;
+
+    FileLayout layout(nstencils, nelems);
+
+    FILE * fp = fopen(filename, "wb");
+    if (not fp) {
+        return false;
+    }
+
+    bool success =
+        BinaryFile::WritePadded(fp, &header, sizeof(FileHeader),
+            layout.sizesOffset) and
+        BinaryFile::WritePadded(fp, nstencils ? &tables._sizes[0] : 0, nstencils,
+            layout.offsetsOffset-layout.sizesOffset) and
+        BinaryFile::WritePadded(fp, stencilOffsets, nstencils*sizeof(int),
+            layout.indicesOffset-layout.offsetsOffset) and
+        BinaryFile::WritePadded(fp, nelems ? &tables._indices[0] : 0, nelems*sizeof(int),
+            layout.weightsOffset-layout.indicesOffset) and
+        BinaryFile::WritePadded(fp, nelems ? &tables._weights[0] : 0, nelems*sizeof(float),
+            layout.fileSize-layout.weightsOffset);
+
+    return (fclose(fp)==0) and success;
+}
+
+StencilTables const *
+StencilTablesSerializer::Read(char const * filename) {
+
+    FILE * fp = fopen(filename, "rb");
+    if (not fp) {
+        return 0;
+    }
+
+    FileHeader header;
+    bool swapped = false;
+    if (fread(&header, sizeof(FileHeader), 1, fp)!=1 or
+        not validateHeader(header, &swapped)) {
+        fclose(fp);
+        return 0;
+    }
+
+    int nstencils = header.numStencils,
+        nelems = header.numElements;
+
+    // Make sure the file holds the arrays declared by the header before
+    // allocating them (a truncated or corrupt header would otherwise trigger
+    // arbitrarily large allocations)
+    FileLayout layout(nstencils, nelems);
+    if (BinaryFile::GetSize(fp)<layout.fileSize) {
+        fclose(fp);
+        return 0;
+    }
+
+    StencilTables * result = new StencilTables;
+    result->_numControlVertices = header.numControlVertices;
+    result->_sizes.resize(nstencils);
+    result->_offsets.resize(nstencils);
+    result->_indices.resize(nelems);
+    result->_weights.resize(nelems);
+
+    bool success =
+        BinaryFile::ReadAt(fp, layout.sizesOffset,
+            nstencils ? &result->_sizes[0] : 0, nstencils) and
+        BinaryFile::ReadAt(fp, layout.offsetsOffset,
+            nstencils ? &result->_offsets[0] : 0, nstencils*sizeof(int)) and
+        BinaryFile::ReadAt(fp, layout.indicesOffset,
+            nelems ? &result->_indices[0] : 0, nelems*sizeof(int)) and
+        BinaryFile::ReadAt(fp, layout.weightsOffset,
+            nelems ? &result->_weights[0] : 0, nelems*sizeof(float));
+    fclose(fp);
+
+    if (not success) {
+        delete result;
+        return 0;
+    }
+
+    if (swapped) {
+        if (nstencils) {
+            BinaryFile::SwapBytes(&result->_offsets[0], nstencils);
+        }
+        if (nelems) {
+            BinaryFile::SwapBytes(&result->_indices[0], nelems);
+            BinaryFile::SwapBytes(&result->_weights[0], nelems);
+        }
+    }
+
+    if (not validateStencils(nstencils ? &result->_sizes[0] : 0,
+            nstencils ? &result->_offsets[0] : 0,
+                nelems ? &result->_indices[0] : 0, nstencils, nelems,
+                    result->_numControlVertices)) {
+        delete result;
+        return 0;
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+
+MappedStencilTables::MappedStencilTables() :
+    _mapping(0), _numStencils(0), _numControlVertices(0), _numElements(0),
+        _sizes(0), _offsets(0), _indices(0), _weights(0) {
+}
+
+MappedStencilTables::~MappedStencilTables() {
+    delete _mapping;
+}
+
+MappedStencilTables const *
+MappedStencilTables::Open(char const * filename, bool validate) {
+
+    FileMapping * mapping = FileMapping::Open(filename);
+    if (not mapping) {
+        return 0;
+    }
+
+    // Validate the header (the byte order must be the host's to use the
+    // arrays in place) and the size of the file
+    FileHeader header;
+    bool swapped = false;
+    if (mapping->GetSize()<sizeof(FileHeader)) {
+        delete mapping;
+        return 0;
+    }
+    memcpy(&header, mapping->GetData(), sizeof(FileHeader));
+    if (not validateHeader(header, &swapped) or swapped) {
+        delete mapping;
+        return 0;
+    }
+
+    FileLayout layout(header.numStencils, header.numElements);
+    if (mapping->GetSize()<layout.fileSize) {
+        delete mapping;
+        return 0;
+    }
+
+    unsigned char const * data = mapping->GetData();
+
+    MappedStencilTables * result = new MappedStencilTables;
+    result->_mapping = mapping;
+    result->_numStencils = header.numStencils;
+    result->_numControlVertices = header.numControlVertices;
+    result->_numElements = header.numElements;
+    result->_sizes   = data + layout.sizesOffset;
+    result->_offsets = (int const *)(data + layout.offsetsOffset);
+    result->_indices = (int const *)(data + layout.indicesOffset);
+    result->_weights = (float const *)(data + layout.weightsOffset);
+
+    if (validate and not validateStencils(result->_sizes, result->_offsets,
+            result->_indices, result->_numStencils, result->_numElements,
+                result->_numControlVertices)) {
+        delete result;
+        return 0;
+    }
+    return result;
+}
+
+StencilTables const *
+MappedStencilTables::CreateStencilTables() const {
+
+    StencilTables * result = new StencilTables;
+    result->_numControlVertices = _numControlVertices;
+    result->_sizes.assign(_sizes, _sizes + _numStencils);
+    result->_offsets.assign(_offsets, _offsets + _numStencils);
+    result->_indices.assign(_indices, _indices + _numElements);
+    result->_weights.assign(_weights, _weights + _numElements);
+    return result;
+}
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
@@ -0,0 +1,213 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef FAR_STENCILTABLES_SERIALIZER_H
+#define FAR_STENCILTABLES_SERIALIZER_H
+
+#include "../version.h"
+
+#include "../far/stencilTables.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Far {
+
+class FileMapping;
+
+/// \brief Binary serialization of StencilTables
+///
+/// The tables are stored as a small header followed by the raw arrays of
+/// sizes, offsets, control vertex indices and weights. The header records a
+/// format version and the byte order of the writer: tables written on a host
+/// of different endianness can still be read (and are byte-swapped), but
+/// cannot be mapped.
+///
+/// Each array starts on a 16 bytes boundary of the file, so a file mapped in
+/// memory can be used in place (see MappedStencilTables).
+///
+class StencilTablesSerializer {
+
+public:
+
+    /// \brief Version of the binary format written
+    enum { FORMAT_VERSION = 1 };
+
+    /// \brief Writes the tables to a binary file
+    ///
+    /// @param tables    The tables to serialize
+    ///
+    /// @param filename  Path of the file to (over)write
+    ///
+    /// @return          False if the file could not be written, or if the
+    ///                  tables are fused (the varying weights are not
+    ///                  supported by the file format)
+    ///
+    static bool Write(StencilTables const & tables, char const * filename);
+
+    /// \brief Reads tables from a binary file into a new StencilTables
+    ///
+    /// @param filename  Path of the file to read
+    ///
+    /// @return          The tables or 0 if the file could not be read, is
+    ///                  not a valid stencil tables file, or holds stencils
+    ///                  referencing elements or control vertices out of range
+    ///
+    static StencilTables const * Read(char const * filename);
+};
+
+/// \brief Read-only StencilTables mapped in memory from a binary file
+///
+/// The arrays of the tables are used in place from the mapped file, so
+/// opening the tables does not copy them: pages are loaded on demand and
+/// shared through the page cache by all the processes mapping the same file.
+///
+/// The Osd compute contexts accept the mapped tables directly (the GPU
+/// contexts upload the arrays from the mapping), and CreateStencilTables()
+/// returns a StencilTables for the other consumers of the tables.
+///
+class MappedStencilTables {
+
+public:
+
+    /// \brief Maps the tables written by StencilTablesSerializer::Write()
+    ///
+    /// @param filename  Path of the file to map
+    ///
+    /// @param validate  If true, the stencils are checked to only reference
+    ///                  elements of the tables and existing control vertices,
+    ///                  as StencilTablesSerializer::Read() does (this reads
+    ///                  the sizes, offsets and indices of the whole file).
+    ///                  Only files from a trusted source should be opened
+    ///                  without validation : the stencils of a corrupt file
+    ///                  would read out of the bounds of the mapping.
+    ///
+    /// @return          The mapped tables or 0 if the file could not be
+    ///                  mapped, is not a valid stencil tables file or was
+    ///                  written with a different byte order
+    ///
+    static MappedStencilTables const * Open(char const * filename,
+        bool validate=true);
+
+    /// \brief Destructor (unmaps the file)
+    ~MappedStencilTables();
+
+    /// \brief Returns a copy of the tables in a new StencilTables
+    ///
+    /// For the consumers that require a StencilTables (the factories,
+    /// StencilTablesFactory::Reorder()...).
+    ///
+    StencilTables const * CreateStencilTables() const;
+
+    /// \brief Returns the number of stencils in the table
+    int GetNumStencils() const {
+        return _numStencils;
+    }
+
+    int GetNumControlVertices() const {
+        return _numControlVertices;
+    }
+
+    /// \brief Returns the number of control vertex indices (and weights) of
+    ///        all the stencils
+    int GetNumElements() const {
+        return _numElements;
+    }
+
+    /// \brief Returns a Stencil at index i in the tables
+    Stencil GetStencil(int i) const {
+        int ofs = _offsets[i];
+        return Stencil( const_cast<unsigned char *>(&_sizes[i]),
+                        const_cast<int *>(&_indices[ofs]),
+                        const_cast<float *>(&_weights[ofs]) );
+    }
+
+    /// \brief Returns the number of control vertices of each stencil
+    unsigned char const * GetSizes() const {
+        return _sizes;
+    }
+
+    /// \brief Returns the offset to each stencil
+    int const * GetOffsets() const {
+        return _offsets;
+    }
+
+    /// \brief Returns the indices of the control vertices
+    int const * GetControlIndices() const {
+        return _indices;
+    }
+
+    /// \brief Returns the stencil interpolation weights
+    float const * GetWeights() const {
+        return _weights;
+    }
+
+    /// \brief Updates point values based on the control values
+    ///
+    /// @param controlValues  Buffer with primvar data for the control vertices
+    ///
+    /// @param values         Destination buffer for the interpolated primvar
+    ///                       data
+    ///
+    /// @param start          (skip to )index of first value to update
+    ///
+    /// @param end            Index of last value to update
+    ///
+    template <class T>
+    void UpdateValues(T const *controlValues, T *values, int start=-1, int end=-1) const {
+
+        StencilTables::_UpdateTables(controlValues, values, _sizes, _offsets,
+            _indices, _weights, _numStencils, start, end);
+    }
+
+private:
+
+    MappedStencilTables();
+
+    // Non-copyable (owns the mapping)
+    MappedStencilTables(MappedStencilTables const &);
+    MappedStencilTables & operator=(MappedStencilTables const &);
+
+private:
+
+    FileMapping * _mapping;  // the mapped file
+
+    int _numStencils,
+        _numControlVertices,
+        _numElements;
+
+    unsigned char const * _sizes;   // arrays within the mapped file
+    int const           * _offsets,
+                        * _indices;
+    float const         * _weights;
+};
+
+} // end namespace Far
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+} // end namespace OpenSubdiv
+
+#endif // FAR_STENCILTABLES_SERIALIZER_H
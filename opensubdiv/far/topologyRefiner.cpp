@@ -24,6 +24,7 @@
 #include "../far/topologyRefiner.h"
 #include "../vtr/sparseSelector.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 
@@ -41,7 +42,8 @@ TopologyRefiner::TopologyRefiner(Sdc::Type schemeType, Sdc::Options schemeOption
     _subdivType(schemeType),
     _subdivOptions(schemeOptions),
     _isUniform(true),
-    _maxLevel(0) {
+    _maxLevel(0),
+    _sparseMaxLevel(0) {
 
     //  Need to revisit allocation scheme here -- want to use smart-ptrs for these
     //  but will probably have to settle for explicit new/delete...
@@ -57,12 +59,14 @@ TopologyRefiner::Unrefine() {
         _levels.resize(1);
     }
     _refinements.clear();
+    _sparseFaceLevels.clear();
 }
 
 void
 TopologyRefiner::Clear() {
     _levels.clear();
     _refinements.clear();
+    _sparseFaceLevels.clear();
 }
 
 
@@ -159,11 +163,15 @@ TopologyRefiner::GetPtexIndex(Index f) const {
 //
 //  Main refinement method -- allocating and initializing levels and refinements:
 //
-void
-TopologyRefiner::RefineUniform(int maxLevel, bool fullTopology) {
+bool
+TopologyRefiner::RefineUniform(int maxLevel, bool fullTopology, ThreadingType threading) {
 
     assert(_levels[0].getNumVertices() > 0);  //  Make sure the base level has been initialized
-    assert(_subdivType == Sdc::TYPE_CATMARK);
+
+    //  Vtr::Refinement only supports the quad split shared by Catmark and Bilinear:
+    if (_subdivType == Sdc::TYPE_LOOP) {
+        return false;
+    }
 
     //
     //  Allocate the stack of levels and the refinements between them:
@@ -171,6 +179,8 @@ TopologyRefiner::RefineUniform(int maxLevel, bool fullTopology) {
     _isUniform = true;
     _maxLevel = maxLevel;
 
+    _sparseFaceLevels.clear();
+
     _levels.resize(maxLevel + 1);
     _refinements.resize(maxLevel);
 
@@ -178,7 +188,8 @@ TopologyRefiner::RefineUniform(int maxLevel, bool fullTopology) {
     //  Initialize refinement options for Vtr -- adjusting full-topology for the last level:
     //
     Vtr::Refinement::Options refineOptions;
-    refineOptions._sparse = false;
+    refineOptions._sparse    = false;
+    refineOptions._threading = threading;
 
     for (int i = 1; i <= maxLevel; ++i) {
         refineOptions._faceTopologyOnly = fullTopology ? false : (i == maxLevel);
@@ -187,14 +198,19 @@ TopologyRefiner::RefineUniform(int maxLevel, bool fullTopology) {
         _refinements[i-1].initialize(_levels[i-1], _levels[i]);
         _refinements[i-1].refine(refineOptions);
     }
+    return true;
 }
 
 
-void
-TopologyRefiner::RefineAdaptive(int subdivLevel, bool fullTopology) {
+bool
+TopologyRefiner::RefineAdaptive(int subdivLevel, bool fullTopology, ThreadingType threading) {
 
     assert(_levels[0].getNumVertices() > 0);  //  Make sure the base level has been initialized
-    assert(_subdivType == Sdc::TYPE_CATMARK);
+
+    //  Features are only isolated (and represented by bicubic patches) for Catmark:
+    if (_subdivType != Sdc::TYPE_CATMARK) {
+        return false;
+    }
 
     //
     //  Allocate the stack of levels and the refinements between them:
@@ -202,6 +218,8 @@ TopologyRefiner::RefineAdaptive(int subdivLevel, bool fullTopology) {
     _isUniform = false;
     _maxLevel = subdivLevel;
 
+    _sparseFaceLevels.clear();
+
     //  Should we presize all or grow one at a time as needed?
     _levels.resize(subdivLevel + 1);
     _refinements.resize(subdivLevel);
@@ -213,6 +231,7 @@ TopologyRefiner::RefineAdaptive(int subdivLevel, bool fullTopology) {
 
     refineOptions._sparse           = true;
     refineOptions._faceTopologyOnly = !fullTopology;
+    refineOptions._threading        = threading;
 
     for (int i = 1; i <= subdivLevel; ++i) {
         //  Keeping full topology on for debugging -- may need to go back a level and "prune"
@@ -258,6 +277,619 @@ TopologyRefiner::RefineAdaptive(int subdivLevel, bool fullTopology) {
             break;
         }
     }
+    return true;
+}
+
+
+//
+//  Selective refinement -- refines all faces whose target level (inherited from the base
+//  face) exceeds that of the parent level.  Features are not isolated beyond the target
+//  levels, which are raised where needed for the leaf faces to be represented by patches
+//  (see initializeSparseFaceLevels()):
+//
+bool
+TopologyRefiner::RefineSparse(int maxLevel, int const * faceLevels, bool fullTopology,
+                              ThreadingType threading) {
+
+    assert(_levels[0].getNumVertices() > 0);  //  Make sure the base level has been initialized
+    assert(faceLevels);
+
+    //  As in RefineAdaptive(), the leaf faces are only represented by patches for Catmark:
+    if (_subdivType != Sdc::TYPE_CATMARK) {
+        return false;
+    }
+
+    _sparseMaxLevel = maxLevel;
+    initializeSparseFaceLevels(faceLevels, _sparseFaceLevels);
+
+    refineSparse(0, fullTopology, threading);
+    return true;
+}
+
+int
+TopologyRefiner::UpdateSparse(int const * faceLevels, std::vector<Index> & vertexOrigins,
+                              ThreadingType threading) {
+
+    //  Make sure the topology was last refined by RefineSparse():
+    assert(!_isUniform && ((int)_sparseFaceLevels.size() == _levels[0].getNumFaces()));
+    assert(faceLevels);
+
+    std::vector<int> targetLevels;
+    initializeSparseFaceLevels(faceLevels, targetLevels);
+
+    //
+    //  The faces descended from a base face whose target level changed from a to b are
+    //  selected differently in all levels from min(a,b) to max(a,b)-1 -- so all levels
+    //  up to and including the lowest of these (as well as the refinements generating
+    //  them) are unaffected:
+    //
+    int keptLevel = _maxLevel;
+    bool changed = false;
+    for (Vtr::Index face = 0; face < (int)targetLevels.size(); ++face) {
+        if (targetLevels[face] != _sparseFaceLevels[face]) {
+            keptLevel = std::min(keptLevel, std::min(targetLevels[face], _sparseFaceLevels[face]));
+            changed = true;
+        }
+    }
+    _sparseFaceLevels.swap(targetLevels);
+
+    if (!changed) {
+        vertexOrigins.resize(GetNumVerticesTotal());
+        for (Index vert = 0; vert < (Index)vertexOrigins.size(); ++vert) {
+            vertexOrigins[vert] = vert;
+        }
+        return keptLevel;
+    }
+
+    //
+    //  The kept refinements refer to the kept levels, so nothing beyond the base level
+    //  can be kept if the vectors cannot hold maxLevel without being reallocated:
+    //
+    if (((int)_levels.capacity() <= _sparseMaxLevel) ||
+        ((int)_refinements.capacity() < _sparseMaxLevel)) {
+        keptLevel = 0;
+    }
+
+    //
+    //  Retain the parent-to-child mappings of the refinements about to be regenerated
+    //  (and the faces of their parent levels) to match the new vertices with the old:
+    //
+    std::vector<SparseChildMapping> mappings(_maxLevel - keptLevel);
+    for (int level = keptLevel; level < _maxLevel; ++level) {
+        detachSparseChildMapping(level, level > keptLevel, mappings[level - keptLevel]);
+    }
+
+    refineSparse(keptLevel, true, threading);
+
+    matchSparseVertices(keptLevel, mappings, vertexOrigins);
+
+    return keptLevel;
+}
+
+//
+//  Detaches the parent-to-child mapping of the refinement of the given level (and the
+//  face-vertex counts and offsets of the level itself if it is to be discarded too):
+//
+void
+TopologyRefiner::detachSparseChildMapping(int level, bool detachParentLevel,
+                                          SparseChildMapping & mapping) {
+
+    Vtr::Refinement & refinement = _refinements[level];
+
+    if (detachParentLevel) {
+        mapping.faceVertCountsAndOffsets.swap(_levels[level]._faceVertCountsAndOffsets);
+    }
+
+    mapping.faceChildFaces.swap(refinement._faceChildFaceIndices);
+    mapping.faceChildEdges.swap(refinement._faceChildEdgeIndices);
+    mapping.faceChildVerts.swap(refinement._faceChildVertIndex);
+    mapping.edgeChildEdges.swap(refinement._edgeChildEdgeIndices);
+    mapping.edgeChildVerts.swap(refinement._edgeChildVertIndex);
+    mapping.vertChildVerts.swap(refinement._vertChildVertIndex);
+
+    int numChildVerts = (int)refinement._childVertexTag.size();
+
+    mapping.incompleteChildVerts.resize(numChildVerts);
+    for (Index cVert = 0; cVert < numChildVerts; ++cVert) {
+        mapping.incompleteChildVerts[cVert] = refinement._childVertexTag[cVert]._incomplete;
+    }
+}
+
+//
+//  Matches the vertices of the levels regenerated by UpdateSparse() with those of the
+//  discarded levels, given the parent-to-child mappings of the discarded refinements.
+//
+//  Components descended from corresponding parents in the same way correspond, starting
+//  with the identical components of the kept level.  A corresponding vertex is carried
+//  over if the vertices involved in its interpolation (see interpolateChildVerts()) are
+//  all carried over -- and if its neighborhood is complete in both refinements, so that
+//  its rules (and the topology its interpolation gathers) are the same:
+//
+//      - the child vertex of a face:    the vertices of the face
+//      - the child vertex of an edge:   the vertices of the edge and of its faces
+//      - the child vertex of a vertex:  the vertex, those opposite its edges and the
+//                                       vertices of its faces
+//
+void
+TopologyRefiner::matchSparseVertices(int keptLevel,
+                                     std::vector<SparseChildMapping> const & mappings,
+                                     std::vector<Index> & vertexOrigins) const {
+
+    vertexOrigins.resize(GetNumVerticesTotal());
+
+    //  Vertices of the kept levels are carried over as is:
+    Index vertOffset = 0;
+    for (int level = 0; level <= keptLevel; ++level) {
+        vertOffset += _levels[level].getNumVertices();
+    }
+    for (Index vert = 0; vert < vertOffset; ++vert) {
+        vertexOrigins[vert] = vert;
+    }
+
+    //  Corresponding faces and edges, and origins of the vertices carried over, of the
+    //  parent level of each refinement:
+    std::vector<Index> faceOrigins,
+                       edgeOrigins,
+                       vertOrigins,
+                       childFaceOrigins,
+                       childEdgeOrigins,
+                       childVertOrigins;
+
+    std::vector<bool> facesCarried;
+
+    Index prevVertOffset = vertOffset;
+
+    for (int level = keptLevel; level < _maxLevel; ++level) {
+
+        Vtr::Refinement const & refinement = _refinements[level];
+
+        Vtr::Level const & parent = refinement.parent(),
+                         & child  = refinement.child();
+
+        if (level == keptLevel) {
+            faceOrigins.resize(parent.getNumFaces());
+            for (Index face = 0; face < parent.getNumFaces(); ++face) {
+                faceOrigins[face] = face;
+            }
+            edgeOrigins.resize(parent.getNumEdges());
+            for (Index edge = 0; edge < parent.getNumEdges(); ++edge) {
+                edgeOrigins[edge] = edge;
+            }
+            vertOrigins.resize(parent.getNumVertices());
+            for (Index vert = 0; vert < parent.getNumVertices(); ++vert) {
+                vertOrigins[vert] = vert;
+            }
+        }
+
+        childFaceOrigins.assign(child.getNumFaces(), Vtr::INDEX_INVALID);
+        childEdgeOrigins.assign(child.getNumEdges(), Vtr::INDEX_INVALID);
+        childVertOrigins.assign(child.getNumVertices(), Vtr::INDEX_INVALID);
+
+        //  Nothing corresponds beyond the highest of the discarded levels:
+        int mappingIndex = level - keptLevel;
+        if (mappingIndex < (int)mappings.size()) {
+            SparseChildMapping const & mapping = mappings[mappingIndex];
+
+            //  Faces whose vertices are all carried over:
+            facesCarried.resize(parent.getNumFaces());
+            for (Index face = 0; face < parent.getNumFaces(); ++face) {
+                IndexArray const fVerts = parent.getFaceVertices(face);
+
+                bool carried = true;
+                for (int i = 0; carried && (i < fVerts.size()); ++i) {
+                    carried = Vtr::IndexIsValid(vertOrigins[fVerts[i]]);
+                }
+                facesCarried[face] = carried;
+            }
+
+            //  Children of faces:
+            for (Index face = 0; face < parent.getNumFaces(); ++face) {
+                Index pFace = faceOrigins[face];
+                if (!Vtr::IndexIsValid(pFace)) continue;
+
+                int offset     = parent.getOffsetOfFaceVertices(face),
+                    prevOffset = mapping.faceVertCountsAndOffsets.empty() ?
+                                 parent.getOffsetOfFaceVertices(pFace) :
+                                 mapping.faceVertCountsAndOffsets[2*pFace + 1];
+
+                for (int i = 0; i < parent.getNumFaceVertices(face); ++i) {
+                    Index cFace     = refinement._faceChildFaceIndices[offset + i],
+                          cEdge     = refinement._faceChildEdgeIndices[offset + i],
+                          prevCFace = mapping.faceChildFaces[prevOffset + i],
+                          prevCEdge = mapping.faceChildEdges[prevOffset + i];
+
+                    if (Vtr::IndexIsValid(cFace) && Vtr::IndexIsValid(prevCFace)) {
+                        childFaceOrigins[cFace] = prevCFace;
+                    }
+                    if (Vtr::IndexIsValid(cEdge) && Vtr::IndexIsValid(prevCEdge)) {
+                        childEdgeOrigins[cEdge] = prevCEdge;
+                    }
+                }
+
+                Index cVert     = refinement._faceChildVertIndex[face],
+                      prevCVert = mapping.faceChildVerts[pFace];
+
+                if (Vtr::IndexIsValid(cVert) && Vtr::IndexIsValid(prevCVert) && facesCarried[face]) {
+                    childVertOrigins[cVert] = prevCVert;
+                }
+            }
+
+            //  Children of edges:
+            for (Index edge = 0; edge < parent.getNumEdges(); ++edge) {
+                Index pEdge = edgeOrigins[edge];
+                if (!Vtr::IndexIsValid(pEdge)) continue;
+
+                for (int i = 0; i < 2; ++i) {
+                    Index cEdge     = refinement._edgeChildEdgeIndices[2*edge + i],
+                          prevCEdge = mapping.edgeChildEdges[2*pEdge + i];
+
+                    if (Vtr::IndexIsValid(cEdge) && Vtr::IndexIsValid(prevCEdge)) {
+                        childEdgeOrigins[cEdge] = prevCEdge;
+                    }
+                }
+
+                Index cVert     = refinement._edgeChildVertIndex[edge],
+                      prevCVert = mapping.edgeChildVerts[pEdge];
+
+                if (!Vtr::IndexIsValid(cVert) || !Vtr::IndexIsValid(prevCVert) ||
+                    refinement._childVertexTag[cVert]._incomplete ||
+                    mapping.incompleteChildVerts[prevCVert]) continue;
+
+                IndexArray const eVerts = parent.getEdgeVertices(edge),
+                                 eFaces = parent.getEdgeFaces(edge);
+
+                bool carried = Vtr::IndexIsValid(vertOrigins[eVerts[0]]) &&
+                               Vtr::IndexIsValid(vertOrigins[eVerts[1]]);
+                for (int i = 0; carried && (i < eFaces.size()); ++i) {
+                    carried = facesCarried[eFaces[i]];
+                }
+                if (carried) {
+                    childVertOrigins[cVert] = prevCVert;
+                }
+            }
+
+            //  Children of vertices (only those of vertices carried over can be):
+            for (Index vert = 0; vert < parent.getNumVertices(); ++vert) {
+                Index pVert = vertOrigins[vert];
+                if (!Vtr::IndexIsValid(pVert)) continue;
+
+                Index cVert     = refinement._vertChildVertIndex[vert],
+                      prevCVert = mapping.vertChildVerts[pVert];
+
+                if (!Vtr::IndexIsValid(cVert) || !Vtr::IndexIsValid(prevCVert) ||
+                    refinement._childVertexTag[cVert]._incomplete ||
+                    mapping.incompleteChildVerts[prevCVert]) continue;
+
+                IndexArray const vEdges = parent.getVertexEdges(vert),
+                                 vFaces = parent.getVertexFaces(vert);
+
+                bool carried = true;
+                for (int i = 0; carried && (i < vEdges.size()); ++i) {
+                    IndexArray const eVerts = parent.getEdgeVertices(vEdges[i]);
+                    carried = Vtr::IndexIsValid(vertOrigins[(eVerts[0] == vert) ? eVerts[1] : eVerts[0]]);
+                }
+                for (int i = 0; carried && (i < vFaces.size()); ++i) {
+                    carried = facesCarried[vFaces[i]];
+                }
+                if (carried) {
+                    childVertOrigins[cVert] = prevCVert;
+                }
+            }
+        }
+
+        //  Origins of the vertices of the child level in the previous vertex buffer:
+        for (Index cVert = 0; cVert < child.getNumVertices(); ++cVert) {
+            vertexOrigins[vertOffset + cVert] = Vtr::IndexIsValid(childVertOrigins[cVert]) ?
+                prevVertOffset + childVertOrigins[cVert] : Vtr::INDEX_INVALID;
+        }
+        vertOffset += child.getNumVertices();
+
+        if (mappingIndex < (int)mappings.size()) {
+            prevVertOffset += (Index)mappings[mappingIndex].incompleteChildVerts.size();
+        }
+
+        faceOrigins.swap(childFaceOrigins);
+        edgeOrigins.swap(childEdgeOrigins);
+        vertOrigins.swap(childVertOrigins);
+    }
+}
+
+//
+//  Clamps the target levels of the base faces to the highest level of the sparse
+//  refinement and raises them until the leaf faces of the refinement can all be
+//  represented by patches:
+//
+//      - faces that are not quads, or quads with more than two or two opposite boundary
+//        edges (see catmarkFeatureAdaptiveSelector()), or that touch the boundary at more
+//        than one vertex but not along an edge or have more than one extra-ordinary
+//        vertex, are refined at least once
+//      - faces around non-manifold vertices are refined to the highest level, as with
+//        RefineAdaptive()
+//      - faces sharing a vertex differ in level by no more than one
+//      - faces around an extra-ordinary vertex share the same level, so the Gregory
+//        patches at their leaves only border leaves of the same level
+//      - Gregory patches cannot be transitional, so faces whose leaves are Gregory
+//        patches and which border a face of a higher level are refined once more
+//
+//  Levels are only ever raised (and never beyond maxLevel), so this terminates once a
+//  pass raises none:
+//
+void
+TopologyRefiner::initializeSparseFaceLevels(int const * faceLevels,
+                                            std::vector<int> & targetLevels) const {
+
+    Vtr::Level const& baseLevel = _levels[0];
+
+    int maxLevel = _sparseMaxLevel;
+
+    targetLevels.resize(baseLevel.getNumFaces());
+    for (Vtr::Index face = 0; face < baseLevel.getNumFaces(); ++face) {
+        targetLevels[face] = std::max(0, std::min(faceLevels[face], maxLevel));
+    }
+    if (maxLevel == 0) return;
+
+    //
+    //  Raise the faces that patches cannot represent at level 0 to their minimum levels.
+    //  Gregory patches are only watertight when the extra-ordinary vertex of each is
+    //  isolated from all others in the neighborhood of the patch, which (at the leaves of
+    //  base faces with irregular features) is the case after one level of refinement if
+    //  the vertex is the only irregular feature of the faces around it, or after two
+    //  levels otherwise:
+    //
+    std::vector<bool> xordFaces(baseLevel.getNumFaces(), false);
+
+    for (Vtr::Index face = 0; face < baseLevel.getNumFaces(); ++face) {
+        Vtr::IndexArray const fVerts = baseLevel.getFaceVertices(face);
+        Vtr::IndexArray const fEdges = baseLevel.getFaceEdges(face);
+
+        int xordCount = 0,
+            boundaryVertCount = 0,
+            boundaryEdgeMask = 0;
+        bool nonManifold = false;
+        Vtr::Index xordVert = Vtr::INDEX_INVALID;
+        for (int i = 0; i < fVerts.size(); ++i) {
+            Vtr::Level::VTag const& vTag = baseLevel._vertTags[fVerts[i]];
+
+            if (vTag._xordinary) {
+                xordVert = fVerts[i];
+                xordCount ++;
+            }
+            boundaryVertCount += vTag._boundary;
+            nonManifold       |= vTag._nonManifold;
+
+            boundaryEdgeMask |= baseLevel._edgeTags[fEdges[i]]._boundary << i;
+        }
+        xordFaces[face] = (xordCount > 0);
+
+        //  Inspect the faces around the vertices of the face for other irregular features:
+        bool isolatedAtLevel0 = (fVerts.size() == 4) && (xordCount <= 1),
+             isolatedAtLevel1 = (xordCount <= ((fVerts.size() == 4) ? 1 : 0));
+        for (int i = 0; i < fVerts.size(); ++i) {
+            Vtr::IndexArray const vFaces = baseLevel.getVertexFaces(fVerts[i]);
+            for (int j = 0; j < vFaces.size(); ++j) {
+                Vtr::IndexArray const nVerts = baseLevel.getFaceVertices(vFaces[j]);
+                if (nVerts.size() != 4) {
+                    isolatedAtLevel0 = false;
+                    if ((vFaces[j] != face) && ((fVerts.size() != 4) || (fVerts[i] == xordVert))) {
+                        isolatedAtLevel1 = false;
+                    }
+                }
+                for (int k = 0; k < nVerts.size(); ++k) {
+                    if (baseLevel._vertTags[nVerts[k]]._xordinary && (nVerts[k] != xordVert)) {
+                        isolatedAtLevel0 = false;
+                    }
+                }
+            }
+        }
+
+        int minLevel = 0;
+        if (nonManifold) {
+            minLevel = maxLevel;
+        } else if ((fVerts.size() != 4) || (xordCount > 0)) {
+            minLevel = isolatedAtLevel0 ? 0 : (isolatedAtLevel1 ? 1 : 2);
+        } else if (!isolatedAtLevel0) {
+            minLevel = 1;
+        }
+        if ((boundaryEdgeMask == 0x5) || (boundaryEdgeMask == 0xa) ||
+            (boundaryEdgeMask == 0x7) || (boundaryEdgeMask == 0xb) ||
+            (boundaryEdgeMask == 0xd) || (boundaryEdgeMask == 0xe) ||
+            (boundaryEdgeMask == 0xf)) {
+            minLevel = std::max(minLevel, 1);
+        } else if ((boundaryEdgeMask == 0) && (boundaryVertCount > 1)) {
+            minLevel = std::max(minLevel, 1);
+        }
+        targetLevels[face] = std::max(targetLevels[face], std::min(minLevel, maxLevel));
+    }
+
+    //
+    //  The patches of faces near sharp features (other than boundaries, which patches
+    //  represent) only approximate them, and differently at each level -- so the faces on
+    //  either side of an edge whose vertices have a sharp feature in their neighborhood
+    //  are kept at the same level:
+    //
+    std::vector<bool> sharpVerts(baseLevel.getNumVertices(), false);
+
+    for (Vtr::Index vert = 0; vert < baseLevel.getNumVertices(); ++vert) {
+        Vtr::Level::VTag const& vTag = baseLevel._vertTags[vert];
+
+        bool sharp = vTag._semiSharp ||
+                     (vTag._infSharp && (baseLevel.getVertexFaces(vert).size() != 1));
+
+        Vtr::IndexArray const vEdges = baseLevel.getVertexEdges(vert);
+        for (int i = 0; i < vEdges.size(); ++i) {
+            Vtr::Level::ETag const& eTag = baseLevel._edgeTags[vEdges[i]];
+
+            sharp |= eTag._semiSharp || (eTag._infSharp && !eTag._boundary);
+        }
+        sharpVerts[vert] = sharp;
+    }
+
+    std::vector<bool> nearSharpVerts(sharpVerts);
+
+    for (Vtr::Index edge = 0; edge < baseLevel.getNumEdges(); ++edge) {
+        Vtr::IndexArray const eVerts = baseLevel.getEdgeVertices(edge);
+        if (sharpVerts[eVerts[0]]) nearSharpVerts[eVerts[1]] = true;
+        if (sharpVerts[eVerts[1]]) nearSharpVerts[eVerts[0]] = true;
+    }
+
+    std::vector<int> vertLevels(baseLevel.getNumVertices());
+
+    for (bool raised = true; raised; ) {
+        raised = false;
+
+        std::fill(vertLevels.begin(), vertLevels.end(), 0);
+        for (Vtr::Index face = 0; face < baseLevel.getNumFaces(); ++face) {
+            Vtr::IndexArray const fVerts = baseLevel.getFaceVertices(face);
+            for (int i = 0; i < fVerts.size(); ++i) {
+                vertLevels[fVerts[i]] = std::max(vertLevels[fVerts[i]], targetLevels[face]);
+            }
+        }
+
+        for (Vtr::Index face = 0; face < baseLevel.getNumFaces(); ++face) {
+            Vtr::IndexArray const fVerts = baseLevel.getFaceVertices(face);
+
+            int level = targetLevels[face];
+            for (int i = 0; i < fVerts.size(); ++i) {
+                int vertLevel = vertLevels[fVerts[i]];
+                if (baseLevel._vertTags[fVerts[i]]._xordinary) {
+                    level = std::max(level, vertLevel);
+                } else {
+                    level = std::max(level, vertLevel - 1);
+                }
+            }
+
+            //
+            //  The leaves of quads with an extra-ordinary vertex are Gregory patches at
+            //  level 0, as are those of all other faces at level 1 (around the vertex
+            //  introduced at their center):
+            //
+            int gregoryLevel = (fVerts.size() == 4) ? (xordFaces[face] ? 0 : -1) : 1;
+
+            Vtr::IndexArray const fEdges = baseLevel.getFaceEdges(face);
+            for (int i = 0; i < fEdges.size(); ++i) {
+                Vtr::IndexArray const eVerts = baseLevel.getEdgeVertices(fEdges[i]);
+                Vtr::IndexArray const eFaces = baseLevel.getEdgeFaces(fEdges[i]);
+
+                bool nearSharp = nearSharpVerts[eVerts[0]] || nearSharpVerts[eVerts[1]];
+                for (int j = 0; j < eFaces.size(); ++j) {
+                    if (nearSharp) {
+                        level = std::max(level, targetLevels[eFaces[j]]);
+                    } else if ((level == gregoryLevel) && (targetLevels[eFaces[j]] > level)) {
+                        level = gregoryLevel + 1;
+                    }
+                }
+            }
+
+            if (level > targetLevels[face]) {
+                targetLevels[face] = level;
+                raised = true;
+            }
+        }
+    }
+}
+
+//
+//  Regenerates the levels (and the refinements between them) of the sparse refinement
+//  following the given level -- which is kept along with all lower levels.  The kept
+//  refinements refer to the kept levels, so the level and refinement vectors must be
+//  able to hold maxLevel without being reallocated (see UpdateSparse()):
+//
+void
+TopologyRefiner::refineSparse(int keptLevel, bool fullTopology, ThreadingType threading) {
+
+    int maxLevel = _sparseMaxLevel;
+
+    assert((keptLevel == 0) ||
+           (((int)_levels.capacity() > maxLevel) && ((int)_refinements.capacity() >= maxLevel)));
+
+    _isUniform = false;
+    _maxLevel = maxLevel;
+
+    _levels.resize(keptLevel + 1);
+    _refinements.resize(keptLevel);
+
+    _levels.reserve(maxLevel + 1);
+    _refinements.reserve(maxLevel);
+
+    _levels.resize(maxLevel + 1);
+    _refinements.resize(maxLevel);
+
+    //
+    //  Initialize refinement options for Vtr -- as with feature-adaptive refinement, the
+    //  full topology is currently kept for all levels:
+    //
+    Vtr::Refinement::Options refineOptions;
+
+    refineOptions._sparse           = true;
+    refineOptions._faceTopologyOnly = !fullTopology;
+    refineOptions._threading        = threading;
+
+    //
+    //  Child faces inherit the target levels of their parent faces -- those of the faces of
+    //  the kept levels are inherited through the kept refinements:
+    //
+    std::vector<int> targetLevels(_sparseFaceLevels),
+                     childTargetLevels;
+
+    for (int i = 1; i <= keptLevel; ++i) {
+        Vtr::Refinement const& refinement = _refinements[i-1];
+
+        childTargetLevels.resize(_levels[i].getNumFaces());
+        for (Vtr::Index face = 0; face < _levels[i].getNumFaces(); ++face) {
+            childTargetLevels[face] = targetLevels[refinement.getChildFaceParentFace(face)];
+        }
+        targetLevels.swap(childTargetLevels);
+    }
+
+    for (int i = keptLevel + 1; i <= maxLevel; ++i) {
+        refineOptions._faceTopologyOnly = false;
+
+        Vtr::Level& parentLevel     = _levels[i-1];
+        Vtr::Level& childLevel      = _levels[i];
+        Vtr::Refinement& refinement = _refinements[i-1];
+
+        refinement.setScheme(_subdivType, _subdivOptions);
+        refinement.initialize(parentLevel, childLevel);
+
+        Vtr::SparseSelector selector(refinement);
+        selector.setPreviousRefinement((i-1) ? &_refinements[i-2] : 0);
+
+        faceLevelSelector(selector, i-1, &targetLevels[0]);
+
+        //
+        //  Continue refining if something selected, otherwise terminate refinement and trim
+        //  the Level and Refinement vectors (see RefineAdaptive()):
+        //
+        if (!selector.isSelectionEmpty()) {
+            refinement.refine(refineOptions);
+
+            childTargetLevels.resize(childLevel.getNumFaces());
+            for (Vtr::Index face = 0; face < childLevel.getNumFaces(); ++face) {
+                childTargetLevels[face] = targetLevels[refinement.getChildFaceParentFace(face)];
+            }
+            targetLevels.swap(childTargetLevels);
+        } else {
+            int lastLevel = i - 1;
+
+            _maxLevel = lastLevel;
+            _levels.resize(lastLevel + 1);
+            _refinements.resize(lastLevel);
+            break;
+        }
+    }
+}
+
+void
+TopologyRefiner::faceLevelSelector(Vtr::SparseSelector& selector, int level,
+                                   int const * faceLevels) {
+
+    Vtr::Level const& parentLevel = selector.getRefinement().parent();
+
+    for (Vtr::Index face = 0; face < parentLevel.getNumFaces(); ++face) {
+        if (faceLevels[face] > level) {
+            selector.selectFace(face);
+        }
+    }
 }
 
 //
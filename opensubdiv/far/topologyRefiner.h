@@ -28,12 +28,14 @@
 
 #include "../sdc/type.h"
 #include "../sdc/options.h"
+#include "../sdc/bilinearScheme.h"
 #include "../sdc/catmarkScheme.h"
 #include "../vtr/level.h"
 #include "../vtr/fvarLevel.h"
 #include "../vtr/refinement.h"
 #include "../vtr/fvarRefinement.h"
 #include "../vtr/maskInterfaces.h"
+#include "../vtr/parallel.h"
 #include "../far/types.h"
 
 #include <vector>
@@ -100,21 +102,114 @@ public:
 
     /// \brief Refine the topology uniformly
     ///
+    /// \note Only the Bilinear and Catmark schemes can be refined : the quad
+    ///       split of Vtr does not support the triangle split of Loop yet, so
+    ///       Loop refiners are left unrefined.
+    ///
     /// @param maxLevel                 Highest level of subdivision refinement
     ///
     /// @param fullTopologyInLastLevel  Skip secondary topological relationships
     ///                                 at the highest level of refinement.
     ///
-    void RefineUniform(int maxLevel, bool fullTopologyInLastLevel = false);
+    /// @param threading                Threading backend used to subdivide the
+    ///                                 topology of each level (the result is
+    ///                                 identical to that of serial refinement)
+    ///
+    /// @return                         False if the scheme of the refiner is
+    ///                                 not supported (the refiner is then left
+    ///                                 unrefined)
+    ///
+    bool RefineUniform(int maxLevel, bool fullTopologyInLastLevel = false,
+                       ThreadingType threading = THREADING_SERIAL);
 
     /// \brief Feature Adaptive topology refinement
     ///
+    /// \note Only Catmark refiners can be refined adaptively : the features
+    ///       of the other schemes are not isolated, and their refiners are
+    ///       left unrefined.
+    ///
     /// @param maxLevel                 Highest level of subdivision refinement
     ///
     /// @param fullTopologyInLastLevel  Skip secondary topological relationships
     ///                                 at the highest level of refinement.
     ///
-    void RefineAdaptive(int maxLevel, bool fullTopologyInLastLevel = false);
+    /// @param threading                Threading backend used to subdivide the
+    ///                                 topology of each level (the result is
+    ///                                 identical to that of serial refinement)
+    ///
+    /// @return                         False if the scheme of the refiner is
+    ///                                 not supported (the refiner is then left
+    ///                                 unrefined)
+    ///
+    bool RefineAdaptive(int maxLevel, bool fullTopologyInLastLevel = false,
+                        ThreadingType threading = THREADING_SERIAL);
+
+    /// \brief Selective (sparse) topology refinement
+    ///
+    /// Refines each face of the base level (and all of its child faces) to the
+    /// target level it specifies -- 0 for faces outside the region of interest,
+    /// maxLevel for faces to be refined to the full depth.  Unlike
+    /// RefineAdaptive(), features are not isolated beyond the target levels:
+    /// the patches of a face approximate the features it contains as those of
+    /// the highest level of RefineAdaptive() do (Gregory patches around
+    /// extra-ordinary vertices, regular patches across semi-sharp creases), so
+    /// the accuracy of the limit surface near features follows the target
+    /// levels.  The target levels are raised where necessary for the resulting
+    /// levels to be represented by patches: faces that are not quads (or with
+    /// irregular boundaries) are refined at least once, the patches of faces
+    /// sharing a vertex differ by no more than one level, and Gregory patches
+    /// only neighbor patches of the same level.
+    ///
+    /// @param maxLevel                 Highest level of subdivision refinement
+    ///
+    /// @param faceLevels               Target level of each face of the base
+    ///                                 level (levels above maxLevel are clamped)
+    ///
+    /// @param fullTopologyInLastLevel  Skip secondary topological relationships
+    ///                                 at the highest level of refinement.
+    ///
+    /// @param threading                Threading backend used to subdivide the
+    ///                                 topology of each level (the result is
+    ///                                 identical to that of serial refinement)
+    ///
+    /// @return                         False if the scheme of the refiner is
+    ///                                 not supported (only Catmark refiners
+    ///                                 can be refined sparsely ; the refiner
+    ///                                 is then left unrefined)
+    ///
+    bool RefineSparse(int maxLevel, int const * faceLevels,
+                      bool fullTopologyInLastLevel = false,
+                      ThreadingType threading = THREADING_SERIAL);
+
+    /// \brief Incremental selective (sparse) topology refinement
+    ///
+    /// Updates the topology last refined with RefineSparse() for new target
+    /// levels of the base faces (and the same maxLevel).  Only the levels that
+    /// are affected by the changes of the target levels are regenerated: the
+    /// levels up to the returned level (and the refinements between them) are
+    /// kept as is.  The vertices of the regenerated levels are then matched
+    /// with those of the previous refinement : a vertex that descends from
+    /// the same components and whose interpolation involves the same vertices
+    /// (so has the same value for the same control vertices) is carried over
+    /// -- see StencilTablesFactory::Update() and PatchTablesFactory::Update()
+    /// to only create the stencils and patches of the vertices that are not.
+    ///
+    /// @param faceLevels     Target level of each face of the base level
+    ///
+    /// @param vertexOrigins  Index of the previous vertex that each vertex is
+    ///                       carried over from, or -1 if it has to be
+    ///                       interpolated (the vertices being indexed as in
+    ///                       primvar buffers : the control vertices, then the
+    ///                       vertices of each level in turn)
+    ///
+    /// @param threading      Threading backend used to subdivide the topology
+    ///                       of each regenerated level
+    ///
+    /// @return               The highest level kept (GetMaxLevel() if no level
+    ///                       was regenerated)
+    ///
+    int UpdateSparse(int const * faceLevels, std::vector<Index> & vertexOrigins,
+                     ThreadingType threading = THREADING_SERIAL);
 
     /// \brief Unrefine the topology (keep control cage)
     void Unrefine();
@@ -159,6 +254,37 @@ public:
     ///
     template <class T, class U> void Interpolate(int level, T const * src, U * dst) const;
 
+    /// \brief Apply vertex and varying interpolation weights to a primvar
+    ///        buffer, distributing the work across threads
+    ///
+    /// Each level is interpolated in three successive passes -- for the child
+    /// vertices of the parent faces, edges and vertices -- each of which is
+    /// partitioned into ranges of parent components.  Each destination element
+    /// is only ever written by a single thread, so the Clear() and Add*() methods
+    /// of the destination class must not modify any data shared between elements.
+    ///
+    /// @param src        Source primvar buffer (control vertex data)
+    ///
+    /// @param dst        Destination primvar buffer (refined vertex data)
+    ///
+    /// @param threading  Threading backend used for each pass
+    ///
+    template <class T, class U> void Interpolate(T const * src, U * dst, ThreadingType threading) const;
+
+    /// \brief Apply vertex and varying interpolation weights to a primvar
+    ///        buffer for a single level of refinement, distributing the work
+    ///        across threads (see above)
+    ///
+    /// @param level      The refinement level
+    ///
+    /// @param src        Source primvar buffer (control vertex data)
+    ///
+    /// @param dst        Destination primvar buffer (refined vertex data)
+    ///
+    /// @param threading  Threading backend used for each pass
+    ///
+    template <class T, class U> void Interpolate(int level, T const * src, U * dst, ThreadingType threading) const;
+
 
     /// \brief Apply only varying interpolation weights to a primvar buffer
     ///
@@ -460,17 +586,54 @@ private:
     void catmarkFeatureAdaptiveSelector(Vtr::SparseSelector& selector);
     void catmarkFeatureAdaptiveSelectorByFace(Vtr::SparseSelector& selector);
 
-    template <class T, class U> void interpolateChildVertsFromFaces(Vtr::Refinement const &, T const * src, U * dst) const;
-    template <class T, class U> void interpolateChildVertsFromEdges(Vtr::Refinement const &, T const * src, U * dst) const;
-    template <class T, class U> void interpolateChildVertsFromVerts(Vtr::Refinement const &, T const * src, U * dst) const;
+    //  Selection for RefineSparse() of the faces of the given level whose target level
+    //  (one per face of that level) exceeds it:
+    void faceLevelSelector(Vtr::SparseSelector& selector, int level, int const * faceLevels);
+
+    //  Supporting methods for RefineSparse() and UpdateSparse():
+    void initializeSparseFaceLevels(int const * faceLevels, std::vector<int> & targetLevels) const;
+    void refineSparse(int keptLevel, bool fullTopology, ThreadingType threading);
+
+    //  The parent-to-child mapping of a refinement discarded by UpdateSparse(), retained
+    //  to match the vertices it generated with those of the new refinement:
+    struct SparseChildMapping {
+        std::vector<Index> faceVertCountsAndOffsets;  // of the parent level (if discarded)
+
+        std::vector<Index> faceChildFaces,
+                           faceChildEdges,
+                           faceChildVerts,
+                           edgeChildEdges,
+                           edgeChildVerts,
+                           vertChildVerts;
+
+        std::vector<bool>  incompleteChildVerts;
+    };
+
+    void detachSparseChildMapping(int level, bool detachParentLevel, SparseChildMapping & mapping);
+    void matchSparseVertices(int keptLevel, std::vector<SparseChildMapping> const & mappings,
+                             std::vector<Index> & vertexOrigins) const;
+
+    //  Vertex interpolation is specialized for each Sdc::Type sharing the quad split of
+    //  Vtr::Refinement (Catmark and Bilinear) and applied to a range of parent components
+    //  -- the weight buffers are allocated per call, so each thread applying a range has
+    //  its own:
+    template <Sdc::Type SCHEME, class T, class U> void interpolateChildVerts(Vtr::Refinement const &, T const * src, U * dst, ThreadingType threading) const;
+
+    template <Sdc::Type SCHEME, class T, class U> void interpolateChildVertsFromFaces(Vtr::Refinement const &, T const * src, U * dst, Index faceBegin, Index faceEnd) const;
+    template <Sdc::Type SCHEME, class T, class U> void interpolateChildVertsFromEdges(Vtr::Refinement const &, T const * src, U * dst, Index edgeBegin, Index edgeEnd) const;
+    template <Sdc::Type SCHEME, class T, class U> void interpolateChildVertsFromVerts(Vtr::Refinement const &, T const * src, U * dst, Index vertBegin, Index vertEnd) const;
+
+    template <Sdc::Type SCHEME, class T, class U> class InterpolateKernel;
 
     template <class T, class U> void varyingInterpolateChildVertsFromFaces(Vtr::Refinement const &, T const * src, U * dst) const;
     template <class T, class U> void varyingInterpolateChildVertsFromEdges(Vtr::Refinement const &, T const * src, U * dst) const;
     template <class T, class U> void varyingInterpolateChildVertsFromVerts(Vtr::Refinement const &, T const * src, U * dst) const;
 
-    template <class T, class U> void faceVaryingInterpolateChildVertsFromFaces(Vtr::Refinement const &, T const * src, U * dst, int channel) const;
-    template <class T, class U> void faceVaryingInterpolateChildVertsFromEdges(Vtr::Refinement const &, T const * src, U * dst, int channel) const;
-    template <class T, class U> void faceVaryingInterpolateChildVertsFromVerts(Vtr::Refinement const &, T const * src, U * dst, int channel) const;
+    template <Sdc::Type SCHEME, class T, class U> void faceVaryingInterpolateChildVerts(Vtr::Refinement const &, T const * src, U * dst, int channel) const;
+
+    template <Sdc::Type SCHEME, class T, class U> void faceVaryingInterpolateChildVertsFromFaces(Vtr::Refinement const &, T const * src, U * dst, int channel) const;
+    template <Sdc::Type SCHEME, class T, class U> void faceVaryingInterpolateChildVertsFromEdges(Vtr::Refinement const &, T const * src, U * dst, int channel) const;
+    template <Sdc::Type SCHEME, class T, class U> void faceVaryingInterpolateChildVertsFromVerts(Vtr::Refinement const &, T const * src, U * dst, int channel) const;
 
 
     void initializePtexIndices() const;
@@ -483,6 +646,11 @@ private:
     bool _isUniform;
     int  _maxLevel;
 
+    //  Highest level and target levels of the base faces of the last RefineSparse() (or
+    //  UpdateSparse()):
+    int              _sparseMaxLevel;
+    std::vector<int> _sparseFaceLevels;
+
     std::vector<Vtr::Level>      _levels;
     std::vector<Vtr::Refinement> _refinements;
 
@@ -493,8 +661,6 @@ template <class T, class U>
 inline void
 TopologyRefiner::Interpolate(T const * src, U * dst) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-
     for (int level=1; level<=GetMaxLevel(); ++level) {
 
         Interpolate(level, src, dst);
@@ -508,27 +674,126 @@ template <class T, class U>
 inline void
 TopologyRefiner::Interpolate(int level, T const * src, U * dst) const {
 
+    Interpolate(level, src, dst, THREADING_SERIAL);
+}
+
+template <class T, class U>
+inline void
+TopologyRefiner::Interpolate(T const * src, U * dst, ThreadingType threading) const {
+
+    for (int level=1; level<=GetMaxLevel(); ++level) {
+
+        Interpolate(level, src, dst, threading);
+
+        src = dst;
+        dst += GetNumVertices(level);
+    }
+}
+
+template <class T, class U>
+inline void
+TopologyRefiner::Interpolate(int level, T const * src, U * dst, ThreadingType threading) const {
+
     assert(level>0 and level<=(int)_refinements.size());
 
     Vtr::Refinement const & refinement = _refinements[level-1];
 
-    interpolateChildVertsFromFaces(refinement, src, dst);
-    interpolateChildVertsFromEdges(refinement, src, dst);
-    interpolateChildVertsFromVerts(refinement, src, dst);
+    switch (_subdivType) {
+        case Sdc::TYPE_BILINEAR:
+            interpolateChildVerts<Sdc::TYPE_BILINEAR>(refinement, src, dst, threading);
+            break;
+        case Sdc::TYPE_CATMARK:
+            interpolateChildVerts<Sdc::TYPE_CATMARK>(refinement, src, dst, threading);
+            break;
+        case Sdc::TYPE_LOOP:
+            //  Loop refiners are never refined (see RefineUniform()), so
+            //  there is no level to interpolate
+            break;
+    }
 }
 
-template <class T, class U>
+//
+//  Kernel applying one of the three vertex interpolation passes to a range of
+//  parent components for the threaded variants of Interpolate():
+//
+template <Sdc::Type SCHEME, class T, class U>
+class TopologyRefiner::InterpolateKernel : public Vtr::ParallelKernel {
+public:
+    enum Origin { FROM_FACES, FROM_EDGES, FROM_VERTS };
+
+    //  Enough parent components per chunk to amortize the allocation of the weights:
+    enum { GRAIN_SIZE = 1024 };
+
+    InterpolateKernel(TopologyRefiner const & refiner, Vtr::Refinement const & refinement,
+                      T const * src, U * dst, Origin origin) :
+        _refiner(refiner), _refinement(refinement), _src(src), _dst(dst), _origin(origin) { }
+
+    virtual void operator()(Index begin, Index end) const {
+        switch (_origin) {
+            case FROM_FACES:
+                _refiner.template interpolateChildVertsFromFaces<SCHEME>(_refinement, _src, _dst, begin, end);
+                break;
+            case FROM_EDGES:
+                _refiner.template interpolateChildVertsFromEdges<SCHEME>(_refinement, _src, _dst, begin, end);
+                break;
+            case FROM_VERTS:
+                _refiner.template interpolateChildVertsFromVerts<SCHEME>(_refinement, _src, _dst, begin, end);
+                break;
+        }
+    }
+
+private:
+    TopologyRefiner const & _refiner;
+    Vtr::Refinement const & _refinement;
+
+    T const * _src;
+    U       * _dst;
+
+    Origin _origin;
+};
+
+template <Sdc::Type SCHEME, class T, class U>
+inline void
+TopologyRefiner::interpolateChildVerts(
+    Vtr::Refinement const & refinement, T const * src, U * dst,
+    ThreadingType threading) const {
+
+    Vtr::Level const & parent = refinement.parent();
+
+    if (threading == THREADING_SERIAL) {
+        interpolateChildVertsFromFaces<SCHEME>(refinement, src, dst, 0, parent.getNumFaces());
+        interpolateChildVertsFromEdges<SCHEME>(refinement, src, dst, 0, parent.getNumEdges());
+        interpolateChildVertsFromVerts<SCHEME>(refinement, src, dst, 0, parent.getNumVertices());
+        return;
+    }
+
+    typedef InterpolateKernel<SCHEME, T, U> Kernel;
+
+    //  The passes for edges and vertices use the results of the pass for faces,
+    //  so only the components within each pass are distributed:
+    Vtr::ThreadingType vtrThreading = (Vtr::ThreadingType) threading;
+
+    Vtr::parallelFor(vtrThreading, 0, parent.getNumFaces(), Kernel::GRAIN_SIZE,
+        Kernel(*this, refinement, src, dst, Kernel::FROM_FACES));
+    Vtr::parallelFor(vtrThreading, 0, parent.getNumEdges(), Kernel::GRAIN_SIZE,
+        Kernel(*this, refinement, src, dst, Kernel::FROM_EDGES));
+    Vtr::parallelFor(vtrThreading, 0, parent.getNumVertices(), Kernel::GRAIN_SIZE,
+        Kernel(*this, refinement, src, dst, Kernel::FROM_VERTS));
+}
+
+template <Sdc::Type SCHEME, class T, class U>
 inline void
 TopologyRefiner::interpolateChildVertsFromFaces(
-    Vtr::Refinement const & refinement, T const * src, U * dst) const {
+    Vtr::Refinement const & refinement, T const * src, U * dst,
+    Index faceBegin, Index faceEnd) const {
 
-    Sdc::Scheme<Sdc::TYPE_CATMARK> scheme(_subdivOptions);
+    Sdc::Scheme<SCHEME> scheme(_subdivOptions);
 
     const Vtr::Level& parent = refinement.parent();
 
     float * fVertWeights = (float *)alloca(parent.getMaxValence()*sizeof(float));
 
-    for (int face = 0; face < parent.getNumFaces(); ++face) {
+    for (int face = faceBegin; face < faceEnd; ++face) {
 
         Vtr::Index cVert = refinement.getFaceChildVertex(face);
         if (!Vtr::IndexIsValid(cVert))
@@ -558,13 +823,13 @@ TopologyRefiner::interpolateChildVertsFromFaces(
     }
 }
 
-template <class T, class U>
+template <Sdc::Type SCHEME, class T, class U>
 inline void
 TopologyRefiner::interpolateChildVertsFromEdges(
-    Vtr::Refinement const & refinement, T const * src, U * dst) const {
+    Vtr::Refinement const & refinement, T const * src, U * dst,
+    Index edgeBegin, Index edgeEnd) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-    Sdc::Scheme<Sdc::TYPE_CATMARK> scheme(_subdivOptions);
+    Sdc::Scheme<SCHEME> scheme(_subdivOptions);
 
     const Vtr::Level& parent = refinement.parent();
     const Vtr::Level& child  = refinement.child();
@@ -574,7 +839,7 @@ TopologyRefiner::interpolateChildVertsFromEdges(
     float   eVertWeights[2],
           * eFaceWeights = (float *)alloca(parent.getMaxEdgeFaces()*sizeof(float));
 
-    for (int edge = 0; edge < parent.getNumEdges(); ++edge) {
+    for (int edge = edgeBegin; edge < edgeEnd; ++edge) {
 
         Vtr::Index cVert = refinement.getEdgeChildVertex(edge);
         if (!Vtr::IndexIsValid(cVert))
@@ -616,13 +881,13 @@ TopologyRefiner::interpolateChildVertsFromEdges(
     }
 }
 
-template <class T, class U>
+template <Sdc::Type SCHEME, class T, class U>
 inline void
 TopologyRefiner::interpolateChildVertsFromVerts(
-    Vtr::Refinement const & refinement, T const * src, U * dst) const {
+    Vtr::Refinement const & refinement, T const * src, U * dst,
+    Index vertBegin, Index vertEnd) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-    Sdc::Scheme<Sdc::TYPE_CATMARK> scheme(_subdivOptions);
+    Sdc::Scheme<SCHEME> scheme(_subdivOptions);
 
     const Vtr::Level& parent = refinement.parent();
     const Vtr::Level& child  = refinement.child();
@@ -631,7 +896,7 @@ TopologyRefiner::interpolateChildVertsFromVerts(
 
     float * weightBuffer = (float *)alloca(2*parent.getMaxValence()*sizeof(float));
 
-    for (int vert = 0; vert < parent.getNumVertices(); ++vert) {
+    for (int vert = vertBegin; vert < vertEnd; ++vert) {
 
         Vtr::Index cVert = refinement.getVertexChildVertex(vert);
         if (!Vtr::IndexIsValid(cVert))
@@ -692,8 +957,6 @@ template <class T, class U>
 inline void
 TopologyRefiner::InterpolateVarying(T const * src, U * dst) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-
     for (int level=1; level<=GetMaxLevel(); ++level) {
 
         InterpolateVarying(level, src, dst);
@@ -749,8 +1012,6 @@ inline void
 TopologyRefiner::varyingInterpolateChildVertsFromEdges(
     Vtr::Refinement const & refinement, T const * src, U * dst) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-
     const Vtr::Level& parent = refinement.parent();
 
     for (int edge = 0; edge < parent.getNumEdges(); ++edge) {
@@ -777,8 +1038,6 @@ inline void
 TopologyRefiner::varyingInterpolateChildVertsFromVerts(
     Vtr::Refinement const & refinement, T const * src, U * dst) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-
     const Vtr::Level& parent = refinement.parent();
 
     for (int vert = 0; vert < parent.getNumVertices(); ++vert) {
@@ -804,8 +1063,6 @@ template <class T, class U>
 inline void
 TopologyRefiner::InterpolateFaceVarying(T const * src, U * dst, int channel) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-
     for (int level=1; level<=GetMaxLevel(); ++level) {
 
         InterpolateFaceVarying(level, src, dst, channel);
@@ -823,17 +1080,36 @@ TopologyRefiner::InterpolateFaceVarying(int level, T const * src, U * dst, int c
 
     Vtr::Refinement const & refinement = _refinements[level-1];
 
-    faceVaryingInterpolateChildVertsFromFaces(refinement, src, dst, channel);
-    faceVaryingInterpolateChildVertsFromEdges(refinement, src, dst, channel);
-    faceVaryingInterpolateChildVertsFromVerts(refinement, src, dst, channel);
+    switch (_subdivType) {
+        case Sdc::TYPE_BILINEAR:
+            faceVaryingInterpolateChildVerts<Sdc::TYPE_BILINEAR>(refinement, src, dst, channel);
+            break;
+        case Sdc::TYPE_CATMARK:
+            faceVaryingInterpolateChildVerts<Sdc::TYPE_CATMARK>(refinement, src, dst, channel);
+            break;
+        case Sdc::TYPE_LOOP:
+            //  Loop refiners are never refined (see RefineUniform()), so
+            //  there is no level to interpolate
+            break;
+    }
 }
 
-template <class T, class U>
+template <Sdc::Type SCHEME, class T, class U>
+inline void
+TopologyRefiner::faceVaryingInterpolateChildVerts(
+    Vtr::Refinement const & refinement, T const * src, U * dst, int channel) const {
+
+    faceVaryingInterpolateChildVertsFromFaces<SCHEME>(refinement, src, dst, channel);
+    faceVaryingInterpolateChildVertsFromEdges<SCHEME>(refinement, src, dst, channel);
+    faceVaryingInterpolateChildVertsFromVerts<SCHEME>(refinement, src, dst, channel);
+}
+
+template <Sdc::Type SCHEME, class T, class U>
 inline void
 TopologyRefiner::faceVaryingInterpolateChildVertsFromFaces(
     Vtr::Refinement const & refinement, T const * src, U * dst, int channel) const {
 
-    Sdc::Scheme<Sdc::TYPE_CATMARK> scheme(_subdivOptions);
+    Sdc::Scheme<SCHEME> scheme(_subdivOptions);
 
     const Vtr::Level& parent = refinement.parent();
 
@@ -869,13 +1145,12 @@ TopologyRefiner::faceVaryingInterpolateChildVertsFromFaces(
     }
 }
 
-template <class T, class U>
+template <Sdc::Type SCHEME, class T, class U>
 inline void
 TopologyRefiner::faceVaryingInterpolateChildVertsFromEdges(
     Vtr::Refinement const & refinement, T const * src, U * dst, int channel) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-    Sdc::Scheme<Sdc::TYPE_CATMARK> scheme(_subdivOptions);
+    Sdc::Scheme<SCHEME> scheme(_subdivOptions);
 
     const Vtr::Level& parent = refinement.parent();
     const Vtr::Level& child  = refinement.child();
@@ -1000,13 +1275,12 @@ TopologyRefiner::faceVaryingInterpolateChildVertsFromEdges(
     }
 }
 
-template <class T, class U>
+template <Sdc::Type SCHEME, class T, class U>
 inline void
 TopologyRefiner::faceVaryingInterpolateChildVertsFromVerts(
     Vtr::Refinement const & refinement, T const * src, U * dst, int channel) const {
 
-    assert(_subdivType == Sdc::TYPE_CATMARK);
-    Sdc::Scheme<Sdc::TYPE_CATMARK> scheme(_subdivOptions);
+    Sdc::Scheme<SCHEME> scheme(_subdivOptions);
 
     const Vtr::Level& parent = refinement.parent();
     const Vtr::Level& child  = refinement.child();
@@ -79,7 +79,8 @@ TopologyRefinerFactoryBase::validateComponentTopologySizing(TopologyRefiner& ref
 }
 
 void
-TopologyRefinerFactoryBase::validateVertexComponentTopologyAssignment(TopologyRefiner& refiner) {
+TopologyRefinerFactoryBase::validateVertexComponentTopologyAssignment(TopologyRefiner& refiner,
+                                                                      ThreadingType threading) {
 
     Vtr::Level& baseLevel = refiner.getBaseLevel();
 
@@ -92,7 +93,7 @@ TopologyRefinerFactoryBase::validateVertexComponentTopologyAssignment(TopologyRe
     bool completeMissingTopology = (baseLevel.getNumEdges() == 0);
     if (completeMissingTopology) {
         //  Need to invoke some Vtr::Level method to "fill in" the missing topology...
-        baseLevel.completeTopologyFromFaceVertices();
+        baseLevel.completeTopologyFromFaceVertices((Vtr::ThreadingType)threading);
     }
 
     bool applyValidation = false;
@@ -199,9 +200,10 @@ TopologyRefinerFactoryBase::applyComponentTagsAndBoundarySharpness(TopologyRefin
 
         //
         //  Assign topological tags -- note that the "xordinary" (or conversely a "regular")
-        //  tag is still being considered, but regardless, it depends on the Sdc::Scheme...
+        //  tag is still being considered, but regardless, it depends on the Sdc::Scheme --
+        //  Bilinear shares the quad valences of Catmark here (though nothing depends on it):
         //
-        assert(refiner.GetSchemeType() == Sdc::TYPE_CATMARK);
+        assert(refiner.GetSchemeType() != Sdc::TYPE_LOOP);
 
         vTag._boundary = (vFaces.size() < vEdges.size());
         if (isCorner) {
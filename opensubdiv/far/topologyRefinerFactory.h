@@ -97,7 +97,8 @@ public:
 protected:
 
     static void validateComponentTopologySizing(TopologyRefiner& refiner);
-    static void validateVertexComponentTopologyAssignment(TopologyRefiner& refiner);
+    static void validateVertexComponentTopologyAssignment(TopologyRefiner& refiner,
+                                                          ThreadingType threading = THREADING_SERIAL);
     static void validateFaceVaryingComponentTopologyAssignment(TopologyRefiner& refiner);
 
     static void applyComponentTagsAndBoundarySharpness(TopologyRefiner& refiner);
@@ -140,9 +141,15 @@ public:
     ///
     /// @param mesh          Client topological representation (or a converter)
     ///
+    /// @param threading     Threading backend used to infer the edges and the
+    ///                      incident components of the vertices when only the
+    ///                      face-vertices are specified (the topology is the
+    ///                      same regardless of the backend)
+    ///
     /// return               An instance of TopologyRefiner or NULL for failure
     ///
-    static TopologyRefiner* Create(Sdc::Type type, Sdc::Options options, MESH const& mesh);
+    static TopologyRefiner* Create(Sdc::Type type, Sdc::Options options, MESH const& mesh,
+                                   ThreadingType threading = THREADING_SERIAL);
 
 protected:
     //
@@ -165,7 +172,8 @@ protected:
 protected:
 
     //  Other protected details -- not to be specialized:
-    static void populateBaseLevel(TopologyRefiner& refiner, MESH const& mesh);
+    static void populateBaseLevel(TopologyRefiner& refiner, MESH const& mesh,
+                                  ThreadingType threading);
 };
 
 
@@ -174,18 +182,20 @@ protected:
 //
 template <class MESH>
 TopologyRefiner*
-TopologyRefinerFactory<MESH>::Create(Sdc::Type type, Sdc::Options options, MESH const& mesh) {
+TopologyRefinerFactory<MESH>::Create(Sdc::Type type, Sdc::Options options, MESH const& mesh,
+                                     ThreadingType threading) {
 
     TopologyRefiner *refiner = new TopologyRefiner(type, options);
 
-    populateBaseLevel(*refiner, mesh);
+    populateBaseLevel(*refiner, mesh, threading);
 
     return refiner;
 }
 
 template <class MESH>
 void
-TopologyRefinerFactory<MESH>::populateBaseLevel(TopologyRefiner& refiner, MESH const& mesh) {
+TopologyRefinerFactory<MESH>::populateBaseLevel(TopologyRefiner& refiner, MESH const& mesh,
+                                                ThreadingType threading) {
 
     //
     //  The following three methods may end up virtual:
@@ -203,7 +213,7 @@ TopologyRefinerFactory<MESH>::populateBaseLevel(TopologyRefiner& refiner, MESH c
 
     //  Required specialization for MESH:
     assignComponentTopology(refiner, mesh);
-    validateVertexComponentTopologyAssignment(refiner);
+    validateVertexComponentTopologyAssignment(refiner, threading);
 
     //  Optional specialization for MESH:
     assignComponentTags(refiner, mesh);
@@ -334,6 +344,30 @@ TopologyRefinerFactory<MESH>::assignComponentTags(TopologyRefiner& /* refiner */
 
 #endif
 
+//
+//  Specializations for TopologyDescriptor (defined in topologyRefinerFactory.cpp) -- declared
+//  here so that clients do not instantiate the generic stubs above:
+//
+template <>
+void
+TopologyRefinerFactory<TopologyRefinerFactoryBase::TopologyDescriptor>::resizeComponentTopology(
+    TopologyRefiner & refiner, TopologyDescriptor const & desc);
+
+template <>
+void
+TopologyRefinerFactory<TopologyRefinerFactoryBase::TopologyDescriptor>::assignComponentTopology(
+    TopologyRefiner & refiner, TopologyDescriptor const & desc);
+
+template <>
+void
+TopologyRefinerFactory<TopologyRefinerFactoryBase::TopologyDescriptor>::assignFaceVaryingTopology(
+    TopologyRefiner & refiner, TopologyDescriptor const & desc);
+
+template <>
+void
+TopologyRefinerFactory<TopologyRefinerFactoryBase::TopologyDescriptor>::assignComponentTags(
+    TopologyRefiner & refiner, TopologyDescriptor const & desc);
+
 } // end namespace Far
 
 } // end namespace OPENSUBDIV_VERSION
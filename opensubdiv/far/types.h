@@ -28,6 +28,7 @@
 #include "../version.h"
 
 #include "../vtr/types.h"
+#include "../vtr/parallel.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -43,6 +44,17 @@ typedef Vtr::LocalIndex  LocalIndex;
 typedef Vtr::IndexArray       IndexArray;
 typedef Vtr::LocalIndexArray  LocalIndexArray;
 
+//
+//  Threading backends available to methods that can distribute their work across
+//  threads -- TBB and OpenMP are only available if the library was built with them
+//  and otherwise fall back to serial execution:
+//
+enum ThreadingType {
+    THREADING_SERIAL = Vtr::THREADING_SERIAL,
+    THREADING_TBB    = Vtr::THREADING_TBB,
+    THREADING_OMP    = Vtr::THREADING_OMP
+};
+
 } // end namespace Far
 
 } // end namespace OPENSUBDIV_VERSION
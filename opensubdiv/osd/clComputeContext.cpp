@@ -23,6 +23,7 @@
 //
 
 #include "../far/stencilTables.h"
+#include "../far/stencilTablesSerializer.h"
 
 #include "../osd/error.h"
 #include "../osd/clComputeContext.h"
@@ -35,12 +36,12 @@ namespace Osd {
 // -----------------------------------------------------------------------------
 
 template <class T> cl_mem
-createCLBuffer(std::vector<T> const & src, cl_context clContext) {
+createCLBuffer(T const * src, int size, cl_context clContext) {
 
     cl_mem devicePtr=0; cl_int errNum;
 
     devicePtr = clCreateBuffer(clContext, CL_MEM_READ_WRITE|CL_MEM_COPY_HOST_PTR,
-            src.size()*sizeof(T), (void*)(&src.at(0)), &errNum);
+            size*sizeof(T), (void*)src, &errNum);
 
     if (errNum!=CL_SUCCESS) {
         Error(OSD_CL_RUNTIME_ERROR, "clCreateBuffer: %d", errNum);
@@ -49,6 +50,12 @@ createCLBuffer(std::vector<T> const & src, cl_context clContext) {
     return devicePtr;
 }
 
+template <class T> cl_mem
+createCLBuffer(std::vector<T> const & src, cl_context clContext) {
+
+    return createCLBuffer(&src.at(0), (int)src.size(), clContext);
+}
+
 // -----------------------------------------------------------------------------
 
 class CLComputeContext::CLStencilTables {
@@ -62,6 +69,15 @@ public:
         _weights = createCLBuffer(stencilTables.GetWeights(), clContext);
     }
 
+    CLStencilTables(Far::MappedStencilTables const & stencilTables, cl_context clContext) {
+        int nstencils = stencilTables.GetNumStencils(),
+            nelems = stencilTables.GetNumElements();
+        _sizes = createCLBuffer(stencilTables.GetSizes(), nstencils, clContext);
+        _offsets = createCLBuffer(stencilTables.GetOffsets(), nstencils, clContext);
+        _indices = createCLBuffer(stencilTables.GetControlIndices(), nelems, clContext);
+        _weights = createCLBuffer(stencilTables.GetWeights(), nelems, clContext);
+    }
+
     ~CLStencilTables() {
         if (_sizes) clReleaseMemObject(_sizes);
         if (_offsets) clReleaseMemObject(_offsets);
@@ -99,9 +115,10 @@ private:
 
 // -----------------------------------------------------------------------------
 
+template <class TABLES>
 CLComputeContext::CLComputeContext(
-    Far::StencilTables const * vertexStencilTables,
-        Far::StencilTables const * varyingStencilTables,
+    TABLES const * vertexStencilTables,
+        TABLES const * varyingStencilTables,
             cl_context clContext) :
                 _vertexStencilTables(0), _varyingStencilTables(0),
                      _numControlVertices(0) {
@@ -198,6 +215,18 @@ CLComputeContext::Create(cl_context clContext,
     return result;
 }
 
+CLComputeContext *
+CLComputeContext::Create(cl_context clContext,
+    Far::MappedStencilTables const * vertexStencilTables,
+        Far::MappedStencilTables const * varyingStencilTables) {
+
+    CLComputeContext *result =
+        new CLComputeContext(
+            vertexStencilTables, varyingStencilTables, clContext);
+
+    return result;
+}
+
 // -----------------------------------------------------------------------------
 }  // end namespace Osd
 
@@ -35,7 +35,7 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-namespace Far{ class StencilTables; }
+namespace Far{ class StencilTables; class MappedStencilTables; }
 
 namespace Osd {
 
@@ -65,6 +65,22 @@ public:
                                         Far::StencilTables const * vertexStencilTables,
                                         Far::StencilTables const * varyingStencilTables=0);
 
+    /// Creates an CLComputeContext instance from tables mapped in memory
+    /// (the arrays are uploaded from the mapping : the tables can be closed
+    /// once the context is created)
+    ///
+    /// @param clContext             An active OpenCL compute context
+    ///
+    /// @param vertexStencilTables   The Far::MappedStencilTables used for
+    ///                              vertex interpolation
+    ///
+    /// @param varyingStencilTables  The Far::MappedStencilTables used for
+    ///                              varying interpolation
+    ///
+    static CLComputeContext * Create(cl_context clContext,
+                                        Far::MappedStencilTables const * vertexStencilTables,
+                                        Far::MappedStencilTables const * varyingStencilTables=0);
+
     /// Destructor
     virtual ~CLComputeContext();
 
@@ -107,9 +123,10 @@ public:
 
 
 protected:
-    explicit CLComputeContext(Far::StencilTables const * vertexStencilTables,
-                                 Far::StencilTables const * varyingStencilTables,
-                                 cl_context clContext);
+    template <class TABLES>
+    CLComputeContext(TABLES const * vertexStencilTables,
+                        TABLES const * varyingStencilTables,
+                        cl_context clContext);
 
 private:
 
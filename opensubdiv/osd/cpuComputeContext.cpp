@@ -23,6 +23,7 @@
 //
 
 #include "../far/stencilTables.h"
+#include "../far/stencilTablesSerializer.h"
 
 #include "../osd/cpuComputeContext.h"
 #include "../osd/cpuKernel.h"
@@ -53,6 +54,20 @@ CpuComputeContext::CpuComputeContext(
     }
 }
 
+CpuComputeContext::CpuComputeContext(
+    Far::MappedStencilTables const * vertexStencilTables,
+        Far::MappedStencilTables const * varyingStencilTables) :
+            _vertexStencilTables(0), _varyingStencilTables(0) {
+
+    if (vertexStencilTables) {
+        _vertexStencilTables = vertexStencilTables->CreateStencilTables();
+    }
+
+    if (varyingStencilTables) {
+        _varyingStencilTables = varyingStencilTables->CreateStencilTables();
+    }
+}
+
 // ----------------------------------------------------------------------------
 
 CpuComputeContext::~CpuComputeContext() { 
@@ -71,6 +86,14 @@ CpuComputeContext::Create(
     return new CpuComputeContext(vertexStencilTables, varyingStencilTables);
 }
 
+CpuComputeContext *
+CpuComputeContext::Create(
+    Far::MappedStencilTables const * vertexStencilTables,
+        Far::MappedStencilTables const * varyingStencilTables) {
+
+    return new CpuComputeContext(vertexStencilTables, varyingStencilTables);
+}
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
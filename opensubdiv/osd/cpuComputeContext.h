@@ -34,7 +34,7 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-namespace Far{ class StencilTables; }
+namespace Far{ class StencilTables; class MappedStencilTables; }
 
 namespace Osd {
 
@@ -55,7 +55,11 @@ public:
     /// Creates an CpuComputeContext instance
     ///
     /// @param vertexStencilTables   The Far::StencilTables used for vertex
-    ///                              interpolation
+    ///                              interpolation. Fused tables (see
+    ///                              Far::StencilTablesFactory::CreateFused())
+    ///                              interpolate the varying primvars too, in
+    ///                              the same pass : the varying tables are
+    ///                              then ignored by the CPU controllers.
     ///
     /// @param varyingStencilTables  The Far::StencilTables used for varying
     ///                              interpolation
@@ -63,6 +67,19 @@ public:
     static CpuComputeContext * Create(Far::StencilTables const * vertexStencilTables,
                                          Far::StencilTables const * varyingStencilTables=0);
 
+    /// Creates an CpuComputeContext instance from tables mapped in memory
+    /// (the context copies the tables, as it does Far::StencilTables : they
+    /// can be closed once the context is created)
+    ///
+    /// @param vertexStencilTables   The Far::MappedStencilTables used for
+    ///                              vertex interpolation
+    ///
+    /// @param varyingStencilTables  The Far::MappedStencilTables used for
+    ///                              varying interpolation
+    ///
+    static CpuComputeContext * Create(Far::MappedStencilTables const * vertexStencilTables,
+                                         Far::MappedStencilTables const * varyingStencilTables=0);
+
     /// Destructor
     virtual ~CpuComputeContext();
 
@@ -81,6 +98,9 @@ protected:
     explicit CpuComputeContext(Far::StencilTables const * vertexStencilTables,
                                   Far::StencilTables const * varyingStencilTables=0);
 
+    explicit CpuComputeContext(Far::MappedStencilTables const * vertexStencilTables,
+                                  Far::MappedStencilTables const * varyingStencilTables=0);
+
 private:
 
     Far::StencilTables const * _vertexStencilTables,
@@ -34,6 +34,100 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
+namespace {
+
+// Returns the ranges of stencils [start, end) to apply : all of them, only
+// those depending on the dirty control vertices, or only those of the
+// vertices not carried over by an update
+void
+getStencilRanges(Far::StencilTables const & stencils, int start, int end,
+    std::vector<int> const * dirtyVertices, std::vector<int> const * vertexOrigins,
+        std::vector<int> & ranges) {
+
+    if (dirtyVertices) {
+        stencils.GetDependentStencilRanges(
+            &dirtyVertices->at(0), (int)dirtyVertices->size(), ranges);
+        ClipStencilRanges(ranges, start, end);
+    } else if (vertexOrigins) {
+        stencils.GetUpdatedStencilRanges(*vertexOrigins, ranges, start, end);
+        ClipStencilRanges(ranges, start, end);
+    } else {
+        ranges.push_back(start);
+        ranges.push_back(end);
+    }
+}
+
+// Applies the stencils [start, end) with the given weights to the buffer,
+// or only those depending on the dirty control vertices (resp. not carried
+// over by an update), to every instance if the buffer is instanced
+void
+computeStencils(Far::StencilTables const & stencils,
+    std::vector<float> const & weights,
+        VertexBufferDescriptor const & desc, float * buffer, int start, int end,
+            std::vector<int> const * dirtyVertices,
+                std::vector<int> const * vertexOrigins,
+                    InstanceBufferDescriptor const * instances) {
+
+    float const * srcBuffer = buffer + desc.offset;
+
+    float * destBuffer = buffer + desc.offset +
+        stencils.GetNumControlVertices() * desc.stride;
+
+    std::vector<int> ranges;
+    getStencilRanges(stencils, start, end, dirtyVertices, vertexOrigins, ranges);
+
+    for (int i=0; i<(int)ranges.size(); i+=2) {
+        if (instances) {
+            CpuComputeInstanceStencils(desc, *instances, srcBuffer, destBuffer,
+                                  &stencils.GetSizes().at(0),
+                                  &stencils.GetOffsets().at(0),
+                                  &stencils.GetControlIndices().at(0),
+                                  &weights.at(0),
+                                  ranges[i],
+                                  ranges[i+1]);
+        } else {
+            CpuComputeStencils(desc, srcBuffer, destBuffer,
+                                  &stencils.GetSizes().at(0),
+                                  &stencils.GetOffsets().at(0),
+                                  &stencils.GetControlIndices().at(0),
+                                  &weights.at(0),
+                                  ranges[i],
+                                  ranges[i+1]);
+        }
+    }
+}
+
+// Applies fused stencils [start, end) to the vertex & varying primvars in a
+// single pass (either destination may be null), or only those depending on
+// the dirty control vertices (resp. not carried over by an update)
+void
+computeFusedStencils(Far::StencilTables const & stencils,
+    VertexBufferDescriptor const & vertexDesc, float const * vertexSrc,
+        float * vertexDst, VertexBufferDescriptor const & varyingDesc,
+            float const * varyingSrc, float * varyingDst, int start, int end,
+                std::vector<int> const * dirtyVertices,
+                    std::vector<int> const * vertexOrigins) {
+
+    std::vector<int> ranges;
+    getStencilRanges(stencils, start, end, dirtyVertices, vertexOrigins, ranges);
+
+    for (int i=0; i<(int)ranges.size(); i+=2) {
+        CpuComputeFusedStencils(vertexDesc, vertexSrc, vertexDst,
+                                varyingDesc, varyingSrc, varyingDst,
+                                &stencils.GetSizes().at(0),
+                                &stencils.GetOffsets().at(0),
+                                &stencils.GetControlIndices().at(0),
+                                &stencils.GetWeights().at(0),
+                                &stencils.GetVaryingSizes().at(0),
+                                &stencils.GetVaryingOffsets().at(0),
+                                &stencils.GetVaryingWeights().at(0),
+                                ranges[i],
+                                ranges[i+1]);
+    }
+}
+
+} // end namespace unnamed
+
 CpuComputeController::CpuComputeController() {
 }
 
@@ -52,44 +146,108 @@ CpuComputeController::ApplyStencilTableKernel(
 
     Far::StencilTables const * vertexStencils = context->GetVertexStencilTables();
 
+    if (_currentBindState.vertexOrigins) {
+        copyCarriedVertices(vertexStencils ? vertexStencils :
+            context->GetVaryingStencilTables(), batch);
+    }
+
+    if (vertexStencils and not vertexStencils->GetVaryingSizes().empty()) {
+        applyFusedStencils(*vertexStencils, batch);
+        return;
+    }
+
     if (vertexStencils and _currentBindState.vertexBuffer) {
+        computeStencils(*vertexStencils, vertexStencils->GetWeights(),
+            _currentBindState.vertexDesc, _currentBindState.vertexBuffer,
+                batch.start, batch.end, _currentBindState.dirtyVertices,
+                    _currentBindState.vertexOrigins, _currentBindState.vertexInstances);
+    }
+
+    Far::StencilTables const * varyingStencils = context->GetVaryingStencilTables();
 
-        VertexBufferDescriptor const & desc = _currentBindState.vertexDesc;
+    if (varyingStencils and _currentBindState.varyingBuffer) {
+        computeStencils(*varyingStencils, varyingStencils->GetWeights(),
+            _currentBindState.varyingDesc, _currentBindState.varyingBuffer,
+                batch.start, batch.end, _currentBindState.dirtyVertices,
+                    _currentBindState.vertexOrigins, _currentBindState.varyingInstances);
+    }
+}
+
+void
+CpuComputeController::copyCarriedVertices(Far::StencilTables const * stencils,
+    Far::KernelBatch const &batch) const {
 
-        float const * srcBuffer = _currentBindState.vertexBuffer + desc.offset;
+    if (not stencils) return;
 
-        float * destBuffer = _currentBindState.vertexBuffer + desc.offset +
-            vertexStencils->GetNumControlVertices() * desc.stride;
+    int numControlVertices = stencils->GetNumControlVertices();
 
-        CpuComputeStencils(_currentBindState.vertexDesc,
-                              srcBuffer, destBuffer,
-                              &vertexStencils->GetSizes().at(0),
-                              &vertexStencils->GetOffsets().at(0),
-                              &vertexStencils->GetControlIndices().at(0),
-                              &vertexStencils->GetWeights().at(0),
-                              batch.start,
-                              batch.end);
+    VertexBufferDescriptor const & vertexDesc = _currentBindState.vertexDesc,
+                                 & varyingDesc = _currentBindState.varyingDesc;
+
+    if (_currentBindState.vertexBuffer) {
+        CpuCopyCarriedVertices(vertexDesc,
+            _currentBindState.prevVertexBuffer + vertexDesc.offset,
+            _currentBindState.vertexBuffer + vertexDesc.offset,
+            *_currentBindState.vertexOrigins, numControlVertices,
+            batch.start, batch.end);
     }
 
-    Far::StencilTables const * varyingStencils = context->GetVaryingStencilTables();
+    if (_currentBindState.varyingBuffer) {
+        CpuCopyCarriedVertices(varyingDesc,
+            _currentBindState.prevVaryingBuffer + varyingDesc.offset,
+            _currentBindState.varyingBuffer + varyingDesc.offset,
+            *_currentBindState.vertexOrigins, numControlVertices,
+            batch.start, batch.end);
+    }
+}
 
-    if (varyingStencils and _currentBindState.varyingBuffer) {
+void
+CpuComputeController::applyFusedStencils(Far::StencilTables const & stencils,
+    Far::KernelBatch const &batch) const {
+
+    int numControlVertices = stencils.GetNumControlVertices();
 
-        VertexBufferDescriptor const & desc = _currentBindState.varyingDesc;
+    VertexBufferDescriptor const & vertexDesc = _currentBindState.vertexDesc,
+                                 & varyingDesc = _currentBindState.varyingDesc;
 
-        float const * srcBuffer = _currentBindState.varyingBuffer + desc.offset;
+    float * vertexBuffer = _currentBindState.vertexBuffer,
+          * varyingBuffer = _currentBindState.varyingBuffer;
 
-        float * destBuffer = _currentBindState.varyingBuffer + desc.offset +
-            varyingStencils->GetNumControlVertices() * desc.stride;
+    if (not _currentBindState.vertexInstances) {
+        // vertex & varying primvars in a single pass
+        computeFusedStencils(stencils, vertexDesc,
+            vertexBuffer ? vertexBuffer + vertexDesc.offset : 0,
+            vertexBuffer ? vertexBuffer + vertexDesc.offset +
+                numControlVertices * vertexDesc.stride : 0,
+            varyingDesc,
+            varyingBuffer ? varyingBuffer + varyingDesc.offset : 0,
+            varyingBuffer ? varyingBuffer + varyingDesc.offset +
+                numControlVertices * varyingDesc.stride : 0,
+            batch.start, batch.end, _currentBindState.dirtyVertices,
+                _currentBindState.vertexOrigins);
+        return;
+    }
+
+    // instanced buffers : the vertex primvars of all the instances, then
+    // the varying primvars of each instance
+    if (vertexBuffer) {
+        computeStencils(stencils, stencils.GetWeights(), vertexDesc,
+            vertexBuffer, batch.start, batch.end,
+                _currentBindState.dirtyVertices, _currentBindState.vertexOrigins,
+                    _currentBindState.vertexInstances);
+    }
 
-        CpuComputeStencils(_currentBindState.varyingDesc,
-                              srcBuffer, destBuffer,
-                              &varyingStencils->GetSizes().at(0),
-                              &varyingStencils->GetOffsets().at(0),
-                              &varyingStencils->GetControlIndices().at(0),
-                              &varyingStencils->GetWeights().at(0),
-                              batch.start,
-                              batch.end);
+    if (varyingBuffer) {
+        InstanceBufferDescriptor const & instances = *_currentBindState.varyingInstances;
+        for (int i=0; i<instances.numInstances; ++i) {
+            computeFusedStencils(stencils, VertexBufferDescriptor(), 0, 0,
+                varyingDesc,
+                varyingBuffer + varyingDesc.offset + i*instances.srcStride,
+                varyingBuffer + varyingDesc.offset + i*instances.dstStride +
+                    numControlVertices * varyingDesc.stride,
+                batch.start, batch.end, _currentBindState.dirtyVertices,
+                    _currentBindState.vertexOrigins);
+        }
     }
 }
 
@@ -31,6 +31,8 @@
 #include "../osd/cpuComputeContext.h"
 #include "../osd/vertexDescriptor.h"
 
+#include <vector>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -113,6 +115,268 @@ public:
         Compute<VERTEX_BUFFER>(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Execute the subdivision kernels of the stencils depending on a set
+    /// of control vertices.
+    ///
+    /// After editing a few control vertices, only the stencils depending on
+    /// them need to be applied again (the other refined vertices in the
+    /// buffers are left untouched). The stencil tables of the context should
+    /// be created with the 'generateDependentStencils' option, or all the
+    /// stencils are applied.
+    ///
+    /// @param  context        The CpuContext to apply refinement operations to
+    ///
+    /// @param  batches        Vector of batches of vertices organized by operative
+    ///                        kernel
+    ///
+    /// @param  dirtyVertices  Indices of the control vertices edited since
+    ///                        the previous refinement
+    ///
+    /// @param  vertexBuffer   Vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer  Vertex-interpolated data buffer
+    ///
+    /// @param  vertexDesc     The descriptor of vertex elements to be refined.
+    ///                        if it's null, all primvars in the vertex buffer
+    ///                        will be refined.
+    ///
+    /// @param  varyingDesc    The descriptor of varying elements to be refined.
+    ///                        if it's null, all primvars in the vertex buffer
+    ///                        will be refined.
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+        void Compute( CpuComputeContext const * context,
+                      Far::KernelBatchVector const & batches,
+                      std::vector<int> const & dirtyVertices,
+                      VERTEX_BUFFER  * vertexBuffer,
+                      VARYING_BUFFER * varyingBuffer,
+                      VertexBufferDescriptor const * vertexDesc=NULL,
+                      VertexBufferDescriptor const * varyingDesc=NULL ){
+
+        if (batches.empty() or dirtyVertices.empty()) return;
+
+        bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
+
+        _currentBindState.dirtyVertices = &dirtyVertices;
+
+        Far::KernelBatchDispatcher::Apply(this, context, batches, /*maxlevel*/ -1);
+
+        unbind();
+    }
+
+    /// Execute the subdivision kernels of the stencils of the vertices
+    /// added or modified by an update of the refinement (see
+    /// Far::TopologyRefiner::UpdateSparse()).
+    ///
+    /// The refined vertices carried over by the update are copied from the
+    /// buffers refined before the update, and only the other stencils are
+    /// applied. The stencil tables of the context should be updated with
+    /// Far::StencilTablesFactory::Update(), and the buffers hold the same
+    /// control vertices.
+    ///
+    /// @param  context           The CpuContext to apply refinement operations to
+    ///
+    /// @param  batches           Vector of batches of vertices organized by operative
+    ///                           kernel
+    ///
+    /// @param  vertexOrigins     Index of the previous vertex of each vertex (or
+    ///                           -1), as returned by UpdateSparse()
+    ///
+    /// @param  prevVertexBuffer  Vertex-interpolated data buffer refined before
+    ///                           the update
+    ///
+    /// @param  vertexBuffer      Vertex-interpolated data buffer
+    ///
+    /// @param  prevVaryingBuffer Varying-interpolated data buffer refined before
+    ///                           the update
+    ///
+    /// @param  varyingBuffer     Varying-interpolated data buffer
+    ///
+    /// @param  vertexDesc        The descriptor of vertex elements to be refined
+    ///                           (in both vertex buffers). if it's null, all
+    ///                           primvars in the vertex buffer will be refined.
+    ///
+    /// @param  varyingDesc       The descriptor of varying elements to be refined
+    ///                           (in both varying buffers). if it's null, all
+    ///                           primvars in the varying buffer will be refined.
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+        void ComputeUpdate( CpuComputeContext const * context,
+                            Far::KernelBatchVector const & batches,
+                            std::vector<int> const & vertexOrigins,
+                            VERTEX_BUFFER  * prevVertexBuffer,
+                            VERTEX_BUFFER  * vertexBuffer,
+                            VARYING_BUFFER * prevVaryingBuffer,
+                            VARYING_BUFFER * varyingBuffer,
+                            VertexBufferDescriptor const * vertexDesc=NULL,
+                            VertexBufferDescriptor const * varyingDesc=NULL ){
+
+        if (batches.empty()) return;
+
+        // carried vertices can only be copied from a previous buffer
+        if ((vertexBuffer and not prevVertexBuffer) or
+            (varyingBuffer and not prevVaryingBuffer)) return;
+
+        bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
+
+        _currentBindState.vertexOrigins = &vertexOrigins;
+
+        _currentBindState.prevVertexBuffer = vertexBuffer ?
+            prevVertexBuffer->BindCpuBuffer() : 0;
+
+        _currentBindState.prevVaryingBuffer = varyingBuffer ?
+            prevVaryingBuffer->BindCpuBuffer() : 0;
+
+        Far::KernelBatchDispatcher::Apply(this, context, batches, /*maxlevel*/ -1);
+
+        unbind();
+    }
+
+    /// Execute subdivision kernels and apply to several instances of the
+    /// primvar data sharing the topology of the context.
+    ///
+    /// All the instances are refined in a single sweep over the stencils :
+    /// each stencil is applied to every instance in turn, so that the
+    /// stencil tables are read from memory only once.
+    ///
+    /// @param  context          The CpuContext to apply refinement operations to
+    ///
+    /// @param  batches          Vector of batches of vertices organized by operative
+    ///                          kernel
+    ///
+    /// @param  vertexBuffer     Vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer    Vertex-interpolated data buffer
+    ///
+    /// @param  vertexInstances  The layout of the instances in the vertex
+    ///                          buffer (strides in floats)
+    ///
+    /// @param  varyingInstances The layout of the instances in the varying
+    ///                          buffer (strides in floats)
+    ///
+    /// Nothing is computed if the instance descriptor of a buffer is not
+    /// valid (see InstanceBufferDescriptor::IsValid()).
+    ///
+    /// @param  vertexDesc       The descriptor of the vertex elements of
+    ///                          the first instance to be refined.
+    ///                          if it's null, all primvars in the vertex
+    ///                          buffer will be refined.
+    ///
+    /// @param  varyingDesc      The descriptor of the varying elements of
+    ///                          the first instance to be refined.
+    ///                          if it's null, all primvars in the varying
+    ///                          buffer will be refined.
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+        void ComputeInstances( CpuComputeContext const * context,
+                               Far::KernelBatchVector const & batches,
+                               VERTEX_BUFFER  * vertexBuffer,
+                               VARYING_BUFFER * varyingBuffer,
+                               InstanceBufferDescriptor const & vertexInstances,
+                               InstanceBufferDescriptor const & varyingInstances,
+                               VertexBufferDescriptor const * vertexDesc=NULL,
+                               VertexBufferDescriptor const * varyingDesc=NULL ){
+
+        if (batches.empty()) return;
+
+        if (not validInstances(vertexBuffer, vertexInstances) or
+            not validInstances(varyingBuffer, varyingInstances)) return;
+
+        bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
+
+        _currentBindState.vertexInstances = &vertexInstances;
+        _currentBindState.varyingInstances = &varyingInstances;
+
+        Far::KernelBatchDispatcher::Apply(this, context, batches, /*maxlevel*/ -1);
+
+        unbind();
+    }
+
+    /// Execute the subdivision kernels of the stencils depending on a set
+    /// of control vertices, for several instances of the primvar data sharing
+    /// the topology of the context.
+    ///
+    /// The control vertices edited must be the same in all the instances
+    /// (see Compute() with dirty vertices and ComputeInstances() above).
+    ///
+    /// @param  context          The CpuContext to apply refinement operations to
+    ///
+    /// @param  batches          Vector of batches of vertices organized by operative
+    ///                          kernel
+    ///
+    /// @param  dirtyVertices    Indices of the control vertices edited since
+    ///                          the previous refinement
+    ///
+    /// @param  vertexBuffer     Vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer    Vertex-interpolated data buffer
+    ///
+    /// @param  vertexInstances  The layout of the instances in the vertex
+    ///                          buffer (strides in floats)
+    ///
+    /// @param  varyingInstances The layout of the instances in the varying
+    ///                          buffer (strides in floats)
+    ///
+    /// @param  vertexDesc       The descriptor of the vertex elements of
+    ///                          the first instance to be refined.
+    ///                          if it's null, all primvars in the vertex
+    ///                          buffer will be refined.
+    ///
+    /// @param  varyingDesc      The descriptor of the varying elements of
+    ///                          the first instance to be refined.
+    ///                          if it's null, all primvars in the varying
+    ///                          buffer will be refined.
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+        void ComputeInstances( CpuComputeContext const * context,
+                               Far::KernelBatchVector const & batches,
+                               std::vector<int> const & dirtyVertices,
+                               VERTEX_BUFFER  * vertexBuffer,
+                               VARYING_BUFFER * varyingBuffer,
+                               InstanceBufferDescriptor const & vertexInstances,
+                               InstanceBufferDescriptor const & varyingInstances,
+                               VertexBufferDescriptor const * vertexDesc=NULL,
+                               VertexBufferDescriptor const * varyingDesc=NULL ){
+
+        if (batches.empty() or dirtyVertices.empty()) return;
+
+        if (not validInstances(vertexBuffer, vertexInstances) or
+            not validInstances(varyingBuffer, varyingInstances)) return;
+
+        bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
+
+        _currentBindState.dirtyVertices = &dirtyVertices;
+        _currentBindState.vertexInstances = &vertexInstances;
+        _currentBindState.varyingInstances = &varyingInstances;
+
+        Far::KernelBatchDispatcher::Apply(this, context, batches, /*maxlevel*/ -1);
+
+        unbind();
+    }
+
+    /// Execute subdivision kernels and apply to several instances of the
+    /// primvar data sharing the topology of the context.
+    ///
+    /// @param  context          The CpuContext to apply refinement operations to
+    ///
+    /// @param  batches          Vector of batches of vertices organized by operative
+    ///                          kernel
+    ///
+    /// @param  vertexBuffer     Vertex-interpolated data buffer
+    ///
+    /// @param  vertexInstances  The layout of the instances in the vertex
+    ///                          buffer (strides in floats)
+    ///
+    template<class VERTEX_BUFFER>
+        void ComputeInstances(CpuComputeContext const * context,
+                              Far::KernelBatchVector const & batches,
+                              VERTEX_BUFFER *vertexBuffer,
+                              InstanceBufferDescriptor const & vertexInstances) {
+
+        ComputeInstances<VERTEX_BUFFER>(context, batches, vertexBuffer,
+            (VERTEX_BUFFER*)0, vertexInstances, InstanceBufferDescriptor());
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
@@ -124,6 +388,16 @@ protected:
     void ApplyStencilTableKernel(Far::KernelBatch const &batch,
         ComputeContext const *context) const;
 
+    // Applies fused vertex & varying stencils (see
+    // Far::StencilTablesFactory::CreateFused())
+    void applyFusedStencils(Far::StencilTables const & stencils,
+        Far::KernelBatch const &batch) const;
+
+    // Copies the vertices of a batch carried over by an update from the
+    // buffers refined before it (see ComputeUpdate())
+    void copyCarriedVertices(Far::StencilTables const * stencils,
+        Far::KernelBatch const &batch) const;
+
     template<class VERTEX_BUFFER, class VARYING_BUFFER>
         void bind( VERTEX_BUFFER * vertexBuffer,
                    VARYING_BUFFER * varyingBuffer,
@@ -159,18 +433,31 @@ protected:
         _currentBindState.Reset();
     }
 
+    // A bound buffer must have a valid instance layout
+    template<class BUFFER>
+        static bool validInstances( BUFFER const * buffer,
+                                    InstanceBufferDescriptor const & instances ) {
+        return (not buffer) or instances.IsValid();
+    }
+
 private:
 
     // Bind state is a transitional state during refinement.
     // It doesn't take an ownership of the vertex buffers.
     struct BindState {
 
-        BindState() : vertexBuffer(0), varyingBuffer(0) { }
+        BindState() : vertexBuffer(0), varyingBuffer(0), dirtyVertices(0),
+            vertexOrigins(0), prevVertexBuffer(0), prevVaryingBuffer(0),
+            vertexInstances(0), varyingInstances(0) { }
 
         void Reset() {
             vertexBuffer = varyingBuffer = 0;
             vertexDesc.Reset();
             varyingDesc.Reset();
+            dirtyVertices = 0;
+            vertexOrigins = 0;
+            prevVertexBuffer = prevVaryingBuffer = 0;
+            vertexInstances = varyingInstances = 0;
         }
 
         float * vertexBuffer,
@@ -178,6 +465,20 @@ private:
 
         VertexBufferDescriptor vertexDesc,
                                   varyingDesc;
+
+        // edited control vertices (all the stencils are applied if null)
+        std::vector<int> const * dirtyVertices;
+
+        // origins of the vertices of an update, and buffers refined before
+        // it to copy the carried vertices from (not an update if null)
+        std::vector<int> const * vertexOrigins;
+
+        float * prevVertexBuffer,
+              * prevVaryingBuffer;
+
+        // layout of the instances in the buffers (not instanced if null)
+        InstanceBufferDescriptor const * vertexInstances,
+                                       * varyingInstances;
     };
 
     BindState _currentBindState;
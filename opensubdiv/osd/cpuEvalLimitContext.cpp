@@ -24,11 +24,14 @@
 
 #include "../osd/cpuEvalLimitContext.h"
 #include "../osd/vertexDescriptor.h"
+#include "../osd/cpuEvalLimitKernel.h"
+#include "../vtr/parallel.h"
 
 #include <string.h>
 #include <cassert>
 #include <cstdio>
 #include <cmath>
+#include <algorithm>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -45,8 +48,20 @@ CpuEvalLimitContext::Create(Far::PatchTables const & patchTables, bool requireFV
     return new CpuEvalLimitContext(patchTables, requireFVarData);
 }
 
+CpuEvalLimitContext *
+CpuEvalLimitContext::CreateShared(Far::PatchTables const & patchTables,
+                                  Far::PatchMap const * patchMap) {
+
+    // there is no limit with uniform subdivision
+    if (not patchTables.IsFeatureAdaptive())
+        return NULL;
+
+    return new CpuEvalLimitContext(patchTables, patchMap);
+}
+
 CpuEvalLimitContext::CpuEvalLimitContext(Far::PatchTables const & patchTables, bool requireFVarData) :
-    EvalLimitContext(patchTables) {
+    EvalLimitContext(patchTables), _patchTables(0), _patchMap(0),
+        _ownsPatchMap(true), _gregoryPointsData(0) {
     
     // copy the data from the FarTables
     _patches = patchTables.GetPatchTable();
@@ -94,8 +109,203 @@ CpuEvalLimitContext::CpuEvalLimitContext(Far::PatchTables const & patchTables, b
     _patchMap = new Far::PatchMap( patchTables );
 }
 
+CpuEvalLimitContext::CpuEvalLimitContext(Far::PatchTables const & patchTables,
+                                         Far::PatchMap const * patchMap) :
+    EvalLimitContext(patchTables), _patchTables(&patchTables),
+        _patchMap(patchMap), _ownsPatchMap(patchMap==0), _gregoryPointsData(0) {
+
+    _maxValence = patchTables.GetMaxValence();
+
+    _fvarwidth = 0;
+
+    if (not _patchMap) {
+        _patchMap = new Far::PatchMap( patchTables );
+    }
+}
+
 CpuEvalLimitContext::~CpuEvalLimitContext() {
-    delete _patchMap;
+    if (_ownsPatchMap) {
+        delete _patchMap;
+    }
+}
+
+namespace {
+
+// Number of Gregory patches computed by each parallel task
+int const gregoryPointsChunkSize = 64;
+
+// Computes the control points of chunks of the patches of a Gregory patch array
+class ComputeGregoryPointsKernel : public Vtr::ParallelKernel {
+
+public:
+
+    ComputeGregoryPointsKernel(CpuEvalLimitContext const & context,
+        Far::PatchTables::PatchArray const & parray,
+            VertexBufferDescriptor const & desc, float const * vertexData,
+                float * points, float const * const * prevPoints) :
+        _context(context), _parray(parray), _desc(desc),
+            _vertexData(vertexData), _points(points), _prevPoints(prevPoints) { }
+
+    virtual void operator()(Vtr::Index begin, Vtr::Index end) const {
+
+        int first = begin * gregoryPointsChunkSize,
+            last = std::min(end * gregoryPointsChunkSize, (int)_parray.GetNumPatches());
+
+        bool boundary =
+            _parray.GetDescriptor().GetType()==Far::PatchTables::GREGORY_BOUNDARY;
+
+        unsigned int const * cvs =
+            &_context.GetControlVertices()[_parray.GetVertIndex()];
+
+        unsigned int const * quadOffsets =
+            &_context.GetQuadOffsetTable()[_parray.GetQuadOffsetIndex()];
+
+        int const * valences = &_context.GetVertexValenceTable()[0];
+
+        for (int i=first; i<last; ++i) {
+
+            float * points = _points + i * 20 * _desc.length;
+
+            if (_prevPoints and _prevPoints[i]) {
+                memcpy(points, _prevPoints[i], 20 * _desc.length * sizeof(float));
+            } else if (boundary) {
+                computeGregoryBoundaryPoints(cvs + i*4, valences, quadOffsets + i*4,
+                    _context.GetMaxValence(), _desc, _vertexData, points);
+            } else {
+                computeGregoryPoints(cvs + i*4, valences, quadOffsets + i*4,
+                    _context.GetMaxValence(), _desc, _vertexData, points);
+            }
+        }
+    }
+
+private:
+
+    CpuEvalLimitContext const & _context;
+    Far::PatchTables::PatchArray const & _parray;
+    VertexBufferDescriptor _desc;
+    float const * _vertexData;
+    float * _points;
+    float const * const * _prevPoints; // cached points of the previous patches
+};
+
+} // end namespace
+
+void
+CpuEvalLimitContext::UpdateGregoryPoints(VertexBufferDescriptor const & desc,
+                                         float const * vertexData,
+                                         Far::ThreadingType threading) {
+
+    updateGregoryPoints(desc, vertexData, 0, 0, threading);
+}
+
+void
+CpuEvalLimitContext::UpdateGregoryPoints(VertexBufferDescriptor const & desc,
+                                         float const * vertexData,
+                                         CpuEvalLimitContext const & prevContext,
+                                         std::vector<int> const & patchOrigins,
+                                         Far::ThreadingType threading) {
+
+    // the points of the previous patches can only be copied from a cache
+    // computed with the same layout
+    bool carryPoints = prevContext._gregoryPointsData and
+        prevContext._gregoryPointsDesc==desc and
+            (int)patchOrigins.size()==GetNumPatches() and
+                &prevContext!=this;
+
+    updateGregoryPoints(desc, vertexData, carryPoints ? &prevContext : 0,
+        carryPoints ? &patchOrigins[0] : 0, threading);
+}
+
+float const *
+CpuEvalLimitContext::getCachedGregoryPoints(int patchIdx) const {
+
+    Far::PatchTables::PatchArrayVector const & patchArrays = GetPatchArrayVector();
+
+    for (int i=0; i<(int)_gregoryPointsOffsets.size(); ++i) {
+
+        Far::PatchTables::PatchArray const & parray = patchArrays[i];
+
+        if (_gregoryPointsOffsets[i]>=0 and
+            patchIdx>=(int)parray.GetPatchIndex() and
+            patchIdx<(int)(parray.GetPatchIndex() + parray.GetNumPatches())) {
+
+            int patch = _gregoryPointsOffsets[i] + (patchIdx - parray.GetPatchIndex());
+
+            return &_gregoryPoints[patch * 20 * _gregoryPointsDesc.length];
+        }
+    }
+    return 0;
+}
+
+void
+CpuEvalLimitContext::updateGregoryPoints(VertexBufferDescriptor const & desc,
+                                         float const * vertexData,
+                                         CpuEvalLimitContext const * prevContext,
+                                         int const * patchOrigins,
+                                         Far::ThreadingType threading) {
+
+    assert(vertexData and desc.length>0);
+
+    Far::PatchTables::PatchArrayVector const & patchArrays = GetPatchArrayVector();
+
+    // Gregory patches are grouped in their own patch arrays
+    _gregoryPointsOffsets.resize(patchArrays.size());
+
+    int numPatches = 0;
+    for (int i=0; i<(int)patchArrays.size(); ++i) {
+
+        Far::PatchTables::Type type = patchArrays[i].GetDescriptor().GetType();
+
+        if (type==Far::PatchTables::GREGORY or
+            type==Far::PatchTables::GREGORY_BOUNDARY) {
+            _gregoryPointsOffsets[i] = numPatches;
+            numPatches += patchArrays[i].GetNumPatches();
+        } else {
+            _gregoryPointsOffsets[i] = -1;
+        }
+    }
+
+    _gregoryPoints.resize(numPatches * 20 * desc.length);
+
+    for (int i=0; i<(int)patchArrays.size(); ++i) {
+
+        Far::PatchTables::PatchArray const & parray = patchArrays[i];
+
+        if (_gregoryPointsOffsets[i]<0 or parray.GetNumPatches()==0)
+            continue;
+
+        // cached points of the previous patches carried over by an update
+        std::vector<float const *> prevPoints;
+        if (prevContext) {
+            prevPoints.resize(parray.GetNumPatches(), 0);
+            for (int j=0; j<(int)parray.GetNumPatches(); ++j) {
+                int origin = patchOrigins[parray.GetPatchIndex() + j];
+                if (origin>=0) {
+                    prevPoints[j] = prevContext->getCachedGregoryPoints(origin);
+                }
+            }
+        }
+
+        int numChunks = (parray.GetNumPatches() + gregoryPointsChunkSize - 1) /
+            gregoryPointsChunkSize;
+
+        Vtr::parallelFor((Vtr::ThreadingType)threading, 0, numChunks, 1,
+            ComputeGregoryPointsKernel(*this, parray, desc, vertexData,
+                &_gregoryPoints[_gregoryPointsOffsets[i] * 20 * desc.length],
+                    prevPoints.empty() ? 0 : &prevPoints[0]));
+    }
+
+    _gregoryPointsDesc = desc;
+    _gregoryPointsData = vertexData;
+}
+
+void
+CpuEvalLimitContext::ClearGregoryPoints() {
+
+    _gregoryPointsOffsets.clear();
+    _gregoryPoints.clear();
+    _gregoryPointsDesc.Reset();
+    _gregoryPointsData = 0;
 }
 
 } // end namespace Osd
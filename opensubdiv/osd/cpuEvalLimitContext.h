@@ -31,6 +31,7 @@
 #include "../osd/vertexDescriptor.h"
 #include "../far/patchTables.h"
 #include "../far/patchMap.h"
+#include "../far/types.h"
 
 #include <map>
 #include <stdio.h>
@@ -55,32 +56,67 @@ public:
     static CpuEvalLimitContext * Create(Far::PatchTables const &patchTables,
                                            bool requireFVarData=false);
 
+    /// \brief Factory
+    /// Returns an EvalLimitContext that shares the topology of the given far
+    /// patch tables instead of copying it : the context only references the
+    /// tables (and the patch map), which must remain valid and unchanged for
+    /// its lifetime. Face-varying data is not supported in this mode.
+    ///
+    /// @param patchTables  an initialized Far::PatchTables (feature-adaptive,
+    ///                     with ptex coordinates tables)
+    ///
+    /// @param patchMap     an optional PatchMap created from 'patchTables'.
+    ///                     A new map is created (and owned by the context)
+    ///                     if null.
+    ///
+    static CpuEvalLimitContext * CreateShared(Far::PatchTables const &patchTables,
+                                              Far::PatchMap const * patchMap=0);
+
     virtual ~CpuEvalLimitContext();
 
 
+    /// Returns true if the context references the topology of the patch
+    /// tables rather than a copy (see CreateShared())
+    bool IsShared() const {
+        return _patchTables!=0;
+    }
+
     /// Returns the vector of patch arrays
     const Far::PatchTables::PatchArrayVector & GetPatchArrayVector() const {
-        return _patchArrays;
+        return _patchTables ? _patchTables->GetPatchArrayVector() : _patchArrays;
     }
     
-    /// Returns the vector of per-patch parametric data
+    /// Returns the vector of per-patch parametric data (empty if the context
+    /// is shared : see GetPatchBitField())
     const std::vector<Far::PatchParam::BitField> & GetPatchBitFields() const {
         return _patchBitFields;
     }
 
+    /// Returns the parametric data of a patch
+    Far::PatchParam::BitField const & GetPatchBitField(int patchIdx) const {
+        return _patchTables ? _patchTables->GetPatchParamTable()[patchIdx].bitField :
+                              _patchBitFields[patchIdx];
+    }
+
+    /// Returns the number of patches
+    int GetNumPatches() const {
+        return _patchTables ? (int)_patchTables->GetPatchParamTable().size() :
+                              (int)_patchBitFields.size();
+    }
+
     /// The ordered array of control vertex indices for all the patches
     const std::vector<unsigned int> & GetControlVertices() const {
-        return _patches;
+        return _patchTables ? _patchTables->GetPatchTable() : _patches;
     }
 
     /// Returns the vertex-valence buffer used for Gregory patch computations
     Far::PatchTables::VertexValenceTable const & GetVertexValenceTable() const {
-        return _vertexValenceTable;
+        return _patchTables ? _patchTables->GetVertexValenceTable() : _vertexValenceTable;
     }
 
     /// Returns the Quad-Offsets buffer used for Gregory patch computations
     Far::PatchTables::QuadOffsetTable const & GetQuadOffsetTable() const {
-        return _quadOffsetTable;
+        return _patchTables ? _patchTables->GetQuadOffsetTable() : _quadOffsetTable;
     }
     
     /// Returns the face-varying data patch table
@@ -103,12 +139,106 @@ public:
         return _maxValence;
     }
 
+    /// \brief Precomputes the control points of the Gregory patches
+    ///
+    /// Computing the 20 control points of a Gregory patch from the 1-rings
+    /// of its corners is far more expensive than blending them, so the
+    /// points can be cached : CpuEvalLimitController then evaluates the
+    /// Gregory patches of the vertex data bound with the same buffer and
+    /// descriptor from the cached points (with identical results).
+    ///
+    /// The cache must be updated whenever the control vertices change, or
+    /// cleared if they are no longer kept up to date.
+    ///
+    /// @param desc        descriptor of the control vertex data
+    ///
+    /// @param vertexData  the control vertex data (the refined vertices
+    ///                    included)
+    ///
+    /// @param threading   the threading backend used to compute the points
+    ///
+    void UpdateGregoryPoints(VertexBufferDescriptor const & desc,
+                             float const * vertexData,
+                             Far::ThreadingType threading=Far::THREADING_SERIAL);
+
+    /// \brief Updates the cached control points of the Gregory patches after
+    /// an update of the refinement (see Far::PatchTablesFactory::Update())
+    ///
+    /// The points of the patches carried over by the update are copied from
+    /// the cache of the context of the previous patch tables, if it was
+    /// updated with the same descriptor : only the points of the other
+    /// patches are computed.
+    ///
+    /// @param desc          descriptor of the control vertex data
+    ///
+    /// @param vertexData    the control vertex data (the refined vertices
+    ///                      included)
+    ///
+    /// @param prevContext   the context of the patch tables before the update
+    ///
+    /// @param patchOrigins  index of the previous patch of each patch (or -1),
+    ///                      as returned by Far::PatchTablesFactory::Update()
+    ///
+    /// @param threading     the threading backend used to compute the points
+    ///
+    void UpdateGregoryPoints(VertexBufferDescriptor const & desc,
+                             float const * vertexData,
+                             CpuEvalLimitContext const & prevContext,
+                             std::vector<int> const & patchOrigins,
+                             Far::ThreadingType threading=Far::THREADING_SERIAL);
+
+    /// Clears the cached Gregory patch control points
+    void ClearGregoryPoints();
+
+    /// \brief Returns the cached control points of a Gregory patch
+    ///
+    /// @param handle      the handle of the patch
+    ///
+    /// @param desc        descriptor of the control vertex data
+    ///
+    /// @param vertexData  the control vertex data
+    ///
+    /// @return the 20 points (with a stride of desc.length floats) or 0 if
+    ///         the cache was not updated from the same data
+    ///
+    float const * GetGregoryPoints(Far::PatchMap::Handle const & handle,
+                                   VertexBufferDescriptor const & desc,
+                                   float const * vertexData) const {
+
+        if (_gregoryPointsData!=vertexData or vertexData==0 or
+            not (_gregoryPointsDesc==desc))
+            return 0;
+
+        int offset = _gregoryPointsOffsets[handle.patchArrayIdx];
+        if (offset<0)
+            return 0;
+
+        Far::PatchTables::PatchArray const & parray = GetPatchArrayVector()[handle.patchArrayIdx];
+
+        int patch = offset + (handle.patchIdx - parray.GetPatchIndex());
+
+        return &_gregoryPoints[patch * 20 * desc.length];
+    }
+
 protected:
     explicit CpuEvalLimitContext(Far::PatchTables const & patchTables, bool requireFVarData);
 
+    CpuEvalLimitContext(Far::PatchTables const & patchTables, Far::PatchMap const * patchMap);
+
 private:
 
-    // Topology data for a mesh
+    // Computes the cached points of the Gregory patches, copying those of the
+    // patches carried over by an update if 'prevContext' is not null
+    void updateGregoryPoints(VertexBufferDescriptor const & desc,
+                             float const * vertexData,
+                             CpuEvalLimitContext const * prevContext,
+                             int const * patchOrigins,
+                             Far::ThreadingType threading);
+
+    // Returns the cached points of a patch (or 0)
+    float const * getCachedGregoryPoints(int patchIdx) const;
+
+    // Topology data for a mesh (empty if the context is shared)
     Far::PatchTables::PatchArrayVector     _patchArrays;    // patch descriptor for each patch in the mesh
     Far::PatchTables::PTable               _patches;        // patch control vertices
     std::vector<Far::PatchParam::BitField> _patchBitFields; // per-patch parametric info
@@ -118,7 +248,17 @@ private:
 
     std::vector<float>                   _fvarData;
 
-    Far::PatchMap * _patchMap;           // map of the sub-patches given a face index
+    Far::PatchTables const * _patchTables; // shared topology (null if copied)
+
+    Far::PatchMap const * _patchMap;     // map of the sub-patches given a face index
+    bool _ownsPatchMap;
+
+    // Gregory patch control points cache
+    std::vector<int>       _gregoryPointsOffsets; // index of the first cached patch
+                                                  // of each patch array (-1 if none)
+    std::vector<float>     _gregoryPoints;        // 20 points per Gregory patch
+    VertexBufferDescriptor _gregoryPointsDesc;    // descriptor & data of the
+    float const *          _gregoryPointsData;    // cached control vertices
 
     int _maxValence, 
         _fvarwidth;
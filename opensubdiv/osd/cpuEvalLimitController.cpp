@@ -25,6 +25,10 @@
 #include "../osd/cpuEvalLimitController.h"
 #include "../osd/cpuEvalLimitKernel.h"
 #include "../far/patchTables.h"
+#include "../vtr/parallel.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -40,9 +44,9 @@ CpuEvalLimitController::~CpuEvalLimitController() {
 
 // normalize & rotate (u,v) to the sub-patch
 inline void
-computeSubPatchCoords( CpuEvalLimitContext * context, unsigned int patchIdx, float & u, float & v ) {
+computeSubPatchCoords( CpuEvalLimitContext const * context, unsigned int patchIdx, float & u, float & v ) {
 
-    Far::PatchParam::BitField bits = context->GetPatchBitFields()[ patchIdx ];
+    Far::PatchParam::BitField bits = context->GetPatchBitField( patchIdx );
 
     bits.Normalize( u, v );
 
@@ -135,60 +139,99 @@ CpuEvalLimitController::EvalLimitSample( EvalCoords const & coord,
 // Vertex interpolation of samples at the limit
 int
 CpuEvalLimitController::_EvalLimitSample( EvalCoords const & coords,
-                                          CpuEvalLimitContext * context,
+                                          CpuEvalLimitContext const * context,
+                                          BindState const & bindState,
                                           unsigned int index ) const {
-    float u=coords.u,
-          v=coords.v;
+    ResolvedSample sample;
+    sample.u = coords.u;
+    sample.v = coords.v;
 
-    Far::PatchMap::Handle const * handle = context->GetPatchMap().FindPatch( coords.face, u, v );
+    sample.handle = context->GetPatchMap().FindPatch( coords.face, sample.u, sample.v );
 
     // the map may not be able to return a handle if there is a hole or the face
     // index is incorrect
-    if (not handle)
+    if (not sample.handle)
         return 0;
 
-    computeSubPatchCoords(context, handle->patchIdx, u, v);
+    computeSubPatchCoords(context, sample.handle->patchIdx, sample.u, sample.v);
 
-    Far::PatchTables::PatchArray const & parray = context->GetPatchArrayVector()[ handle->patchArrayIdx ];
+    _EvalVertexData( sample, context, bindState, index );
 
-    unsigned int const * cvs = &context->GetControlVertices()[ parray.GetVertIndex() + handle->vertexOffset ];
+    _EvalVaryingData( sample, context, bindState, index );
 
-    VertexData const & vertexData = _currentBindState.vertexData;
+    return 1;
+}
 
-    if (vertexData.in) {
+void
+CpuEvalLimitController::_EvalVertexData( ResolvedSample const & sample,
+                                         CpuEvalLimitContext const * context,
+                                         BindState const & bindState,
+                                         unsigned int index ) const {
 
-        int offset = vertexData.outDesc.stride * index;
+    VertexData const & vertexData = bindState.vertexData;
 
-        if (vertexData.out) {
+    if (not (vertexData.in and vertexData.out))
+        return;
 
-            float * out   = vertexData.out+offset,
-                  * outDu = vertexData.outDu ? vertexData.outDu+offset : 0,
-                  * outDv = vertexData.outDv ? vertexData.outDv+offset : 0;
+    Far::PatchMap::Handle const * handle = sample.handle;
 
-            // Based on patch type - go execute interpolation
-            switch( parray.GetDescriptor().GetType() ) {
+    Far::PatchTables::PatchArray const & parray = context->GetPatchArrayVector()[ handle->patchArrayIdx ];
 
-                case Far::PatchTables::REGULAR  : evalBSpline( v, u, cvs,
-                                                             vertexData.inDesc,
-                                                             vertexData.in,
-                                                             vertexData.outDesc,
-                                                             out, outDu, outDv );
-                                                break;
-
-                case Far::PatchTables::BOUNDARY : evalBoundary( v, u, cvs,
-                                                              vertexData.inDesc,
-                                                              vertexData.in,
-                                                              vertexData.outDesc,
-                                                              out, outDu, outDv );
-                                                break;
-
-                case Far::PatchTables::CORNER   : evalCorner( v, u, cvs,
-                                                            vertexData.inDesc,
-                                                            vertexData.in,
-                                                            vertexData.outDesc,
-                                                            out, outDu, outDv );
-                                                break;
-                case Far::PatchTables::GREGORY  : evalGregory( v, u, cvs,
+    unsigned int const * cvs = &context->GetControlVertices()[ parray.GetVertIndex() + handle->vertexOffset ];
+
+    float u = sample.u,
+          v = sample.v;
+
+    int offset = vertexData.outDesc.stride * index;
+
+    float * out   = vertexData.out+offset,
+          * outDu = vertexData.outDu ? vertexData.outDu+offset : 0,
+          * outDv = vertexData.outDv ? vertexData.outDv+offset : 0;
+
+    // Gregory patches with cached control points
+    if (float const * points = context->GetGregoryPoints(*handle, vertexData.inDesc, vertexData.in)) {
+        evalGregoryPoints( v, u, points,
+                           vertexData.inDesc.length,
+                           vertexData.outDesc,
+                           out, outDu, outDv );
+        return;
+    }
+
+    // Based on patch type - go execute interpolation
+    switch( parray.GetDescriptor().GetType() ) {
+
+        case Far::PatchTables::REGULAR  : evalBSpline( v, u, cvs,
+                                                     vertexData.inDesc,
+                                                     vertexData.in,
+                                                     vertexData.outDesc,
+                                                     out, outDu, outDv );
+                                        break;
+
+        case Far::PatchTables::BOUNDARY : evalBoundary( v, u, cvs,
+                                                      vertexData.inDesc,
+                                                      vertexData.in,
+                                                      vertexData.outDesc,
+                                                      out, outDu, outDv );
+                                        break;
+
+        case Far::PatchTables::CORNER   : evalCorner( v, u, cvs,
+                                                    vertexData.inDesc,
+                                                    vertexData.in,
+                                                    vertexData.outDesc,
+                                                    out, outDu, outDv );
+                                        break;
+        case Far::PatchTables::GREGORY  : evalGregory( v, u, cvs,
+                                                     &context->GetVertexValenceTable()[0],
+                                                     &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ],
+                                                     context->GetMaxValence(),
+                                                     vertexData.inDesc,
+                                                     vertexData.in,
+                                                     vertexData.outDesc,
+                                                     out, outDu, outDv );
+                                        break;
+
+        case Far::PatchTables::GREGORY_BOUNDARY :
+                                        evalGregoryBoundary( v, u, cvs,
                                                              &context->GetVertexValenceTable()[0],
                                                              &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ],
                                                              context->GetMaxValence(),
@@ -196,25 +239,24 @@ CpuEvalLimitController::_EvalLimitSample( EvalCoords const & coords,
                                                              vertexData.in,
                                                              vertexData.outDesc,
                                                              out, outDu, outDv );
-                                                break;
-
-                case Far::PatchTables::GREGORY_BOUNDARY :
-                                                evalGregoryBoundary( v, u, cvs,
-                                                                     &context->GetVertexValenceTable()[0],
-                                                                     &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ],
-                                                                     context->GetMaxValence(),
-                                                                     vertexData.inDesc,
-                                                                     vertexData.in,
-                                                                     vertexData.outDesc,
-                                                                     out, outDu, outDv );
-                                                break;
-                default:
-                    assert(0);
-            }
-        }
+                                        break;
+        default:
+            assert(0);
     }
+}
 
-    VaryingData const & varyingData = _currentBindState.varyingData;
+void
+CpuEvalLimitController::_EvalVaryingData( ResolvedSample const & sample,
+                                          CpuEvalLimitContext const * context,
+                                          BindState const & bindState,
+                                          unsigned int index ) const {
+
+    Far::PatchMap::Handle const * handle = sample.handle;
+
+    float u = sample.u,
+          v = sample.v;
+
+    VaryingData const & varyingData = bindState.varyingData;
 
     if (varyingData.in and varyingData.out) {
 
@@ -224,6 +266,10 @@ CpuEvalLimitController::_EvalLimitSample( EvalCoords const & coords,
                                      {0, 1, 2, 3},  // gregory
                                      {0, 1, 2, 3} };// gregory boundary
 
+        Far::PatchTables::PatchArray const & parray = context->GetPatchArrayVector()[ handle->patchArrayIdx ];
+
+        unsigned int const * cvs = &context->GetControlVertices()[ parray.GetVertIndex() + handle->vertexOffset ];
+
         int type = (int)(parray.GetDescriptor().GetType() - Far::PatchTables::REGULAR);
 
         int offset = varyingData.outDesc.stride * index;
@@ -246,7 +292,7 @@ CpuEvalLimitController::_EvalLimitSample( EvalCoords const & coords,
     // sets, the feature-adaptive patch interpolation code currently does not
     // support them, and neither does this EvalContext.
 
-    FacevaryingData const & facevaryingData = _currentBindState.facevaryingData;
+    FacevaryingData const & facevaryingData = bindState.facevaryingData;
 
     if (facevaryingData.out) {
 
@@ -265,7 +311,272 @@ CpuEvalLimitController::_EvalLimitSample( EvalCoords const & coords,
                           facevaryingData.out+offset);
         }
     }
-    return 1;
+}
+
+// Evaluates batched samples sorted by patch
+void
+CpuEvalLimitController::_EvalLimitSamples( ResolvedSample const * samples,
+                                           int const * order, int begin, int end,
+                                           CpuEvalLimitContext const * context,
+                                           BindState const & bindState,
+                                           unsigned int index ) const {
+
+    VertexData const & vertexData = bindState.vertexData;
+
+    bool evalVertex = vertexData.in and vertexData.out;
+
+    int length = vertexData.inDesc.length,
+        stride = vertexData.outDesc.stride;
+
+    // gathered B-spline or computed Gregory control points of a bin
+    std::vector<float> points(evalVertex ? 20*length : 0);
+
+    int const W = EVAL_LIMIT_BATCH_WIDTH;
+
+    for (int bin=begin; bin<end; ) {
+
+        Far::PatchMap::Handle const * handle = samples[order[bin]].handle;
+
+        int binEnd = bin+1;
+        while (binEnd<end and samples[order[binEnd]].handle->patchIdx==handle->patchIdx) {
+            ++binEnd;
+        }
+
+        Far::PatchTables::PatchArray const & parray = context->GetPatchArrayVector()[ handle->patchArrayIdx ];
+
+        Far::PatchTables::Type type = parray.GetDescriptor().GetType();
+
+        if (evalVertex and (type==Far::PatchTables::REGULAR or
+                            type==Far::PatchTables::BOUNDARY or
+                            type==Far::PatchTables::CORNER)) {
+
+            unsigned int const * cvs = &context->GetControlVertices()[ parray.GetVertIndex() + handle->vertexOffset ];
+
+            gatherBSplinePoints(type, cvs, vertexData.inDesc, vertexData.in, &points[0]);
+
+            for (int i=bin; i<binEnd; i+=W) {
+
+                int n = std::min(W, binEnd-i);
+
+                float u[W], v[W],
+                      * out[W], * outDu[W], * outDv[W];
+
+                for (int s=0; s<n; ++s) {
+                    ResolvedSample const & sample = samples[order[i+s]];
+
+                    int offset = stride * (index + order[i+s]) + vertexData.outDesc.offset;
+
+                    // (u,v) are swapped, as in _EvalVertexData()
+                    u[s] = sample.v;
+                    v[s] = sample.u;
+
+                    out[s]   = vertexData.out + offset;
+                    outDu[s] = vertexData.outDu ? vertexData.outDu + offset : 0;
+                    outDv[s] = vertexData.outDv ? vertexData.outDv + offset : 0;
+                }
+
+                evalBSplineBatch(n, u, v, &points[0], length, out,
+                    vertexData.outDu ? outDu : 0,
+                    vertexData.outDv ? outDv : 0);
+            }
+        } else if (evalVertex) {
+
+            // Gregory patches : compute the control points once per bin if
+            // they are not cached
+            float const * gregoryPoints =
+                context->GetGregoryPoints(*handle, vertexData.inDesc, vertexData.in);
+
+            if (not gregoryPoints) {
+
+                unsigned int const * cvs = &context->GetControlVertices()[ parray.GetVertIndex() + handle->vertexOffset ];
+
+                unsigned int const * quadOffsets = &context->GetQuadOffsetTable()[ parray.GetQuadOffsetIndex() + handle->vertexOffset ];
+
+                if (type==Far::PatchTables::GREGORY) {
+                    computeGregoryPoints(cvs, &context->GetVertexValenceTable()[0],
+                        quadOffsets, context->GetMaxValence(), vertexData.inDesc,
+                            vertexData.in, &points[0]);
+                } else {
+                    computeGregoryBoundaryPoints(cvs, &context->GetVertexValenceTable()[0],
+                        quadOffsets, context->GetMaxValence(), vertexData.inDesc,
+                            vertexData.in, &points[0]);
+                }
+                gregoryPoints = &points[0];
+            }
+
+            for (int i=bin; i<binEnd; ++i) {
+
+                ResolvedSample const & sample = samples[order[i]];
+
+                int offset = stride * (index + order[i]);
+
+                evalGregoryPoints(sample.v, sample.u, gregoryPoints, length,
+                    vertexData.outDesc,
+                    vertexData.out + offset,
+                    vertexData.outDu ? vertexData.outDu + offset : 0,
+                    vertexData.outDv ? vertexData.outDv + offset : 0);
+            }
+        }
+
+        for (int i=bin; i<binEnd; ++i) {
+            _EvalVaryingData(samples[order[i]], context, bindState, index + order[i]);
+        }
+
+        bin = binEnd;
+    }
+}
+
+namespace {
+
+// Number of samples resolved or evaluated by each parallel task
+int const limitSamplesChunkSize = 1024;
+
+} // end namespace
+
+// Resolves the patches & sub-patch coordinates of chunks of samples
+class CpuEvalLimitController::ResolveLimitSamplesKernel : public Vtr::ParallelKernel {
+
+public:
+
+    ResolveLimitSamplesKernel(EvalCoords const * coords, int numSamples,
+        CpuEvalLimitContext const * context, ResolvedSample * samples) :
+            _coords(coords), _numSamples(numSamples), _context(context),
+                _samples(samples) { }
+
+    virtual void operator()(Vtr::Index begin, Vtr::Index end) const {
+
+        Far::PatchMap const & patchMap = _context->GetPatchMap();
+
+        int first = begin * limitSamplesChunkSize,
+            last = std::min(end * limitSamplesChunkSize, _numSamples);
+
+        // the samples are located in batches
+        int const batchSize = 64;
+
+        int faces[batchSize];
+        float u[batchSize], v[batchSize];
+        Far::PatchMap::Handle const * handles[batchSize];
+
+        for (int batch=first; batch<last; batch+=batchSize) {
+
+            int n = std::min(batchSize, last-batch);
+
+            for (int i=0; i<n; ++i) {
+                faces[i] = (int)_coords[batch+i].face;
+                u[i] = _coords[batch+i].u;
+                v[i] = _coords[batch+i].v;
+            }
+
+            patchMap.FindPatches(faces, u, v, n, handles);
+
+            for (int i=0; i<n; ++i) {
+
+                ResolvedSample & sample = _samples[batch+i];
+
+                sample.u = u[i];
+                sample.v = v[i];
+                sample.handle = handles[i];
+
+                if (sample.handle) {
+                    computeSubPatchCoords(_context, sample.handle->patchIdx, sample.u, sample.v);
+                }
+            }
+        }
+    }
+
+private:
+
+    EvalCoords const * _coords;
+    int _numSamples;
+    CpuEvalLimitContext const * _context;
+    ResolvedSample * _samples;
+};
+
+// Evaluates chunks of the samples sorted by patch
+class CpuEvalLimitController::EvalLimitSamplesKernel : public Vtr::ParallelKernel {
+
+public:
+
+    EvalLimitSamplesKernel(CpuEvalLimitController const & controller,
+        ResolvedSample const * samples, int const * order, int numSamples,
+            CpuEvalLimitContext const * context, BindState const & bindState,
+                unsigned int index) :
+                    _controller(controller), _samples(samples), _order(order),
+                        _numSamples(numSamples), _context(context),
+                            _bindState(bindState), _index(index) { }
+
+    virtual void operator()(Vtr::Index begin, Vtr::Index end) const {
+
+        _controller._EvalLimitSamples(_samples, _order,
+            begin * limitSamplesChunkSize,
+                std::min(end * limitSamplesChunkSize, _numSamples),
+                    _context, _bindState, _index);
+    }
+
+private:
+
+    CpuEvalLimitController const & _controller;
+    ResolvedSample const * _samples;
+    int const * _order;
+    int _numSamples;
+    CpuEvalLimitContext const * _context;
+    BindState const & _bindState;
+    unsigned int _index;
+};
+
+// Vertex interpolation of a batch of samples at the limit
+int
+CpuEvalLimitController::EvalLimitSamples( EvalCoords const * coords,
+                                          int numSamples,
+                                          CpuEvalLimitContext const * context,
+                                          BindState const & bindState,
+                                          unsigned int index,
+                                          Far::ThreadingType threading ) const {
+
+    if (not context or not coords or numSamples<=0)
+        return 0;
+
+    Vtr::ThreadingType backend = (Vtr::ThreadingType)threading;
+
+    int numChunks = (numSamples + limitSamplesChunkSize - 1) / limitSamplesChunkSize;
+
+    std::vector<ResolvedSample> samples(numSamples);
+
+    Vtr::parallelFor(backend, 0, numChunks, 1,
+        ResolveLimitSamplesKernel(coords, numSamples, context, &samples[0]));
+
+    // bin the samples that were found by patch (counting sort : the samples
+    // of each patch remain in their original order)
+    int numPatches = context->GetNumPatches();
+
+    std::vector<int> binOffsets(numPatches+1, 0);
+    for (int i=0; i<numSamples; ++i) {
+        if (samples[i].handle) {
+            ++binOffsets[samples[i].handle->patchIdx+1];
+        }
+    }
+    for (int i=0; i<numPatches; ++i) {
+        binOffsets[i+1] += binOffsets[i];
+    }
+
+    int numFound = binOffsets[numPatches];
+    if (numFound==0)
+        return 0;
+
+    std::vector<int> order(numFound);
+    for (int i=0; i<numSamples; ++i) {
+        if (samples[i].handle) {
+            order[binOffsets[samples[i].handle->patchIdx]++] = i;
+        }
+    }
+
+    numChunks = (numFound + limitSamplesChunkSize - 1) / limitSamplesChunkSize;
+
+    Vtr::parallelFor(backend, 0, numChunks, 1,
+        EvalLimitSamplesKernel(*this, &samples[0], &order[0], numFound, context,
+            bindState, index));
+
+    return numFound;
 }
 
 }  // end namespace Osd
@@ -29,6 +29,7 @@
 
 #include "../osd/cpuEvalLimitContext.h"
 #include "../osd/vertexDescriptor.h"
+#include "../far/types.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -50,16 +51,34 @@ namespace Osd {
 /// evalCtroller->BindVaryingBuffers( ... );
 /// evalCtroller->BindFacevaryingBuffers( ... );
 ///
-/// parallel_for( int index=0; i<nsamples; ++index ) {
+/// parallel_for( int index=0; index<nsamples; ++index ) {
 ///    evalCtroller->EvalLimitSample( coord, evalCtxt, index );
 /// }
 ///
 /// evalCtroller->Unbind();
 /// \endcode
 ///
+/// Alternatively, the buffers can be bound to a BindState owned by the client
+/// and passed explicitly to the evaluation methods : the controller is then
+/// stateless, and can be shared by threads evaluating different meshes or
+/// buffers concurrently.
+///
+/// Ex :
+/// \code
+/// CpuEvalLimitController::BindState bindState;
+/// bindState.BindVertexBuffers( ... );
+///
+/// parallel_for( int index=0; index<nsamples; ++index ) {
+///    evalCtroller->EvalLimitSample( coord, evalCtxt, bindState, index );
+/// }
+/// \endcode
+///
 class CpuEvalLimitController {
 
 public:
+    /// Data buffers bound for evaluation (see below)
+    struct BindState;
+
     /// Constructor.
     CpuEvalLimitController();
 
@@ -85,13 +104,7 @@ public:
                             VertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ,
                                                                      OUTPUT_BUFFER *outdQu=0,
                                                                      OUTPUT_BUFFER *outdQv=0 ) {
-        _currentBindState.vertexData.inDesc = iDesc;
-        _currentBindState.vertexData.in = inQ ? inQ->BindCpuBuffer() : 0;
-
-        _currentBindState.vertexData.outDesc = oDesc;
-        _currentBindState.vertexData.out = outQ ? outQ->BindCpuBuffer() : 0;
-        _currentBindState.vertexData.outDu = outdQu ? outdQu->BindCpuBuffer() : 0;
-        _currentBindState.vertexData.outDv = outdQv ? outdQv->BindCpuBuffer() : 0;
+        _currentBindState.BindVertexBuffers(iDesc, inQ, oDesc, outQ, outdQu, outdQv);
     }
 
     /// \brief Binds the varying-interpolated data streams
@@ -107,11 +120,7 @@ public:
     template<class INPUT_BUFFER, class OUTPUT_BUFFER>
     void BindVaryingBuffers( VertexBufferDescriptor const & iDesc, INPUT_BUFFER *inQ,
                              VertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
-        _currentBindState.varyingData.inDesc = iDesc;
-        _currentBindState.varyingData.in = inQ ? inQ->BindCpuBuffer() : 0;
-
-        _currentBindState.varyingData.outDesc = oDesc;
-        _currentBindState.varyingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        _currentBindState.BindVaryingBuffers(iDesc, inQ, oDesc, outQ);
     }
 
     /// \brief Binds the face-varying-interpolated data streams
@@ -130,10 +139,7 @@ public:
     template<class OUTPUT_BUFFER>
     void BindFacevaryingBuffers( VertexBufferDescriptor const & iDesc,
                                  VertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
-        _currentBindState.facevaryingData.inDesc = iDesc;
-
-        _currentBindState.facevaryingData.outDesc = oDesc;
-        _currentBindState.facevaryingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        _currentBindState.BindFacevaryingBuffers(iDesc, oDesc, outQ);
     }
 
     /// \brief Vertex interpolation of a single sample at the limit
@@ -185,11 +191,110 @@ public:
         if (not context)
             return 0;
 
-        int n = _EvalLimitSample( coords, context, index );
+        int n = _EvalLimitSample( coords, context, _currentBindState, index );
 
         return n;
     }
 
+    /// \brief Vertex interpolation of samples at the limit
+    ///
+    /// Evaluates "vertex" interpolation of a sample on the surface limit from
+    /// and into the buffers of the given bind state rather than the buffers
+    /// bound to the controller. This method does not modify the controller,
+    /// the context or the bind state, so it can be called concurrently (with
+    /// different bind states, contexts or output indices) without locking.
+    ///
+    /// @param coords     location on the limit surface to be evaluated
+    ///
+    /// @param context    the EvalLimitContext that the controller will evaluate
+    ///
+    /// @param bindState  the data buffers to evaluate
+    ///
+    /// @param index      the index of the vertex in the output buffers of the
+    ///                   bind state
+    ///
+    /// @return the number of samples found (0 if the location was tagged as a hole
+    ///         or the coordinate was invalid)
+    ///
+    int EvalLimitSample( EvalCoords const & coords,
+                         CpuEvalLimitContext const * context,
+                         BindState const & bindState,
+                         unsigned int index ) const {
+        if (not context)
+            return 0;
+
+        return _EvalLimitSample( coords, context, bindState, index );
+    }
+
+    /// \brief Vertex interpolation of a batch of samples at the limit
+    ///
+    /// Evaluates the bound vertex, varying and face-varying data of an array
+    /// of samples : sample 'i' is written at 'index + i' in the output
+    /// buffers bound to the controller (the outputs of samples that are not
+    /// found are left untouched). The results are identical to those of
+    /// EvalLimitSample().
+    ///
+    /// Rather than dispatching each sample separately, the samples are
+    /// binned by patch : the control points of regular, boundary and corner
+    /// patches are gathered once per bin and their basis functions are
+    /// evaluated for several samples at once. The control points of Gregory
+    /// patches are also computed once per bin, unless they are cached in the
+    /// context (see CpuEvalLimitContext::UpdateGregoryPoints()). The bins are
+    /// distributed across threads with the given threading backend.
+    ///
+    /// @param coords     locations on the limit surface to be evaluated
+    ///
+    /// @param numSamples the number of locations in 'coords'
+    ///
+    /// @param context    the EvalLimitContext that the controller will evaluate
+    ///
+    /// @param index      the index of the first sample in the output buffers
+    ///                   bound to the controller
+    ///
+    /// @param threading  the threading backend used to resolve & evaluate the
+    ///                   samples
+    ///
+    /// @return the number of samples found
+    ///
+    int EvalLimitSamples( EvalCoords const * coords,
+                          int numSamples,
+                          CpuEvalLimitContext * context,
+                          unsigned int index=0,
+                          Far::ThreadingType threading=Far::THREADING_SERIAL ) const {
+
+        return EvalLimitSamples( coords, numSamples, context, _currentBindState,
+                                 index, threading );
+    }
+
+    /// \brief Vertex interpolation of a batch of samples at the limit
+    ///
+    /// Same as above, but the samples are evaluated from and into the buffers
+    /// of the given bind state rather than the buffers bound to the
+    /// controller (see EvalLimitSample()).
+    ///
+    /// @param coords     locations on the limit surface to be evaluated
+    ///
+    /// @param numSamples the number of locations in 'coords'
+    ///
+    /// @param context    the EvalLimitContext that the controller will evaluate
+    ///
+    /// @param bindState  the data buffers to evaluate
+    ///
+    /// @param index      the index of the first sample in the output buffers
+    ///                   of the bind state
+    ///
+    /// @param threading  the threading backend used to resolve & evaluate the
+    ///                   samples
+    ///
+    /// @return the number of samples found
+    ///
+    int EvalLimitSamples( EvalCoords const * coords,
+                          int numSamples,
+                          CpuEvalLimitContext const * context,
+                          BindState const & bindState,
+                          unsigned int index=0,
+                          Far::ThreadingType threading=Far::THREADING_SERIAL ) const;
+
     void Unbind() {
         _currentBindState.Reset();
     }
@@ -251,19 +356,54 @@ protected:
         float * out;
     };
 
+public:
 
-private:
-
-    int _EvalLimitSample( EvalCoords const & coords,
-                          CpuEvalLimitContext * context,
-                          unsigned int index ) const;
-
-    // Bind state is a transitional state during refinement.
-    // It doesn't take an ownership of vertex buffers.
+    /// \brief The data buffers samples are evaluated from and into
+    ///
+    /// The bind state does not take the ownership of the buffers. The Bind
+    /// methods have the same arguments as those of the controller.
+    ///
     struct BindState {
 
         BindState() { }
 
+        /// Binds control vertex data buffers
+        template<class INPUT_BUFFER, class OUTPUT_BUFFER>
+        void BindVertexBuffers( VertexBufferDescriptor const & iDesc, INPUT_BUFFER *inQ,
+                                VertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ,
+                                                                         OUTPUT_BUFFER *outdQu=0,
+                                                                         OUTPUT_BUFFER *outdQv=0 ) {
+            vertexData.inDesc = iDesc;
+            vertexData.in = inQ ? inQ->BindCpuBuffer() : 0;
+
+            vertexData.outDesc = oDesc;
+            vertexData.out = outQ ? outQ->BindCpuBuffer() : 0;
+            vertexData.outDu = outdQu ? outdQu->BindCpuBuffer() : 0;
+            vertexData.outDv = outdQv ? outdQv->BindCpuBuffer() : 0;
+        }
+
+        /// Binds the varying-interpolated data streams
+        template<class INPUT_BUFFER, class OUTPUT_BUFFER>
+        void BindVaryingBuffers( VertexBufferDescriptor const & iDesc, INPUT_BUFFER *inQ,
+                                 VertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
+            varyingData.inDesc = iDesc;
+            varyingData.in = inQ ? inQ->BindCpuBuffer() : 0;
+
+            varyingData.outDesc = oDesc;
+            varyingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        }
+
+        /// Binds the face-varying-interpolated data streams
+        template<class OUTPUT_BUFFER>
+        void BindFacevaryingBuffers( VertexBufferDescriptor const & iDesc,
+                                     VertexBufferDescriptor const & oDesc, OUTPUT_BUFFER *outQ ) {
+            facevaryingData.inDesc = iDesc;
+
+            facevaryingData.outDesc = oDesc;
+            facevaryingData.out = outQ ? outQ->BindCpuBuffer() : 0;
+        }
+
+        /// Unbinds all the buffers
         void Reset() {
             vertexData.Reset();
             varyingData.Reset();
@@ -275,6 +415,45 @@ private:
         FacevaryingData  facevaryingData; // face-varying interpolated data descriptor
     };
 
+private:
+
+    int _EvalLimitSample( EvalCoords const & coords,
+                          CpuEvalLimitContext const * context,
+                          BindState const & bindState,
+                          unsigned int index ) const;
+
+    // A sample resolved to its patch (with sub-patch coordinates)
+    struct ResolvedSample {
+        Far::PatchMap::Handle const * handle;
+        float u, v;
+    };
+
+    // Interpolates the vertex data of a resolved sample
+    void _EvalVertexData( ResolvedSample const & sample,
+                          CpuEvalLimitContext const * context,
+                          BindState const & bindState,
+                          unsigned int index ) const;
+
+    // Interpolates the varying & face-varying data of a resolved sample
+    void _EvalVaryingData( ResolvedSample const & sample,
+                           CpuEvalLimitContext const * context,
+                           BindState const & bindState,
+                           unsigned int index ) const;
+
+    // Evaluates the samples [begin, end) of 'order', a list of resolved
+    // samples sorted by patch
+    void _EvalLimitSamples( ResolvedSample const * samples,
+                            int const * order, int begin, int end,
+                            CpuEvalLimitContext const * context,
+                            BindState const & bindState,
+                            unsigned int index ) const;
+
+    // Parallel tasks of EvalLimitSamples()
+    class ResolveLimitSamplesKernel;
+    class EvalLimitSamplesKernel;
+
+    // Bind state is a transitional state during refinement.
+    // It doesn't take an ownership of vertex buffers.
     BindState _currentBindState;
 };
 
@@ -376,6 +376,178 @@ evalCorner(float u, float v,
     }
 }
 
+void
+gatherBSplinePoints(Far::PatchTables::Type type,
+                    unsigned int const * vertexIndices,
+                    VertexBufferDescriptor const & inDesc,
+                    float const * inQ,
+                    float * points) {
+
+    int length = inDesc.length;
+
+    float const * inOffset = inQ + inDesc.offset;
+
+    switch (type) {
+
+        case Far::PatchTables::REGULAR : {
+            for (int i=0; i<16; ++i) {
+                memcpy(points+i*length, inOffset + vertexIndices[i]*inDesc.stride,
+                    length*sizeof(float));
+            }
+        } break;
+
+        case Far::PatchTables::BOUNDARY : {
+            // mirror the missing row (see evalBoundary())
+            for (int i=0; i<4; ++i) {
+                float const * vi = inOffset + vertexIndices[i]*inDesc.stride,
+                            * vj = inOffset + vertexIndices[i+4]*inDesc.stride;
+                for (int k=0; k<length; ++k) {
+                    points[i*length+k] = 2.0f*vi[k] - vj[k];
+                }
+            }
+            for (int i=0; i<12; ++i) {
+                memcpy(points+(i+4)*length, inOffset + vertexIndices[i]*inDesc.stride,
+                    length*sizeof(float));
+            }
+        } break;
+
+        case Far::PatchTables::CORNER : {
+            // mirror the missing row & column (see evalCorner())
+            float const *v0 = inOffset + vertexIndices[0]*inDesc.stride,
+                        *v1 = inOffset + vertexIndices[1]*inDesc.stride,
+                        *v2 = inOffset + vertexIndices[2]*inDesc.stride,
+                        *v3 = inOffset + vertexIndices[3]*inDesc.stride,
+                        *v4 = inOffset + vertexIndices[4]*inDesc.stride,
+                        *v5 = inOffset + vertexIndices[5]*inDesc.stride,
+                        *v7 = inOffset + vertexIndices[7]*inDesc.stride,
+                        *v8 = inOffset + vertexIndices[8]*inDesc.stride;
+
+            float * M0 = points,
+                  * M1 = points +  1*length,
+                  * M2 = points +  2*length,
+                  * M3 = points +  3*length,
+                  * M4 = points +  7*length,
+                  * M5 = points + 11*length,
+                  * M6 = points + 15*length;
+
+            for (int k=0; k<length; ++k) {
+                M0[k] = 2.0f*v0[k] - v3[k];
+                M1[k] = 2.0f*v1[k] - v4[k];
+                M2[k] = 2.0f*v2[k] - v5[k];
+                M3[k] = 2.0f*M2[k] - M1[k];
+                M4[k] = 2.0f*v2[k] - v1[k];
+                M5[k] = 2.0f*v5[k] - v4[k];
+                M6[k] = 2.0f*v8[k] - v7[k];
+            }
+            for (int j=1; j<4; ++j) {
+                for (int i=0; i<3; ++i) {
+                    memcpy(points+(i+j*4)*length,
+                        inOffset + vertexIndices[i+(j-1)*3]*inDesc.stride,
+                            length*sizeof(float));
+                }
+            }
+        } break;
+
+        default:
+            assert(0);
+    }
+}
+
+// Same as evalCubicBSpline() for a batch of parametric coordinates
+inline void
+evalCubicBSplineBatch(float const * u,
+                      float B[4][EVAL_LIMIT_BATCH_WIDTH],
+                      float D[4][EVAL_LIMIT_BATCH_WIDTH]) {
+
+    for (int s=0; s<EVAL_LIMIT_BATCH_WIDTH; ++s) {
+        float t = u[s];
+        float r = 1.0f - u[s];
+
+        float A0 =                      r * (0.5f * r);
+        float A1 = t * (r + 0.5f * t) + r * (0.5f * r + t);
+        float A2 = t * (    0.5f * t);
+
+        B[0][s] =                                     1.f/3.f * r                * A0;
+        B[1][s] = (2.f/3.f * r +           t) * A0 + (2.f/3.f * r + 1.f/3.f * t) * A1;
+        B[2][s] = (1.f/3.f * r + 2.f/3.f * t) * A1 + (          r + 2.f/3.f * t) * A2;
+        B[3][s] =                1.f/3.f * t  * A2;
+
+        D[0][s] =    - A0;
+        D[1][s] = A0 - A1;
+        D[2][s] = A1 - A2;
+        D[3][s] = A2;
+    }
+}
+
+void
+evalBSplineBatch(int numSamples,
+                 float const * u, float const * v,
+                 float const * points, int length,
+                 float * const * outQ,
+                 float * const * outDQU,
+                 float * const * outDQV ) {
+
+    assert( numSamples>0 and numSamples<=EVAL_LIMIT_BATCH_WIDTH );
+
+    int const W = EVAL_LIMIT_BATCH_WIDTH;
+
+    // pad the batch so that all the loops over the samples run W times
+    float U[W], V[W];
+    for (int s=0; s<W; ++s) {
+        U[s] = s<numSamples ? u[s] : 0.0f;
+        V[s] = s<numSamples ? v[s] : 0.0f;
+    }
+
+    float BU[4][W], DU[4][W],
+          BV[4][W], DV[4][W];
+
+    evalCubicBSplineBatch(U, BU, DU);
+    evalCubicBSplineBatch(V, BV, DV);
+
+    // the operations (and their order) are those of evalBSpline() for each
+    // sample, so that the results are identical
+    for (int k=0; k<length; ++k) {
+
+        float PU[4][W], PDU[4][W];
+
+        for (int i=0; i<4; ++i) {
+            for (int s=0; s<W; ++s) {
+                PU[i][s] = PDU[i][s] = 0.0f;
+            }
+            for (int j=0; j<4; ++j) {
+                float p = points[(i+j*4)*length+k];
+                for (int s=0; s<W; ++s) {
+                    PU[i][s] += p * BU[j][s];
+                    PDU[i][s] += p * DU[j][s];
+                }
+            }
+        }
+
+        float Q[W], dQU[W], dQV[W];
+
+        for (int s=0; s<W; ++s) {
+            Q[s] = dQU[s] = dQV[s] = 0.0f;
+        }
+        for (int i=0; i<4; ++i) {
+            for (int s=0; s<W; ++s) {
+                Q[s] += PU[i][s] * BV[i][s];
+                dQU[s] += PDU[i][s] * BV[i][s];
+                dQV[s] += PU[i][s] * DV[i][s];
+            }
+        }
+
+        for (int s=0; s<numSamples; ++s) {
+            outQ[s][k] = Q[s];
+            if (outDQU) {
+                outDQU[s][k] = dQU[s];
+            }
+            if (outDQV) {
+                outDQV[s][k] = dQV[s];
+            }
+        }
+    }
+}
+
 /*
 static float ef[7] = {
     0.813008f, 0.500000f, 0.363636f, 0.287505f,
@@ -427,25 +599,16 @@ csf(unsigned int n, unsigned int j)
 
 
 void
-evalGregory(float u, float v,
-            unsigned int const * vertexIndices,
-            int const * vertexValenceBuffer,
-            unsigned int const  * quadOffsetBuffer,
-            int maxValence,
-            VertexBufferDescriptor const & inDesc,
-            float const * inQ,
-            VertexBufferDescriptor const & outDesc,
-            float * outQ,
-            float * outDQU,
-            float * outDQV )
+computeGregoryPoints(unsigned int const * vertexIndices,
+                     int const * vertexValenceBuffer,
+                     unsigned int const  * quadOffsetBuffer,
+                     int maxValence,
+                     VertexBufferDescriptor const & inDesc,
+                     float const * inQ,
+                     float * points)
 {
     // vertex
 
-    // make sure that we have enough space to store results
-    assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
-
-    bool evalDeriv = (outDQU or outDQV);
-
     int valences[4], length=inDesc.length;
 
     float const * inOffset = inQ + inDesc.offset;
@@ -593,13 +756,32 @@ evalGregory(float u, float v,
         }
     }
 
-    float * p[20];
+    // pack the 20 control points
     for (int i=0, ofs=0; i<4; ++i, ofs+=length) {
-        p[i*5+0] = opos + ofs;
-        p[i*5+1] =   Ep + ofs;
-        p[i*5+2] =   Em + ofs;
-        p[i*5+3] =   Fp + ofs;
-        p[i*5+4] =   Fm + ofs;
+        memcpy(points + (i*5+0)*length, opos + ofs, length*sizeof(float));
+        memcpy(points + (i*5+1)*length,   Ep + ofs, length*sizeof(float));
+        memcpy(points + (i*5+2)*length,   Em + ofs, length*sizeof(float));
+        memcpy(points + (i*5+3)*length,   Fp + ofs, length*sizeof(float));
+        memcpy(points + (i*5+4)*length,   Fm + ofs, length*sizeof(float));
+    }
+}
+
+
+void
+evalGregoryPoints(float u, float v,
+                  float const * points, int length,
+                  VertexBufferDescriptor const & outDesc,
+                  float * outQ,
+                  float * outDQU,
+                  float * outDQV )
+{
+    assert( outQ and length <= (outDesc.stride-outDesc.offset) );
+
+    bool evalDeriv = (outDQU or outDQV);
+
+    float const * p[20];
+    for (int i=0; i<20; ++i) {
+        p[i] = points + i*length;
     }
 
     float U = 1-u, V=1-v;
@@ -636,10 +818,10 @@ evalGregory(float u, float v,
     memcpy(q+15*length, p[10], length*sizeof(float));
 
     float B[4], D[4],
-          *BU=(float*)alloca(inDesc.length*4*sizeof(float)),
-          *DU=(float*)alloca(inDesc.length*4*sizeof(float));
-    memset(BU, 0, inDesc.length*4*sizeof(float));
-    memset(DU, 0, inDesc.length*4*sizeof(float));
+          *BU=(float*)alloca(length*4*sizeof(float)),
+          *DU=(float*)alloca(length*4*sizeof(float));
+    memset(BU, 0, length*4*sizeof(float));
+    memset(DU, 0, length*4*sizeof(float));
 
     univar4x4(u, B, evalDeriv ? D : 0);
 
@@ -648,12 +830,12 @@ evalGregory(float u, float v,
 
             float const * in = q + (i+j*4)*length;
 
-            for (int k=0; k<inDesc.length; ++k) {
+            for (int k=0; k<length; ++k) {
 
-                BU[i*inDesc.length+k] += in[k] * B[j];
+                BU[i*length+k] += in[k] * B[j];
 
                 if (evalDeriv)
-                    DU[i*inDesc.length+k] += in[k] * D[j];
+                    DU[i*length+k] += in[k] * D[j];
             }
         }
     }
@@ -672,12 +854,12 @@ evalGregory(float u, float v,
     }
 
     for (int i=0; i<4; ++i) {
-        for (int k=0; k<inDesc.length; ++k) {
-            Q[k] += BU[inDesc.length*i+k] * B[i];
+        for (int k=0; k<length; ++k) {
+            Q[k] += BU[length*i+k] * B[i];
 
             if (evalDeriv) {
-                dQU[k] += DU[inDesc.length*i+k] * B[i];
-                dQV[k] += BU[inDesc.length*i+k] * D[i];
+                dQU[k] += DU[length*i+k] * B[i];
+                dQV[k] += BU[length*i+k] * D[i];
             }
         }
     }
@@ -685,24 +867,40 @@ evalGregory(float u, float v,
 
 
 void
-evalGregoryBoundary(float u, float v,
-                    unsigned int const * vertexIndices,
-                    int const * vertexValenceBuffer,
-                    unsigned int const  * quadOffsetBuffer,
-                    int maxValence,
-                    VertexBufferDescriptor const & inDesc,
-                    float const * inQ,
-                    VertexBufferDescriptor const & outDesc,
-                    float * outQ,
-                    float * outDQU,
-                    float * outDQV )
+evalGregory(float u, float v,
+            unsigned int const * vertexIndices,
+            int const * vertexValenceBuffer,
+            unsigned int const  * quadOffsetBuffer,
+            int maxValence,
+            VertexBufferDescriptor const & inDesc,
+            float const * inQ,
+            VertexBufferDescriptor const & outDesc,
+            float * outQ,
+            float * outDQU,
+            float * outDQV )
 {
-    // vertex
-
     // make sure that we have enough space to store results
     assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
 
-    bool evalDeriv = (outDQU or outDQV);
+    float * points = (float*)alloca(20*inDesc.length*sizeof(float));
+
+    computeGregoryPoints(vertexIndices, vertexValenceBuffer, quadOffsetBuffer,
+        maxValence, inDesc, inQ, points);
+
+    evalGregoryPoints(u, v, points, inDesc.length, outDesc, outQ, outDQU, outDQV);
+}
+
+
+void
+computeGregoryBoundaryPoints(unsigned int const * vertexIndices,
+                             int const * vertexValenceBuffer,
+                             unsigned int const  * quadOffsetBuffer,
+                             int maxValence,
+                             VertexBufferDescriptor const & inDesc,
+                             float const * inQ,
+                             float * points)
+{
+    // vertex
 
     int valences[4], zerothNeighbors[4], length=inDesc.length;
 
@@ -820,7 +1018,7 @@ evalGregoryBoundary(float u, float v,
                                     inOffset[boundaryEdgeNeighbors[1]*inDesc.stride+k] + 4.0f*pos[k])/6.0f;
                 }
             } else {
-                memcpy(opos, pos, length*sizeof(float));
+                memcpy(opos+vofs, pos, length*sizeof(float));
             }
 
             float k = float(float(ivalence) - 1.0f);    //k is the number of faces
@@ -994,99 +1192,44 @@ evalGregoryBoundary(float u, float v,
             for (int k=0, ofs=vofs, ipofs=ip*length, imofs=im*length; k<length; ++k, ++ofs, ++ipofs, ++imofs) {
                 Ep[ofs] = (2.0f * org[ofs] + org[ipofs])/3.0f;
                 Em[ofs] = (2.0f * org[ofs] + org[imofs])/3.0f;
-                Fp[ofs] = Fm[ofs] = (4.0f * org[ofs] + org[((vid+2)%n)*inDesc.stride+k] + 2.0f * org[ipofs] + 2.0f * org[imofs])/9.0f;
+                Fp[ofs] = Fm[ofs] = (4.0f * org[ofs] + org[((vid+2)%4)*length+k] + 2.0f * org[ipofs] + 2.0f * org[imofs])/9.0f;
             }
         }
     }
 
-    float * p[20];
-    for (int vid=0, ofs=0; vid<4; ++vid, ofs+=length) {
-        p[vid*5+0] = opos + ofs;
-        p[vid*5+1] =   Ep + ofs;
-        p[vid*5+2] =   Em + ofs;
-        p[vid*5+3] =   Fp + ofs;
-        p[vid*5+4] =   Fm + ofs;
-    }
-
-    float U = 1-u, V=1-v;
-#ifdef __INTEL_COMPILER // remark #1572: floating-point equality and inequality comparisons are unreliable
-#pragma warning disable 1572
-#endif
-    float d11 = u+v; if(u+v==0.0f) d11 = 1.0f;
-    float d12 = U+v; if(U+v==0.0f) d12 = 1.0f;
-    float d21 = u+V; if(u+V==0.0f) d21 = 1.0f;
-    float d22 = U+V; if(U+V==0.0f) d22 = 1.0f;
-#ifdef __INTEL_COMPILER
-#pragma warning enable 1572
-#endif
-
-    float *q=(float*)alloca(length*16*sizeof(float));
-    for (int k=0; k<length; ++k) {
-        q[ 5*length+k] = (u*p[ 3][k] + v*p[ 4][k])/d11;
-        q[ 6*length+k] = (U*p[ 9][k] + v*p[ 8][k])/d12;
-        q[ 9*length+k] = (u*p[19][k] + V*p[18][k])/d21;
-        q[10*length+k] = (U*p[13][k] + V*p[14][k])/d22;
-    }
-
-    memcpy(q+ 0*length, p[ 0], length*sizeof(float));
-    memcpy(q+ 1*length, p[ 1], length*sizeof(float));
-    memcpy(q+ 2*length, p[ 7], length*sizeof(float));
-    memcpy(q+ 3*length, p[ 5], length*sizeof(float));
-    memcpy(q+ 4*length, p[ 2], length*sizeof(float));
-    memcpy(q+ 7*length, p[ 6], length*sizeof(float));
-    memcpy(q+ 8*length, p[16], length*sizeof(float));
-    memcpy(q+11*length, p[12], length*sizeof(float));
-    memcpy(q+12*length, p[15], length*sizeof(float));
-    memcpy(q+13*length, p[17], length*sizeof(float));
-    memcpy(q+14*length, p[11], length*sizeof(float));
-    memcpy(q+15*length, p[10], length*sizeof(float));
-
-    float B[4], D[4],
-          *BU=(float*)alloca(inDesc.length*4*sizeof(float)),
-          *DU=(float*)alloca(inDesc.length*4*sizeof(float));
-    memset(BU, 0, inDesc.length*4*sizeof(float));
-    memset(DU, 0, inDesc.length*4*sizeof(float));
-
-    univar4x4(u, B, evalDeriv ? D : 0);
-
-    for (int i=0; i<4; ++i) {
-        for (int j=0; j<4; ++j) {
-
-            float const * in = q + (i+j*4)*length;
-
-            for (int k=0; k<inDesc.length; ++k) {
-
-                BU[i*inDesc.length+k] += in[k] * B[j];
-
-                if (evalDeriv)
-                    DU[i*inDesc.length+k] += in[k] * D[j];
-            }
-        }
+    // pack the 20 control points
+    for (int i=0, ofs=0; i<4; ++i, ofs+=length) {
+        memcpy(points + (i*5+0)*length, opos + ofs, length*sizeof(float));
+        memcpy(points + (i*5+1)*length,   Ep + ofs, length*sizeof(float));
+        memcpy(points + (i*5+2)*length,   Em + ofs, length*sizeof(float));
+        memcpy(points + (i*5+3)*length,   Fp + ofs, length*sizeof(float));
+        memcpy(points + (i*5+4)*length,   Fm + ofs, length*sizeof(float));
     }
+}
 
-    univar4x4(v, B, evalDeriv ? D : 0);
 
-    float * Q = outQ + outDesc.offset;
-    float * dQU = outDQU + outDesc.offset;
-    float * dQV = outDQV + outDesc.offset;
+void
+evalGregoryBoundary(float u, float v,
+                    unsigned int const * vertexIndices,
+                    int const * vertexValenceBuffer,
+                    unsigned int const  * quadOffsetBuffer,
+                    int maxValence,
+                    VertexBufferDescriptor const & inDesc,
+                    float const * inQ,
+                    VertexBufferDescriptor const & outDesc,
+                    float * outQ,
+                    float * outDQU,
+                    float * outDQV )
+{
+    // make sure that we have enough space to store results
+    assert( outQ and inDesc.length <= (outDesc.stride-outDesc.offset) );
 
-    // clear result
-    memset(Q, 0, outDesc.length*sizeof(float));
-    if (evalDeriv) {
-        memset(dQU, 0, outDesc.length*sizeof(float));
-        memset(dQV, 0, outDesc.length*sizeof(float));
-    }
+    float * points = (float*)alloca(20*inDesc.length*sizeof(float));
 
-    for (int i=0; i<4; ++i) {
-        for (int k=0; k<inDesc.length; ++k) {
-            Q[k] += BU[inDesc.length*i+k] * B[i];
+    computeGregoryBoundaryPoints(vertexIndices, vertexValenceBuffer, quadOffsetBuffer,
+        maxValence, inDesc, inQ, points);
 
-            if (evalDeriv) {
-                dQU[k] += DU[inDesc.length*i+k] * B[i];
-                dQV[k] += BU[inDesc.length*i+k] * D[i];
-            }
-        }
-    }
+    evalGregoryPoints(u, v, points, inDesc.length, outDesc, outQ, outDQU, outDQV);
 }
 
 }  // end namespace Osd
@@ -28,6 +28,7 @@
 #include "../version.h"
 
 #include "../osd/vertexDescriptor.h"
+#include "../far/patchTables.h"
 
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
@@ -98,6 +99,68 @@ evalGregoryBoundary(float u, float v,
                     float * outDQU,
                     float * outDQV );
 
+// Computes the 20 control points of a GREGORY patch from the 1-rings of its
+// corners into 'points' (packed with a stride of inDesc.length floats, 5 per
+// corner : P, Ep, Em, Fp, Fm)
+void
+computeGregoryPoints(unsigned int const * vertexIndices,
+                     int const * vertexValenceBuffer,
+                     unsigned int const  * quadOffsetBuffer,
+                     int maxValence,
+                     VertexBufferDescriptor const & inDesc,
+                     float const * inQ,
+                     float * points);
+
+// Computes the 20 control points of a GREGORY_BOUNDARY patch (see
+// computeGregoryPoints())
+void
+computeGregoryBoundaryPoints(unsigned int const * vertexIndices,
+                             int const * vertexValenceBuffer,
+                             unsigned int const  * quadOffsetBuffer,
+                             int maxValence,
+                             VertexBufferDescriptor const & inDesc,
+                             float const * inQ,
+                             float * points);
+
+// Evaluates a Gregory patch from its 20 control points : evalGregory() and
+// evalGregoryBoundary() are equivalent to computing the points of the patch
+// and calling this function.
+void
+evalGregoryPoints(float u, float v,
+                  float const * points, int length,
+                  VertexBufferDescriptor const & outDesc,
+                  float * outQ,
+                  float * outDQU,
+                  float * outDQV );
+
+// Number of samples evaluated at once by evalBSplineBatch()
+enum { EVAL_LIMIT_BATCH_WIDTH = 8 };
+
+// Gathers the 16 control points of a REGULAR, BOUNDARY or CORNER patch into
+// 'points' (packed with a stride of inDesc.length floats). The points missing
+// from boundary & corner patches are mirrored as in evalBoundary() and
+// evalCorner().
+void
+gatherBSplinePoints(Far::PatchTables::Type type,
+                    unsigned int const * vertexIndices,
+                    VertexBufferDescriptor const & inDesc,
+                    float const * inQ,
+                    float * points);
+
+// Evaluates a bicubic B-spline patch at up to EVAL_LIMIT_BATCH_WIDTH samples
+// at once : the basis functions of all the samples are computed together and
+// each control point is applied to every sample in turn. 'points' are the
+// gathered control points of the patch and the output arrays hold one
+// destination per sample (the derivative arrays are optional). The results
+// are identical to those of evalBSpline().
+void
+evalBSplineBatch(int numSamples,
+                 float const * u, float const * v,
+                 float const * points, int length,
+                 float * const * outQ,
+                 float * const * outDQU,
+                 float * const * outDQV );
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -29,13 +29,19 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
-CpuEvalStencilsContext::CpuEvalStencilsContext(Far::StencilTables const *stencils) :
-    _stencils(stencils) {
+CpuEvalStencilsContext::CpuEvalStencilsContext(Far::StencilTables const *stencils,
+    Far::LimitStencilTables const *limitStencils) :
+    _stencils(stencils), _limitStencils(limitStencils) {
 }
 
 CpuEvalStencilsContext *
 CpuEvalStencilsContext::Create(Far::StencilTables const *stencils) {
-    return new CpuEvalStencilsContext(stencils);
+    return new CpuEvalStencilsContext(stencils, 0);
+}
+
+CpuEvalStencilsContext *
+CpuEvalStencilsContext::Create(Far::LimitStencilTables const *stencils) {
+    return new CpuEvalStencilsContext(stencils, stencils);
 }
 
 } // end namespace Osd
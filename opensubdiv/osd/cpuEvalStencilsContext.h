@@ -50,18 +50,34 @@ public:
     ///
     static CpuEvalStencilsContext * Create(Far::StencilTables const *stencils);
 
+    /// \brief Creates an CpuEvalStencilsContext instance that can also
+    /// evaluate derivatives
+    ///
+    /// @param stencils  a pointer to the Far::LimitStencilTables
+    ///
+    static CpuEvalStencilsContext * Create(Far::LimitStencilTables const *stencils);
+
     /// \brief Returns the Far::StencilTables applied
     Far::StencilTables const * GetStencilTables() const {
         return _stencils;
     }
 
+    /// \brief Returns the Far::LimitStencilTables applied (null if the
+    /// context was created from tables without derivative weights)
+    Far::LimitStencilTables const * GetLimitStencilTables() const {
+        return _limitStencils;
+    }
+
 protected:
 
-    CpuEvalStencilsContext(Far::StencilTables const *stencils);
+    CpuEvalStencilsContext(Far::StencilTables const *stencils,
+                           Far::LimitStencilTables const *limitStencils);
 
 private:
 
     Far::StencilTables const * _stencils;
+
+    Far::LimitStencilTables const * _limitStencils;
 };
 
 } // end namespace Osd
@@ -23,6 +23,7 @@
 //
 
 #include "../osd/cpuEvalStencilsController.h"
+#include "../osd/cpuKernel.h"
 
 #include <cassert>
 
@@ -40,101 +41,72 @@ CpuEvalStencilsController::~CpuEvalStencilsController() {
 int
 CpuEvalStencilsController::_UpdateValues( CpuEvalStencilsContext * context ) {
 
-    int result=0;
-
-    Far::StencilTables const * stencils = context->GetStencilTables();
-
-    int nstencils = stencils->GetNumStencils();
-    if (not nstencils)
-        return result;
-
-    VertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
-                              outDesc = _currentBindState.outputDataDesc;
-
-    // make sure that we have control data to work with
-    if (not ctrlDesc.CanEval(outDesc))
-        return 0;
-
-    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
-
-    float * out = _currentBindState.outputData + outDesc.offset;
-
-    if ((not ctrl) or (not out))
-        return result;
-
-    int const * sizes = &stencils->GetSizes().at(0),
-              * index = &stencils->GetControlIndices().at(0);
-
-    float const * weight = &stencils->GetWeights().at(0);
-
-    for (int i=0; i<nstencils; ++i) {
-
-        memset(out, 0, outDesc.length*sizeof(float));
+    return _Update(context, true, false);
+}
 
-        for (int j=0; j<sizes[i]; ++j, ++index, ++weight) {
+int
+CpuEvalStencilsController::_UpdateDerivs( CpuEvalStencilsContext * context ) {
 
-            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+    return _Update(context, false, true);
+}
 
-            for (int k=0; k<outDesc.length; ++k) {
-                out[k] += cv[k] * (*weight);
-            }
-        }
-        out += outDesc.stride;
-    }
+int
+CpuEvalStencilsController::_UpdateValuesAndDerivs( CpuEvalStencilsContext * context ) {
 
-    return nstencils;
+    return _Update(context, true, true);
 }
 
 int
-CpuEvalStencilsController::_UpdateDerivs( CpuEvalStencilsContext * context ) {
-
-    int result=0;
+CpuEvalStencilsController::_Update( CpuEvalStencilsContext * context,
+    bool values, bool derivs ) {
 
     Far::StencilTables const * stencils = context->GetStencilTables();
+    Far::LimitStencilTables const * limitStencils = context->GetLimitStencilTables();
+
+    // derivatives require limit stencils
+    if (not stencils or (derivs and not limitStencils))
+        return 0;
 
     int nstencils = stencils->GetNumStencils();
     if (not nstencils)
-        return result;
-
-    VertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
-                              duDesc = _currentBindState.outputDuDesc,
-                              dvDesc = _currentBindState.outputDvDesc;
-
-    // make sure that we have control data to work with
-    if (not (ctrlDesc.CanEval(duDesc) and ctrlDesc.CanEval(dvDesc)))
         return 0;
 
-    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
-
-    float * du = _currentBindState.outputUDeriv + duDesc.offset,
-          * dv = _currentBindState.outputVDeriv + dvDesc.offset;
+    BindState const & bs = _currentBindState;
 
-    if ((not ctrl) or (not du) or (not dv))
-        return result;
+    VertexBufferDescriptor const & ctrlDesc = bs.controlDataDesc;
 
-    int const * sizes = &stencils->GetSizes().at(0),
-              * index = &stencils->GetControlIndices().at(0);
-
-    float const * duweight = &stencils->GetDuWeights().at(0),
-                * dvweight = &stencils->GetDvWeights().at(0);
+    // make sure that we have control data to work with
+    if (not bs.controlData)
+        return 0;
 
-    for (int i=0; i<nstencils; ++i) {
+    float * out = 0,
+          * du = 0,
+          * dv = 0;
 
-        memset(du, 0, duDesc.length*sizeof(float));
-        memset(dv, 0, dvDesc.length*sizeof(float));
+    if (values) {
+        if (not bs.outputData or not ctrlDesc.CanEval(bs.outputDataDesc))
+            return 0;
+        out = bs.outputData + bs.outputDataDesc.offset;
+    }
 
-        for (int j=0; j<sizes[i]; ++j, ++index, ++duweight, ++dvweight) {
+    if (derivs) {
+        if (not bs.outputUDeriv or not ctrlDesc.CanEval(bs.outputDuDesc) or
+            not bs.outputVDeriv or not ctrlDesc.CanEval(bs.outputDvDesc))
+            return 0;
+        du = bs.outputUDeriv + bs.outputDuDesc.offset;
+        dv = bs.outputVDeriv + bs.outputDvDesc.offset;
+    }
 
-            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+    std::vector<int> const & offsets = stencils->GetOffsets();
 
-            for (int k=0; k<duDesc.length; ++k) {
-                du[k] += cv[k] * (*duweight);
-                dv[k] += cv[k] * (*dvweight);
-            }
-        }
-        du += duDesc.stride;
-        dv += dvDesc.stride;
-    }
+    CpuComputeLimitStencils(ctrlDesc, bs.controlData + ctrlDesc.offset,
+        bs.outputDataDesc, out, bs.outputDuDesc, du, bs.outputDvDesc, dv,
+            &stencils->GetSizes()[0], offsets.empty() ? 0 : &offsets[0],
+                &stencils->GetControlIndices()[0],
+                    values ? &stencils->GetWeights()[0] : 0,
+                        derivs ? &limitStencils->GetDuWeights()[0] : 0,
+                            derivs ? &limitStencils->GetDvWeights()[0] : 0,
+                                0, nstencils);
 
     return nstencils;
 }
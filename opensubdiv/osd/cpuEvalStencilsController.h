@@ -127,6 +127,55 @@ public:
         return n;
     }
 
+    /// \brief Applies stencil and derivative stencil weights to the control
+    ///        vertex data
+    ///
+    /// Equivalent to UpdateValues() followed by UpdateDerivs(), but each
+    /// control vertex is read once per stencil and blended in the three
+    /// outputs together. The context must have been created from
+    /// Far::LimitStencilTables.
+    ///
+    /// @param context          the CpuEvalStencilsContext with the stencil weights
+    ///
+    /// @param controlDataDesc  vertex buffer descriptor for the control vertex data
+    ///
+    /// @param controlVertices  vertex buffer with the control vertices data
+    ///
+    /// @param outputDataDesc   vertex buffer descriptor for the output vertex data
+    ///
+    /// @param outputData       output vertex buffer for the interpolated data
+    ///
+    /// @param outputDuDesc     vertex buffer descriptor for the U derivative output data
+    ///
+    /// @param outputDuData     output vertex buffer for the U derivative data
+    ///
+    /// @param outputDvDesc     vertex buffer descriptor for the V deriv output data
+    ///
+    /// @param outputDvData     output vertex buffer for the V derivative data
+    ///
+    template<class CONTROL_BUFFER, class OUTPUT_BUFFER>
+    int UpdateValuesAndDerivs( CpuEvalStencilsContext * context,
+                               VertexBufferDescriptor const & controlDataDesc, CONTROL_BUFFER *controlVertices,
+                               VertexBufferDescriptor const & outputDataDesc, OUTPUT_BUFFER *outputData,
+                               VertexBufferDescriptor const & outputDuDesc, OUTPUT_BUFFER *outputDuData,
+                               VertexBufferDescriptor const & outputDvDesc, OUTPUT_BUFFER *outputDvData ) {
+
+        if (not context->GetStencilTables()->GetNumStencils())
+            return 0;
+
+        bindControlData( controlDataDesc, controlVertices );
+
+        bindOutputData( outputDataDesc, outputData );
+
+        bindOutputDerivData( outputDuDesc, outputDuData, outputDvDesc, outputDvData );
+
+        int n = _UpdateValuesAndDerivs( context );
+
+        unbind();
+
+        return n;
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
@@ -169,6 +218,11 @@ private:
 
     int _UpdateValues( CpuEvalStencilsContext * context );
     int _UpdateDerivs( CpuEvalStencilsContext * context );
+    int _UpdateValuesAndDerivs( CpuEvalStencilsContext * context );
+
+    // Applies the weights of the stencils to the bound outputs : values
+    // and / or derivatives
+    int _Update( CpuEvalStencilsContext * context, bool values, bool derivs );
 
     // Bind state is a transitional state during refinement.
     // It doesn't take an ownership of vertex buffers.
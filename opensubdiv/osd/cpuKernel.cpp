@@ -23,11 +23,14 @@
 //
 
 #include "../osd/cpuKernel.h"
+#include "../osd/cpuSimdKernel.h"
 #include "../osd/vertexDescriptor.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
 
 namespace OpenSubdiv {
@@ -69,27 +72,32 @@ copy(float *dst, int dstIndex, const float *src,
     memcpy(dst, src, desc.length*sizeof(float));
 }
 
-void
+template <class INDEX, class WEIGHT> void
 CpuComputeStencils(VertexBufferDescriptor const &vertexDesc,
                    float const * vertexSrc,
                    float * vertexDst,
                    unsigned char const * sizes,
                    int const * offsets,
-                   int const * indices,
-                   float const * weights,
+                   INDEX const * indices,
+                   WEIGHT const * weights,
                    int start, int end) {
 
     assert(start>=0 and start<end);
 
     if (start>0) {
-        sizes += start;
         indices += offsets[start];
         weights += offsets[start];
     }
 
+    // Explicit SSE4 / AVX2 / AVX-512 kernels selected at runtime
+    if (SimdComputeStencils(vertexDesc, vertexSrc, vertexDst,
+        sizes, indices, weights, start, end)) {
+        return;
+    }
+
     if (vertexDesc.length==4 and vertexDesc.stride==4) {
 
-        // SIMD fast path for aligned primvar data (8 floats)
+        // SIMD fast path for aligned primvar data (4 floats)
         ComputeStencilKernel<4>(vertexSrc, vertexDst,
             sizes, indices, weights, start,  end);
 
@@ -104,13 +112,12 @@ CpuComputeStencils(VertexBufferDescriptor const &vertexDesc,
         // Slow path for non-aligned data
         float * result = (float*)alloca(vertexDesc.length * sizeof(float));
 
-        int nstencils = end-start;
-        for (int i=0; i<nstencils; ++i, ++sizes) {
+        for (int i=start; i<end; ++i) {
 
             clear(result, vertexDesc);
 
-            for (int j=0; j<*sizes; ++j) {
-                addWithWeight(result, vertexSrc, *indices++, *weights++, vertexDesc);
+            for (int j=0; j<sizes[i]; ++j) {
+                addWithWeight(result, vertexSrc, *indices++, (float)*weights++, vertexDesc);
             }
 
             copy(vertexDst, i, result, vertexDesc);
@@ -118,6 +125,271 @@ CpuComputeStencils(VertexBufferDescriptor const &vertexDesc,
     }
 }
 
+void
+CpuComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                        float const * vertexSrc,
+                        float * vertexDst,
+                        VertexBufferDescriptor const &varyingDesc,
+                        float const * varyingSrc,
+                        float * varyingDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        unsigned char const * varyingSizes,
+                        int const * varyingOffsets,
+                        float const * varyingWeights,
+                        int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    if (vertexDst and varyingDst and SimdComputeFusedStencils(vertexDesc,
+        vertexSrc, vertexDst, varyingDesc, varyingSrc, varyingDst, sizes,
+            indices + offsets[start], weights + offsets[start], varyingSizes,
+                varyingWeights + varyingOffsets[start], start, end)) {
+        return;
+    }
+
+    // No fused kernel : vertex primvars with the regular kernels, then
+    // varying primvars (either buffer may be omitted)
+    if (vertexDst) {
+        CpuComputeStencils(vertexDesc, vertexSrc, vertexDst,
+            sizes, offsets, indices, weights, start, end);
+    }
+
+    if (not varyingDst or SimdComputeFusedStencils(vertexDesc, 0, 0,
+        varyingDesc, varyingSrc, varyingDst, sizes, indices + offsets[start],
+            weights + offsets[start], varyingSizes,
+                varyingWeights + varyingOffsets[start], start, end)) {
+        return;
+    }
+
+    // Slow path
+    float * result = (float*)alloca(varyingDesc.length * sizeof(float));
+
+    varyingWeights += varyingOffsets[start];
+
+    for (int i=start; i<end; ++i) {
+
+        int const * stencilIndices = indices + offsets[i];
+
+        clear(result, varyingDesc);
+
+        for (int j=0; j<varyingSizes[i]; ++j) {
+            addWithWeight(result, varyingSrc, stencilIndices[j],
+                *varyingWeights++, varyingDesc);
+        }
+
+        copy(varyingDst, i, result, varyingDesc);
+    }
+}
+
+void
+CpuComputeLimitStencils(VertexBufferDescriptor const &controlDesc,
+                        float const * controlSrc,
+                        VertexBufferDescriptor const &outputDesc,
+                        float * outputDst,
+                        VertexBufferDescriptor const &duDesc,
+                        float * duDst,
+                        VertexBufferDescriptor const &dvDesc,
+                        float * dvDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        float const * duWeights,
+                        float const * dvWeights,
+                        int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    int offset = start>0 ? offsets[start] : 0;
+
+    indices += offset;
+    if (outputDst) weights += offset;
+    if (duDst) duWeights += offset;
+    if (dvDst) dvWeights += offset;
+
+    if (SimdComputeLimitStencils(controlDesc, controlSrc, outputDesc,
+        outputDst, duDesc, duDst, dvDesc, dvDst, sizes, indices, weights,
+            duWeights, dvWeights, start, end)) {
+        return;
+    }
+
+    // Slow path : one accumulator per destination
+    int length = controlDesc.length;
+
+    float * result = (float*)alloca(3 * length * sizeof(float)),
+          * duResult = result + length,
+          * dvResult = duResult + length;
+
+    for (int i=start; i<end; ++i) {
+
+        memset(result, 0, 3 * length * sizeof(float));
+
+        for (int j=0; j<sizes[i]; ++j) {
+
+            float const * src = elementAtIndex(controlSrc, indices[j], controlDesc);
+
+            if (outputDst) {
+                float w = weights[j];
+                for (int k=0; k<length; ++k) {
+                    result[k] += src[k] * w;
+                }
+            }
+            if (duDst) {
+                float w = duWeights[j];
+                for (int k=0; k<length; ++k) {
+                    duResult[k] += src[k] * w;
+                }
+            }
+            if (dvDst) {
+                float w = dvWeights[j];
+                for (int k=0; k<length; ++k) {
+                    dvResult[k] += src[k] * w;
+                }
+            }
+        }
+
+        if (outputDst) {
+            copy(outputDst, i, result, outputDesc);
+            weights += sizes[i];
+        }
+        if (duDst) {
+            copy(duDst, i, duResult, duDesc);
+            duWeights += sizes[i];
+        }
+        if (dvDst) {
+            copy(dvDst, i, dvResult, dvDesc);
+            dvWeights += sizes[i];
+        }
+        indices += sizes[i];
+    }
+}
+
+// Number of stencils applied to all the instances before moving on to the
+// next block (see CpuComputeInstanceStencils())
+static const int instanceBlockSize = 256;
+
+template <class INDEX, class WEIGHT> void
+CpuComputeInstanceStencils(VertexBufferDescriptor const &vertexDesc,
+                           InstanceBufferDescriptor const &instanceDesc,
+                           float const * vertexSrc,
+                           float * vertexDst,
+                           unsigned char const * sizes,
+                           int const * offsets,
+                           INDEX const * indices,
+                           WEIGHT const * weights,
+                           int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    for (int blockStart=start; blockStart<end; blockStart+=instanceBlockSize) {
+
+        int blockEnd = std::min(blockStart+instanceBlockSize, end);
+
+        for (int i=0; i<instanceDesc.numInstances; ++i) {
+            CpuComputeStencils(vertexDesc,
+                vertexSrc + i*instanceDesc.srcStride,
+                vertexDst + i*instanceDesc.dstStride,
+                sizes, offsets, indices, weights, blockStart, blockEnd);
+        }
+    }
+}
+
+void
+ClipStencilRanges(std::vector<int> & ranges, int start, int end) {
+
+    int nranges = 0, nstencils = 0;
+    for (int i=0; i<(int)ranges.size(); i+=2) {
+        int rangeStart = std::max(ranges[i], start),
+            rangeEnd = std::min(ranges[i+1], end);
+        if (rangeStart<rangeEnd) {
+            ranges[2*nranges] = rangeStart;
+            ranges[2*nranges+1] = rangeEnd;
+            nstencils += rangeEnd - rangeStart;
+            ++nranges;
+        }
+    }
+    ranges.resize(2*nranges);
+
+    if (nstencils*2 > end-start) {
+        ranges.resize(2);
+        ranges[0] = start;
+        ranges[1] = end;
+    }
+}
+
+void
+CpuCopyCarriedVertices(VertexBufferDescriptor const &desc,
+                       float const * prevBuffer,
+                       float * buffer,
+                       std::vector<int> const & vertexOrigins,
+                       int numControlVertices,
+                       int start, int end) {
+
+    end = std::min(end, (int)vertexOrigins.size() - numControlVertices);
+
+    int const * origins = &vertexOrigins[numControlVertices];
+
+    for (int i=start; i<end; ) {
+        if (origins[i] < 0) {
+            ++i;
+            continue;
+        }
+
+        // the vertices carried over are mostly in runs of consecutive origins
+        int runEnd = i+1;
+        while (runEnd<end and origins[runEnd]==origins[runEnd-1]+1) {
+            ++runEnd;
+        }
+
+        float const * src = prevBuffer + origins[i] * desc.stride;
+        float * dst = buffer + (numControlVertices + i) * desc.stride;
+
+        if (desc.length==desc.stride) {
+            std::memcpy(dst, src, (runEnd-i) * desc.length * sizeof(float));
+        } else {
+            for (int j=i; j<runEnd; ++j, src+=desc.stride, dst+=desc.stride) {
+                std::memcpy(dst, src, desc.length * sizeof(float));
+            }
+        }
+        i = runEnd;
+    }
+}
+
+template void CpuComputeStencils<int, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        int const *, float const *, int, int);
+
+template void CpuComputeStencils<int, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        int const *, Far::Half const *, int, int);
+
+template void CpuComputeStencils<unsigned short, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        unsigned short const *, float const *, int, int);
+
+template void CpuComputeStencils<unsigned short, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        unsigned short const *, Far::Half const *, int, int);
+
+template void CpuComputeInstanceStencils<int, float>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, int const *, float const *, int, int);
+
+template void CpuComputeInstanceStencils<int, Far::Half>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, int const *, Far::Half const *, int, int);
+
+template void CpuComputeInstanceStencils<unsigned short, float>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, unsigned short const *, float const *, int, int);
+
+template void CpuComputeInstanceStencils<unsigned short, Far::Half>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, unsigned short const *, Far::Half const *, int, int);
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -27,8 +27,12 @@
 
 #include "../version.h"
 
+#include "../far/compactStencilTables.h"
 #include "../osd/vertexDescriptor.h"
 
+#include <cstring>
+#include <vector>
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
@@ -38,16 +42,91 @@ struct VertexDescriptor;
 
 
 
-void
+// Instantiated for 'int' and 'unsigned short' indices, and for 'float' and
+// 'Far::Half' weights (see Far::CompactStencilTables)
+template <class INDEX, class WEIGHT> void
 CpuComputeStencils(VertexBufferDescriptor const &vertexDesc,
                    float const * vertexSrc,
                    float * vertexDst,
                    unsigned char const * sizes,
                    int const * offsets,
-                   int const * indices,
-                   float const * weights,
+                   INDEX const * indices,
+                   WEIGHT const * weights,
                    int start, int end);
 
+// Applies stencils [start, end) to every instance described by
+// 'instanceDesc' : stencils are swept in small blocks, each block being
+// applied to all the instances in turn so that its indices and weights stay
+// in cache. Same instantiations as CpuComputeStencils()
+template <class INDEX, class WEIGHT> void
+CpuComputeInstanceStencils(VertexBufferDescriptor const &vertexDesc,
+                           InstanceBufferDescriptor const &instanceDesc,
+                           float const * vertexSrc,
+                           float * vertexDst,
+                           unsigned char const * sizes,
+                           int const * offsets,
+                           INDEX const * indices,
+                           WEIGHT const * weights,
+                           int start, int end);
+
+// Applies fused vertex & varying stencils [start, end) (see
+// Far::StencilTablesFactory::CreateFused()) to the vertex and varying
+// buffers, walking the control vertex indices once. Either destination may
+// be null to interpolate the other primvars only.
+void
+CpuComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                        float const * vertexSrc,
+                        float * vertexDst,
+                        VertexBufferDescriptor const &varyingDesc,
+                        float const * varyingSrc,
+                        float * varyingDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        unsigned char const * varyingSizes,
+                        int const * varyingOffsets,
+                        float const * varyingWeights,
+                        int start, int end);
+
+// Applies limit stencils [start, end) (see Far::LimitStencilTables) to the
+// control vertices, walking the indices once to interpolate the limit values
+// and their 'u' & 'v' derivatives together. Any of the destinations may be
+// null (its weights are then ignored). The destinations hold the same number
+// of elements as the control vertices, with their own strides.
+void
+CpuComputeLimitStencils(VertexBufferDescriptor const &controlDesc,
+                        float const * controlSrc,
+                        VertexBufferDescriptor const &outputDesc,
+                        float * outputDst,
+                        VertexBufferDescriptor const &duDesc,
+                        float * duDst,
+                        VertexBufferDescriptor const &dvDesc,
+                        float * dvDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        float const * duWeights,
+                        float const * dvWeights,
+                        int start, int end);
+
+// Clips ranges of stencils ([start, end) pairs, see
+// Far::StencilTables::GetDependentStencilRanges()) to the stencils of a
+// batch. Returns the whole batch if the ranges cover most of it, as it is
+// faster to apply than many scattered ranges.
+void ClipStencilRanges(std::vector<int> & ranges, int start, int end);
+
+// Copies the refined vertices of a batch of stencils [start, end) carried
+// over by an update of the refinement (see Far::TopologyRefiner::UpdateSparse())
+// from the buffer refined before the update.
+void CpuCopyCarriedVertices(VertexBufferDescriptor const &desc,
+                            float const * prevBuffer,
+                            float * buffer,
+                            std::vector<int> const & vertexOrigins,
+                            int numControlVertices,
+                            int start, int end);
+
 //
 // SIMD ICC optimization of the stencil kernel
 //
@@ -59,12 +138,15 @@ CpuComputeStencils(VertexBufferDescriptor const &vertexDesc,
 #endif
 
 // Note : this function is re-used in the TBB Compute kernel
-template <int numElems> void
+//
+// 'indices' and 'weights' point to the first element of stencil 'start',
+// weights are accumulated as floats
+template <int numElems, class INDEX, class WEIGHT> void
 ComputeStencilKernel(float const * vertexSrc,
                      float * vertexDst,
                      unsigned char const * sizes,
-                     int const * indices,
-                     float const * weights,
+                     INDEX const * indices,
+                     WEIGHT const * weights,
                      int start,
                      int end) {
 
@@ -87,7 +169,7 @@ ComputeStencilKernel(float const * vertexSrc,
         for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
 
             src = vertexSrc + (*indices)*numElems;
-            weight = *weights;
+            weight = (float)*weights;
 
             // AddWithWeight
 #if defined ( __INTEL_COMPILER ) or defined ( __ICC )
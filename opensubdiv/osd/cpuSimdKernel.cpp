@@ -0,0 +1,758 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include "../osd/cpuSimdKernel.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) or defined(__i386__) or defined(_M_X64) or defined(_M_IX86)
+    #define OSD_SIMD_X86
+#endif
+
+#if defined(OSD_SIMD_X86)
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #include <malloc.h>
+        #define OSD_TARGET(isa)
+    #else
+        #include <cpuid.h>
+        #define OSD_TARGET(isa) __attribute__((target(isa)))
+    #endif
+#endif
+
+// Keep products & sums separate when FMA is available (AVX-512), so that
+// the interleaved kernels match the scalar kernels bit for bit
+#if defined(__clang__)
+    #pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+    #pragma GCC optimize ("fp-contract=off")
+#endif
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+namespace {
+
+SimdInstructionSet
+detectInstructionSet() {
+
+#if defined(OSD_SIMD_X86)
+    unsigned int regs1[4] = { 0, 0, 0, 0 },  // eax, ebx, ecx, edx of leaf 1
+                 regs7[4] = { 0, 0, 0, 0 };  // ... and of leaf 7
+
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    memcpy(regs1, info, sizeof(regs1));
+    if (maxLeaf>=7) {
+        __cpuidex(info, 7, 0);
+        memcpy(regs7, info, sizeof(regs7));
+    }
+#else
+    unsigned int maxLeaf = __get_cpuid_max(0, 0);
+    __get_cpuid(1, &regs1[0], &regs1[1], &regs1[2], &regs1[3]);
+    if (maxLeaf>=7) {
+        __cpuid_count(7, 0, regs7[0], regs7[1], regs7[2], regs7[3]);
+    }
+#endif
+
+    bool sse41   = (regs1[2] & (1u<<19))!=0,
+         osxsave = (regs1[2] & (1u<<27))!=0,
+         avx     = (regs1[2] & (1u<<28))!=0,
+         f16c    = (regs1[2] & (1u<<29))!=0,
+         avx2    = (regs7[1] & (1u<<5))!=0,
+         avx512f = (regs7[1] & (1u<<16))!=0;
+
+    // The OS must save the AVX (and AVX-512) registers
+    unsigned long long xcr0 = 0;
+    if (osxsave) {
+#if defined(_MSC_VER)
+        xcr0 = _xgetbv(0);
+#else
+        unsigned int lo, hi;
+        __asm__ __volatile__ ("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+        xcr0 = ((unsigned long long)hi << 32) | lo;
+#endif
+    }
+    bool osAvx    = (xcr0 & 0x06)==0x06,
+         osAvx512 = (xcr0 & 0xe6)==0xe6;
+
+    if (avx and avx2 and f16c and osAvx) {
+        return (avx512f and osAvx512) ? SIMD_AVX512 : SIMD_AVX2;
+    }
+    if (sse41) {
+        return SIMD_SSE4;
+    }
+#endif
+    return SIMD_NONE;
+}
+
+SimdInstructionSet
+getSupportedInstructionSet() {
+    static SimdInstructionSet isa = detectInstructionSet();
+    return isa;
+}
+
+SimdInstructionSet &
+getSelectedInstructionSet() {
+    static SimdInstructionSet isa = getSupportedInstructionSet();
+    return isa;
+}
+
+#if defined(OSD_SIMD_X86)
+
+//
+// Interleaved kernels : each control value is accumulated with a (masked)
+// vector load of its elements. Products and sums are computed in the same
+// order as the scalar kernels, so the results are identical.
+//
+// The accumulators of primvars longer than a vector live in 'result', which
+// is padded to a whole number of vectors.
+//
+
+// 4 or 8 elements per primvar, in registers
+template <int LENGTH, class INDEX, class WEIGHT> OSD_TARGET("sse4.1") void
+sseComputeRegisters(int stride, float const * src, float * dst,
+    unsigned char const * sizes, INDEX const * indices, WEIGHT const * weights,
+        int start, int end) {
+
+    for (int i=start; i<end; ++i) {
+        __m128 r0 = _mm_setzero_ps(),
+               r1 = _mm_setzero_ps();
+        for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
+            __m128 w = _mm_set1_ps((float)*weights);
+            float const * s = src + (*indices)*stride;
+            r0 = _mm_add_ps(r0, _mm_mul_ps(_mm_loadu_ps(s), w));
+            if (LENGTH==8) {
+                r1 = _mm_add_ps(r1, _mm_mul_ps(_mm_loadu_ps(s+4), w));
+            }
+        }
+        float * d = dst + i*stride;
+        _mm_storeu_ps(d, r0);
+        if (LENGTH==8) {
+            _mm_storeu_ps(d+4, r1);
+        }
+    }
+}
+
+template <class INDEX, class WEIGHT> OSD_TARGET("sse4.1") void
+sseComputeInterleaved(int length, int stride, float const * src, float * dst,
+    unsigned char const * sizes, INDEX const * indices, WEIGHT const * weights,
+        int start, int end) {
+
+    assert(length%4==0);
+
+    if (length==4) {
+        sseComputeRegisters<4>(stride, src, dst, sizes, indices, weights, start, end);
+    } else if (length==8) {
+        sseComputeRegisters<8>(stride, src, dst, sizes, indices, weights, start, end);
+    } else {
+        float * result = (float *)alloca(length*sizeof(float));
+        for (int i=start; i<end; ++i) {
+            for (int k=0; k<length; k+=4) {
+                _mm_storeu_ps(result+k, _mm_setzero_ps());
+            }
+            for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
+                __m128 w = _mm_set1_ps((float)*weights);
+                float const * s = src + (*indices)*stride;
+                for (int k=0; k<length; k+=4) {
+                    __m128 r = _mm_loadu_ps(result+k);
+                    r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(s+k), w));
+                    _mm_storeu_ps(result+k, r);
+                }
+            }
+            memcpy(dst + i*stride, result, length*sizeof(float));
+        }
+    }
+}
+
+// Mask of the first n (1 to 8) lanes
+OSD_TARGET("avx2") inline __m256i
+avx2Mask(int n) {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(n),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+template <class INDEX, class WEIGHT> OSD_TARGET("avx2,f16c") void
+avx2ComputeInterleaved(int length, int stride, float const * src, float * dst,
+    unsigned char const * sizes, INDEX const * indices, WEIGHT const * weights,
+        int start, int end) {
+
+    if (length<=16) {
+        // one or two registers, the last one masked
+        __m256i mask = avx2Mask(length<=8 ? length : length-8);
+        for (int i=start; i<end; ++i) {
+            __m256 r0 = _mm256_setzero_ps(),
+                   r1 = _mm256_setzero_ps();
+            for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
+                __m256 w = _mm256_set1_ps((float)*weights);
+                float const * s = src + (*indices)*stride;
+                if (length<=8) {
+                    r0 = _mm256_add_ps(r0, _mm256_mul_ps(_mm256_maskload_ps(s, mask), w));
+                } else {
+                    r0 = _mm256_add_ps(r0, _mm256_mul_ps(_mm256_loadu_ps(s), w));
+                    r1 = _mm256_add_ps(r1, _mm256_mul_ps(_mm256_maskload_ps(s+8, mask), w));
+                }
+            }
+            float * d = dst + i*stride;
+            if (length<=8) {
+                _mm256_maskstore_ps(d, mask, r0);
+            } else {
+                _mm256_storeu_ps(d, r0);
+                _mm256_maskstore_ps(d+8, mask, r1);
+            }
+        }
+    } else {
+        int nfull = length & ~7,
+            tail = length - nfull;
+        __m256i mask = avx2Mask(tail ? tail : 8);
+
+        float * result = (float *)alloca((nfull+8)*sizeof(float));
+        for (int i=start; i<end; ++i) {
+            for (int k=0; k<length; k+=8) {
+                _mm256_storeu_ps(result+k, _mm256_setzero_ps());
+            }
+            for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
+                __m256 w = _mm256_set1_ps((float)*weights);
+                float const * s = src + (*indices)*stride;
+                for (int k=0; k<nfull; k+=8) {
+                    __m256 r = _mm256_loadu_ps(result+k);
+                    r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_loadu_ps(s+k), w));
+                    _mm256_storeu_ps(result+k, r);
+                }
+                if (tail) {
+                    __m256 r = _mm256_loadu_ps(result+nfull);
+                    r = _mm256_add_ps(r, _mm256_mul_ps(
+                        _mm256_maskload_ps(s+nfull, mask), w));
+                    _mm256_storeu_ps(result+nfull, r);
+                }
+            }
+            float * d = dst + i*stride;
+            for (int k=0; k<nfull; k+=8) {
+                _mm256_storeu_ps(d+k, _mm256_loadu_ps(result+k));
+            }
+            if (tail) {
+                _mm256_maskstore_ps(d+nfull, mask, _mm256_loadu_ps(result+nfull));
+            }
+        }
+    }
+}
+
+// Vertex & varying primvars of 1 to 8 elements, one masked register each :
+// the leading control vertices of each stencil are blended in both (the
+// vertex primvars are skipped if 'dst' is null)
+OSD_TARGET("avx2") void
+avx2ComputeFused(int length, int stride, float const * src, float * dst,
+    int varyingLength, int varyingStride, float const * varyingSrc,
+        float * varyingDst, unsigned char const * sizes, int const * indices,
+            float const * weights, unsigned char const * varyingSizes,
+                float const * varyingWeights, int start, int end) {
+
+    __m256i mask = avx2Mask(dst ? length : 0),
+            varyingMask = avx2Mask(varyingLength);
+
+    for (int i=start; i<end; ++i) {
+        __m256 r = _mm256_setzero_ps(),
+               vr = _mm256_setzero_ps();
+        int j = 0;
+        for (; j<varyingSizes[i]; ++j, ++varyingWeights) {
+            __m256 vw = _mm256_set1_ps(*varyingWeights);
+            vr = _mm256_add_ps(vr, _mm256_mul_ps(
+                _mm256_maskload_ps(varyingSrc + indices[j]*varyingStride, varyingMask), vw));
+            if (dst) {
+                __m256 w = _mm256_set1_ps(weights[j]);
+                r = _mm256_add_ps(r, _mm256_mul_ps(
+                    _mm256_maskload_ps(src + indices[j]*stride, mask), w));
+            }
+        }
+        if (dst) {
+            for (; j<sizes[i]; ++j) {
+                __m256 w = _mm256_set1_ps(weights[j]);
+                r = _mm256_add_ps(r, _mm256_mul_ps(
+                    _mm256_maskload_ps(src + indices[j]*stride, mask), w));
+            }
+            _mm256_maskstore_ps(dst + i*stride, mask, r);
+        }
+        _mm256_maskstore_ps(varyingDst + i*varyingStride, varyingMask, vr);
+        indices += sizes[i];
+        weights += sizes[i];
+    }
+}
+
+// Limit values & derivatives : the primvars are processed in blocks of up
+// to 16 elements (two registers, the last ones masked), each control vertex
+// being loaded once per block and blended in the accumulators of the
+// non-null destinations
+OSD_TARGET("avx2") void
+avx2ComputeLimit(int length, int stride, float const * src,
+    float * dst, int dstStride, float * du, int duStride, float * dv,
+        int dvStride, unsigned char const * sizes, int const * indices,
+            float const * weights, float const * duWeights,
+                float const * dvWeights, int start, int end) {
+
+    for (int i=start; i<end; ++i) {
+
+        int size = sizes[i];
+
+        for (int k=0; k<length; k+=16) {
+
+            int n = std::min(length-k, 16);
+
+            __m256i mask0 = avx2Mask(n),
+                    mask1 = avx2Mask(n-8);
+
+            __m256 r0 = _mm256_setzero_ps(), r1 = _mm256_setzero_ps(),
+                   u0 = _mm256_setzero_ps(), u1 = _mm256_setzero_ps(),
+                   v0 = _mm256_setzero_ps(), v1 = _mm256_setzero_ps();
+
+            for (int j=0; j<size; ++j) {
+                float const * s = src + indices[j]*stride + k;
+                __m256 s0 = _mm256_maskload_ps(s, mask0),
+                       s1 = n>8 ? _mm256_maskload_ps(s+8, mask1) : _mm256_setzero_ps();
+                if (dst) {
+                    __m256 w = _mm256_set1_ps(weights[j]);
+                    r0 = _mm256_add_ps(r0, _mm256_mul_ps(s0, w));
+                    r1 = _mm256_add_ps(r1, _mm256_mul_ps(s1, w));
+                }
+                if (du) {
+                    __m256 w = _mm256_set1_ps(duWeights[j]);
+                    u0 = _mm256_add_ps(u0, _mm256_mul_ps(s0, w));
+                    u1 = _mm256_add_ps(u1, _mm256_mul_ps(s1, w));
+                }
+                if (dv) {
+                    __m256 w = _mm256_set1_ps(dvWeights[j]);
+                    v0 = _mm256_add_ps(v0, _mm256_mul_ps(s0, w));
+                    v1 = _mm256_add_ps(v1, _mm256_mul_ps(s1, w));
+                }
+            }
+            if (dst) {
+                float * d = dst + i*dstStride + k;
+                _mm256_maskstore_ps(d, mask0, r0);
+                if (n>8) _mm256_maskstore_ps(d+8, mask1, r1);
+            }
+            if (du) {
+                float * d = du + i*duStride + k;
+                _mm256_maskstore_ps(d, mask0, u0);
+                if (n>8) _mm256_maskstore_ps(d+8, mask1, u1);
+            }
+            if (dv) {
+                float * d = dv + i*dvStride + k;
+                _mm256_maskstore_ps(d, mask0, v0);
+                if (n>8) _mm256_maskstore_ps(d+8, mask1, v1);
+            }
+        }
+        if (dst) weights += size;
+        if (du) duWeights += size;
+        if (dv) dvWeights += size;
+        indices += size;
+    }
+}
+
+template <class INDEX, class WEIGHT> OSD_TARGET("avx512f") void
+avx512ComputeInterleaved(int length, int stride, float const * src, float * dst,
+    unsigned char const * sizes, INDEX const * indices, WEIGHT const * weights,
+        int start, int end) {
+
+    if (length<=16) {
+        __mmask16 mask = (__mmask16)((1u<<length)-1);
+        for (int i=start; i<end; ++i) {
+            __m512 r = _mm512_setzero_ps();
+            for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
+                __m512 w = _mm512_set1_ps((float)*weights);
+                r = _mm512_add_ps(r, _mm512_mul_ps(
+                    _mm512_maskz_loadu_ps(mask, src + (*indices)*stride), w));
+            }
+            _mm512_mask_storeu_ps(dst + i*stride, mask, r);
+        }
+    } else {
+        int nfull = length & ~15,
+            tail = length - nfull;
+        __mmask16 mask = (__mmask16)((1u<<tail)-1);
+
+        float * result = (float *)alloca((nfull+16)*sizeof(float));
+        for (int i=start; i<end; ++i) {
+            for (int k=0; k<length; k+=16) {
+                _mm512_storeu_ps(result+k, _mm512_setzero_ps());
+            }
+            for (int j=0; j<sizes[i]; ++j, ++indices, ++weights) {
+                __m512 w = _mm512_set1_ps((float)*weights);
+                float const * s = src + (*indices)*stride;
+                for (int k=0; k<nfull; k+=16) {
+                    __m512 r = _mm512_loadu_ps(result+k);
+                    r = _mm512_add_ps(r, _mm512_mul_ps(_mm512_loadu_ps(s+k), w));
+                    _mm512_storeu_ps(result+k, r);
+                }
+                if (tail) {
+                    __m512 r = _mm512_loadu_ps(result+nfull);
+                    r = _mm512_add_ps(r, _mm512_mul_ps(
+                        _mm512_maskz_loadu_ps(mask, s+nfull), w));
+                    _mm512_storeu_ps(result+nfull, r);
+                }
+            }
+            float * d = dst + i*stride;
+            for (int k=0; k<nfull; k+=16) {
+                _mm512_storeu_ps(d+k, _mm512_loadu_ps(result+k));
+            }
+            if (tail) {
+                _mm512_mask_storeu_ps(d+nfull, mask, _mm512_loadu_ps(result+nfull));
+            }
+        }
+    }
+}
+
+//
+// Gather kernels (primvars of length 1) : the control values of 8 (or 16)
+// weights of a stencil are gathered at once into partial sums, which
+// reassociates the sums of the scalar kernels.
+//
+
+OSD_TARGET("avx2") inline __m256i
+avx2LoadIndices(int const * indices) {
+    return _mm256_loadu_si256((__m256i const *)indices);
+}
+
+OSD_TARGET("avx2") inline __m256i
+avx2LoadIndices(unsigned short const * indices) {
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const *)indices));
+}
+
+OSD_TARGET("avx2") inline __m256
+avx2LoadWeights(float const * weights) {
+    return _mm256_loadu_ps(weights);
+}
+
+OSD_TARGET("avx2,f16c") inline __m256
+avx2LoadWeights(Far::Half const * weights) {
+    return _mm256_cvtph_ps(_mm_loadu_si128((__m128i const *)weights));
+}
+
+OSD_TARGET("avx2") inline float
+avx2Sum(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+// Gathers & accumulates the weights [j, j+8) of a stencil
+template <class INDEX, class WEIGHT> OSD_TARGET("avx2,f16c") inline __m256
+avx2Gather(__m256 r, float const * src, int stride,
+    INDEX const * indices, WEIGHT const * weights) {
+
+    __m256i vi = avx2LoadIndices(indices);
+    if (stride!=1) {
+        vi = _mm256_mullo_epi32(vi, _mm256_set1_epi32(stride));
+    }
+    return _mm256_add_ps(r, _mm256_mul_ps(
+        _mm256_i32gather_ps(src, vi, 4), avx2LoadWeights(weights)));
+}
+
+template <class INDEX, class WEIGHT> OSD_TARGET("avx2,f16c") void
+avx2ComputeGather(int stride, float const * src, float * dst,
+    unsigned char const * sizes, INDEX const * indices, WEIGHT const * weights,
+        int start, int end) {
+
+    for (int i=start; i<end; ++i) {
+
+        int n = sizes[i], j = 0;
+
+        __m256 r = _mm256_setzero_ps();
+        for (; j+8<=n; j+=8) {
+            r = avx2Gather(r, src, stride, indices+j, weights+j);
+        }
+
+        float sum = avx2Sum(r);
+        for (; j<n; ++j) {
+            sum += src[indices[j]*stride] * (float)weights[j];
+        }
+        dst[i*stride] = sum;
+
+        indices += n;
+        weights += n;
+    }
+}
+
+// Note : the unmasked forms of the AVX-512 conversions, gathers, extracts and
+// casts are built on _mm*_undefined_* sources, which trips -Wmaybe-uninitialized
+// with some compilers : use the zero-masked forms with a full mask instead
+
+OSD_TARGET("avx512f") inline __m512i
+avx512LoadIndices(int const * indices) {
+    return _mm512_loadu_si512((void const *)indices);
+}
+
+OSD_TARGET("avx512f") inline __m512i
+avx512LoadIndices(unsigned short const * indices) {
+    return _mm512_maskz_cvtepu16_epi32(0xFFFF,
+        _mm256_loadu_si256((__m256i const *)indices));
+}
+
+OSD_TARGET("avx512f") inline __m512
+avx512LoadWeights(float const * weights) {
+    return _mm512_loadu_ps(weights);
+}
+
+OSD_TARGET("avx512f") inline __m512
+avx512LoadWeights(Far::Half const * weights) {
+    return _mm512_maskz_cvtph_ps(0xFFFF,
+        _mm256_loadu_si256((__m256i const *)weights));
+}
+
+template <class INDEX, class WEIGHT> OSD_TARGET("avx512f,avx2,f16c") void
+avx512ComputeGather(int stride, float const * src, float * dst,
+    unsigned char const * sizes, INDEX const * indices, WEIGHT const * weights,
+        int start, int end) {
+
+    for (int i=start; i<end; ++i) {
+
+        int n = sizes[i], j = 0;
+
+        __m512 r = _mm512_setzero_ps();
+        for (; j+16<=n; j+=16) {
+            __m512i vi = avx512LoadIndices(indices+j);
+            if (stride!=1) {
+                vi = _mm512_mullo_epi32(vi, _mm512_set1_epi32(stride));
+            }
+            r = _mm512_add_ps(r, _mm512_mul_ps(
+                _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, vi, src, 4),
+                    avx512LoadWeights(weights+j)));
+        }
+
+        // remaining weights : 8 at a time, then one by one
+        __m512d rd = _mm512_castps_pd(r);
+        __m256 r8 = _mm256_add_ps(
+            _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, rd, 0)),
+            _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xFF, rd, 1)));
+        for (; j+8<=n; j+=8) {
+            r8 = avx2Gather(r8, src, stride, indices+j, weights+j);
+        }
+
+        float sum = avx2Sum(r8);
+        for (; j<n; ++j) {
+            sum += src[indices[j]*stride] * (float)weights[j];
+        }
+        dst[i*stride] = sum;
+
+        indices += n;
+        weights += n;
+    }
+}
+
+#endif // OSD_SIMD_X86
+
+} // end namespace unnamed
+
+SimdInstructionSet
+GetSimdInstructionSet() {
+    return getSelectedInstructionSet();
+}
+
+void
+SetSimdInstructionSet(SimdInstructionSet isa) {
+    getSelectedInstructionSet() = std::min(isa, getSupportedInstructionSet());
+}
+
+bool
+HasSimdStencilKernel(VertexBufferDescriptor const &vertexDesc) {
+
+    switch (GetSimdInstructionSet()) {
+        case SIMD_AVX512 :
+        case SIMD_AVX2   : return vertexDesc.length>0;
+        case SIMD_SSE4   : return vertexDesc.length>0 and vertexDesc.length%4==0;
+        default : return false;
+    }
+}
+
+template <class INDEX, class WEIGHT> bool
+SimdComputeStencils(VertexBufferDescriptor const &vertexDesc,
+                    float const * vertexSrc,
+                    float * vertexDst,
+                    unsigned char const * sizes,
+                    INDEX const * indices,
+                    WEIGHT const * weights,
+                    int start, int end) {
+
+    if (not HasSimdStencilKernel(vertexDesc)) {
+        return false;
+    }
+
+#if defined(OSD_SIMD_X86)
+    int length = vertexDesc.length,
+        stride = vertexDesc.stride;
+
+    if (length==4) {
+        // a 128-bit register holds the whole primvar
+        sseComputeInterleaved(length, stride, vertexSrc, vertexDst,
+            sizes, indices, weights, start, end);
+        return true;
+    }
+
+    switch (GetSimdInstructionSet()) {
+
+        case SIMD_AVX512 :
+            if (length==1) {
+                avx512ComputeGather(stride, vertexSrc, vertexDst,
+                    sizes, indices, weights, start, end);
+            } else {
+                avx512ComputeInterleaved(length, stride, vertexSrc, vertexDst,
+                    sizes, indices, weights, start, end);
+            }
+            return true;
+
+        case SIMD_AVX2 :
+            if (length==1) {
+                avx2ComputeGather(stride, vertexSrc, vertexDst,
+                    sizes, indices, weights, start, end);
+            } else {
+                avx2ComputeInterleaved(length, stride, vertexSrc, vertexDst,
+                    sizes, indices, weights, start, end);
+            }
+            return true;
+
+        case SIMD_SSE4 :
+            sseComputeInterleaved(length, stride, vertexSrc, vertexDst,
+                sizes, indices, weights, start, end);
+            return true;
+
+        default :
+            break;
+    }
+#else
+    (void)vertexSrc; (void)vertexDst; (void)sizes; (void)indices;
+    (void)weights; (void)start; (void)end;
+#endif
+    return false;
+}
+
+bool
+SimdComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                         float const * vertexSrc,
+                         float * vertexDst,
+                         VertexBufferDescriptor const &varyingDesc,
+                         float const * varyingSrc,
+                         float * varyingDst,
+                         unsigned char const * sizes,
+                         int const * indices,
+                         float const * weights,
+                         unsigned char const * varyingSizes,
+                         float const * varyingWeights,
+                         int start, int end) {
+
+    if ((vertexDst and (vertexDesc.length<1 or vertexDesc.length>8)) or
+        varyingDesc.length<1 or varyingDesc.length>8) {
+        return false;
+    }
+
+#if defined(OSD_SIMD_X86)
+    switch (GetSimdInstructionSet()) {
+
+        case SIMD_AVX512 :
+        case SIMD_AVX2 :
+            avx2ComputeFused(vertexDesc.length, vertexDesc.stride,
+                vertexSrc, vertexDst, varyingDesc.length, varyingDesc.stride,
+                    varyingSrc, varyingDst, sizes, indices, weights,
+                        varyingSizes, varyingWeights, start, end);
+            return true;
+
+        default :
+            break;
+    }
+#else
+    (void)vertexSrc; (void)vertexDst; (void)varyingSrc; (void)varyingDst;
+    (void)sizes; (void)indices; (void)weights; (void)varyingSizes;
+    (void)varyingWeights; (void)start; (void)end;
+#endif
+    return false;
+}
+
+bool
+SimdComputeLimitStencils(VertexBufferDescriptor const &controlDesc,
+                         float const * controlSrc,
+                         VertexBufferDescriptor const &outputDesc,
+                         float * outputDst,
+                         VertexBufferDescriptor const &duDesc,
+                         float * duDst,
+                         VertexBufferDescriptor const &dvDesc,
+                         float * dvDst,
+                         unsigned char const * sizes,
+                         int const * indices,
+                         float const * weights,
+                         float const * duWeights,
+                         float const * dvWeights,
+                         int start, int end) {
+
+    if (controlDesc.length<1) {
+        return false;
+    }
+
+#if defined(OSD_SIMD_X86)
+    switch (GetSimdInstructionSet()) {
+
+        case SIMD_AVX512 :
+        case SIMD_AVX2 :
+            avx2ComputeLimit(controlDesc.length, controlDesc.stride,
+                controlSrc, outputDst, outputDesc.stride, duDst, duDesc.stride,
+                    dvDst, dvDesc.stride, sizes, indices, weights, duWeights,
+                        dvWeights, start, end);
+            return true;
+
+        default :
+            break;
+    }
+#else
+    (void)controlSrc; (void)outputDesc; (void)outputDst; (void)duDesc;
+    (void)duDst; (void)dvDesc; (void)dvDst; (void)sizes; (void)indices;
+    (void)weights; (void)duWeights; (void)dvWeights; (void)start; (void)end;
+#endif
+    return false;
+}
+
+template bool SimdComputeStencils<int, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *,
+        int const *, float const *, int, int);
+
+template bool SimdComputeStencils<int, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *,
+        int const *, Far::Half const *, int, int);
+
+template bool SimdComputeStencils<unsigned short, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *,
+        unsigned short const *, float const *, int, int);
+
+template bool SimdComputeStencils<unsigned short, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *,
+        unsigned short const *, Far::Half const *, int, int);
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+}  // end namespace OpenSubdiv
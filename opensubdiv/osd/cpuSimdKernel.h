@@ -0,0 +1,137 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#ifndef OSD_CPU_SIMD_KERNEL_H
+#define OSD_CPU_SIMD_KERNEL_H
+
+#include "../version.h"
+
+#include "../far/compactStencilTables.h"
+#include "../osd/vertexDescriptor.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Osd {
+
+//
+// Explicit SIMD stencil kernels, selected at run time from the instruction
+// sets supported by the CPU (and the OS)
+//
+enum SimdInstructionSet {
+    SIMD_NONE = 0,
+    SIMD_SSE4,      // 128 bits : primvar lengths multiple of 4 only
+    SIMD_AVX2,      // 256 bits (with F16C)
+    SIMD_AVX512     // 512 bits (AVX-512F)
+};
+
+// Returns the instruction set used by the kernels (the best one supported
+// unless lowered with SetSimdInstructionSet())
+SimdInstructionSet GetSimdInstructionSet();
+
+// Restricts the kernels to the given instruction set (clamped to the best
+// one supported), mostly for benchmarking and testing
+void SetSimdInstructionSet(SimdInstructionSet isa);
+
+// True if SimdComputeStencils() has a kernel for primvars described by
+// 'vertexDesc' with the selected instruction set
+bool HasSimdStencilKernel(VertexBufferDescriptor const &vertexDesc);
+
+// Applies stencils [start, end) with the selected SIMD kernel: 'indices' and
+// 'weights' point to the first element of stencil 'start', 'vertexDst' to
+// the destination of stencil 0.
+//
+// Primvars with a length of 1 (including de-interleaved, "SOA", buffers)
+// gather the control values of several weights of a stencil at once. Longer
+// (interleaved) primvars accumulate each control value with a masked vector
+// load, as its elements are contiguous.
+//
+// Interleaved results match the scalar kernels exactly, gathered ones up to
+// the reassociation of the sums.
+//
+// Returns false if no SIMD kernel applies (see HasSimdStencilKernel()), in
+// which case the caller falls back to the scalar kernels. Instantiated for
+// the same index & weight types as CpuComputeStencils().
+template <class INDEX, class WEIGHT> bool
+SimdComputeStencils(VertexBufferDescriptor const &vertexDesc,
+                    float const * vertexSrc,
+                    float * vertexDst,
+                    unsigned char const * sizes,
+                    INDEX const * indices,
+                    WEIGHT const * weights,
+                    int start, int end);
+
+// Applies fused vertex & varying stencils [start, end) (see
+// Far::StencilTablesFactory::CreateFused()) with the selected SIMD kernel,
+// walking the indices once : 'indices', 'weights' and 'varyingWeights' point
+// to the first element of stencil 'start'.
+//
+// 'vertexDst' may be null to interpolate the varying primvars only. Returns
+// false if no SIMD kernel applies (AVX2 or AVX-512 selected, and primvar
+// lengths of 1 to 8).
+bool
+SimdComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                         float const * vertexSrc,
+                         float * vertexDst,
+                         VertexBufferDescriptor const &varyingDesc,
+                         float const * varyingSrc,
+                         float * varyingDst,
+                         unsigned char const * sizes,
+                         int const * indices,
+                         float const * weights,
+                         unsigned char const * varyingSizes,
+                         float const * varyingWeights,
+                         int start, int end);
+
+// Applies limit stencils [start, end) (see Far::LimitStencilTables) with the
+// selected SIMD kernel, interpolating the values and both derivatives from a
+// single load of each control vertex : 'indices' and the weights of the
+// non-null destinations point to the first element of stencil 'start'.
+//
+// Results match CpuComputeLimitStencils() exactly. Returns false if no SIMD
+// kernel applies (AVX2 or AVX-512 selected).
+bool
+SimdComputeLimitStencils(VertexBufferDescriptor const &controlDesc,
+                         float const * controlSrc,
+                         VertexBufferDescriptor const &outputDesc,
+                         float * outputDst,
+                         VertexBufferDescriptor const &duDesc,
+                         float * duDst,
+                         VertexBufferDescriptor const &dvDesc,
+                         float * dvDst,
+                         unsigned char const * sizes,
+                         int const * indices,
+                         float const * weights,
+                         float const * duWeights,
+                         float const * dvWeights,
+                         int start, int end);
+
+}  // end namespace Osd
+
+}  // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+
+}  // end namespace OpenSubdiv
+
+#endif  // OSD_CPU_SIMD_KERNEL_H
@@ -23,6 +23,7 @@
 //
 
 #include "../far/stencilTables.h"
+#include "../far/stencilTablesSerializer.h"
 
 #include "../osd/cudaComputeContext.h"
 
@@ -37,18 +38,18 @@ namespace Osd {
 // ----------------------------------------------------------------------------
 
 template <class T> void *
-createCudaBuffer(std::vector<T> const & src) {
+createCudaBuffer(T const * src, int count) {
 
     void * devicePtr=0;
 
-    size_t size = src.size()*sizeof(T);
+    size_t size = count*sizeof(T);
 
     cudaError_t err = cudaMalloc(&devicePtr, size);
     if (err != cudaSuccess) {
         return devicePtr;
     }
 
-    err = cudaMemcpy(devicePtr, &src.at(0), size, cudaMemcpyHostToDevice);
+    err = cudaMemcpy(devicePtr, src, size, cudaMemcpyHostToDevice);
     if (err != cudaSuccess) {
         cudaFree(devicePtr);
         return 0;
@@ -56,6 +57,12 @@ createCudaBuffer(std::vector<T> const & src) {
     return devicePtr;
 }
 
+template <class T> void *
+createCudaBuffer(std::vector<T> const & src) {
+
+    return createCudaBuffer(&src.at(0), (int)src.size());
+}
+
 // ----------------------------------------------------------------------------
 
 class CudaComputeContext::CudaStencilTables {
@@ -69,6 +76,15 @@ public:
         _weights = createCudaBuffer(stencilTables.GetWeights());
     }
 
+    CudaStencilTables(Far::MappedStencilTables const & stencilTables) {
+        int nstencils = stencilTables.GetNumStencils(),
+            nelems = stencilTables.GetNumElements();
+        _sizes = createCudaBuffer(stencilTables.GetSizes(), nstencils);
+        _offsets = createCudaBuffer(stencilTables.GetOffsets(), nstencils);
+        _indices = createCudaBuffer(stencilTables.GetControlIndices(), nelems);
+        _weights = createCudaBuffer(stencilTables.GetWeights(), nelems);
+    }
+
     ~CudaStencilTables() {
         if (_sizes) { cudaFree(_sizes); }
         if (_offsets) { cudaFree(_offsets); }
@@ -105,9 +121,10 @@ private:
 
 // ----------------------------------------------------------------------------
 
+template <class TABLES>
 CudaComputeContext::CudaComputeContext(
-    Far::StencilTables const * vertexStencilTables,
-        Far::StencilTables const * varyingStencilTables) :
+    TABLES const * vertexStencilTables,
+        TABLES const * varyingStencilTables) :
             _vertexStencilTables(0), _varyingStencilTables(0),
                 _numControlVertices(0) {
 
@@ -200,6 +217,16 @@ CudaComputeContext::Create(Far::StencilTables const * vertexStencilTables,
     return result;
 }
 
+CudaComputeContext *
+CudaComputeContext::Create(Far::MappedStencilTables const * vertexStencilTables,
+                              Far::MappedStencilTables const * varyingStencilTables) {
+
+    CudaComputeContext *result =
+        new CudaComputeContext(vertexStencilTables, varyingStencilTables);
+
+    return result;
+}
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
@@ -35,7 +35,7 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-namespace Far{ class StencilTables; }
+namespace Far{ class StencilTables; class MappedStencilTables; }
 
 namespace Osd {
 
@@ -63,6 +63,19 @@ public:
     static CudaComputeContext * Create(Far::StencilTables const * vertexStencilTables,
                                           Far::StencilTables const * varyingStencilTables=0);
 
+    /// Creates an CudaComputeContext instance from tables mapped in memory
+    /// (the arrays are uploaded from the mapping : the tables can be closed
+    /// once the context is created)
+    ///
+    /// @param vertexStencilTables   The Far::MappedStencilTables used for
+    ///                              vertex interpolation
+    ///
+    /// @param varyingStencilTables  The Far::MappedStencilTables used for
+    ///                              varying interpolation
+    ///
+    static CudaComputeContext * Create(Far::MappedStencilTables const * vertexStencilTables,
+                                          Far::MappedStencilTables const * varyingStencilTables=0);
+
     /// Destructor
     virtual ~CudaComputeContext();
 
@@ -105,8 +118,9 @@ public:
 
 protected:
 
-    explicit CudaComputeContext(Far::StencilTables const * vertexStencilTables,
-                                   Far::StencilTables const * varyingStencilTables);
+    template <class TABLES>
+    CudaComputeContext(TABLES const * vertexStencilTables,
+                          TABLES const * varyingStencilTables);
 
 private:
 
@@ -23,6 +23,7 @@
 //
 
 #include "../far/stencilTables.h"
+#include "../far/stencilTablesSerializer.h"
 
 #include "../osd/d3d11ComputeContext.h"
 #include "../osd/error.h"
@@ -55,7 +56,14 @@ struct D3D11Table {
     template <class T> void initialize(std::vector<T> const & src,
         DXGI_FORMAT format, ID3D11DeviceContext *deviceContext) {
 
-        size_t size = src.size()*sizeof(T);
+        initialize(src.empty() ? 0 : &src[0], (int)src.size(), format,
+            deviceContext);
+    }
+
+    template <class T> void initialize(T const * src, int count,
+        DXGI_FORMAT format, ID3D11DeviceContext *deviceContext) {
+
+        size_t size = count*sizeof(T);
 
         if (size==0) {
             buffer = 0;
@@ -76,7 +84,7 @@ struct D3D11Table {
         bd.StructureByteStride = 0;
 
         D3D11_SUBRESOURCE_DATA initData;
-        initData.pSysMem = &src.at(0);
+        initData.pSysMem = src;
 
         HRESULT hr = device->CreateBuffer(&bd, &initData, &buffer);
         if (FAILED(hr)) {
@@ -90,7 +98,7 @@ struct D3D11Table {
         srvd.Format = format;
         srvd.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
         srvd.Buffer.FirstElement = 0;
-        srvd.Buffer.NumElements = (unsigned int)src.size();
+        srvd.Buffer.NumElements = (unsigned int)count;
 
         hr = device->CreateShaderResourceView(buffer, &srvd, &srv);
         if (FAILED(hr)) {
@@ -127,6 +135,25 @@ public:
         _weights.initialize(stencilTables.GetWeights(), DXGI_FORMAT_R32_FLOAT, deviceContext);
     }
 
+    D3D11StencilTables(Far::MappedStencilTables const & stencilTables,
+        ID3D11DeviceContext *deviceContext) {
+
+        int nstencils = stencilTables.GetNumStencils(),
+            nelems = stencilTables.GetNumElements();
+
+        // convert unsigned char sizes buffer to ints (HLSL does not have uint8 type)
+        std::vector<int> const sizes(stencilTables.GetSizes(),
+            stencilTables.GetSizes() + nstencils);
+
+        _sizes.initialize(sizes, DXGI_FORMAT_R32_SINT, deviceContext);
+
+        _offsets.initialize(stencilTables.GetOffsets(), nstencils, DXGI_FORMAT_R32_SINT, deviceContext);
+
+        _indices.initialize(stencilTables.GetControlIndices(), nelems, DXGI_FORMAT_R32_SINT, deviceContext);
+
+        _weights.initialize(stencilTables.GetWeights(), nelems, DXGI_FORMAT_R32_FLOAT, deviceContext);
+    }
+
     bool IsValid() const {
         return _sizes.IsValid() and _offsets.IsValid() and
             _indices.IsValid() and _weights.IsValid();
@@ -174,10 +201,11 @@ private:
 
 // ----------------------------------------------------------------------------
 
+template <class TABLES>
 D3D11ComputeContext::D3D11ComputeContext(
     ID3D11DeviceContext *deviceContext,
-        Far::StencilTables const * vertexStencilTables,
-            Far::StencilTables const * varyingStencilTables) :
+        TABLES const * vertexStencilTables,
+            TABLES const * varyingStencilTables) :
                 _vertexStencilTables(0), _varyingStencilTables(0),
                     _numControlVertices(0) {
 
@@ -252,6 +280,17 @@ D3D11ComputeContext::Create(ID3D11DeviceContext *deviceContext,
     return result;
 }
 
+D3D11ComputeContext *
+D3D11ComputeContext::Create(ID3D11DeviceContext *deviceContext,
+    Far::MappedStencilTables const * vertexStencilTables,
+        Far::MappedStencilTables const * varyingStencilTables) {
+
+    D3D11ComputeContext *result =
+        new D3D11ComputeContext(deviceContext, vertexStencilTables, varyingStencilTables);
+
+    return result;
+}
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
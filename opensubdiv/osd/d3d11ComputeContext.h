@@ -34,7 +34,7 @@ struct ID3D11DeviceContext;
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-namespace Far{ class StencilTables; }
+namespace Far{ class StencilTables; class MappedStencilTables; }
 
 namespace Osd {
 
@@ -64,6 +64,22 @@ public:
                                            Far::StencilTables const * vertexStencilTables,
                                            Far::StencilTables const * varyingStencilTables=0);
 
+    /// Creates an D3D11ComputeContext instance from tables mapped in memory
+    /// (the arrays are uploaded from the mapping : the tables can be closed
+    /// once the context is created)
+    ///
+    /// @param vertexStencilTables   The Far::MappedStencilTables used for
+    ///                              vertex interpolation
+    ///
+    /// @param varyingStencilTables  The Far::MappedStencilTables used for
+    ///                              varying interpolation
+    ///
+    /// @param deviceContext         The D3D device
+    ///
+    static D3D11ComputeContext * Create(ID3D11DeviceContext *deviceContext,
+                                           Far::MappedStencilTables const * vertexStencilTables,
+                                           Far::MappedStencilTables const * varyingStencilTables=0);
+
     /// Destructor
     virtual ~D3D11ComputeContext();
 
@@ -98,9 +114,10 @@ public:
 
 protected:
 
-    explicit D3D11ComputeContext(ID3D11DeviceContext *deviceContext,
-                                    Far::StencilTables const * vertexStencilTables,
-                                    Far::StencilTables const * varyingStencilTables);
+    template <class TABLES>
+    D3D11ComputeContext(ID3D11DeviceContext *deviceContext,
+                           TABLES const * vertexStencilTables,
+                           TABLES const * varyingStencilTables);
 
 private:
 
@@ -74,8 +74,21 @@ D3D11DrawContext::Create(Far::PatchTables const *patchTables,
     return NULL;
 }
 
-bool
-D3D11DrawContext::create(Far::PatchTables const &patchTables,
+D3D11DrawContext *
+D3D11DrawContext::Create(Far::MappedPatchTables const *patchTables,
+                            ID3D11DeviceContext *pd3d11DeviceContext,
+                            int numVertexElements)
+{
+    D3D11DrawContext * result = new D3D11DrawContext();
+    if (result->create(*patchTables, pd3d11DeviceContext, numVertexElements))
+        return result;
+
+    delete result;
+    return NULL;
+}
+
+template <class TABLES> bool
+D3D11DrawContext::create(TABLES const &patchTables,
                             ID3D11DeviceContext *pd3d11DeviceContext,
                             int numVertexElements)
 {
@@ -88,8 +101,8 @@ D3D11DrawContext::create(Far::PatchTables const &patchTables,
 
     ConvertPatchArrays(patchTables.GetPatchArrayVector(), _patchArrays, patchTables.GetMaxValence(), numVertexElements);
 
-    Far::PatchTables::PTable const & ptables = patchTables.GetPatchTable();
-    Far::PatchTables::PatchParamTable const & ptexCoordTables = patchTables.GetPatchParamTable();
+    typename TABLES::PTable const & ptables = patchTables.GetPatchTable();
+    typename TABLES::PatchParamTable const & ptexCoordTables = patchTables.GetPatchParamTable();
     int totalPatchIndices = (int)ptables.size();
     int totalPatches = (int)ptexCoordTables.size();
 
@@ -148,7 +161,7 @@ D3D11DrawContext::create(Far::PatchTables const &patchTables,
     pd3d11DeviceContext->Unmap(ptexCoordinateBuffer, 0);
 
     // create vertex valence buffer and vertex texture
-    Far::PatchTables::VertexValenceTable const &
+    typename TABLES::VertexValenceTable const &
         valenceTable = patchTables.GetVertexValenceTable();
 
     if (not valenceTable.empty()) {
@@ -178,7 +191,7 @@ D3D11DrawContext::create(Far::PatchTables const &patchTables,
         }
     }
 
-    Far::PatchTables::QuadOffsetTable const &
+    typename TABLES::QuadOffsetTable const &
         quadOffsetTable = patchTables.GetQuadOffsetTable();
 
     if (not quadOffsetTable.empty()) {
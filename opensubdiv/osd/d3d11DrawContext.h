@@ -28,6 +28,7 @@
 #include "../version.h"
 
 #include "../far/patchTables.h"
+#include "../far/patchTablesSerializer.h"
 #include "../osd/drawContext.h"
 #include "../osd/vertex.h"
 
@@ -78,6 +79,20 @@ public:
                                        ID3D11DeviceContext *pd3d11DeviceContext,
                                        int numVertexElements);
 
+    /// \brief Create an D3D11DrawContext from Far::MappedPatchTables
+    ///
+    /// The D3D11 buffers are filled directly from the mapped tables.
+    ///
+    /// @param patchTables          A valid set of Far::MappedPatchTables
+    ///
+    /// @param pd3d11DeviceContext  A device context
+    ///
+    /// @param numVertexElements    The number of vertex elements
+    ///
+    static D3D11DrawContext *Create(Far::MappedPatchTables const *patchTables,
+                                       ID3D11DeviceContext *pd3d11DeviceContext,
+                                       int numVertexElements);
+
     /// Set vbo as a vertex texture (for gregory patch drawing)
     ///
     /// @param vbo                  The vertex buffer object to update
@@ -127,8 +142,10 @@ private:
     D3D11DrawContext();
 
 
-    // allocate buffers from patchTables
-    bool create(Far::PatchTables const &patchTables,
+    // allocate buffers from patchTables (Far::PatchTables or
+    // Far::MappedPatchTables)
+    template <class TABLES>
+    bool create(TABLES const &patchTables,
                 ID3D11DeviceContext *pd3d11DeviceContext,
                 int numVertexElements);
 
@@ -113,13 +113,29 @@ GLDrawContext::Create(Far::PatchTables const * patchTables, int numVertexElement
     return NULL;
 }
 
-bool
-GLDrawContext::create(Far::PatchTables const & patchTables, int numVertexElements) {
+GLDrawContext *
+GLDrawContext::Create(Far::MappedPatchTables const * patchTables, int numVertexElements) {
+
+    if (patchTables) {
+
+        GLDrawContext * result = new GLDrawContext();
+
+        if (result->create(*patchTables, numVertexElements)) {
+            return result;
+        } else {
+            delete result;
+        }
+    }
+    return NULL;
+}
+
+template <class TABLES> bool
+GLDrawContext::create(TABLES const & patchTables, int numVertexElements) {
 
     _isAdaptive = patchTables.IsFeatureAdaptive();
 
     // Process PTable
-    Far::PatchTables::PTable const & ptables = patchTables.GetPatchTable();
+    typename TABLES::PTable const & ptables = patchTables.GetPatchTable();
 
     glGenBuffers(1, &_patchIndexBuffer);
 
@@ -144,7 +160,7 @@ GLDrawContext::create(Far::PatchTables const & patchTables, int numVertexElement
 
 #if defined(GL_ARB_texture_buffer_object) || defined(GL_VERSION_3_1)
     // create vertex valence buffer and vertex texture
-    Far::PatchTables::VertexValenceTable const &
+    typename TABLES::VertexValenceTable const &
         valenceTable = patchTables.GetVertexValenceTable();
 
     if (not valenceTable.empty()) {
@@ -156,7 +172,7 @@ GLDrawContext::create(Far::PatchTables const & patchTables, int numVertexElement
 
 
     // create quad offset table buffer
-    Far::PatchTables::QuadOffsetTable const &
+    typename TABLES::QuadOffsetTable const &
         quadOffsetTable = patchTables.GetQuadOffsetTable();
 
     if (not quadOffsetTable.empty())
@@ -164,7 +180,7 @@ GLDrawContext::create(Far::PatchTables const & patchTables, int numVertexElement
 
 
     // create ptex coordinate buffer
-    Far::PatchTables::PatchParamTable const &
+    typename TABLES::PatchParamTable const &
         patchParamTables = patchTables.GetPatchParamTable();
 
     if (not patchParamTables.empty())
@@ -28,6 +28,7 @@
 #include "../version.h"
 
 #include "../far/patchTables.h"
+#include "../far/patchTablesSerializer.h"
 #include "../osd/drawContext.h"
 #include "../osd/drawRegistry.h"
 #include "../osd/vertex.h"
@@ -65,6 +66,16 @@ public:
     ///
     static GLDrawContext * Create(Far::PatchTables const * patchTables, int numVertexElements);
 
+    /// \brief Create an GLDraContext from Far::MappedPatchTables
+    ///
+    /// The GL buffers are filled directly from the mapped tables.
+    ///
+    /// @param patchTables          a valid set of Far::MappedPatchTables
+    ///
+    /// @param numVertexElements    the number of vertex elements
+    ///
+    static GLDrawContext * Create(Far::MappedPatchTables const * patchTables, int numVertexElements);
+
     /// Set vbo as a vertex texture (for gregory patch drawing)
     ///
     /// @param vbo  the vertex buffer object to update
@@ -137,8 +148,10 @@ protected:
 
     GLDrawContext();
 
-    // allocate buffers from patchTables
-    bool create(Far::PatchTables const & patchTables, int numElements);
+    // allocate buffers from patchTables (Far::PatchTables or
+    // Far::MappedPatchTables)
+    template <class TABLES>
+    bool create(TABLES const & patchTables, int numElements);
 
     void updateVertexTexture(GLuint vbo);
 };
@@ -23,6 +23,7 @@
 //
 
 #include "../far/stencilTables.h"
+#include "../far/stencilTablesSerializer.h"
 
 #include "../osd/error.h"
 //#include "../osd/debug.h"
@@ -37,7 +38,7 @@ namespace Osd {
 // -----------------------------------------------------------------------------
 
 template <class T> GLuint
-createGLSLBuffer(std::vector<T> const & src) {
+createGLSLBuffer(T const * src, int size) {
 
     GLuint devicePtr=0;
 
@@ -45,7 +46,7 @@ createGLSLBuffer(std::vector<T> const & src) {
 
 #if defined(GL_EXT_direct_state_access)
     if (glNamedBufferDataEXT) {
-        glNamedBufferDataEXT(devicePtr, src.size()*sizeof(T), &src.at(0), GL_STATIC_DRAW);
+        glNamedBufferDataEXT(devicePtr, size*sizeof(T), src, GL_STATIC_DRAW);
     } else {
 #else
     {
@@ -53,14 +54,20 @@ createGLSLBuffer(std::vector<T> const & src) {
         GLint prev = 0;
         glGetIntegerv(GL_SHADER_STORAGE_BUFFER_BINDING, &prev);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, devicePtr);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, src.size()*sizeof(T), &src.at(0), GL_STATIC_DRAW);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, size*sizeof(T), src, GL_STATIC_DRAW);
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, prev);
     }
 
-    //OSD_DEBUG_CHECK_GL_ERROR("createGLSLBuffer size %ld", src.size());
+    //OSD_DEBUG_CHECK_GL_ERROR("createGLSLBuffer size %d", size);
     return devicePtr;
 }
 
+template <class T> GLuint
+createGLSLBuffer(std::vector<T> const & src) {
+
+    return createGLSLBuffer(&src.at(0), (int)src.size());
+}
+
 // -----------------------------------------------------------------------------
 
 class GLSLComputeContext::GLSLStencilTables {
@@ -74,6 +81,15 @@ public:
         _weights = createGLSLBuffer(stencilTables.GetWeights());
     }
 
+    GLSLStencilTables(Far::MappedStencilTables const & stencilTables) {
+        int nstencils = stencilTables.GetNumStencils(),
+            nelems = stencilTables.GetNumElements();
+        _sizes = createGLSLBuffer(stencilTables.GetSizes(), nstencils);
+        _offsets = createGLSLBuffer(stencilTables.GetOffsets(), nstencils);
+        _indices = createGLSLBuffer(stencilTables.GetControlIndices(), nelems);
+        _weights = createGLSLBuffer(stencilTables.GetWeights(), nelems);
+    }
+
     ~GLSLStencilTables() {
         glDeleteBuffers(1, &_sizes);
         glDeleteBuffers(1, &_offsets);
@@ -127,9 +143,10 @@ private:
 
 // -----------------------------------------------------------------------------
 
+template <class TABLES>
 GLSLComputeContext::GLSLComputeContext(
-    Far::StencilTables const * vertexStencilTables,
-        Far::StencilTables const * varyingStencilTables) :
+    TABLES const * vertexStencilTables,
+        TABLES const * varyingStencilTables) :
             _vertexStencilTables(0), _varyingStencilTables(0),
                 _numControlVertices(0) {
 
@@ -201,6 +218,16 @@ GLSLComputeContext::Create(Far::StencilTables const * vertexStencilTables,
     return result;
 }
 
+GLSLComputeContext *
+GLSLComputeContext::Create(Far::MappedStencilTables const * vertexStencilTables,
+                              Far::MappedStencilTables const * varyingStencilTables) {
+
+    GLSLComputeContext *result =
+        new GLSLComputeContext(vertexStencilTables, varyingStencilTables);
+
+    return result;
+}
+
 // -----------------------------------------------------------------------------
 
 }  // end namespace Osd
@@ -35,7 +35,7 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-namespace Far{ class StencilTables; }
+namespace Far{ class StencilTables; class MappedStencilTables; }
 
 namespace Osd {
 
@@ -62,6 +62,19 @@ public:
     static GLSLComputeContext * Create(Far::StencilTables const * vertexStencilTables,
                                           Far::StencilTables const * varyingStencilTables=0);
 
+    /// Creates an GLSLComputeContext instance from tables mapped in memory
+    /// (the arrays are uploaded from the mapping : the tables can be closed
+    /// once the context is created)
+    ///
+    /// @param vertexStencilTables   The Far::MappedStencilTables used for
+    ///                              vertex interpolation
+    ///
+    /// @param varyingStencilTables  The Far::MappedStencilTables used for
+    ///                              varying interpolation
+    ///
+    static GLSLComputeContext * Create(Far::MappedStencilTables const * vertexStencilTables,
+                                          Far::MappedStencilTables const * varyingStencilTables=0);
+
     /// Destructor
     virtual ~GLSLComputeContext();
 
@@ -93,8 +106,9 @@ public:
 
 protected:
 
-    explicit GLSLComputeContext(Far::StencilTables const * vertexStencilTables,
-                                   Far::StencilTables const * varyingStencilTables);
+    template <class TABLES>
+    GLSLComputeContext(TABLES const * vertexStencilTables,
+                          TABLES const * varyingStencilTables);
 
 private:
 
@@ -23,6 +23,7 @@
 //
 
 #include "../far/stencilTables.h"
+#include "../far/stencilTablesSerializer.h"
 
 #include "../osd/error.h"
 //#define OSD_DEBUG_BUILD
@@ -38,10 +39,10 @@ namespace Osd {
 // -----------------------------------------------------------------------------
 
 template <class T> GLuint
-createGLTextureBuffer(std::vector<T> const & src, GLenum type) {
+createGLTextureBuffer(T const * src, int count, GLenum type) {
 
-    int size = (int)src.size()*sizeof(T);
-    void const * ptr = &src.at(0);
+    int size = count*sizeof(T);
+    void const * ptr = src;
 
     GLuint buffer;
     glGenBuffers(1, &buffer);
@@ -76,6 +77,12 @@ createGLTextureBuffer(std::vector<T> const & src, GLenum type) {
     return devicePtr;
 }
 
+template <class T> GLuint
+createGLTextureBuffer(std::vector<T> const & src, GLenum type) {
+
+    return createGLTextureBuffer(&src.at(0), (int)src.size(), type);
+}
+
 // -----------------------------------------------------------------------------
 
 class GLSLTransformFeedbackComputeContext::GLStencilTables {
@@ -89,6 +96,15 @@ public:
         _weights = createGLTextureBuffer(stencilTables.GetWeights(), GL_R32F);
     }
 
+    GLStencilTables(Far::MappedStencilTables const & stencilTables) {
+        int nstencils = stencilTables.GetNumStencils(),
+            nelems = stencilTables.GetNumElements();
+        _sizes = createGLTextureBuffer(stencilTables.GetSizes(), nstencils, GL_R8UI);
+        _offsets = createGLTextureBuffer(stencilTables.GetOffsets(), nstencils, GL_R32I);
+        _indices = createGLTextureBuffer(stencilTables.GetControlIndices(), nelems, GL_R32I);
+        _weights = createGLTextureBuffer(stencilTables.GetWeights(), nelems, GL_R32F);
+    }
+
     ~GLStencilTables() {
         glDeleteTextures(1, &_sizes);
         glDeleteTextures(1, &_offsets);
@@ -126,9 +142,10 @@ private:
 
 // -----------------------------------------------------------------------------
 
+template <class TABLES>
 GLSLTransformFeedbackComputeContext::GLSLTransformFeedbackComputeContext(
-    Far::StencilTables const * vertexStencilTables,
-        Far::StencilTables const * varyingStencilTables) :
+    TABLES const * vertexStencilTables,
+        TABLES const * varyingStencilTables) :
             _vertexStencilTables(0), _varyingStencilTables(0),
                 _numControlVertices(0) {
 
@@ -224,6 +241,18 @@ GLSLTransformFeedbackComputeContext::Create(
     return result;
 }
 
+GLSLTransformFeedbackComputeContext *
+GLSLTransformFeedbackComputeContext::Create(
+    Far::MappedStencilTables const * vertexStencilTables,
+        Far::MappedStencilTables const * varyingStencilTables) {
+
+    GLSLTransformFeedbackComputeContext *result =
+        new GLSLTransformFeedbackComputeContext(
+            vertexStencilTables, varyingStencilTables);
+
+    return result;
+}
+
 
 // -----------------------------------------------------------------------------
 
@@ -35,7 +35,7 @@
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
-namespace Far{ class StencilTables; }
+namespace Far{ class StencilTables; class MappedStencilTables; }
 
 namespace Osd {
 
@@ -61,6 +61,19 @@ public:
     static GLSLTransformFeedbackComputeContext * Create(Far::StencilTables const * vertexStencilTables,
                                                            Far::StencilTables const * varyingStencilTables=0);
 
+    /// Creates an GLSLTransformFeedbackComputeContext instance from tables
+    /// mapped in memory (the arrays are uploaded from the mapping : the
+    /// tables can be closed once the context is created)
+    ///
+    /// @param vertexStencilTables   The Far::MappedStencilTables used for
+    ///                              vertex interpolation
+    ///
+    /// @param varyingStencilTables  The Far::MappedStencilTables used for
+    ///                              varying interpolation
+    ///
+    static GLSLTransformFeedbackComputeContext * Create(Far::MappedStencilTables const * vertexStencilTables,
+                                                           Far::MappedStencilTables const * varyingStencilTables=0);
+
     /// Destructor
     virtual ~GLSLTransformFeedbackComputeContext();
 
@@ -103,8 +116,9 @@ public:
 
 protected:
 
-    explicit GLSLTransformFeedbackComputeContext(Far::StencilTables const * vertexStencilTables,
-                                                    Far::StencilTables const * varyingStencilTables);
+    template <class TABLES>
+    GLSLTransformFeedbackComputeContext(TABLES const * vertexStencilTables,
+                                           TABLES const * varyingStencilTables);
 
 private:
 
@@ -33,6 +33,63 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
+namespace {
+
+// Applies the stencils [start, end) with the given weights to the buffer,
+// to every instance if the buffer is instanced
+void
+computeStencils(Far::StencilTables const & stencils,
+    std::vector<float> const & weights,
+        VertexBufferDescriptor const & desc, float * buffer, int start, int end,
+            InstanceBufferDescriptor const * instances) {
+
+    float const * srcBuffer = buffer + desc.offset;
+
+    float * destBuffer = buffer + desc.offset +
+        stencils.GetNumControlVertices() * desc.stride;
+
+    if (instances) {
+        OmpComputeInstanceStencils(desc, *instances, srcBuffer, destBuffer,
+                              &stencils.GetSizes().at(0),
+                              &stencils.GetOffsets().at(0),
+                              &stencils.GetControlIndices().at(0),
+                              &weights.at(0),
+                              start,
+                              end);
+    } else {
+        OmpComputeStencils(desc, srcBuffer, destBuffer,
+                              &stencils.GetSizes().at(0),
+                              &stencils.GetOffsets().at(0),
+                              &stencils.GetControlIndices().at(0),
+                              &weights.at(0),
+                              start,
+                              end);
+    }
+}
+
+// Applies fused stencils [start, end) to the vertex & varying primvars in a
+// single pass (either destination may be null)
+void
+computeFusedStencils(Far::StencilTables const & stencils,
+    VertexBufferDescriptor const & vertexDesc, float const * vertexSrc,
+        float * vertexDst, VertexBufferDescriptor const & varyingDesc,
+            float const * varyingSrc, float * varyingDst, int start, int end) {
+
+    OmpComputeFusedStencils(vertexDesc, vertexSrc, vertexDst,
+                            varyingDesc, varyingSrc, varyingDst,
+                            &stencils.GetSizes().at(0),
+                            &stencils.GetOffsets().at(0),
+                            &stencils.GetControlIndices().at(0),
+                            &stencils.GetWeights().at(0),
+                            &stencils.GetVaryingSizes().at(0),
+                            &stencils.GetVaryingOffsets().at(0),
+                            &stencils.GetVaryingWeights().at(0),
+                            start,
+                            end);
+}
+
+} // end namespace unnamed
+
 OmpComputeController::OmpComputeController(int numThreads) {
 
     _numThreads = (numThreads == -1) ? omp_get_max_threads() : numThreads;
@@ -46,44 +103,70 @@ OmpComputeController::ApplyStencilTableKernel(
 
     Far::StencilTables const * vertexStencils = context->GetVertexStencilTables();
 
-    if (vertexStencils and _currentBindState.vertexBuffer) {
-
-        VertexBufferDescriptor const & desc = _currentBindState.vertexDesc;
-
-        float const * srcBuffer = _currentBindState.vertexBuffer + desc.offset;
-
-        float * destBuffer = _currentBindState.vertexBuffer + desc.offset +
-            vertexStencils->GetNumControlVertices() * desc.stride;
+    if (vertexStencils and not vertexStencils->GetVaryingSizes().empty()) {
+        applyFusedStencils(*vertexStencils, batch);
+        return;
+    }
 
-        OmpComputeStencils(_currentBindState.vertexDesc,
-                              srcBuffer, destBuffer,
-                              &vertexStencils->GetSizes().at(0),
-                              &vertexStencils->GetOffsets().at(0),
-                              &vertexStencils->GetControlIndices().at(0),
-                              &vertexStencils->GetWeights().at(0),
-                              batch.start,
-                              batch.end);
+    if (vertexStencils and _currentBindState.vertexBuffer) {
+        computeStencils(*vertexStencils, vertexStencils->GetWeights(),
+            _currentBindState.vertexDesc, _currentBindState.vertexBuffer,
+                batch.start, batch.end, _currentBindState.vertexInstances);
     }
 
     Far::StencilTables const * varyingStencils = context->GetVaryingStencilTables();
 
     if (varyingStencils and _currentBindState.varyingBuffer) {
+        computeStencils(*varyingStencils, varyingStencils->GetWeights(),
+            _currentBindState.varyingDesc, _currentBindState.varyingBuffer,
+                batch.start, batch.end, _currentBindState.varyingInstances);
+    }
+}
 
-        VertexBufferDescriptor const & desc = _currentBindState.varyingDesc;
-
-        float const * srcBuffer = _currentBindState.varyingBuffer + desc.offset;
+void
+OmpComputeController::applyFusedStencils(Far::StencilTables const & stencils,
+    Far::KernelBatch const &batch) const {
+
+    int numControlVertices = stencils.GetNumControlVertices();
+
+    VertexBufferDescriptor const & vertexDesc = _currentBindState.vertexDesc,
+                                 & varyingDesc = _currentBindState.varyingDesc;
+
+    float * vertexBuffer = _currentBindState.vertexBuffer,
+          * varyingBuffer = _currentBindState.varyingBuffer;
+
+    if (not _currentBindState.vertexInstances) {
+        // vertex & varying primvars in a single pass
+        computeFusedStencils(stencils, vertexDesc,
+            vertexBuffer ? vertexBuffer + vertexDesc.offset : 0,
+            vertexBuffer ? vertexBuffer + vertexDesc.offset +
+                numControlVertices * vertexDesc.stride : 0,
+            varyingDesc,
+            varyingBuffer ? varyingBuffer + varyingDesc.offset : 0,
+            varyingBuffer ? varyingBuffer + varyingDesc.offset +
+                numControlVertices * varyingDesc.stride : 0,
+            batch.start, batch.end);
+        return;
+    }
 
-        float * destBuffer = _currentBindState.varyingBuffer + desc.offset +
-            varyingStencils->GetNumControlVertices() * desc.stride;
+    // instanced buffers : the vertex primvars of all the instances, then
+    // the varying primvars of each instance
+    if (vertexBuffer) {
+        computeStencils(stencils, stencils.GetWeights(), vertexDesc,
+            vertexBuffer, batch.start, batch.end,
+                _currentBindState.vertexInstances);
+    }
 
-        OmpComputeStencils(_currentBindState.varyingDesc,
-                              srcBuffer, destBuffer,
-                              &varyingStencils->GetSizes().at(0),
-                              &varyingStencils->GetOffsets().at(0),
-                              &varyingStencils->GetControlIndices().at(0),
-                              &varyingStencils->GetWeights().at(0),
-                              batch.start,
-                              batch.end);
+    if (varyingBuffer) {
+        InstanceBufferDescriptor const & instances = *_currentBindState.varyingInstances;
+        for (int i=0; i<instances.numInstances; ++i) {
+            computeFusedStencils(stencils, VertexBufferDescriptor(), 0, 0,
+                varyingDesc,
+                varyingBuffer + varyingDesc.offset + i*instances.srcStride,
+                varyingBuffer + varyingDesc.offset + i*instances.dstStride +
+                    numControlVertices * varyingDesc.stride,
+                batch.start, batch.end);
+        }
     }
 }
 
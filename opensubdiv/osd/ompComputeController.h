@@ -117,6 +117,91 @@ public:
         Compute<VERTEX_BUFFER>(context, batches, vertexBuffer, (VERTEX_BUFFER*)0);
     }
 
+    /// Execute subdivision kernels and apply to several instances of the
+    /// primvar data sharing the topology of the context.
+    ///
+    /// All the instances are refined in a single sweep over the stencils :
+    /// each stencil is applied to every instance in turn, so that the
+    /// stencil tables are read from memory only once.
+    ///
+    /// @param  context          The CpuContext to apply refinement operations to
+    ///
+    /// @param  batches          Vector of batches of vertices organized by operative
+    ///                          kernel
+    ///
+    /// @param  vertexBuffer     Vertex-interpolated data buffer
+    ///
+    /// @param  varyingBuffer    Vertex-interpolated data buffer
+    ///
+    /// @param  vertexInstances  The layout of the instances in the vertex
+    ///                          buffer (strides in floats)
+    ///
+    /// @param  varyingInstances The layout of the instances in the varying
+    ///                          buffer (strides in floats)
+    ///
+    /// Nothing is computed if the instance descriptor of a buffer is not
+    /// valid (see InstanceBufferDescriptor::IsValid()).
+    ///
+    /// @param  vertexDesc       The descriptor of the vertex elements of
+    ///                          the first instance to be refined.
+    ///                          if it's null, all primvars in the vertex
+    ///                          buffer will be refined.
+    ///
+    /// @param  varyingDesc      The descriptor of the varying elements of
+    ///                          the first instance to be refined.
+    ///                          if it's null, all primvars in the varying
+    ///                          buffer will be refined.
+    ///
+    template<class VERTEX_BUFFER, class VARYING_BUFFER>
+        void ComputeInstances( CpuComputeContext const * context,
+                               Far::KernelBatchVector const & batches,
+                               VERTEX_BUFFER  * vertexBuffer,
+                               VARYING_BUFFER * varyingBuffer,
+                               InstanceBufferDescriptor const & vertexInstances,
+                               InstanceBufferDescriptor const & varyingInstances,
+                               VertexBufferDescriptor const * vertexDesc=NULL,
+                               VertexBufferDescriptor const * varyingDesc=NULL ){
+
+        if (batches.empty()) return;
+
+        if (not validInstances(vertexBuffer, vertexInstances) or
+            not validInstances(varyingBuffer, varyingInstances)) return;
+
+        omp_set_num_threads(_numThreads);
+
+        bind(vertexBuffer, varyingBuffer, vertexDesc, varyingDesc);
+
+        _currentBindState.vertexInstances = &vertexInstances;
+        _currentBindState.varyingInstances = &varyingInstances;
+
+        Far::KernelBatchDispatcher::Apply(this, context, batches, /*maxlevel*/ -1);
+
+        unbind();
+    }
+
+    /// Execute subdivision kernels and apply to several instances of the
+    /// primvar data sharing the topology of the context.
+    ///
+    /// @param  context          The CpuContext to apply refinement operations to
+    ///
+    /// @param  batches          Vector of batches of vertices organized by operative
+    ///                          kernel
+    ///
+    /// @param  vertexBuffer     Vertex-interpolated data buffer
+    ///
+    /// @param  vertexInstances  The layout of the instances in the vertex
+    ///                          buffer (strides in floats)
+    ///
+    template<class VERTEX_BUFFER>
+        void ComputeInstances(CpuComputeContext const * context,
+                              Far::KernelBatchVector const & batches,
+                              VERTEX_BUFFER *vertexBuffer,
+                              InstanceBufferDescriptor const & vertexInstances) {
+
+        ComputeInstances<VERTEX_BUFFER>(context, batches, vertexBuffer,
+            (VERTEX_BUFFER*)0, vertexInstances, InstanceBufferDescriptor());
+    }
+
     /// Waits until all running subdivision kernels finish.
     void Synchronize();
 
@@ -127,6 +212,11 @@ protected:
     void ApplyStencilTableKernel(Far::KernelBatch const &batch,
         ComputeContext const *context) const;
 
+    // Applies fused vertex & varying stencils (see
+    // Far::StencilTablesFactory::CreateFused())
+    void applyFusedStencils(Far::StencilTables const & stencils,
+        Far::KernelBatch const &batch) const;
+
     template<class VERTEX_BUFFER, class VARYING_BUFFER>
         void bind( VERTEX_BUFFER * vertexBuffer,
                    VARYING_BUFFER * varyingBuffer,
@@ -163,18 +253,27 @@ protected:
         _currentBindState.Reset();
     }
 
+    // A bound buffer must have a valid instance layout
+    template<class BUFFER>
+        static bool validInstances( BUFFER const * buffer,
+                                    InstanceBufferDescriptor const & instances ) {
+        return (not buffer) or instances.IsValid();
+    }
+
 private:
 
     // Bind state is a transitional state during refinement.
     // It doesn't take an ownership of the vertex buffers.
     struct BindState {
 
-        BindState() : vertexBuffer(0), varyingBuffer(0) { }
+        BindState() : vertexBuffer(0), varyingBuffer(0),
+            vertexInstances(0), varyingInstances(0) { }
 
         void Reset() {
             vertexBuffer = varyingBuffer = 0;
             vertexDesc.Reset();
             varyingDesc.Reset();
+            vertexInstances = varyingInstances = 0;
         }
 
         float * vertexBuffer,
@@ -182,6 +281,10 @@ private:
 
         VertexBufferDescriptor vertexDesc,
                                   varyingDesc;
+
+        // layout of the instances in the buffers (not instanced if null)
+        InstanceBufferDescriptor const * vertexInstances,
+                                       * varyingInstances;
     };
 
     BindState _currentBindState;
@@ -23,7 +23,9 @@
 //
 
 #include "../osd/ompEvalStencilsController.h"
+#include "../osd/cpuKernel.h"
 
+#include <algorithm>
 #include <cassert>
 
 namespace OpenSubdiv {
@@ -31,6 +33,9 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
+// Number of stencils applied by each parallel iteration
+static const int grainSize = 200;
+
 OmpEvalStencilsController::OmpEvalStencilsController(int numThreads) {
 
     _numThreads = (numThreads == -1) ? omp_get_num_procs() : numThreads;
@@ -39,106 +44,141 @@ OmpEvalStencilsController::OmpEvalStencilsController(int numThreads) {
 OmpEvalStencilsController::~OmpEvalStencilsController() {
 }
 
-int
-OmpEvalStencilsController::_UpdateValues( CpuEvalStencilsContext * context ) {
+namespace {
+
+// Applies a range of limit stencils to the bound outputs
+class LimitStencilKernel {
+
+public:
+    LimitStencilKernel( VertexBufferDescriptor const & ctrlDesc, float const * ctrl,
+                        VertexBufferDescriptor const & outDesc, float * out,
+                        VertexBufferDescriptor const & duDesc, float * du,
+                        VertexBufferDescriptor const & dvDesc, float * dv,
+                        Far::StencilTables const * stencils,
+                        Far::LimitStencilTables const * limitStencils ) :
+        _ctrlDesc(ctrlDesc), _outDesc(outDesc), _duDesc(duDesc), _dvDesc(dvDesc),
+        _ctrl(ctrl), _out(out), _du(du), _dv(dv) {
+
+        std::vector<int> const & offsets = stencils->GetOffsets();
+
+        _sizes = &stencils->GetSizes()[0];
+        _offsets = offsets.empty() ? 0 : &offsets[0];
+        _indices = &stencils->GetControlIndices()[0];
+        _weights = out ? &stencils->GetWeights()[0] : 0;
+        _duWeights = du ? &limitStencils->GetDuWeights()[0] : 0;
+        _dvWeights = dv ? &limitStencils->GetDvWeights()[0] : 0;
+    }
 
-    int result=0;
+    // Stencils can only be applied by ranges if the tables have offsets
+    bool HasOffsets() const {
+        return _offsets!=0;
+    }
 
-    Far::StencilTables const * stencils = context->GetStencilTables();
+    void Apply(int start, int end) const {
 
-    int nstencils = stencils->GetNumStencils();
-    if (not nstencils)
-        return result;
+        CpuComputeLimitStencils(_ctrlDesc, _ctrl, _outDesc, _out,
+            _duDesc, _du, _dvDesc, _dv, _sizes, _offsets, _indices,
+                _weights, _duWeights, _dvWeights, start, end);
+    }
 
-    VertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
-                              outDesc = _currentBindState.outputDataDesc;
+private:
+    VertexBufferDescriptor _ctrlDesc,
+                           _outDesc,
+                           _duDesc,
+                           _dvDesc;
 
-    // make sure that we have control data to work with
-    if (not ctrlDesc.CanEval(outDesc))
-        return 0;
-
-    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
+    float const * _ctrl;
 
-    if (not ctrl)
-        return result;
+    float * _out,
+          * _du,
+          * _dv;
 
-#pragma omp parallel for
-    for (int i=0; i<nstencils; ++i) {
+    unsigned char const * _sizes;
 
-        int size = stencils->GetSizes()[i],
-            offset = stencils->GetOffsets()[i];
+    int const * _offsets,
+              * _indices;
 
-        int const * index = &stencils->GetControlIndices().at(offset);
+    float const * _weights,
+                * _duWeights,
+                * _dvWeights;
+};
 
-        float const * weight = &stencils->GetWeights().at(offset);
+} // end namespace unnamed
 
-        float * out = _currentBindState.outputData + i * outDesc.stride + outDesc.offset;
+int
+OmpEvalStencilsController::_UpdateValues( CpuEvalStencilsContext * context ) {
 
-        memset(out, 0, outDesc.length*sizeof(float));
+    return _Update(context, true, false);
+}
 
-        for (int j=0; j<size; ++j, ++index, ++weight) {
+int
+OmpEvalStencilsController::_UpdateDerivs( CpuEvalStencilsContext * context ) {
 
-            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+    return _Update(context, false, true);
+}
 
-            for (int k=0; k<outDesc.length; ++k) {
-                out[k] += cv[k] * (*weight);
-            }
-        }
-    }
+int
+OmpEvalStencilsController::_UpdateValuesAndDerivs( CpuEvalStencilsContext * context ) {
 
-    return nstencils;
+    return _Update(context, true, true);
 }
 
 int
-OmpEvalStencilsController::_UpdateDerivs( CpuEvalStencilsContext * context ) {
-
-    int result=0;
+OmpEvalStencilsController::_Update( CpuEvalStencilsContext * context,
+    bool values, bool derivs ) {
 
     Far::StencilTables const * stencils = context->GetStencilTables();
+    Far::LimitStencilTables const * limitStencils = context->GetLimitStencilTables();
+
+    // derivatives require limit stencils
+    if (not stencils or (derivs and not limitStencils))
+        return 0;
 
     int nstencils = stencils->GetNumStencils();
     if (not nstencils)
-        return result;
-
-    VertexBufferDescriptor ctrlDesc = _currentBindState.controlDataDesc,
-                              duDesc = _currentBindState.outputDuDesc,
-                              dvDesc = _currentBindState.outputDvDesc;
-
-    // make sure that we have control data to work with
-    if (not (ctrlDesc.CanEval(duDesc) and ctrlDesc.CanEval(dvDesc)))
         return 0;
 
-    float const * ctrl = _currentBindState.controlData + ctrlDesc.offset;
+    BindState const & bs = _currentBindState;
 
-    if (not ctrl)
-        return result;
+    VertexBufferDescriptor const & ctrlDesc = bs.controlDataDesc;
 
-#pragma omp parallel for
-    for (int i=0; i<nstencils; ++i) {
-
-        int size = stencils->GetSizes()[i],
-            offset = stencils->GetOffsets()[i];
+    // make sure that we have control data to work with
+    if (not bs.controlData)
+        return 0;
 
-        int const * index = &stencils->GetControlIndices().at(offset);
+    float * out = 0,
+          * du = 0,
+          * dv = 0;
 
-        float const * duweight = &stencils->GetDuWeights().at(offset),
-                    * dvweight = &stencils->GetDvWeights().at(offset);
+    if (values) {
+        if (not bs.outputData or not ctrlDesc.CanEval(bs.outputDataDesc))
+            return 0;
+        out = bs.outputData + bs.outputDataDesc.offset;
+    }
 
-        float * du = _currentBindState.outputUDeriv + i * duDesc.stride + duDesc.offset,
-              * dv = _currentBindState.outputVDeriv + i * dvDesc.stride + dvDesc.offset;
+    if (derivs) {
+        if (not bs.outputUDeriv or not ctrlDesc.CanEval(bs.outputDuDesc) or
+            not bs.outputVDeriv or not ctrlDesc.CanEval(bs.outputDvDesc))
+            return 0;
+        du = bs.outputUDeriv + bs.outputDuDesc.offset;
+        dv = bs.outputVDeriv + bs.outputDvDesc.offset;
+    }
 
-        memset(du, 0, duDesc.length*sizeof(float));
-        memset(dv, 0, dvDesc.length*sizeof(float));
+    LimitStencilKernel kernel(ctrlDesc, bs.controlData + ctrlDesc.offset,
+        bs.outputDataDesc, out, bs.outputDuDesc, du, bs.outputDvDesc, dv,
+            stencils, limitStencils);
 
-        for (int j=0; j<size; ++j, ++index, ++duweight, ++dvweight) {
+    if (not kernel.HasOffsets()) {
+        kernel.Apply(0, nstencils);
+        return nstencils;
+    }
 
-            float const * cv = ctrl + (*index)*ctrlDesc.stride;
+    int nblocks = (nstencils + grainSize - 1) / grainSize;
 
-            for (int k=0; k<duDesc.length; ++k) {
-                du[k] += cv[k] * (*duweight);
-                dv[k] += cv[k] * (*dvweight);
-            }
-        }
+#pragma omp parallel for
+    for (int i=0; i<nblocks; ++i) {
+        int start = i * grainSize;
+        kernel.Apply(start, std::min(start + grainSize, nstencils));
     }
 
     return nstencils;
@@ -148,7 +188,6 @@ void
 OmpEvalStencilsController::Synchronize() {
 }
 
-
 } // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
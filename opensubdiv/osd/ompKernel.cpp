@@ -23,8 +23,11 @@
 //
 
 #include "../osd/ompKernel.h"
+#include "../osd/cpuKernel.h"
+#include "../osd/cpuSimdKernel.h"
 #include "../osd/vertexDescriptor.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <omp.h>
@@ -71,14 +74,14 @@ copy(float *dst, int dstIndex, const float *src,
 
 // XXXX manuelk this should be optimized further by using SIMD - considering
 //              OMP is somewhat obsolete - this is probably not worth it.
-void
+template <class INDEX, class WEIGHT> void
 OmpComputeStencils(VertexBufferDescriptor const &vertexDesc,
                       float const * vertexSrc,
                       float * vertexDst,
                       unsigned char const * sizes,
                       int const * offsets,
-                      int const * indices,
-                      float const * weights,
+                      INDEX const * indices,
+                      WEIGHT const * weights,
                       int start, int end) {
 
     assert(start>=0 and start<end);
@@ -86,6 +89,27 @@ OmpComputeStencils(VertexBufferDescriptor const &vertexDesc,
     int numThreads = omp_get_max_threads(),
         nstencils = end-start;
 
+    if (HasSimdStencilKernel(vertexDesc)) {
+
+        // Explicit SSE4 / AVX2 / AVX-512 kernels selected at runtime : each
+        // thread applies contiguous blocks of stencils
+        int const blockSize = 256;
+
+        int nblocks = (nstencils + blockSize - 1) / blockSize;
+
+#pragma omp parallel for
+        for (int block=0; block<nblocks; ++block) {
+
+            int blockStart = start + block*blockSize,
+                blockEnd = std::min(blockStart+blockSize, end);
+
+            SimdComputeStencils(vertexDesc, vertexSrc, vertexDst, sizes,
+                indices + offsets[blockStart], weights + offsets[blockStart],
+                    blockStart, blockEnd);
+        }
+        return;
+    }
+
     float * result = (float*)alloca(vertexDesc.length*numThreads*sizeof(float));
 
 #pragma omp parallel for
@@ -94,8 +118,8 @@ OmpComputeStencils(VertexBufferDescriptor const &vertexDesc,
         int index = i + (start>0 ? start : 0); // Stencil index
 
         // Get thread-local pointers
-        int const           * threadIndices = indices + offsets[index];
-        float const         * threadWeights = weights + offsets[index];
+        INDEX const         * threadIndices = indices + offsets[index];
+        WEIGHT const        * threadWeights = weights + offsets[index];
 
         int threadId = omp_get_thread_num();
 
@@ -105,14 +129,112 @@ OmpComputeStencils(VertexBufferDescriptor const &vertexDesc,
 
         for (int j=0; j<(int)sizes[index]; ++j) {
             addWithWeight(threadResult, vertexSrc,
-                threadIndices[j], threadWeights[j], vertexDesc);
+                threadIndices[j], (float)threadWeights[j], vertexDesc);
         }
 
-        copy(vertexDst, i, threadResult, vertexDesc);
+        copy(vertexDst, index, threadResult, vertexDesc);
     }
 
 }
 
+template <class INDEX, class WEIGHT> void
+OmpComputeInstanceStencils(VertexBufferDescriptor const &vertexDesc,
+                           InstanceBufferDescriptor const &instanceDesc,
+                           float const * vertexSrc,
+                           float * vertexDst,
+                           unsigned char const * sizes,
+                           int const * offsets,
+                           INDEX const * indices,
+                           WEIGHT const * weights,
+                           int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    // Each thread applies contiguous blocks of stencils to all the instances
+    int const blockSize = 256;
+
+    int nblocks = (end - start + blockSize - 1) / blockSize;
+
+#pragma omp parallel for
+    for (int block=0; block<nblocks; ++block) {
+
+        int blockStart = start + block*blockSize,
+            blockEnd = std::min(blockStart+blockSize, end);
+
+        CpuComputeInstanceStencils(vertexDesc, instanceDesc,
+            vertexSrc, vertexDst, sizes, offsets, indices, weights,
+                blockStart, blockEnd);
+    }
+}
+
+void
+OmpComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                        float const * vertexSrc,
+                        float * vertexDst,
+                        VertexBufferDescriptor const &varyingDesc,
+                        float const * varyingSrc,
+                        float * varyingDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        unsigned char const * varyingSizes,
+                        int const * varyingOffsets,
+                        float const * varyingWeights,
+                        int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    // Each thread applies contiguous blocks of stencils
+    int const blockSize = 256;
+
+    int nblocks = (end - start + blockSize - 1) / blockSize;
+
+#pragma omp parallel for
+    for (int block=0; block<nblocks; ++block) {
+
+        int blockStart = start + block*blockSize,
+            blockEnd = std::min(blockStart+blockSize, end);
+
+        CpuComputeFusedStencils(vertexDesc, vertexSrc, vertexDst,
+            varyingDesc, varyingSrc, varyingDst, sizes, offsets, indices,
+                weights, varyingSizes, varyingOffsets, varyingWeights,
+                    blockStart, blockEnd);
+    }
+}
+
+template void OmpComputeStencils<int, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        int const *, float const *, int, int);
+
+template void OmpComputeStencils<int, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        int const *, Far::Half const *, int, int);
+
+template void OmpComputeStencils<unsigned short, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        unsigned short const *, float const *, int, int);
+
+template void OmpComputeStencils<unsigned short, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        unsigned short const *, Far::Half const *, int, int);
+
+template void OmpComputeInstanceStencils<int, float>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, int const *, float const *, int, int);
+
+template void OmpComputeInstanceStencils<int, Far::Half>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, int const *, Far::Half const *, int, int);
+
+template void OmpComputeInstanceStencils<unsigned short, float>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, unsigned short const *, float const *, int, int);
+
+template void OmpComputeInstanceStencils<unsigned short, Far::Half>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, unsigned short const *, Far::Half const *, int, int);
+
 } // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
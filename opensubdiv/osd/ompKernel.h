@@ -27,6 +27,8 @@
 
 #include "../version.h"
 
+#include "../far/compactStencilTables.h"
+
 #include "../osd/vertexDescriptor.h"
 
 namespace OpenSubdiv {
@@ -36,16 +38,46 @@ namespace Osd {
 
 struct VertexDescriptor;
 
-void
+// Same instantiations as CpuComputeStencils()
+template <class INDEX, class WEIGHT> void
 OmpComputeStencils(VertexBufferDescriptor const &vertexDesc,
                       float const * vertexSrc,
                       float * vertexDst,
                       unsigned char const * sizes,
                       int const * offsets,
-                      int const * indices,
-                      float const * weights,
+                      INDEX const * indices,
+                      WEIGHT const * weights,
                       int start, int end);
 
+// Same instantiations as CpuComputeStencils()
+template <class INDEX, class WEIGHT> void
+OmpComputeInstanceStencils(VertexBufferDescriptor const &vertexDesc,
+                           InstanceBufferDescriptor const &instanceDesc,
+                           float const * vertexSrc,
+                           float * vertexDst,
+                           unsigned char const * sizes,
+                           int const * offsets,
+                           INDEX const * indices,
+                           WEIGHT const * weights,
+                           int start, int end);
+
+// Same as CpuComputeFusedStencils()
+void
+OmpComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                        float const * vertexSrc,
+                        float * vertexDst,
+                        VertexBufferDescriptor const &varyingDesc,
+                        float const * varyingSrc,
+                        float * varyingDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        unsigned char const * varyingSizes,
+                        int const * varyingOffsets,
+                        float const * varyingWeights,
+                        int start, int end);
+
 } // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
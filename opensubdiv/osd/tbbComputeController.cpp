@@ -26,9 +26,13 @@
 
 #include "../far/stencilTables.h"
 #include "../osd/cpuComputeContext.h"
+#include "../osd/cpuKernel.h"
 #include "../osd/tbbComputeController.h"
 #include "../osd/tbbKernel.h"
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #ifdef OPENSUBDIV_HAS_TBB
     #include <tbb/task_scheduler_init.h>
 #endif
@@ -38,6 +42,205 @@ namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
+namespace {
+
+// Applies ranges of stencils in parallel (each range serially)
+class TBBStencilRangesKernel {
+
+    Far::StencilTables const & _stencils;
+    float const * _weights;
+    VertexBufferDescriptor _desc;
+    float const * _srcBuffer;
+    float * _destBuffer;
+    int const * _ranges;
+    InstanceBufferDescriptor const * _instances;
+
+public:
+    TBBStencilRangesKernel(Far::StencilTables const & stencils,
+        float const * weights, VertexBufferDescriptor const & desc,
+            float const * srcBuffer, float * destBuffer, int const * ranges,
+                InstanceBufferDescriptor const * instances) :
+        _stencils(stencils),
+        _weights(weights),
+        _desc(desc),
+        _srcBuffer(srcBuffer),
+        _destBuffer(destBuffer),
+        _ranges(ranges),
+        _instances(instances) { }
+
+    void operator() (tbb::blocked_range<int> const &r) const {
+
+        for (int i=r.begin(); i<r.end(); ++i) {
+            if (_instances) {
+                CpuComputeInstanceStencils(_desc, *_instances,
+                                  _srcBuffer, _destBuffer,
+                                  &_stencils.GetSizes().at(0),
+                                  &_stencils.GetOffsets().at(0),
+                                  &_stencils.GetControlIndices().at(0),
+                                  _weights,
+                                  _ranges[2*i],
+                                  _ranges[2*i+1]);
+            } else {
+                CpuComputeStencils(_desc, _srcBuffer, _destBuffer,
+                                  &_stencils.GetSizes().at(0),
+                                  &_stencils.GetOffsets().at(0),
+                                  &_stencils.GetControlIndices().at(0),
+                                  _weights,
+                                  _ranges[2*i],
+                                  _ranges[2*i+1]);
+            }
+        }
+    }
+};
+
+// Applies ranges of fused stencils in parallel (each range serially)
+class TBBFusedStencilRangesKernel {
+
+    Far::StencilTables const & _stencils;
+    VertexBufferDescriptor _vertexDesc,
+                           _varyingDesc;
+    float const * _vertexSrc,
+                * _varyingSrc;
+    float * _vertexDst,
+          * _varyingDst;
+    int const * _ranges;
+
+public:
+    TBBFusedStencilRangesKernel(Far::StencilTables const & stencils,
+        VertexBufferDescriptor const & vertexDesc, float const * vertexSrc,
+            float * vertexDst, VertexBufferDescriptor const & varyingDesc,
+                float const * varyingSrc, float * varyingDst, int const * ranges) :
+        _stencils(stencils),
+        _vertexDesc(vertexDesc),
+        _varyingDesc(varyingDesc),
+        _vertexSrc(vertexSrc),
+        _varyingSrc(varyingSrc),
+        _vertexDst(vertexDst),
+        _varyingDst(varyingDst),
+        _ranges(ranges) { }
+
+    void operator() (tbb::blocked_range<int> const &r) const {
+
+        for (int i=r.begin(); i<r.end(); ++i) {
+            CpuComputeFusedStencils(_vertexDesc, _vertexSrc, _vertexDst,
+                                _varyingDesc, _varyingSrc, _varyingDst,
+                                &_stencils.GetSizes().at(0),
+                                &_stencils.GetOffsets().at(0),
+                                &_stencils.GetControlIndices().at(0),
+                                &_stencils.GetWeights().at(0),
+                                &_stencils.GetVaryingSizes().at(0),
+                                &_stencils.GetVaryingOffsets().at(0),
+                                &_stencils.GetVaryingWeights().at(0),
+                                _ranges[2*i],
+                                _ranges[2*i+1]);
+        }
+    }
+};
+
+// Returns true if all the stencils [start, end) are applied, otherwise the
+// ranges of those depending on the dirty control vertices, or of those of the
+// vertices not carried over by an update
+bool
+getStencilRanges(Far::StencilTables const & stencils, int start, int end,
+    std::vector<int> const * dirtyVertices, std::vector<int> const * vertexOrigins,
+        std::vector<int> & ranges) {
+
+    if (dirtyVertices) {
+        stencils.GetDependentStencilRanges(
+            &dirtyVertices->at(0), (int)dirtyVertices->size(), ranges);
+        ClipStencilRanges(ranges, start, end);
+    } else if (vertexOrigins) {
+        stencils.GetUpdatedStencilRanges(*vertexOrigins, ranges, start, end);
+        ClipStencilRanges(ranges, start, end);
+    }
+
+    return (not dirtyVertices and not vertexOrigins) or (ranges.size()==2 and
+        ranges[0]==start and ranges[1]==end);
+}
+
+// Applies the stencils [start, end) with the given weights to the buffer,
+// or only those depending on the dirty control vertices (resp. not carried
+// over by an update), to every instance if the buffer is instanced
+void
+computeStencils(Far::StencilTables const & stencils,
+    std::vector<float> const & weights,
+        VertexBufferDescriptor const & desc, float * buffer, int start, int end,
+            std::vector<int> const * dirtyVertices,
+                std::vector<int> const * vertexOrigins,
+                    InstanceBufferDescriptor const * instances) {
+
+    float const * srcBuffer = buffer + desc.offset;
+
+    float * destBuffer = buffer + desc.offset +
+        stencils.GetNumControlVertices() * desc.stride;
+
+    std::vector<int> ranges;
+    if (getStencilRanges(stencils, start, end, dirtyVertices, vertexOrigins, ranges)) {
+        if (instances) {
+            TbbComputeInstanceStencils(desc, *instances, srcBuffer, destBuffer,
+                              &stencils.GetSizes().at(0),
+                              &stencils.GetOffsets().at(0),
+                              &stencils.GetControlIndices().at(0),
+                              &weights.at(0),
+                              start,
+                              end);
+        } else {
+            TbbComputeStencils(desc, srcBuffer, destBuffer,
+                              &stencils.GetSizes().at(0),
+                              &stencils.GetOffsets().at(0),
+                              &stencils.GetControlIndices().at(0),
+                              &weights.at(0),
+                              start,
+                              end);
+        }
+        return;
+    }
+
+    int nranges = (int)ranges.size()/2;
+    if (nranges>0) {
+        tbb::parallel_for(tbb::blocked_range<int>(0, nranges, 16),
+            TBBStencilRangesKernel(stencils, &weights.at(0), desc,
+                srcBuffer, destBuffer, &ranges[0], instances));
+    }
+}
+
+// Applies fused stencils [start, end) to the vertex & varying primvars in a
+// single pass (either destination may be null), or only those depending on
+// the dirty control vertices (resp. not carried over by an update)
+void
+computeFusedStencils(Far::StencilTables const & stencils,
+    VertexBufferDescriptor const & vertexDesc, float const * vertexSrc,
+        float * vertexDst, VertexBufferDescriptor const & varyingDesc,
+            float const * varyingSrc, float * varyingDst, int start, int end,
+                std::vector<int> const * dirtyVertices,
+                    std::vector<int> const * vertexOrigins) {
+
+    std::vector<int> ranges;
+    if (getStencilRanges(stencils, start, end, dirtyVertices, vertexOrigins, ranges)) {
+        TbbComputeFusedStencils(vertexDesc, vertexSrc, vertexDst,
+                                varyingDesc, varyingSrc, varyingDst,
+                                &stencils.GetSizes().at(0),
+                                &stencils.GetOffsets().at(0),
+                                &stencils.GetControlIndices().at(0),
+                                &stencils.GetWeights().at(0),
+                                &stencils.GetVaryingSizes().at(0),
+                                &stencils.GetVaryingOffsets().at(0),
+                                &stencils.GetVaryingWeights().at(0),
+                                start,
+                                end);
+        return;
+    }
+
+    int nranges = (int)ranges.size()/2;
+    if (nranges>0) {
+        tbb::parallel_for(tbb::blocked_range<int>(0, nranges, 16),
+            TBBFusedStencilRangesKernel(stencils, vertexDesc, vertexSrc,
+                vertexDst, varyingDesc, varyingSrc, varyingDst, &ranges[0]));
+    }
+}
+
+} // end namespace unnamed
+
 TbbComputeController::TbbComputeController(int numThreads)
     : _numThreads(numThreads) {
 
@@ -55,44 +258,108 @@ TbbComputeController::ApplyStencilTableKernel(
 
     Far::StencilTables const * vertexStencils = context->GetVertexStencilTables();
 
+    if (_currentBindState.vertexOrigins) {
+        copyCarriedVertices(vertexStencils ? vertexStencils :
+            context->GetVaryingStencilTables(), batch);
+    }
+
+    if (vertexStencils and not vertexStencils->GetVaryingSizes().empty()) {
+        applyFusedStencils(*vertexStencils, batch);
+        return;
+    }
+
     if (vertexStencils and _currentBindState.vertexBuffer) {
+        computeStencils(*vertexStencils, vertexStencils->GetWeights(),
+            _currentBindState.vertexDesc, _currentBindState.vertexBuffer,
+                batch.start, batch.end, _currentBindState.dirtyVertices,
+                    _currentBindState.vertexOrigins, _currentBindState.vertexInstances);
+    }
 
-        VertexBufferDescriptor const & desc = _currentBindState.vertexDesc;
+    Far::StencilTables const * varyingStencils = context->GetVaryingStencilTables();
 
-        float const * srcBuffer = _currentBindState.vertexBuffer + desc.offset;
+    if (varyingStencils and _currentBindState.varyingBuffer) {
+        computeStencils(*varyingStencils, varyingStencils->GetWeights(),
+            _currentBindState.varyingDesc, _currentBindState.varyingBuffer,
+                batch.start, batch.end, _currentBindState.dirtyVertices,
+                    _currentBindState.vertexOrigins, _currentBindState.varyingInstances);
+    }
+}
+
+void
+TbbComputeController::copyCarriedVertices(Far::StencilTables const * stencils,
+    Far::KernelBatch const &batch) const {
+
+    if (not stencils) return;
 
-        float * destBuffer = _currentBindState.vertexBuffer + desc.offset +
-            vertexStencils->GetNumControlVertices() * desc.stride;
+    int numControlVertices = stencils->GetNumControlVertices();
 
-        TbbComputeStencils(_currentBindState.vertexDesc,
-                              srcBuffer, destBuffer,
-                              &vertexStencils->GetSizes().at(0),
-                              &vertexStencils->GetOffsets().at(0),
-                              &vertexStencils->GetControlIndices().at(0),
-                              &vertexStencils->GetWeights().at(0),
-                              batch.start,
-                              batch.end);
+    VertexBufferDescriptor const & vertexDesc = _currentBindState.vertexDesc,
+                                 & varyingDesc = _currentBindState.varyingDesc;
+
+    if (_currentBindState.vertexBuffer) {
+        CpuCopyCarriedVertices(vertexDesc,
+            _currentBindState.prevVertexBuffer + vertexDesc.offset,
+            _currentBindState.vertexBuffer + vertexDesc.offset,
+            *_currentBindState.vertexOrigins, numControlVertices,
+            batch.start, batch.end);
     }
 
-    Far::StencilTables const * varyingStencils = context->GetVaryingStencilTables();
+    if (_currentBindState.varyingBuffer) {
+        CpuCopyCarriedVertices(varyingDesc,
+            _currentBindState.prevVaryingBuffer + varyingDesc.offset,
+            _currentBindState.varyingBuffer + varyingDesc.offset,
+            *_currentBindState.vertexOrigins, numControlVertices,
+            batch.start, batch.end);
+    }
+}
 
-    if (varyingStencils and _currentBindState.varyingBuffer) {
+void
+TbbComputeController::applyFusedStencils(Far::StencilTables const & stencils,
+    Far::KernelBatch const &batch) const {
+
+    int numControlVertices = stencils.GetNumControlVertices();
 
-        VertexBufferDescriptor const & desc = _currentBindState.varyingDesc;
+    VertexBufferDescriptor const & vertexDesc = _currentBindState.vertexDesc,
+                                 & varyingDesc = _currentBindState.varyingDesc;
 
-        float const * srcBuffer = _currentBindState.varyingBuffer + desc.offset;
+    float * vertexBuffer = _currentBindState.vertexBuffer,
+          * varyingBuffer = _currentBindState.varyingBuffer;
 
-        float * destBuffer = _currentBindState.varyingBuffer + desc.offset +
-            varyingStencils->GetNumControlVertices() * desc.stride;
+    if (not _currentBindState.vertexInstances) {
+        // vertex & varying primvars in a single pass
+        computeFusedStencils(stencils, vertexDesc,
+            vertexBuffer ? vertexBuffer + vertexDesc.offset : 0,
+            vertexBuffer ? vertexBuffer + vertexDesc.offset +
+                numControlVertices * vertexDesc.stride : 0,
+            varyingDesc,
+            varyingBuffer ? varyingBuffer + varyingDesc.offset : 0,
+            varyingBuffer ? varyingBuffer + varyingDesc.offset +
+                numControlVertices * varyingDesc.stride : 0,
+            batch.start, batch.end, _currentBindState.dirtyVertices,
+                _currentBindState.vertexOrigins);
+        return;
+    }
+
+    // instanced buffers : the vertex primvars of all the instances, then
+    // the varying primvars of each instance
+    if (vertexBuffer) {
+        computeStencils(stencils, stencils.GetWeights(), vertexDesc,
+            vertexBuffer, batch.start, batch.end,
+                _currentBindState.dirtyVertices, _currentBindState.vertexOrigins,
+                    _currentBindState.vertexInstances);
+    }
 
-        TbbComputeStencils(_currentBindState.varyingDesc,
-                              srcBuffer, destBuffer,
-                              &varyingStencils->GetSizes().at(0),
-                              &varyingStencils->GetOffsets().at(0),
-                              &varyingStencils->GetControlIndices().at(0),
-                              &varyingStencils->GetWeights().at(0),
-                              batch.start,
-                              batch.end);
+    if (varyingBuffer) {
+        InstanceBufferDescriptor const & instances = *_currentBindState.varyingInstances;
+        for (int i=0; i<instances.numInstances; ++i) {
+            computeFusedStencils(stencils, VertexBufferDescriptor(), 0, 0,
+                varyingDesc,
+                varyingBuffer + varyingDesc.offset + i*instances.srcStride,
+                varyingBuffer + varyingDesc.offset + i*instances.dstStride +
+                    numControlVertices * varyingDesc.stride,
+                batch.start, batch.end, _currentBindState.dirtyVertices,
+                    _currentBindState.vertexOrigins);
+        }
     }
 }
 
@@ -23,9 +23,17 @@
 //
 
 #include "../osd/tbbEvalStencilsController.h"
+#include "../osd/cpuKernel.h"
 
+#include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
-#include <tbb/task_scheduler_init.h>
+
+// task_scheduler_init was removed from oneTBB : the number of threads is
+// limited with a task arena instead, where available
+#if TBB_INTERFACE_VERSION >= 8000
+    #include <tbb/task_arena.h>
+    #define OSD_TBB_HAS_TASK_ARENA
+#endif
 
 #include <cassert>
 
@@ -36,155 +44,168 @@ namespace Osd {
 
 #define grain_size  200
 
-TbbEvalStencilsController::TbbEvalStencilsController(int numThreads) {
-
-    _numThreads = numThreads > 0 ? numThreads : tbb::task_scheduler_init::automatic;
-
-   tbb::task_scheduler_init init(numThreads);
+TbbEvalStencilsController::TbbEvalStencilsController(int numThreads) :
+    _numThreads(numThreads) {
 }
 
 TbbEvalStencilsController::~TbbEvalStencilsController() {
 }
 
+namespace {
 
-class StencilKernel {
+// Applies a range of limit stencils to the bound outputs
+class LimitStencilKernel {
 
 public:
-    enum Mode { UNDEFINED, POINT, U_DERIV, V_DERIV };
-
-    StencilKernel( Far::StencilTables const * stencils,
-                   VertexBufferDescriptor ctrlDesc,
-                   float const * ctrlData ) :
-        _stencils(stencils),
-        _mode(UNDEFINED),
-        _ctrlDesc(ctrlDesc),
-        _length(0),
-        _outStride(0),
-        _outData(0) {
-
-        _ctrlData = ctrlData + ctrlDesc.offset;
+    LimitStencilKernel( VertexBufferDescriptor const & ctrlDesc, float const * ctrl,
+                        VertexBufferDescriptor const & outDesc, float * out,
+                        VertexBufferDescriptor const & duDesc, float * du,
+                        VertexBufferDescriptor const & dvDesc, float * dv,
+                        Far::StencilTables const * stencils,
+                        Far::LimitStencilTables const * limitStencils ) :
+        _ctrlDesc(ctrlDesc), _outDesc(outDesc), _duDesc(duDesc), _dvDesc(dvDesc),
+        _ctrl(ctrl), _out(out), _du(du), _dv(dv) {
+
+        std::vector<int> const & offsets = stencils->GetOffsets();
+
+        _sizes = &stencils->GetSizes()[0];
+        _offsets = offsets.empty() ? 0 : &offsets[0];
+        _indices = &stencils->GetControlIndices()[0];
+        _weights = out ? &stencils->GetWeights()[0] : 0;
+        _duWeights = du ? &limitStencils->GetDuWeights()[0] : 0;
+        _dvWeights = dv ? &limitStencils->GetDvWeights()[0] : 0;
     }
 
-    bool SetOutput(Mode mode, VertexBufferDescriptor outDesc, float * outData) {
-
-        if (_ctrlDesc.CanEval(outDesc)) {
-            _mode = mode;
-            _length = outDesc.length;
-            _outStride = outDesc.stride;
-            _outData = outData + outDesc.offset;
-            return true;
-        }
-        return false;
+    // Stencils can only be applied by ranges if the tables have offsets
+    bool HasOffsets() const {
+        return _offsets!=0;
     }
 
-    void operator() (tbb::blocked_range<int> const &r) const {
+    void Apply(int start, int end) const {
 
-        assert(_stencils and _ctrlData and _length and _outStride and _outData);
+        CpuComputeLimitStencils(_ctrlDesc, _ctrl, _outDesc, _out,
+            _duDesc, _du, _dvDesc, _dv, _sizes, _offsets, _indices,
+                _weights, _duWeights, _dvWeights, start, end);
+    }
 
-        int offset = _stencils->GetOffsets()[r.begin()];
+    void operator() (tbb::blocked_range<int> const &r) const {
+        Apply(r.begin(), r.end());
+    }
 
-        int const * sizes = &_stencils->GetSizes()[r.begin()],
-                  * index = &_stencils->GetControlIndices()[offset];
+private:
+    VertexBufferDescriptor _ctrlDesc,
+                           _outDesc,
+                           _duDesc,
+                           _dvDesc;
 
-        float const * weight;
+    float const * _ctrl;
 
-        switch (_mode) {
-            case POINT   : weight = &_stencils->GetWeights()[offset]; break;
-            case U_DERIV : weight = &_stencils->GetDuWeights()[offset]; break;
-            case V_DERIV : weight = &_stencils->GetDvWeights()[offset]; break;
-            default:
-                return;
-        }
-        assert( weight);
+    float * _out,
+          * _du,
+          * _dv;
 
-        float * out = _outData + r.begin() * _outStride;
+    unsigned char const * _sizes;
 
-        for (int i=r.begin(); i<r.end(); ++i, ++sizes) {
+    int const * _offsets,
+              * _indices;
 
-            memset( out, 0, _length * sizeof(float) );
+    float const * _weights,
+                * _duWeights,
+                * _dvWeights;
+};
 
-            for (int j=0; j<(*sizes); ++j, ++index, ++weight) {
+// Applies all the stencils in parallel
+class ParallelLimitStencils {
 
-                float const * cv = _ctrlData + (*index)*_ctrlDesc.stride;
+public:
+    ParallelLimitStencils(LimitStencilKernel const & kernel, int nstencils) :
+        _kernel(kernel), _nstencils(nstencils) { }
 
-                for (int k=0; k<_length; ++k) {
-                    out[k] += cv[k] * (*weight);
-                }
-            }
-            out+=_outStride;
-        }
+    void operator() () const {
+        tbb::parallel_for(tbb::blocked_range<int>(0, _nstencils, grain_size), _kernel);
     }
 
 private:
-    Far::StencilTables const * _stencils;
-
-    Mode _mode;
-
-    VertexBufferDescriptor _ctrlDesc;
-    float const * _ctrlData;
-
-    int _length,
-        _outStride;
-
-    float * _outData;
+    LimitStencilKernel const & _kernel;
+    int _nstencils;
 };
 
+} // end namespace unnamed
+
 int
 TbbEvalStencilsController::_UpdateValues( CpuEvalStencilsContext * context ) {
 
-    Far::StencilTables const * stencils = context->GetStencilTables();
-    if (not stencils)
-        return 0;
-
-    int nstencils = stencils->GetNumStencils();
-    if (not nstencils)
-        return 0;
-
-    StencilKernel kernel( stencils, _currentBindState.controlDataDesc,
-                                    _currentBindState.controlData );
-
+    return _Update(context, true, false);
+}
 
-    if (not kernel.SetOutput( StencilKernel::POINT,
-                              _currentBindState.outputDataDesc,
-                              _currentBindState.outputData ))
-        return 0;
+int
+TbbEvalStencilsController::_UpdateDerivs( CpuEvalStencilsContext * context ) {
 
-    tbb::blocked_range<int> range(0, nstencils, grain_size);
+    return _Update(context, false, true);
+}
 
-    tbb::parallel_for(range, kernel);
+int
+TbbEvalStencilsController::_UpdateValuesAndDerivs( CpuEvalStencilsContext * context ) {
 
-    return nstencils;
+    return _Update(context, true, true);
 }
 
 int
-TbbEvalStencilsController::_UpdateDerivs( CpuEvalStencilsContext * context ) {
+TbbEvalStencilsController::_Update( CpuEvalStencilsContext * context,
+    bool values, bool derivs ) {
 
     Far::StencilTables const * stencils = context->GetStencilTables();
-    if (not stencils)
+    Far::LimitStencilTables const * limitStencils = context->GetLimitStencilTables();
+
+    // derivatives require limit stencils
+    if (not stencils or (derivs and not limitStencils))
         return 0;
 
     int nstencils = stencils->GetNumStencils();
     if (not nstencils)
         return 0;
 
-    tbb::blocked_range<int> range(0, nstencils, grain_size);
+    BindState const & bs = _currentBindState;
 
-    StencilKernel kernel( stencils, _currentBindState.controlDataDesc,
-                                    _currentBindState.controlData );
+    VertexBufferDescriptor const & ctrlDesc = bs.controlDataDesc;
 
-    if (not kernel.SetOutput( StencilKernel::U_DERIV,
-                              _currentBindState.outputDuDesc,
-                              _currentBindState.outputUDeriv ) )
+    // make sure that we have control data to work with
+    if (not bs.controlData)
         return 0;
 
-    tbb::parallel_for(range, kernel);
+    float * out = 0,
+          * du = 0,
+          * dv = 0;
 
-    if (not kernel.SetOutput( StencilKernel::V_DERIV,
-                              _currentBindState.outputDvDesc,
-                              _currentBindState.outputVDeriv ) )
-        return 0;
+    if (values) {
+        if (not bs.outputData or not ctrlDesc.CanEval(bs.outputDataDesc))
+            return 0;
+        out = bs.outputData + bs.outputDataDesc.offset;
+    }
+
+    if (derivs) {
+        if (not bs.outputUDeriv or not ctrlDesc.CanEval(bs.outputDuDesc) or
+            not bs.outputVDeriv or not ctrlDesc.CanEval(bs.outputDvDesc))
+            return 0;
+        du = bs.outputUDeriv + bs.outputDuDesc.offset;
+        dv = bs.outputVDeriv + bs.outputDvDesc.offset;
+    }
 
-    tbb::parallel_for(range, kernel);
+    LimitStencilKernel kernel(ctrlDesc, bs.controlData + ctrlDesc.offset,
+        bs.outputDataDesc, out, bs.outputDuDesc, du, bs.outputDvDesc, dv,
+            stencils, limitStencils);
+
+    if (kernel.HasOffsets()) {
+        ParallelLimitStencils parallel(kernel, nstencils);
+#ifdef OSD_TBB_HAS_TASK_ARENA
+        tbb::task_arena arena(_numThreads>0 ? _numThreads : tbb::task_arena::automatic);
+        arena.execute(parallel);
+#else
+        parallel();
+#endif
+    } else {
+        kernel.Apply(0, nstencils);
+    }
 
     return nstencils;
 }
@@ -23,6 +23,7 @@
 //
 
 #include "../osd/cpuKernel.h"
+#include "../osd/cpuSimdKernel.h"
 #include "../osd/tbbKernel.h"
 #include "../osd/vertexDescriptor.h"
 
@@ -72,7 +73,7 @@ copy(float *dst, int dstIndex, const float *src,
 }
 
 
-class TBBStencilKernel {
+template <class INDEX, class WEIGHT> class TBBStencilKernel {
 
     VertexBufferDescriptor _vertexDesc;
     float const * _vertexSrc;
@@ -80,15 +81,15 @@ class TBBStencilKernel {
     float * _vertexDst;
 
     unsigned char const * _sizes;
-    int const * _offsets,
-              * _indices;
-    float const * _weights;
+    int const * _offsets;
+    INDEX const * _indices;
+    WEIGHT const * _weights;
 
 
 public:
     TBBStencilKernel(VertexBufferDescriptor vertexDesc, float const * vertexSrc,
         float * vertexDst, unsigned char const * sizes, int const * offsets,
-            int const * indices, float const * weights ) :
+            INDEX const * indices, WEIGHT const * weights ) :
          _vertexDesc(vertexDesc),
          _vertexSrc(vertexSrc),
          _vertexDst(vertexDst),
@@ -108,19 +109,25 @@ public:
     }
 
     void operator() (tbb::blocked_range<int> const &r) const {
+
+        // Explicit SSE4 / AVX2 / AVX-512 kernels selected at runtime
+        int offset = _offsets[r.begin()];
+        if (SimdComputeStencils(_vertexDesc, _vertexSrc, _vertexDst,
+            _sizes, _indices+offset, _weights+offset, r.begin(), r.end())) {
+            return;
+        }
+
 #define USE_SIMD
 #ifdef USE_SIMD
         if (_vertexDesc.length==4 and _vertexDesc.stride==4) {
 
             // SIMD fast path for aligned primvar data (4 floats)
-            int offset = _offsets[r.begin()];
             ComputeStencilKernel<4>(_vertexSrc, _vertexDst,
                 _sizes, _indices+offset, _weights+offset, r.begin(), r.end());
 
-        } else if (_vertexDesc.length==8 and _vertexDesc.stride==4) {
+        } else if (_vertexDesc.length==8 and _vertexDesc.stride==8) {
 
             // SIMD fast path for aligned primvar data (8 floats)
-            int offset = _offsets[r.begin()];
             ComputeStencilKernel<8>(_vertexSrc, _vertexDst,
                 _sizes, _indices+offset, _weights+offset, r.begin(), r.end());
 
@@ -129,8 +136,8 @@ public:
         {
 #endif                
             unsigned char const * sizes = _sizes;
-            int const * indices = _indices;
-            float const * weights = _weights;
+            INDEX const * indices = _indices;
+            WEIGHT const * weights = _weights;
 
             if (r.begin()>0) {
                 sizes += r.begin();
@@ -146,7 +153,7 @@ public:
                 clear(result, _vertexDesc);
 
                 for (int j=0; j<*sizes; ++j) {
-                    addWithWeight(result, _vertexSrc, *indices++, *weights++, _vertexDesc);
+                    addWithWeight(result, _vertexSrc, *indices++, (float)*weights++, _vertexDesc);
                 }
 
                 copy(_vertexDst, i, result, _vertexDesc);
@@ -155,19 +162,19 @@ public:
     }
 };
 
-void
+template <class INDEX, class WEIGHT> void
 TbbComputeStencils(VertexBufferDescriptor const &vertexDesc,
                       float const * vertexSrc,
                       float * vertexDst,
                       unsigned char const * sizes,
                       int const * offsets,
-                      int const * indices,
-                      float const * weights,
+                      INDEX const * indices,
+                      WEIGHT const * weights,
                       int start, int end) {
 
     assert(start>=0 and start<end);
 
-    TBBStencilKernel kernel(vertexDesc, vertexSrc, vertexDst,
+    TBBStencilKernel<INDEX, WEIGHT> kernel(vertexDesc, vertexSrc, vertexDst,
         sizes, offsets, indices, weights);
 
     tbb::blocked_range<int> range(start, end, grain_size);
@@ -175,6 +182,171 @@ TbbComputeStencils(VertexBufferDescriptor const &vertexDesc,
     tbb::parallel_for(range, kernel);
 }
 
+template <class INDEX, class WEIGHT> class TBBInstanceStencilKernel {
+
+    VertexBufferDescriptor _vertexDesc;
+    InstanceBufferDescriptor _instanceDesc;
+    float const * _vertexSrc;
+
+    float * _vertexDst;
+
+    unsigned char const * _sizes;
+    int const * _offsets;
+    INDEX const * _indices;
+    WEIGHT const * _weights;
+
+public:
+    TBBInstanceStencilKernel(VertexBufferDescriptor vertexDesc,
+        InstanceBufferDescriptor instanceDesc, float const * vertexSrc,
+            float * vertexDst, unsigned char const * sizes, int const * offsets,
+                INDEX const * indices, WEIGHT const * weights ) :
+         _vertexDesc(vertexDesc),
+         _instanceDesc(instanceDesc),
+         _vertexSrc(vertexSrc),
+         _vertexDst(vertexDst),
+         _sizes(sizes),
+         _offsets(offsets),
+         _indices(indices),
+         _weights(weights) { }
+
+    void operator() (tbb::blocked_range<int> const &r) const {
+
+        CpuComputeInstanceStencils(_vertexDesc, _instanceDesc,
+            _vertexSrc, _vertexDst, _sizes, _offsets, _indices, _weights,
+                r.begin(), r.end());
+    }
+};
+
+template <class INDEX, class WEIGHT> void
+TbbComputeInstanceStencils(VertexBufferDescriptor const &vertexDesc,
+                           InstanceBufferDescriptor const &instanceDesc,
+                           float const * vertexSrc,
+                           float * vertexDst,
+                           unsigned char const * sizes,
+                           int const * offsets,
+                           INDEX const * indices,
+                           WEIGHT const * weights,
+                           int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    TBBInstanceStencilKernel<INDEX, WEIGHT> kernel(vertexDesc, instanceDesc,
+        vertexSrc, vertexDst, sizes, offsets, indices, weights);
+
+    // each task already applies its stencils to all the instances
+    tbb::blocked_range<int> range(start, end, grain_size);
+
+    tbb::parallel_for(range, kernel);
+}
+
+class TBBFusedStencilKernel {
+
+    VertexBufferDescriptor _vertexDesc,
+                           _varyingDesc;
+    float const * _vertexSrc,
+                * _varyingSrc;
+
+    float * _vertexDst,
+          * _varyingDst;
+
+    unsigned char const * _sizes,
+                        * _varyingSizes;
+    int const * _offsets,
+              * _varyingOffsets,
+              * _indices;
+    float const * _weights,
+                * _varyingWeights;
+
+public:
+    TBBFusedStencilKernel(VertexBufferDescriptor vertexDesc,
+        float const * vertexSrc, float * vertexDst,
+            VertexBufferDescriptor varyingDesc, float const * varyingSrc,
+                float * varyingDst, unsigned char const * sizes,
+                    int const * offsets, int const * indices,
+                        float const * weights, unsigned char const * varyingSizes,
+                            int const * varyingOffsets, float const * varyingWeights) :
+         _vertexDesc(vertexDesc),
+         _varyingDesc(varyingDesc),
+         _vertexSrc(vertexSrc),
+         _varyingSrc(varyingSrc),
+         _vertexDst(vertexDst),
+         _varyingDst(varyingDst),
+         _sizes(sizes),
+         _varyingSizes(varyingSizes),
+         _offsets(offsets),
+         _varyingOffsets(varyingOffsets),
+         _indices(indices),
+         _weights(weights),
+         _varyingWeights(varyingWeights) { }
+
+    void operator() (tbb::blocked_range<int> const &r) const {
+
+        CpuComputeFusedStencils(_vertexDesc, _vertexSrc, _vertexDst,
+            _varyingDesc, _varyingSrc, _varyingDst, _sizes, _offsets,
+                _indices, _weights, _varyingSizes, _varyingOffsets,
+                    _varyingWeights, r.begin(), r.end());
+    }
+};
+
+void
+TbbComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                        float const * vertexSrc,
+                        float * vertexDst,
+                        VertexBufferDescriptor const &varyingDesc,
+                        float const * varyingSrc,
+                        float * varyingDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        unsigned char const * varyingSizes,
+                        int const * varyingOffsets,
+                        float const * varyingWeights,
+                        int start, int end) {
+
+    assert(start>=0 and start<end);
+
+    TBBFusedStencilKernel kernel(vertexDesc, vertexSrc, vertexDst,
+        varyingDesc, varyingSrc, varyingDst, sizes, offsets, indices,
+            weights, varyingSizes, varyingOffsets, varyingWeights);
+
+    tbb::blocked_range<int> range(start, end, grain_size);
+
+    tbb::parallel_for(range, kernel);
+}
+
+template void TbbComputeStencils<int, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        int const *, float const *, int, int);
+
+template void TbbComputeStencils<int, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        int const *, Far::Half const *, int, int);
+
+template void TbbComputeStencils<unsigned short, float>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        unsigned short const *, float const *, int, int);
+
+template void TbbComputeStencils<unsigned short, Far::Half>(VertexBufferDescriptor const &,
+    float const *, float *, unsigned char const *, int const *,
+        unsigned short const *, Far::Half const *, int, int);
+
+template void TbbComputeInstanceStencils<int, float>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, int const *, float const *, int, int);
+
+template void TbbComputeInstanceStencils<int, Far::Half>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, int const *, Far::Half const *, int, int);
+
+template void TbbComputeInstanceStencils<unsigned short, float>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, unsigned short const *, float const *, int, int);
+
+template void TbbComputeInstanceStencils<unsigned short, Far::Half>(VertexBufferDescriptor const &,
+    InstanceBufferDescriptor const &, float const *, float *,
+        unsigned char const *, int const *, unsigned short const *, Far::Half const *, int, int);
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
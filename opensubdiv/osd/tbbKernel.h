@@ -27,23 +27,56 @@
 
 #include "../version.h"
 
+#include "../far/compactStencilTables.h"
+
 namespace OpenSubdiv {
 namespace OPENSUBDIV_VERSION {
 
 namespace Osd {
 
 struct VertexBufferDescriptor;
+struct InstanceBufferDescriptor;
 
-void
+// Same instantiations as CpuComputeStencils()
+template <class INDEX, class WEIGHT> void
 TbbComputeStencils(VertexBufferDescriptor const &vertexDesc,
                    float const * vertexSrc,
                    float * vertexDst,
                    unsigned char const * sizes,
                    int const * offsets,
-                   int const * indices,
-                   float const * weights,
+                   INDEX const * indices,
+                   WEIGHT const * weights,
                    int start, int end);
 
+// Same instantiations as CpuComputeStencils()
+template <class INDEX, class WEIGHT> void
+TbbComputeInstanceStencils(VertexBufferDescriptor const &vertexDesc,
+                           InstanceBufferDescriptor const &instanceDesc,
+                           float const * vertexSrc,
+                           float * vertexDst,
+                           unsigned char const * sizes,
+                           int const * offsets,
+                           INDEX const * indices,
+                           WEIGHT const * weights,
+                           int start, int end);
+
+// Same as CpuComputeFusedStencils()
+void
+TbbComputeFusedStencils(VertexBufferDescriptor const &vertexDesc,
+                        float const * vertexSrc,
+                        float * vertexDst,
+                        VertexBufferDescriptor const &varyingDesc,
+                        float const * varyingSrc,
+                        float * varyingDst,
+                        unsigned char const * sizes,
+                        int const * offsets,
+                        int const * indices,
+                        float const * weights,
+                        unsigned char const * varyingSizes,
+                        int const * varyingOffsets,
+                        float const * varyingWeights,
+                        int start, int end);
+
 }  // end namespace Osd
 
 }  // end namespace OPENSUBDIV_VERSION
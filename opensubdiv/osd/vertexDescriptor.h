@@ -72,6 +72,36 @@ struct VertexBufferDescriptor {
     int stride;  // stride to the next element
 };
 
+/// \brief Describes instances of a primvar buffer sharing the same topology
+///
+/// The control vertices of instance 'i' start 'i*srcStride' floats after the
+/// ones of instance 0, and its refined vertices 'i*dstStride' floats after
+/// the refined vertices of instance 0.
+///
+struct InstanceBufferDescriptor {
+
+    /// Default Constructor
+    InstanceBufferDescriptor() : numInstances(0), srcStride(0), dstStride(0) { }
+
+    /// Constructor
+    InstanceBufferDescriptor(int n, int src, int dst) :
+        numInstances(n), srcStride(src), dstStride(dst) { }
+
+    /// True if the descriptor values are internally consistent
+    bool IsValid() const {
+        return (numInstances>0 and srcStride>=0 and dstStride>=0);
+    }
+
+    /// Resets the descriptor to default
+    void Reset() {
+        numInstances = srcStride = dstStride = 0;
+    }
+
+    int numInstances;  // number of instances
+    int srcStride;     // floats between the control vertices of 2 instances
+    int dstStride;     // floats between the refined vertices of 2 instances
+};
+
 } // end namespace Osd
 
 } // end namespace OPENSUBDIV_VERSION
@@ -27,13 +27,13 @@
 #include "../vtr/level.h"
 #include "../vtr/refinement.h"
 #include "../vtr/fvarLevel.h"
+#include "../vtr/parallel.h"
 
 #include <cassert>
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
 #include <vector>
-#include <map>
 
 
 //
@@ -769,7 +769,7 @@ Level::gatherQuadRegularCornerPatchVertices(
 
 
 //
-//  What follows is an internal/anonymous class and protected methods to complete all
+//  What follows are internal/anonymous kernels and protected methods to complete all
 //  topological relations when only the face-vertex relations is defined.
 //
 //  In keeping with the original idea that Level is just data and relies on other
@@ -777,165 +777,89 @@ Level::gatherQuadRegularCornerPatchVertices(
 //  collectively unclear as to where that should be at present.  In the meantime, the
 //  implementation is provided here so that we can test and make use of it.
 //
+//  Rather than searching the edges of each vertex for every face-vertex (which degrades
+//  quickly with the valence of the vertices), each "slot" of the face-vertex relation --
+//  a vertex of a face and the leading edge of the face at that vertex -- is bucketed by
+//  the lower of the two vertices of its edge.  The slots sharing an edge are then found
+//  within each bucket independently, and the remaining relations are assembled as simple
+//  counting sorts, preserving the order in which the faces are traversed (so the result
+//  is identical to the incremental construction of the relations).
+//
 namespace {
-    //
-    //  This is an internal helper class to manage the assembly of the tological relations
-    //  that do not have a predictable size, i.e. faces-per-edge, faces-per-vertex and
-    //  edges-per-vertex.  Level manages these with two vectors:
-    //
-    //      - a vector of integer pairs for the "counts" and "offsets"
-    //      - a vector of incident members accessed by the "offset" of each
-    //
-    //  The "dynamic relation" allocates the latter vector of members based on a typical
-    //  number of members per component, e.g. we expect valence 4 vertices in a typical
-    //  quad-mesh, and so an "expected" number might be 6 to accomodate a few x-ordinary
-    //  vertices.  The member vector is allocated with this number per component and the
-    //  counts and offsets initialized to refer to them -- but with the counts set to 0.
-    //  The count will be incremented as members are identified and entered, and if any
-    //  component "overflows" the expected number of members, the members are moved to a
-    //  separate vector in an std::map for the component.
-    //
-    //  Once all incident members have been added, the main vector is compressed and may
-    //  need to merge entries from the map in the process.
-    //
-    typedef std::map<Index, IndexVector> IrregIndexMap;
-
-    class DynamicRelation {
-    public:
-        DynamicRelation(IndexVector& countAndOffsets, IndexVector& indices, int membersPerComp);
-        ~DynamicRelation() { }
-
-    public:
-        //  Methods dealing with the members for each component:
-        IndexArray getCompMembers(Index index);
-        void          appendCompMember(Index index, Index member);
+    const int completeGrainSize = 2048;
 
-        //  Methods dealing with the components:
-        void appendComponent();
-        void compressMemberIndices();
+    //  Buckets with more slots than this are sorted rather than searched linearly:
+    const int maxEdgeSlotsSearched = 32;
 
+    //
+    //  Identifies for each slot of the buckets of a range of vertices the first slot (in
+    //  face order) sharing its edge -- the slots of each bucket being in face order and
+    //  paired with the other (higher) vertex of their edges:
+    //
+    class EdgeSlotsKernel : public ParallelKernel {
     public:
-        int _compCount;
-        int _memberCountPerComp;
-
-        IndexVector & _countsAndOffsets;
-        IndexVector & _regIndices;
-
-        IrregIndexMap _irregIndices;
-    };
-
-    inline
-    DynamicRelation::DynamicRelation(IndexVector& countAndOffsets, IndexVector& indices, int membersPerComp) :
-            _compCount(0),
-            _memberCountPerComp(membersPerComp),
-            _countsAndOffsets(countAndOffsets),
-            _regIndices(indices) {
-
-        _compCount = (int) _countsAndOffsets.size() / 2;
-
-        for (int i = 0; i < _compCount; ++i) {
-            _countsAndOffsets[2*i]   = 0;
-            _countsAndOffsets[2*i+1] = i * _memberCountPerComp;
-        }
-        _regIndices.resize(_compCount * _memberCountPerComp);
-    }
-
-    inline IndexArray
-    DynamicRelation::getCompMembers(Index compIndex) {
-
-        int count = _countsAndOffsets[2*compIndex];
-        if (count > _memberCountPerComp) {
-            IndexVector & irregMembers = _irregIndices[compIndex];
-            return IndexArray(&irregMembers[0], (int)irregMembers.size());
-        } else {
-            int offset = _countsAndOffsets[2*compIndex+1];
-            return IndexArray(&_regIndices[offset], count);
-        }
-    }
-    inline void
-    DynamicRelation::appendCompMember(Index compIndex, Index memberValue) {
-
-        int count  = _countsAndOffsets[2*compIndex];
-        int offset = _countsAndOffsets[2*compIndex+1];
-
-        if (count < _memberCountPerComp) {
-            _regIndices[offset + count] = memberValue;
-        } else {
-            IndexVector& irregMembers = _irregIndices[compIndex];
-
-            if (count > _memberCountPerComp) {
-                irregMembers.push_back(memberValue);
-            } else {
-                irregMembers.resize(_memberCountPerComp + 1);
-                std::memcpy(&irregMembers[0], &_regIndices[offset], sizeof(Index) * _memberCountPerComp);
-                irregMembers[_memberCountPerComp] = memberValue;
+        EdgeSlotsKernel(Index const * bucketCountsAndOffsets, Index const * bucketSlots,
+                        Index const * bucketOtherVerts, Index * firstSlots) :
+            _bucketCountsAndOffsets(bucketCountsAndOffsets), _bucketSlots(bucketSlots),
+            _bucketOtherVerts(bucketOtherVerts), _firstSlots(firstSlots) { }
+
+        virtual void operator()(Index begin, Index end) const {
+            std::vector<std::pair<Index, Index> > sortedSlots;
+
+            for (Index vIndex = begin; vIndex < end; ++vIndex) {
+                int           count  = _bucketCountsAndOffsets[2*vIndex];
+                int           offset = _bucketCountsAndOffsets[2*vIndex + 1];
+                Index const * slots  = _bucketSlots + offset;
+                Index const * others = _bucketOtherVerts + offset;
+
+                if (count <= maxEdgeSlotsSearched) {
+                    for (int i = 0; i < count; ++i) {
+                        Index first = slots[i];
+                        for (int j = 0; j < i; ++j) {
+                            if (others[j] == others[i]) {
+                                first = slots[j];
+                                break;
+                            }
+                        }
+                        _firstSlots[slots[i]] = first;
+                    }
+                } else {
+                    sortedSlots.resize(count);
+                    for (int i = 0; i < count; ++i) {
+                        sortedSlots[i] = std::make_pair(others[i], slots[i]);
+                    }
+                    std::sort(sortedSlots.begin(), sortedSlots.end());
+
+                    Index first = INDEX_INVALID;
+                    for (int i = 0; i < count; ++i) {
+                        if ((i == 0) || (sortedSlots[i].first != sortedSlots[i-1].first)) {
+                            first = sortedSlots[i].second;
+                        }
+                        _firstSlots[sortedSlots[i].second] = first;
+                    }
+                }
             }
         }
-        _countsAndOffsets[2*compIndex] ++;
-    }
-    inline void
-    DynamicRelation::appendComponent() {
-
-        _countsAndOffsets.push_back(0);
-        _countsAndOffsets.push_back(_compCount * _memberCountPerComp);
 
-        ++ _compCount;
-        _regIndices.resize(_compCount * _memberCountPerComp);
-    }
-    void
-    DynamicRelation::compressMemberIndices() {
-
-        if (_irregIndices.size() == 0) {
-            int memberCount = _countsAndOffsets[0];
-            for (int i = 1; i < _compCount; ++i) {
-                int count  = _countsAndOffsets[2*i];
-                int offset = _countsAndOffsets[2*i + 1];
-
-                memmove(&_regIndices[memberCount], &_regIndices[offset], count * sizeof(Index));
-
-                _countsAndOffsets[2*i + 1] = memberCount;
-                memberCount += count;
-            }
-            _regIndices.resize(memberCount);
-        } else {
-            //  Assign new offsets-per-component while determining if we can trivially compressed in place:
-            bool cannotBeCompressedInPlace = false;
-
-            int memberCount = _countsAndOffsets[0];
-            for (int i = 1; i < _compCount; ++i) {
-                _countsAndOffsets[2*i + 1] = memberCount;
-
-                cannotBeCompressedInPlace |= (memberCount > (_memberCountPerComp * i));
-
-                memberCount += _countsAndOffsets[2*i];
-            }
-            cannotBeCompressedInPlace |= (memberCount > (_memberCountPerComp * _compCount));
+    private:
+        Index const * _bucketCountsAndOffsets;
+        Index const * _bucketSlots;
+        Index const * _bucketOtherVerts;
+        Index       * _firstSlots;
+    };
 
-            //  Copy members into the original or temporary vector accordingly:
-            IndexVector  tmpIndices;
-            if (cannotBeCompressedInPlace) {
-                tmpIndices.resize(memberCount);
-            }
-            IndexVector& dstIndices = cannotBeCompressedInPlace ? tmpIndices : _regIndices;
-            for (int i = 0; i < _compCount; ++i) {
-                int count = _countsAndOffsets[2*i];
-
-                Index *dstMembers = &dstIndices[_countsAndOffsets[2*i + 1]];
-                Index *srcMembers = (count <= _memberCountPerComp)
-                                     ? &_regIndices[i * _memberCountPerComp]
-                                     : &_irregIndices[i][0];
-                memmove(dstMembers, srcMembers, count * sizeof(Index));
-            }
-            if (cannotBeCompressedInPlace) {
-                _regIndices.swap(tmpIndices);
-            } else {
-                _regIndices.resize(memberCount);
-            }
+    //
+    //  Clears the counts of a vector of (count, offset) pairs once scanned, so that the
+    //  members can be assigned while recounting them:
+    //
+    inline void
+    clearCounts(IndexVector& countsAndOffsets) {
+        for (int i = 0; i < (int)countsAndOffsets.size(); i += 2) {
+            countsAndOffsets[i] = 0;
         }
     }
 }
 
-
 //
 //  Methods to populate the missing topology relations of the Level:
 //
@@ -966,7 +890,7 @@ Level::findEdge(Index v0Index, Index v1Index) const {
 }
 
 void
-Level::completeTopologyFromFaceVertices() {
+Level::completeTopologyFromFaceVertices(ThreadingType threading) {
 
     //
     //  Its assumed (a pre-condition) that face-vertices have been fully specified and that we
@@ -988,64 +912,133 @@ Level::completeTopologyFromFaceVertices() {
     this->resizeEdges(0);
 
     //
-    //  Resize face-edges to match face-verts and reserve for edges based on an estimate:
+    //  Resize face-edges to match face-verts -- both are indexed by "slot":
     //
-    this->_faceEdgeIndices.resize(this->getNumFaceVerticesTotal());
+    int slotCount = this->getNumFaceVerticesTotal();
 
-    int eCountEstimate = (vCount << 1);
-
-    this->_edgeVertIndices.reserve(eCountEstimate * 2);
-    this->_edgeFaceIndices.reserve(eCountEstimate * 2);
-
-    this->_edgeFaceCountsAndOffsets.reserve(eCountEstimate * 2);
+    this->_faceEdgeIndices.resize(slotCount);
 
     //
-    //  Create the dynamic relations to be populated (edge-faces will remain empty as reserved
-    //  above since there are currently no edges) and iterate through the faces to do so:
+    //  Count the slots of the bucket of each vertex along with the faces incident each
+    //  vertex, then assign the slots to the buckets and the vertex-faces in face order:
     //
-    const int avgSize = 6;
+    IndexVector bucketCountsAndOffsets(2 * vCount, 0);
 
-    DynamicRelation dynEdgeFaces(this->_edgeFaceCountsAndOffsets, this->_edgeFaceIndices, 2);
-    DynamicRelation dynVertFaces(this->_vertFaceCountsAndOffsets, this->_vertFaceIndices, avgSize);
-    DynamicRelation dynVertEdges(this->_vertEdgeCountsAndOffsets, this->_vertEdgeIndices, avgSize);
+    std::fill(this->_vertFaceCountsAndOffsets.begin(), this->_vertFaceCountsAndOffsets.end(), 0);
 
     for (Index fIndex = 0; fIndex < fCount; ++fIndex) {
         IndexArray fVerts = this->getFaceVertices(fIndex);
-        IndexArray fEdges = this->getFaceEdges(fIndex);
 
         for (int i = 0; i < fVerts.size(); ++i) {
             Index v0Index = fVerts[i];
-            Index v1Index = fVerts[(i+1) % fVerts.size()];
+            Index v1Index = fVerts[(i + 1) < fVerts.size() ? (i + 1) : 0];
+
+            bucketCountsAndOffsets[2*std::min(v0Index, v1Index)] ++;
+            this->_vertFaceCountsAndOffsets[2*v0Index] ++;
+        }
+        _maxValence = std::max(_maxValence, fVerts.size());
+    }
+    scanCountsAndOffsets(threading, bucketCountsAndOffsets, completeGrainSize);
+    this->resizeVertexFaces(scanCountsAndOffsets(threading, this->_vertFaceCountsAndOffsets, completeGrainSize));
+
+    clearCounts(bucketCountsAndOffsets);
+    clearCounts(this->_vertFaceCountsAndOffsets);
+
+    IndexVector bucketSlots(slotCount);
+    IndexVector bucketOtherVerts(slotCount);
+
+    for (Index fIndex = 0, slot = 0; fIndex < fCount; ++fIndex) {
+        IndexArray fVerts = this->getFaceVertices(fIndex);
+
+        for (int i = 0; i < fVerts.size(); ++i, ++slot) {
+            Index v0Index = fVerts[i];
+            Index v1Index = fVerts[(i + 1) < fVerts.size() ? (i + 1) : 0];
 
-            //  Look for the edge in v0's incident edge members:
-            IndexArray v0Edges = dynVertEdges.getCompMembers(v0Index);
+            Index vLow  = std::min(v0Index, v1Index);
+            int   bSlot = bucketCountsAndOffsets[2*vLow + 1] + bucketCountsAndOffsets[2*vLow] ++;
 
-            Index eIndex = this->findEdge(v0Index, v1Index, v0Edges);
+            bucketSlots[bSlot]      = slot;
+            bucketOtherVerts[bSlot] = std::max(v0Index, v1Index);
 
-            //  If no edge found, create/append a new one:
-            if (!IndexIsValid(eIndex)) {
-                eIndex = (Index) this->_edgeCount;
+            this->_vertFaceIndices[this->_vertFaceCountsAndOffsets[2*v0Index + 1] +
+                                   this->_vertFaceCountsAndOffsets[2*v0Index] ++] = fIndex;
+        }
+    }
 
-                this->_edgeCount ++;
-                this->_edgeVertIndices.push_back(v0Index);
-                this->_edgeVertIndices.push_back(v1Index);
+    IndexVector firstSlots(slotCount);
 
-                dynEdgeFaces.appendComponent();
+    parallelFor(threading, 0, vCount, completeGrainSize,
+                EdgeSlotsKernel(&bucketCountsAndOffsets[0], &bucketSlots[0],
+                                &bucketOtherVerts[0], &firstSlots[0]));
 
-                dynVertEdges.appendCompMember(v0Index, eIndex);
-                dynVertEdges.appendCompMember(v1Index, eIndex);
+    //
+    //  Edges are numbered in the order of their first slots, i.e. the order in which they
+    //  are first encountered traversing the faces, and oriented as in that first face.  The
+    //  faces incident each edge and the edges incident each vertex are counted as well:
+    //
+    eCount = 0;
+    for (Index slot = 0; slot < slotCount; ++slot) {
+        eCount += (firstSlots[slot] == slot);
+    }
+    this->resizeEdges(eCount);
+    this->resizeEdgeVertices();
+
+    std::fill(this->_vertEdgeCountsAndOffsets.begin(), this->_vertEdgeCountsAndOffsets.end(), 0);
+
+    Index eNext = 0;
+    for (Index fIndex = 0, slot = 0; fIndex < fCount; ++fIndex) {
+        IndexArray fVerts = this->getFaceVertices(fIndex);
+
+        for (int i = 0; i < fVerts.size(); ++i, ++slot) {
+            Index eIndex;
+            if (firstSlots[slot] == slot) {
+                Index v0Index = fVerts[i];
+                Index v1Index = fVerts[(i + 1) < fVerts.size() ? (i + 1) : 0];
+
+                eIndex = eNext ++;
+
+                this->_edgeVertIndices[2*eIndex]     = v0Index;
+                this->_edgeVertIndices[2*eIndex + 1] = v1Index;
+
+                this->_vertEdgeCountsAndOffsets[2*v0Index] ++;
+                this->_vertEdgeCountsAndOffsets[2*v1Index] ++;
+            } else {
+                eIndex = this->_faceEdgeIndices[firstSlots[slot]];
             }
-            dynEdgeFaces.appendCompMember(eIndex,  fIndex);
-            dynVertFaces.appendCompMember(v0Index, fIndex);
+            this->_faceEdgeIndices[slot] = eIndex;
 
-            fEdges[i] = eIndex;
+            this->_edgeFaceCountsAndOffsets[2*eIndex] ++;
         }
-        _maxValence = std::max(_maxValence, fVerts.size());
     }
 
-    dynEdgeFaces.compressMemberIndices();
-    dynVertFaces.compressMemberIndices();
-    dynVertEdges.compressMemberIndices();
+    //
+    //  Assign the edge-faces (in face order) and the vertex-edges (in edge order):
+    //
+    this->resizeEdgeFaces(scanCountsAndOffsets(threading, this->_edgeFaceCountsAndOffsets, completeGrainSize));
+
+    clearCounts(this->_edgeFaceCountsAndOffsets);
+
+    for (Index fIndex = 0, slot = 0; fIndex < fCount; ++fIndex) {
+        int fSize = this->getNumFaceVertices(fIndex);
+
+        for (int i = 0; i < fSize; ++i, ++slot) {
+            Index eIndex = this->_faceEdgeIndices[slot];
+
+            this->_edgeFaceIndices[this->_edgeFaceCountsAndOffsets[2*eIndex + 1] +
+                                   this->_edgeFaceCountsAndOffsets[2*eIndex] ++] = fIndex;
+        }
+    }
+
+    this->resizeVertexEdges(scanCountsAndOffsets(threading, this->_vertEdgeCountsAndOffsets, completeGrainSize));
+
+    clearCounts(this->_vertEdgeCountsAndOffsets);
+
+    for (int i = 0; i < 2 * eCount; ++i) {
+        Index vIndex = this->_edgeVertIndices[i];
+
+        this->_vertEdgeIndices[this->_vertEdgeCountsAndOffsets[2*vIndex + 1] +
+                               this->_vertEdgeCountsAndOffsets[2*vIndex] ++] = i >> 1;
+    }
 
     //
     //  At this point all incident members are associated with each component.  We now need
@@ -1057,10 +1050,6 @@ Level::completeTopologyFromFaceVertices() {
     //  better of orienting to determine manifold status and then computing local indices
     //  according to the manifold status.
     //
-    //  Resize edges with the Level to ensure anything else related to edges is created:
-    eCount = this->getNumEdges();
-    this->resizeEdges(eCount);
-
     for (Index eIndex = 0; eIndex < eCount; ++eIndex) {
         Level::ETag& eTag = this->_edgeTags[eIndex];
 
@@ -1085,23 +1074,35 @@ Level::completeTopologyFromFaceVertices() {
             this->_vertTags[eVerts[1]]._nonManifold = true;
         }
     }
-    orientIncidentComponents();
+    orientIncidentComponents(threading);
 
-    populateLocalIndices();
+    populateLocalIndices(threading);
 }
 
 void
-Level::populateLocalIndices() {
+Level::populateLocalIndices(ThreadingType threading) {
 
     //
-    //  We have two sets of local indices -- vert-faces and vert-edges:
+    //  We have two sets of local indices -- vert-faces and vert-edges -- populated
+    //  independently for each vertex:
     //
     int vCount = this->getNumVertices();
 
     this->_vertFaceLocalIndices.resize(this->_vertFaceIndices.size());
     this->_vertEdgeLocalIndices.resize(this->_vertEdgeIndices.size());
 
+    parallelFor(threading, 0, vCount, completeGrainSize,
+                ParallelMethodKernel<Level>(*this, &Level::populateLocalIndicesInRange));
+
     for (Index vIndex = 0; vIndex < vCount; ++vIndex) {
+        _maxValence = std::max(_maxValence, this->getNumVertexEdges(vIndex));
+    }
+}
+
+void
+Level::populateLocalIndicesInRange(Index vBegin, Index vEnd) {
+
+    for (Index vIndex = vBegin; vIndex < vEnd; ++vIndex) {
         IndexArray      vFaces   = this->getVertexFaces(vIndex);
         LocalIndexArray vInFaces = this->getVertexFaceLocalIndices(vIndex);
 
@@ -1113,7 +1114,7 @@ Level::populateLocalIndices() {
         }
     }
 
-    for (Index vIndex = 0; vIndex < vCount; ++vIndex) {
+    for (Index vIndex = vBegin; vIndex < vEnd; ++vIndex) {
         IndexArray      vEdges   = this->getVertexEdges(vIndex);
         LocalIndexArray vInEdges = this->getVertexEdgeLocalIndices(vIndex);
 
@@ -1122,16 +1123,21 @@ Level::populateLocalIndices() {
 
             vInEdges[i] = (vIndex == eVerts[1]);
         }
-        _maxValence = std::max(_maxValence, vEdges.size());
     }
 }
 
 void
-Level::orientIncidentComponents() {
+Level::orientIncidentComponents(ThreadingType threading) {
 
-    int vCount = this->getNumVertices();
+    //  Each vertex only reorders its own incident faces and edges:
+    parallelFor(threading, 0, this->getNumVertices(), completeGrainSize,
+                ParallelMethodKernel<Level>(*this, &Level::orientIncidentComponentsInRange));
+}
 
-    for (Index vIndex = 0; vIndex < vCount; ++vIndex) {
+void
+Level::orientIncidentComponentsInRange(Index vBegin, Index vEnd) {
+
+    for (Index vIndex = vBegin; vIndex < vEnd; ++vIndex) {
         Level::VTag vTag = this->_vertTags[vIndex];
 
         if (!vTag._nonManifold) {
@@ -30,6 +30,7 @@
 #include "../sdc/crease.h"
 #include "../sdc/options.h"
 #include "../vtr/types.h"
+#include "../vtr/parallel.h"
 
 #include <algorithm>
 #include <vector>
@@ -336,13 +337,16 @@ protected:
     //  externally (either a Factory outside Vtr or another Vtr construction helper), but
     //  until we decide where, the required implementation is defined here.
     //
-    void completeTopologyFromFaceVertices();
+    void completeTopologyFromFaceVertices(ThreadingType threading = THREADING_SERIAL);
     Index findEdge(Index v0, Index v1, IndexArray const& v0Edges) const;
 
-    //  Methods supporting the above:
-    void orientIncidentComponents();
+    //  Methods supporting the above (the "InRange" variants being applied to ranges of
+    //  vertices by the given threading backend):
+    void orientIncidentComponents(ThreadingType threading = THREADING_SERIAL);
+    void orientIncidentComponentsInRange(Index vBegin, Index vEnd);
     bool orderVertexFacesAndEdges(int vIndex);
-    void populateLocalIndices();
+    void populateLocalIndices(ThreadingType threading = THREADING_SERIAL);
+    void populateLocalIndicesInRange(Index vBegin, Index vEnd);
 
 protected:
     //  Its debatable whether we should retain a Type or Options associated with
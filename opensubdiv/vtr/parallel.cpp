@@ -0,0 +1,221 @@
+//
+//   Copyright 2014 DreamWorks Animation LLC.
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+#include "../vtr/parallel.h"
+
+#include <algorithm>
+#include <vector>
+
+#ifdef OPENSUBDIV_HAS_TBB
+    #include <tbb/blocked_range.h>
+    #include <tbb/parallel_for.h>
+#endif
+
+#ifdef OPENSUBDIV_HAS_OPENMP
+    #include <omp.h>
+#endif
+
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Vtr {
+
+#ifdef OPENSUBDIV_HAS_TBB
+namespace {
+    //
+    //  Adapter for the TBB parallel_for -- TBB requires a copyable functor taking a
+    //  blocked_range, so simply forward its range to the referenced kernel:
+    //
+    class TbbParallelKernel {
+    public:
+        TbbParallelKernel(ParallelKernel const& kernel) : _kernel(kernel) { }
+
+        void operator()(tbb::blocked_range<Index> const& range) const {
+            _kernel(range.begin(), range.end());
+        }
+
+    private:
+        ParallelKernel const& _kernel;
+    };
+}
+#endif
+
+namespace {
+    //
+    //  Kernels for the two passes of the scan of counts/offsets -- both iterate over
+    //  ranges of chunks rather than ranges of the pairs themselves:
+    //
+    class SumCountsKernel : public ParallelKernel {
+    public:
+        SumCountsKernel(int const* countsAndOffsets, int numPairs, int chunkSize, int* chunkSums) :
+            _countsAndOffsets(countsAndOffsets), _numPairs(numPairs), _chunkSize(chunkSize),
+            _chunkSums(chunkSums) { }
+
+        virtual void operator()(Index chunkBegin, Index chunkEnd) const {
+            for (Index chunk = chunkBegin; chunk < chunkEnd; ++chunk) {
+                int pairBegin = chunk * _chunkSize;
+                int pairEnd   = std::min(pairBegin + _chunkSize, _numPairs);
+
+                int sum = 0;
+                for (int i = pairBegin; i < pairEnd; ++i) {
+                    sum += _countsAndOffsets[2*i];
+                }
+                _chunkSums[chunk] = sum;
+            }
+        }
+
+    private:
+        int const* _countsAndOffsets;
+        int        _numPairs;
+        int        _chunkSize;
+        int*       _chunkSums;
+    };
+
+    class AssignOffsetsKernel : public ParallelKernel {
+    public:
+        AssignOffsetsKernel(int* countsAndOffsets, int numPairs, int chunkSize, int const* chunkOffsets) :
+            _countsAndOffsets(countsAndOffsets), _numPairs(numPairs), _chunkSize(chunkSize),
+            _chunkOffsets(chunkOffsets) { }
+
+        virtual void operator()(Index chunkBegin, Index chunkEnd) const {
+            for (Index chunk = chunkBegin; chunk < chunkEnd; ++chunk) {
+                int pairBegin = chunk * _chunkSize;
+                int pairEnd   = std::min(pairBegin + _chunkSize, _numPairs);
+
+                int offset = _chunkOffsets[chunk];
+                for (int i = pairBegin; i < pairEnd; ++i) {
+                    _countsAndOffsets[2*i + 1] = offset;
+                    offset += _countsAndOffsets[2*i];
+                }
+            }
+        }
+
+    private:
+        int*       _countsAndOffsets;
+        int        _numPairs;
+        int        _chunkSize;
+        int const* _chunkOffsets;
+    };
+}
+
+bool
+isThreadingSupported(ThreadingType threading) {
+
+    switch (threading) {
+        case THREADING_SERIAL:
+            return true;
+#ifdef OPENSUBDIV_HAS_TBB
+        case THREADING_TBB:
+            return true;
+#endif
+#ifdef OPENSUBDIV_HAS_OPENMP
+        case THREADING_OMP:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+void
+parallelFor(ThreadingType threading, Index begin, Index end, int grainSize,
+            ParallelKernel const& kernel) {
+
+    if (end <= begin) return;
+
+    if (grainSize < 1) grainSize = 1;
+
+    //  Not worth the overhead of the threading backend for a single chunk:
+    if ((end - begin) <= grainSize) threading = THREADING_SERIAL;
+
+    switch (threading) {
+#ifdef OPENSUBDIV_HAS_TBB
+        case THREADING_TBB:
+            tbb::parallel_for(tbb::blocked_range<Index>(begin, end, grainSize),
+                              TbbParallelKernel(kernel));
+            return;
+#endif
+#ifdef OPENSUBDIV_HAS_OPENMP
+        case THREADING_OMP: {
+            int numChunks = (end - begin + grainSize - 1) / grainSize;
+
+#pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < numChunks; ++i) {
+                Index chunkBegin = begin + i * grainSize;
+                Index chunkEnd   = std::min(chunkBegin + grainSize, end);
+
+                kernel(chunkBegin, chunkEnd);
+            }
+            return;
+        }
+#endif
+        default:
+            kernel(begin, end);
+            return;
+    }
+}
+
+int
+scanCountsAndOffsets(ThreadingType threading, IndexVector& countsAndOffsets, int grainSize) {
+
+    int numPairs = (int)countsAndOffsets.size() / 2;
+    if (numPairs == 0) return 0;
+
+    if (grainSize < 1) grainSize = 1;
+
+    int numChunks = (numPairs + grainSize - 1) / grainSize;
+
+    //  A single pass is all that is needed when not distributing the chunks:
+    if ((threading == THREADING_SERIAL) || (numChunks == 1) || !isThreadingSupported(threading)) {
+        int offset = 0;
+        for (int i = 0; i < numPairs; ++i) {
+            countsAndOffsets[2*i + 1] = offset;
+            offset += countsAndOffsets[2*i];
+        }
+        return offset;
+    }
+
+    std::vector<int> chunkOffsets(numChunks);
+
+    parallelFor(threading, 0, numChunks, 1,
+                SumCountsKernel(&countsAndOffsets[0], numPairs, grainSize, &chunkOffsets[0]));
+
+    //  The number of chunks is small enough to scan their sums serially:
+    int total = 0;
+    for (int chunk = 0; chunk < numChunks; ++chunk) {
+        int chunkSum = chunkOffsets[chunk];
+        chunkOffsets[chunk] = total;
+        total += chunkSum;
+    }
+
+    parallelFor(threading, 0, numChunks, 1,
+                AssignOffsetsKernel(&countsAndOffsets[0], numPairs, grainSize, &chunkOffsets[0]));
+
+    return total;
+}
+
+} // end namespace Vtr
+
+} // end namespace OPENSUBDIV_VERSION
+} // end namespace OpenSubdiv
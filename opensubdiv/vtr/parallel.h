@@ -0,0 +1,102 @@
+//
+//   Copyright 2014 DreamWorks Animation LLC.
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+#ifndef VTR_PARALLEL_H
+#define VTR_PARALLEL_H
+
+#include "../version.h"
+
+#include "../vtr/types.h"
+
+namespace OpenSubdiv {
+namespace OPENSUBDIV_VERSION {
+
+namespace Vtr {
+
+//
+//  A minimal parallel-for used to distribute the loops over components within Vtr
+//  (and the Far classes that build on it) across threads.
+//
+//  The backends mirror the tbb* and omp* split of the compute kernels in Osd and
+//  are only available when the library was built with the corresponding dependency
+//  (OPENSUBDIV_HAS_TBB and OPENSUBDIV_HAS_OPENMP) -- requesting one that is not
+//  available silently falls back to the serial loop.
+//
+//  The work to be done is expressed as a kernel applied to a range [begin, end) of
+//  component indices.  The range is partitioned into chunks of (at least) the given
+//  grain size, so kernels must only write to data owned by the components in their
+//  range for the result to be deterministic and identical to the serial loop.
+//
+enum ThreadingType {
+    THREADING_SERIAL = 0,
+    THREADING_TBB,
+    THREADING_OMP
+};
+
+bool isThreadingSupported(ThreadingType threading);
+
+class ParallelKernel {
+public:
+    virtual ~ParallelKernel() { }
+
+    virtual void operator()(Index begin, Index end) const = 0;
+};
+
+//
+//  Simple kernel to apply a method of a class to each chunk -- this is typically
+//  how the methods iterating through a range of parent components are invoked:
+//
+template <class T>
+class ParallelMethodKernel : public ParallelKernel {
+public:
+    typedef void (T::*Method)(Index begin, Index end);
+
+    ParallelMethodKernel(T& object, Method method) : _object(object), _method(method) { }
+
+    virtual void operator()(Index begin, Index end) const { (_object.*_method)(begin, end); }
+
+private:
+    T&     _object;
+    Method _method;
+};
+
+void parallelFor(ThreadingType threading, Index begin, Index end, int grainSize,
+                 ParallelKernel const& kernel);
+
+//
+//  Exclusive scan of the counts of a vector of (count, offset) pairs -- the layout of
+//  the counts/offsets vectors for the topological relations in Level -- assigning the
+//  offset of each pair and returning the total count.  The scan is done in two passes
+//  over chunks of the given grain size:  the first sums the counts of each chunk and
+//  the second assigns the offsets within each chunk from the sums of its predecessors.
+//
+int scanCountsAndOffsets(ThreadingType threading, IndexVector& countsAndOffsets,
+                         int grainSize);
+
+} // end namespace Vtr
+
+} // end namespace OPENSUBDIV_VERSION
+using namespace OPENSUBDIV_VERSION;
+} // end namespace OpenSubdiv
+
+#endif /* VTR_PARALLEL_H */
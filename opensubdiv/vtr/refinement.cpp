@@ -30,9 +30,11 @@
 #include "../vtr/fvarLevel.h"
 #include "../vtr/fvarRefinement.h"
 #include "../vtr/maskInterfaces.h"
+#include "../vtr/parallel.h"
 
 #include <cassert>
 #include <cstdio>
+#include <algorithm>
 
 
 //
@@ -64,6 +66,7 @@ Refinement::Refinement() :
     _schemeType(Sdc::TYPE_CATMARK),
     _schemeOptions(),
     _quadSplit(true),
+    _threading(THREADING_SERIAL),
     _childFaceFromFaceCount(0),
     _childEdgeFromFaceCount(0),
     _childEdgeFromEdgeCount(0),
@@ -297,22 +300,48 @@ Refinement::createChildComponents() {
 
 //
 //  Before we can refine the topological relations, we want to have the vectors
-//  sized appropriately so that we can (potentially) distribute the computation
-//  over chunks of these vectors.
+//  sized appropriately so that we can distribute the computation over chunks of
+//  these vectors.
 //
-//  This is non-trivial in the case of sparse subdivision, but there are still
-//  some opportunities for concurrency within these...
+//  This is non-trivial in the case of sparse subdivision, as not all of the
+//  components incident a child component may be present.  We know the maximal
+//  size of each relation based on the origin of the child component, but rather
+//  than over-allocating (and trimming or compacting afterward) we determine the
+//  exact counts for each child component -- concurrently, as each count depends
+//  only on the parent and its children -- then make a second pass through them
+//  to assemble the offsets (a parallel prefix sum of the counts).  The relations
+//  are then allocated to their exact size and each child component populated
+//  independently.
 //
-//  We will know the maximal size of each relation based on the origin of the
-//  child component -- so we could over-allocate.  If the refinement is very
-//  sparse the greatest savings will come from the small number of components
-//  and the overhead in the relations of each should be miminal (there should
-//  be a mix between maximal and minimal size given the mix of both interior
-//  and exterior components when sparse).
+//  When uniform, the counts are trivially those of the parent components, but
+//  when sparse the children of the parent components need to be inspected in
+//  the same way as when populating the relations.
 //
-//  Is it worth populating the counts concurrently, then making a single
-//  pass through them to assemble the offsets?
+//  The grain size here is a compromise between the amount of work per parent
+//  component (which varies between the relations) and the overhead of dispatching
+//  a chunk to a thread:
 //
+namespace {
+    const int populateGrainSize = 2048;
+}
+
+namespace {
+    class FaceVertexCountsAndOffsetsKernel : public ParallelKernel {
+    public:
+        FaceVertexCountsAndOffsetsKernel(int* countsAndOffsets) : _countsAndOffsets(countsAndOffsets) { }
+
+        virtual void operator()(Index begin, Index end) const {
+            for (Index i = begin; i < end; ++i) {
+                _countsAndOffsets[i*2 + 0] = 4;
+                _countsAndOffsets[i*2 + 1] = i << 2;
+            }
+        }
+
+    private:
+        int* _countsAndOffsets;
+    };
+}
+
 void
 Refinement::initializeFaceVertexCountsAndOffsets() {
 
@@ -324,9 +353,9 @@ Refinement::initializeFaceVertexCountsAndOffsets() {
     //  account for possibility of both quads and tris...
     //
     child._faceVertCountsAndOffsets.resize(child.getNumFaces() * 2);
-    for (int i = 0; i < child.getNumFaces(); ++i) {
-        child._faceVertCountsAndOffsets[i*2 + 0] = 4;
-        child._faceVertCountsAndOffsets[i*2 + 1] = i << 2;
+    if (child.getNumFaces()) {
+        parallelFor(_threading, 0, child.getNumFaces(), populateGrainSize,
+                    FaceVertexCountsAndOffsetsKernel(&child._faceVertCountsAndOffsets[0]));
     }
 }
 void
@@ -347,6 +376,15 @@ Refinement::initializeEdgeFaceCountsAndOffsets() {
     //          - given end vertex must have its full set of child faces
     //          - not for Bilinear -- only if neighborhood is non-zero
     //
+    Level& child = *_child;
+
+    child._edgeFaceCountsAndOffsets.resize(child.getNumEdges() * 2);
+
+    populateInParallel(&Refinement::countEdgeFacesFromParentFaces, _parent->getNumFaces());
+    populateInParallel(&Refinement::countEdgeFacesFromParentEdges, _parent->getNumEdges());
+
+    child._edgeFaceIndices.resize(
+            scanCountsAndOffsets(_threading, child._edgeFaceCountsAndOffsets, populateGrainSize));
 }
 void
 Refinement::initializeVertexFaceCountsAndOffsets() {
@@ -367,6 +405,19 @@ Refinement::initializeVertexFaceCountsAndOffsets() {
     //          - where the 1 or 2 is number of child edges of parent edge
     //      - same as parent vert for verts from parent verts (catmark)
     //
+    Level& child = *_child;
+
+    child._vertFaceCountsAndOffsets.resize(child.getNumVertices() * 2);
+
+    populateInParallel(&Refinement::countVertexFacesFromParentFaces,    _parent->getNumFaces());
+    populateInParallel(&Refinement::countVertexFacesFromParentEdges,    _parent->getNumEdges());
+    populateInParallel(&Refinement::countVertexFacesFromParentVertices, _parent->getNumVertices());
+
+    int childVertFaceIndexSize =
+            scanCountsAndOffsets(_threading, child._vertFaceCountsAndOffsets, populateGrainSize);
+
+    child._vertFaceIndices.resize(     childVertFaceIndexSize);
+    child._vertFaceLocalIndices.resize(childVertFaceIndexSize);
 }
 void
 Refinement::initializeVertexEdgeCountsAndOffsets() {
@@ -391,13 +442,245 @@ Refinement::initializeVertexEdgeCountsAndOffsets() {
     //          - any end vertex will require all N child faces (catmark)
     //      - same as parent vert for verts from parent verts (catmark)
     //
+    Level& child = *_child;
+
+    child._vertEdgeCountsAndOffsets.resize(child.getNumVertices() * 2);
+
+    populateInParallel(&Refinement::countVertexEdgesFromParentFaces,    _parent->getNumFaces());
+    populateInParallel(&Refinement::countVertexEdgesFromParentEdges,    _parent->getNumEdges());
+    populateInParallel(&Refinement::countVertexEdgesFromParentVertices, _parent->getNumVertices());
+
+    int childVertEdgeIndexSize =
+            scanCountsAndOffsets(_threading, child._vertEdgeCountsAndOffsets, populateGrainSize);
+
+    child._vertEdgeIndices.resize(     childVertEdgeIndexSize);
+    child._vertEdgeLocalIndices.resize(childVertEdgeIndexSize);
+}
+
+//
+//  Methods counting the incident components of the child components -- one for each
+//  origin of the child components of the three relations with variable counts.  These
+//  mirror the corresponding populate methods that follow, inspecting the same child
+//  components for validity when the refinement is sparse:
+//
+void
+Refinement::countEdgeFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
+
+    for (Index pFace = pFaceBegin; pFace < pFaceEnd; ++pFace) {
+        IndexArray const pFaceChildFaces = getFaceChildFaces(pFace);
+        IndexArray const pFaceChildEdges = getFaceChildEdges(pFace);
+
+        int pFaceValence = _parent->getFaceVertices(pFace).size();
+
+        for (int j = 0; j < pFaceValence; ++j) {
+            Index cEdge = pFaceChildEdges[j];
+            if (IndexIsValid(cEdge)) {
+                int jNext = ((j + 1) < pFaceValence) ? (j + 1) : 0;
+
+                _child->_edgeFaceCountsAndOffsets[2*cEdge] =
+                        IndexIsValid(pFaceChildFaces[j]) + IndexIsValid(pFaceChildFaces[jNext]);
+            }
+        }
+    }
+}
+
+void
+Refinement::countEdgeFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd) {
+
+    for (Index pEdge = pEdgeBegin; pEdge < pEdgeEnd; ++pEdge) {
+        IndexArray const pEdgeVerts = _parent->getEdgeVertices(pEdge);
+        IndexArray const pEdgeFaces = _parent->getEdgeFaces(pEdge);
+
+        IndexArray const pEdgeChildEdges = getEdgeChildEdges(pEdge);
+
+        for (int j = 0; j < 2; ++j) {
+            Index cEdge = pEdgeChildEdges[j];
+            if (!IndexIsValid(cEdge)) continue;
+
+            if (_uniform) {
+                _child->_edgeFaceCountsAndOffsets[2*cEdge] = pEdgeFaces.size();
+                continue;
+            }
+
+            int cEdgeFaceCount = 0;
+            for (int i = 0; i < pEdgeFaces.size(); ++i) {
+                Index pFace = pEdgeFaces[i];
+
+                IndexArray const pFaceEdges = _parent->getFaceEdges(pFace);
+                IndexArray const pFaceVerts = _parent->getFaceVertices(pFace);
+
+                int pFaceValence = pFaceVerts.size();
+
+                int edgeInFace = 0;
+                for ( ; pFaceEdges[edgeInFace] != pEdge; ++edgeInFace) ;
+
+                int childInFace = edgeInFace + (pFaceVerts[edgeInFace] != pEdgeVerts[j]);
+                if (childInFace == pFaceValence) childInFace = 0;
+
+                cEdgeFaceCount += IndexIsValid(getFaceChildFaces(pFace)[childInFace]);
+            }
+            _child->_edgeFaceCountsAndOffsets[2*cEdge] = cEdgeFaceCount;
+        }
+    }
+}
+
+void
+Refinement::countVertexFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
+
+    for (Index pFace = pFaceBegin; pFace < pFaceEnd; ++pFace) {
+        Index cVert = _faceChildVertIndex[pFace];
+        if (!IndexIsValid(cVert)) continue;
+
+        IndexArray const pFaceChildren = getFaceChildFaces(pFace);
+
+        int cVertFaceCount = 0;
+        for (int j = 0; j < pFaceChildren.size(); ++j) {
+            cVertFaceCount += IndexIsValid(pFaceChildren[j]);
+        }
+        _child->_vertFaceCountsAndOffsets[2*cVert] = cVertFaceCount;
+    }
+}
+
+void
+Refinement::countVertexFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd) {
+
+    for (Index pEdge = pEdgeBegin; pEdge < pEdgeEnd; ++pEdge) {
+        Index cVert = _edgeChildVertIndex[pEdge];
+        if (!IndexIsValid(cVert)) continue;
+
+        IndexArray const pEdgeFaces = _parent->getEdgeFaces(pEdge);
+
+        if (_uniform) {
+            _child->_vertFaceCountsAndOffsets[2*cVert] = 2 * pEdgeFaces.size();
+            continue;
+        }
+
+        int cVertFaceCount = 0;
+        for (int i = 0; i < pEdgeFaces.size(); ++i) {
+            Index pFace = pEdgeFaces[i];
+
+            IndexArray const pFaceEdges    = _parent->getFaceEdges(pFace);
+            IndexArray const pFaceChildren = getFaceChildFaces(pFace);
+
+            int pFaceEdgeCount = pFaceEdges.size();
+
+            int faceChild0 = 0;
+            for ( ; pFaceEdges[faceChild0] != pEdge; ++faceChild0) ;
+
+            int faceChild1 = faceChild0 + 1;
+            if (faceChild1 == pFaceEdgeCount) faceChild1 = 0;
+
+            cVertFaceCount += IndexIsValid(pFaceChildren[faceChild0]) +
+                              IndexIsValid(pFaceChildren[faceChild1]);
+        }
+        _child->_vertFaceCountsAndOffsets[2*cVert] = cVertFaceCount;
+    }
+}
+
+void
+Refinement::countVertexFacesFromParentVertices(Index pVertBegin, Index pVertEnd) {
+
+    for (Index pVert = pVertBegin; pVert < pVertEnd; ++pVert) {
+        Index cVert = _vertChildVertIndex[pVert];
+        if (!IndexIsValid(cVert)) continue;
+
+        IndexArray const pVertFaces = _parent->getVertexFaces(pVert);
+
+        if (_uniform) {
+            _child->_vertFaceCountsAndOffsets[2*cVert] = pVertFaces.size();
+            continue;
+        }
+
+        LocalIndexArray const pVertInFace = _parent->getVertexFaceLocalIndices(pVert);
+
+        int cVertFaceCount = 0;
+        for (int i = 0; i < pVertFaces.size(); ++i) {
+            cVertFaceCount += IndexIsValid(getFaceChildFaces(pVertFaces[i])[pVertInFace[i]]);
+        }
+        _child->_vertFaceCountsAndOffsets[2*cVert] = cVertFaceCount;
+    }
+}
+
+void
+Refinement::countVertexEdgesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
+
+    for (Index pFace = pFaceBegin; pFace < pFaceEnd; ++pFace) {
+        Index cVert = _faceChildVertIndex[pFace];
+        if (!IndexIsValid(cVert)) continue;
+
+        IndexArray const pFaceChildren = getFaceChildEdges(pFace);
+
+        int cVertEdgeCount = 0;
+        for (int j = 0; j < pFaceChildren.size(); ++j) {
+            cVertEdgeCount += IndexIsValid(pFaceChildren[j]);
+        }
+        _child->_vertEdgeCountsAndOffsets[2*cVert] = cVertEdgeCount;
+    }
+}
+
+void
+Refinement::countVertexEdgesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd) {
+
+    for (Index pEdge = pEdgeBegin; pEdge < pEdgeEnd; ++pEdge) {
+        Index cVert = _edgeChildVertIndex[pEdge];
+        if (!IndexIsValid(cVert)) continue;
+
+        IndexArray const pEdgeFaces = _parent->getEdgeFaces(pEdge);
+
+        if (_uniform) {
+            _child->_vertEdgeCountsAndOffsets[2*cVert] = pEdgeFaces.size() + 2;
+            continue;
+        }
+
+        int cVertEdgeCount = 0;
+        for (int i = 0; i < pEdgeFaces.size(); ++i) {
+            Index pFace = pEdgeFaces[i];
+
+            IndexArray const pFaceEdges = _parent->getFaceEdges(pFace);
+
+            int edgeInFace = 0;
+            for ( ; pFaceEdges[edgeInFace] != pEdge; ++edgeInFace) ;
+
+            cVertEdgeCount += IndexIsValid(getFaceChildEdges(pFace)[edgeInFace]);
+        }
+
+        IndexArray const pEdgeChildren = getEdgeChildEdges(pEdge);
+
+        cVertEdgeCount += IndexIsValid(pEdgeChildren[0]) + IndexIsValid(pEdgeChildren[1]);
+
+        _child->_vertEdgeCountsAndOffsets[2*cVert] = cVertEdgeCount;
+    }
+}
+
+void
+Refinement::countVertexEdgesFromParentVertices(Index pVertBegin, Index pVertEnd) {
+
+    for (Index pVert = pVertBegin; pVert < pVertEnd; ++pVert) {
+        Index cVert = _vertChildVertIndex[pVert];
+        if (!IndexIsValid(cVert)) continue;
+
+        IndexArray const pVertEdges = _parent->getVertexEdges(pVert);
+
+        if (_uniform) {
+            _child->_vertEdgeCountsAndOffsets[2*cVert] = pVertEdges.size();
+            continue;
+        }
+
+        LocalIndexArray const pVertInEdge = _parent->getVertexEdgeLocalIndices(pVert);
+
+        int cVertEdgeCount = 0;
+        for (int i = 0; i < pVertEdges.size(); ++i) {
+            cVertEdgeCount += IndexIsValid(getEdgeChildEdges(pVertEdges[i])[pVertInEdge[i]]);
+        }
+        _child->_vertEdgeCountsAndOffsets[2*cVert] = cVertEdgeCount;
+    }
 }
 
 //
 //  Face-vert and face-edge topology propagation -- faces only originate from faces:
 //
 void
-Refinement::populateFaceVerticesFromParentFaces() {
+Refinement::populateFaceVerticesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
 
     //
     //  Algorithm:
@@ -405,7 +688,7 @@ Refinement::populateFaceVerticesFromParentFaces() {
     //    - use parent components incident the parent face:
     //        - use the interior face-vert, corner vert-vert and two edge-verts
     //
-    for (Index pFace = 0; pFace < _parent->getNumFaces(); ++pFace) {
+    for (Index pFace = pFaceBegin; pFace < pFaceEnd; ++pFace) {
         IndexArray const pFaceVerts = _parent->getFaceVertices(pFace);
         IndexArray const pFaceEdges = _parent->getFaceEdges(pFace);
 
@@ -445,7 +728,7 @@ Refinement::populateFaceVerticesFromParentFaces() {
 }
 
 void
-Refinement::populateFaceEdgesFromParentFaces() {
+Refinement::populateFaceEdgesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
 
     //
     //  Algorithm:
@@ -453,7 +736,7 @@ Refinement::populateFaceEdgesFromParentFaces() {
     //    - use parent components incident the parent face:
     //        - use the two interior face-edges and the two boundary edge-edges
     //
-    for (Index pFace = 0; pFace < _parent->getNumFaces(); ++pFace) {
+    for (Index pFace = pFaceBegin; pFace < pFaceEnd; ++pFace) {
         IndexArray const pFaceVerts = _parent->getFaceVertices(pFace);
         IndexArray const pFaceEdges = _parent->getFaceEdges(pFace);
 
@@ -519,7 +802,7 @@ Refinement::populateFaceEdgesFromParentFaces() {
 //  Edge-vert topology propagation -- two functions for face or edge origin:
 //
 void
-Refinement::populateEdgeVerticesFromParentFaces() {
+Refinement::populateEdgeVerticesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
 
     //
     //  For each parent face's edge-children:
@@ -527,7 +810,7 @@ Refinement::populateEdgeVerticesFromParentFaces() {
     //    - identify parent edge perpendicular to face's child edge:
     //        - identify parent edge's vert-child
     //
-    for (Index pFace = 0; pFace < _parent->getNumFaces(); ++pFace) {
+    for (Index pFace = pFaceBegin; pFace < pFaceEnd; ++pFace) {
         IndexArray const pFaceEdges = _parent->getFaceEdges(pFace);
 
         IndexArray const pFaceChildren = getFaceChildEdges(pFace);
@@ -545,7 +828,7 @@ Refinement::populateEdgeVerticesFromParentFaces() {
 }
 
 void
-Refinement::populateEdgeVerticesFromParentEdges() {
+Refinement::populateEdgeVerticesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd) {
 
     //
     //  For each parent edge's edge-children:
@@ -553,7 +836,7 @@ Refinement::populateEdgeVerticesFromParentEdges() {
     //    - identify parent vert at end of child edge:
     //        - identify parent vert's vert-child
     //
-    for (Index pEdge = 0; pEdge < _parent->getNumEdges(); ++pEdge) {
+    for (Index pEdge = pEdgeBegin; pEdge < pEdgeEnd; ++pEdge) {
         IndexArray const pEdgeVerts = _parent->getEdgeVertices(pEdge);
 
         IndexArray const pEdgeChildren = getEdgeChildEdges(pEdge);
@@ -575,14 +858,14 @@ Refinement::populateEdgeVerticesFromParentEdges() {
 //  Edge-face topology propagation -- two functions for face or edge origin:
 //
 void
-Refinement::populateEdgeFacesFromParentFaces() {
+Refinement::populateEdgeFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
 
     //
-    //  Note -- the edge-face counts/offsets vector is not known
-    //  ahead of time and is populated incrementally, so we cannot
-    //  thread this yet...
+    //  Note -- the edge-face counts/offsets have been initialized ahead
+    //  of time with the exact number of faces for each child edge, so
+    //  each child edge can be populated independently...
     //
-    for (Index pFace = 0; pFace < _parent->getNumFaces(); ++pFace) {
+    for (Index pFace = pFaceBegin; pFace < pFaceEnd; ++pFace) {
         IndexArray const pFaceChildFaces = getFaceChildFaces(pFace);
         IndexArray const pFaceChildEdges = getFaceChildEdges(pFace);
 
@@ -592,10 +875,8 @@ Refinement::populateEdgeFacesFromParentFaces() {
             Index cEdge = pFaceChildEdges[j];
             if (IndexIsValid(cEdge)) {
                 //
-                //  Reserve enough edge-faces, populate and trim as needed:
+                //  The exact number of edge-faces has been allocated, so simply populate:
                 //
-                _child->resizeEdgeFaces(cEdge, 2);
-
                 IndexArray cEdgeFaces = _child->getEdgeFaces(cEdge);
 
                 //  One or two child faces may be assigned:
@@ -608,21 +889,21 @@ Refinement::populateEdgeFacesFromParentFaces() {
                 if (IndexIsValid(pFaceChildFaces[jNext])) {
                     cEdgeFaces[cEdgeFaceCount++] = pFaceChildFaces[jNext];
                 }
-                _child->trimEdgeFaces(cEdge, cEdgeFaceCount);
+                assert(cEdgeFaceCount == cEdgeFaces.size());
             }
         }
     }
 }
 
 void
-Refinement::populateEdgeFacesFromParentEdges() {
+Refinement::populateEdgeFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd) {
 
     //
-    //  Note -- the edge-face counts/offsets vector is not known
-    //  ahead of time and is populated incrementally, so we cannot
-    //  thread this yet...
+    //  Note -- the edge-face counts/offsets have been initialized ahead
+    //  of time with the exact number of faces for each child edge, so
+    //  each child edge can be populated independently...
     //
-    for (Index pEdge = 0; pEdge < _parent->getNumEdges(); ++pEdge) {
+    for (Index pEdge = pEdgeBegin; pEdge < pEdgeEnd; ++pEdge) {
         IndexArray const pEdgeVerts = _parent->getEdgeVertices(pEdge);
         IndexArray const pEdgeFaces = _parent->getEdgeFaces(pEdge);
 
@@ -633,10 +914,8 @@ Refinement::populateEdgeFacesFromParentEdges() {
             if (!IndexIsValid(cEdge)) continue;
 
             //
-            //  Reserve enough edge-faces, populate and trim as needed:
+            //  The exact number of edge-faces has been allocated, so simply populate:
             //
-            _child->resizeEdgeFaces(cEdge, pEdgeFaces.size());
-
             IndexArray cEdgeFaces = _child->getEdgeFaces(cEdge);
 
             //
@@ -686,7 +965,7 @@ Refinement::populateEdgeFacesFromParentEdges() {
                     cEdgeFaces[cEdgeFaceCount++] = pFaceChildren[childInFace];
                 }
             }
-            _child->trimEdgeFaces(cEdge, cEdgeFaceCount);
+            assert(cEdgeFaceCount == cEdgeFaces.size());
         }
     }
 }
@@ -696,16 +975,16 @@ Refinement::populateEdgeFacesFromParentEdges() {
 //  Vert-face topology propagation -- three functions for face, edge or vert origin:
 //
 //  Remember for these that the corresponding counts/offsets for each component are
-//  not yet known and so are also populated by these functions.  This does impose an
-//  ordering requirement here and inhibits concurrency.
+//  initialized ahead of time with the exact number of incident components, so there
+//  is no ordering requirement here and these can be applied concurrently.
 //
 void
-Refinement::populateVertexFacesFromParentFaces() {
+Refinement::populateVertexFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
 
     const Level& parent = *this->_parent;
           Level& child  = *this->_child;
 
-    for (int fIndex = 0; fIndex < parent.getNumFaces(); ++fIndex) {
+    for (int fIndex = pFaceBegin; fIndex < pFaceEnd; ++fIndex) {
         int cVertIndex = this->_faceChildVertIndex[fIndex];
         if (!IndexIsValid(cVertIndex)) continue;
 
@@ -717,10 +996,8 @@ Refinement::populateVertexFacesFromParentFaces() {
         IndexArray const pFaceChildren = this->getFaceChildFaces(fIndex);
 
         //
-        //  Reserve enough vert-faces, populate and trim to the actual size:
+        //  The exact number of vert-faces has been allocated, so simply populate:
         //
-        child.resizeVertexFaces(cVertIndex, pFaceVertCount);
-
         IndexArray      cVertFaces  = child.getVertexFaces(cVertIndex);
         LocalIndexArray cVertInFace = child.getVertexFaceLocalIndices(cVertIndex);
 
@@ -736,17 +1013,17 @@ Refinement::populateVertexFacesFromParentFaces() {
                 cVertFaceCount++;
             }
         }
-        child.trimVertexFaces(cVertIndex, cVertFaceCount);
+        assert(cVertFaceCount == cVertFaces.size());
     }
 }
 
 void
-Refinement::populateVertexFacesFromParentEdges() {
+Refinement::populateVertexFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd) {
 
     const Level& parent = *this->_parent;
           Level& child  = *this->_child;
 
-    for (int pEdgeIndex = 0; pEdgeIndex < parent.getNumEdges(); ++pEdgeIndex) {
+    for (int pEdgeIndex = pEdgeBegin; pEdgeIndex < pEdgeEnd; ++pEdgeIndex) {
         int cVertIndex = this->_edgeChildVertIndex[pEdgeIndex];
         if (!IndexIsValid(cVertIndex)) continue;
 
@@ -756,10 +1033,8 @@ Refinement::populateVertexFacesFromParentEdges() {
         IndexArray const pEdgeFaces = parent.getEdgeFaces(pEdgeIndex);
 
         //
-        //  Reserve enough vert-faces, populate and trim to the actual size:
+        //  The exact number of vert-faces has been allocated, so simply populate:
         //
-        child.resizeVertexFaces(cVertIndex, 2 * pEdgeFaces.size());
-
         IndexArray      cVertFaces  = child.getVertexFaces(cVertIndex);
         LocalIndexArray cVertInFace = child.getVertexFaceLocalIndices(cVertIndex);
 
@@ -801,17 +1076,17 @@ Refinement::populateVertexFacesFromParentEdges() {
                 cVertFaceCount++;
             }
         }
-        child.trimVertexFaces(cVertIndex, cVertFaceCount);
+        assert(cVertFaceCount == cVertFaces.size());
     }
 }
 
 void
-Refinement::populateVertexFacesFromParentVertices() {
+Refinement::populateVertexFacesFromParentVertices(Index pVertBegin, Index pVertEnd) {
 
     const Level& parent = *this->_parent;
           Level& child  = *this->_child;
 
-    for (int vIndex = 0; vIndex < parent.getNumVertices(); ++vIndex) {
+    for (int vIndex = pVertBegin; vIndex < pVertEnd; ++vIndex) {
         int cVertIndex = this->_vertChildVertIndex[vIndex];
         if (!IndexIsValid(cVertIndex)) continue;
 
@@ -822,10 +1097,8 @@ Refinement::populateVertexFacesFromParentVertices() {
         LocalIndexArray const pVertInFace = parent.getVertexFaceLocalIndices(vIndex);
 
         //
-        //  Reserve enough vert-faces, populate and trim to the actual size:
+        //  The exact number of vert-faces has been allocated, so simply populate:
         //
-        child.resizeVertexFaces(cVertIndex, pVertFaces.size());
-
         IndexArray      cVertFaces  = child.getVertexFaces(cVertIndex);
         LocalIndexArray cVertInFace = child.getVertexFaceLocalIndices(cVertIndex);
 
@@ -844,7 +1117,7 @@ Refinement::populateVertexFacesFromParentVertices() {
                 cVertFaceCount++;
             }
         }
-        child.trimVertexFaces(cVertIndex, cVertFaceCount);
+        assert(cVertFaceCount == cVertFaces.size());
     }
 }
 
@@ -852,12 +1125,12 @@ Refinement::populateVertexFacesFromParentVertices() {
 //  Vert-edge topology propagation -- three functions for face, edge or vert origin:
 //
 void
-Refinement::populateVertexEdgesFromParentFaces() {
+Refinement::populateVertexEdgesFromParentFaces(Index pFaceBegin, Index pFaceEnd) {
 
     const Level& parent = *this->_parent;
           Level& child  = *this->_child;
 
-    for (int fIndex = 0; fIndex < parent.getNumFaces(); ++fIndex) {
+    for (int fIndex = pFaceBegin; fIndex < pFaceEnd; ++fIndex) {
         int cVertIndex = this->_faceChildVertIndex[fIndex];
         if (!IndexIsValid(cVertIndex)) continue;
 
@@ -869,10 +1142,8 @@ Refinement::populateVertexEdgesFromParentFaces() {
         IndexArray const pFaceChildren = this->getFaceChildEdges(fIndex);
 
         //
-        //  Reserve enough vert-edges, populate and trim to the actual size:
+        //  The exact number of vert-edges has been allocated, so simply populate:
         //
-        child.resizeVertexEdges(cVertIndex, pFaceVerts.size());
-
         IndexArray      cVertEdges  = child.getVertexEdges(cVertIndex);
         LocalIndexArray cVertInEdge = child.getVertexEdgeLocalIndices(cVertIndex);
 
@@ -884,16 +1155,16 @@ Refinement::populateVertexEdgesFromParentFaces() {
                 cVertEdgeCount++;
             }
         }
-        child.trimVertexEdges(cVertIndex, cVertEdgeCount);
+        assert(cVertEdgeCount == cVertEdges.size());
     }
 }
 void
-Refinement::populateVertexEdgesFromParentEdges() {
+Refinement::populateVertexEdgesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd) {
 
     const Level& parent = *this->_parent;
           Level& child  = *this->_child;
 
-    for (int eIndex = 0; eIndex < parent.getNumEdges(); ++eIndex) {
+    for (int eIndex = pEdgeBegin; eIndex < pEdgeEnd; ++eIndex) {
         int cVertIndex = this->_edgeChildVertIndex[eIndex];
         if (!IndexIsValid(cVertIndex)) continue;
 
@@ -905,10 +1176,8 @@ Refinement::populateVertexEdgesFromParentEdges() {
         IndexArray const pEdgeChild = this->getEdgeChildEdges(eIndex);
 
         //
-        //  Reserve enough vert-edges, populate and trim to the actual size:
+        //  The exact number of vert-edges has been allocated, so simply populate:
         //
-        child.resizeVertexEdges(cVertIndex, pEdgeFaces.size() + 2);
-
         IndexArray      cVertEdges  = child.getVertexEdges(cVertIndex);
         LocalIndexArray cVertInEdge = child.getVertexEdgeLocalIndices(cVertIndex);
 
@@ -966,16 +1235,16 @@ Refinement::populateVertexEdgesFromParentEdges() {
         } else if (edgeFromEdgeCount == 2) {
         }
 
-        child.trimVertexEdges(cVertIndex, cVertEdgeCount);
+        assert(cVertEdgeCount == cVertEdges.size());
     }
 }
 void
-Refinement::populateVertexEdgesFromParentVertices() {
+Refinement::populateVertexEdgesFromParentVertices(Index pVertBegin, Index pVertEnd) {
 
     const Level& parent = *this->_parent;
           Level& child  = *this->_child;
 
-    for (int vIndex = 0; vIndex < parent.getNumVertices(); ++vIndex) {
+    for (int vIndex = pVertBegin; vIndex < pVertEnd; ++vIndex) {
         int cVertIndex = this->_vertChildVertIndex[vIndex];
         if (!IndexIsValid(cVertIndex)) continue;
 
@@ -986,10 +1255,8 @@ Refinement::populateVertexEdgesFromParentVertices() {
         LocalIndexArray const pVertInEdge = parent.getVertexEdgeLocalIndices(vIndex);
 
         //
-        //  Reserve enough vert-edges, populate and trim to the actual size:
+        //  The exact number of vert-edges has been allocated, so simply populate:
         //
-        child.resizeVertexEdges(cVertIndex, pVertEdges.size());
-
         IndexArray      cVertEdges  = child.getVertexEdges(cVertIndex);
         LocalIndexArray cVertInEdge = child.getVertexEdgeLocalIndices(cVertIndex);
 
@@ -1005,7 +1272,7 @@ Refinement::populateVertexEdgesFromParentVertices() {
                 cVertEdgeCount++;
             }
         }
-        child.trimVertexEdges(cVertIndex, cVertEdgeCount);
+        assert(cVertEdgeCount == cVertEdges.size());
     }
 }
 
@@ -1070,6 +1337,8 @@ Refinement::refine(Options refineOptions) {
 
     _uniform = !refineOptions._sparse;
 
+    _threading = (ThreadingType) refineOptions._threading;
+
     //
     //  First determine the inventory of child components by populating the parent-to-child
     //  vectors and identifying the future child components as we take inventory:
@@ -1169,23 +1438,20 @@ Refinement::subdivideTopology(Relations const& applyTo) {
     //  Note on sizing:
     //      All faces now quads or tris, so the face-* relation sizes should be known.
     //  For edge and vert relations, where the number of incident components is more
-    //  variable, we allocate/offset assuming 1-to-1 correspondence between child and
-    //  parent incident components (which will be true for uniform subdivision), then
-    //  "compress" later on-the-fly as we determine the subset of parent components
-    //  that contribute children to the neighborhood (not really "compressing" here
-    //  but more initializing as we go and adjusting the counts and offsets to reflect
-    //  the actual valences -- so we never pack/move the vector elements).
-    //      Some of the above inhibits concurrency in the mapping of the child indices
-    //  from the parent.  Knowing all of the counts/offsets before applying the mapping
-    //  would be helpful.  Current count/offset vectors are:
+    //  variable, we first count the incident child components of each child -- the
+    //  parent's incident components when uniform, or the subset of those that
+    //  contribute children to the neighborhood when sparse -- then assemble the
+    //  offsets from the counts.  With all of the counts/offsets known before applying
+    //  the mapping, each child component can be populated independently and no
+    //  relation is over-allocated.  Current count/offset vectors are:
     //
     //      - face-verts, also used by/shared with face-edges
     //      - edge-faces
     //      - vert-faces
     //      - vert-edges, not shared with vert-faces to allow non-manifold cases
     //
-    //  So we have 6 relations to transform and 4 count/offset vectors required -- 3
-    //  of which are currently assembled incrementally.  The two that are not build:
+    //  So we have 6 relations to transform and 4 count/offset vectors required.  The
+    //  two that are not built:
     //
     //      - face-edges, we share the face-vert counts/offsets
     //      - edge-verts, no need -- constant size of 2
@@ -1205,12 +1471,14 @@ Refinement::subdivideTopology(Relations const& applyTo) {
         //  Face-verts -- allocate and populate:
         if (applyTo._faceVertices) {
             child._faceVertIndices.resize(child.getNumFaces() * 4);
-            populateFaceVerticesFromParentFaces();
+
+            populateInParallel(&Refinement::populateFaceVerticesFromParentFaces, parent.getNumFaces());
         }
         //  Face-edges -- allocate and populate:
         if (applyTo._faceEdges) {
             child._faceEdgeIndices.resize(child.getNumFaces() * 4);
-            populateFaceEdgesFromParentFaces();
+
+            populateInParallel(&Refinement::populateFaceEdgesFromParentFaces, parent.getNumFaces());
         }
     }
 
@@ -1221,35 +1489,20 @@ Refinement::subdivideTopology(Relations const& applyTo) {
     if (applyTo._edgeVertices) {
         child._edgeVertIndices.resize(child.getNumEdges() * 2);
 
-        populateEdgeVerticesFromParentFaces();
-        populateEdgeVerticesFromParentEdges();
+        populateInParallel(&Refinement::populateEdgeVerticesFromParentFaces, parent.getNumFaces());
+        populateInParallel(&Refinement::populateEdgeVerticesFromParentEdges, parent.getNumEdges());
     }
 
     //  Edge-faces:
-    //      NOTE we do not know the exact counts/offsets here because of the
-    //  potentially sparse subdivision.  If we must compute this incrementally,
-    //  i.e. as we populate the edge-face indices, we will not be able to thread
-    //  that operation.  See populateEdgeFaceCountsAndOffsets() for possibilities
-    //  of pre-computing these.
+    //      NOTE the exact counts/offsets are not trivially known here because of the
+    //  potentially sparse subdivision, so they are computed first (see comments in
+    //  initializeEdgeFaceCountsAndOffsets()).
     //
     if (applyTo._edgeFaces) {
-        //  Empty stub to eventually replace the incremental assembly that follows:
         initializeEdgeFaceCountsAndOffsets();
 
-        int childEdgeFaceIndexSizeEstimate = (int)parent._faceVertIndices.size() * 2 +
-                                             (int)parent._edgeFaceIndices.size() * 2;
-
-        child._edgeFaceCountsAndOffsets.resize(child.getNumEdges() * 2);
-        child._edgeFaceIndices.resize(         childEdgeFaceIndexSizeEstimate);
-
-        populateEdgeFacesFromParentFaces();
-        populateEdgeFacesFromParentEdges();
-
-        //  Revise the over-allocated estimate based on what is used (as indicated in the
-        //  count/offset for the last vertex) and trim the index vector accordingly:
-        childEdgeFaceIndexSizeEstimate = child.getNumEdgeFaces(child.getNumEdges()-1) +
-                                         child.getOffsetOfEdgeFaces(child.getNumEdges()-1);
-        child._edgeFaceIndices.resize(childEdgeFaceIndexSizeEstimate);
+        populateInParallel(&Refinement::populateEdgeFacesFromParentFaces, parent.getNumFaces());
+        populateInParallel(&Refinement::populateEdgeFacesFromParentEdges, parent.getNumEdges());
 
         child._maxEdgeFaces = parent._maxEdgeFaces;
     }
@@ -1258,21 +1511,10 @@ Refinement::subdivideTopology(Relations const& applyTo) {
     //  Vert relations -- vert-faces and vert-edges can be populated independently:
     //
     //  Vert-faces:
-    //      We know the number of counts/offsets required, but we do not yet know how
-    //  many total incident faces we will have -- given we are generating a potential
-    //  subset of the number of children possible, allocate for the maximum and trim
-    //  once its determined how many were used.
-    //      The upper-bound for allocation is determined by the incidence vectors for
-    //  the parent components, e.g. assuming fully populated, the total number of faces
-    //  incident all vertices that are generated from parent faces is equal to the size
-    //  of the parent's face-vert index vector.  Similar deductions can be made for
-    //  for those originating from parent edges and verts.
-    //      If this over-allocation proves excessive, we can get a more reasonable
-    //  estimate, or even the exact size, by iterating though topology/child vectors.
-    //
-    //      The bigger issue here though is that not having the counts/offsets known
-    //  and updating it incrementally inhibits threading.  So consider figuring out the
-    //  counts/offsets before remapping the topology:
+    //      We know the number of counts/offsets required, but we do not know how many
+    //  total incident faces we will have -- given we are generating a potential subset
+    //  of the number of children possible, the counts are determined before allocating
+    //  (see initializeVertexFaceCountsAndOffsets()):
     //      - if uniform subdivision, vert-face count will be:
     //          - 4 for verts from parent faces (for catmark)
     //          - 2x number in parent edge for verts from parent edges
@@ -1290,36 +1532,17 @@ Refinement::subdivideTopology(Relations const& applyTo) {
     //  account when marking/generating children.
     //
     if (applyTo._vertexFaces) {
-        //  Empty stub to eventually replace the incremental assembly that follows:
         initializeVertexFaceCountsAndOffsets();
 
-        int childVertFaceIndexSizeEstimate = (int)parent._faceVertIndices.size()
-                                            + (int)parent._edgeFaceIndices.size() * 2
-                                            + (int)parent._vertFaceIndices.size();
-
-        child._vertFaceCountsAndOffsets.resize(child.getNumVertices() * 2);
-        child._vertFaceIndices.resize(         childVertFaceIndexSizeEstimate);
-        child._vertFaceLocalIndices.resize(    childVertFaceIndexSizeEstimate);
-
-        populateVertexFacesFromParentFaces();
-        populateVertexFacesFromParentEdges();
-        populateVertexFacesFromParentVertices();
-
-        //  Revise the over-allocated estimate based on what is used (as indicated in the
-        //  count/offset for the last vertex) and trim the index vectors accordingly:
-        childVertFaceIndexSizeEstimate = child.getNumVertexFaces(child.getNumVertices()-1) +
-                                         child.getOffsetOfVertexFaces(child.getNumVertices()-1);
-        child._vertFaceIndices.resize(     childVertFaceIndexSizeEstimate);
-        child._vertFaceLocalIndices.resize(childVertFaceIndexSizeEstimate);
+        populateInParallel(&Refinement::populateVertexFacesFromParentFaces,    parent.getNumFaces());
+        populateInParallel(&Refinement::populateVertexFacesFromParentEdges,    parent.getNumEdges());
+        populateInParallel(&Refinement::populateVertexFacesFromParentVertices, parent.getNumVertices());
     }
 
     //  Vert-edges:
     //      As for vert-faces, we know the number of counts/offsets required, but we do
-    //  not yet know how many total incident edges we will have.  So over-estimate and
-    //  trim after population, similar to above for face-verts.
-    //
-    //  See also notes above regarding attempts to determine counts/offsets before we
-    //  start to remap the components:
+    //  not know how many total incident edges we will have.  So determine the counts
+    //  before allocating, similar to above for vert-faces:
     //      - if uniform subdivision, vert-edge count will be:
     //          - 4 for verts from parent faces (for catmark)
     //          - 2 + N faces incident parent edge for verts from parent edges
@@ -1335,31 +1558,26 @@ Refinement::subdivideTopology(Relations const& applyTo) {
     //          - same as parent vert for verts from parent verts (catmark)
     //
     if (applyTo._vertexEdges) {
-        //  Empty stub to eventually replace the incremental assembly that follows:
         initializeVertexEdgeCountsAndOffsets();
 
-        int childVertEdgeIndexSizeEstimate = (int)parent._faceVertIndices.size()
-                                           + (int)parent._edgeFaceIndices.size() + parent.getNumEdges() * 2
-                                           + (int)parent._vertEdgeIndices.size();
-
-        child._vertEdgeCountsAndOffsets.resize(child.getNumVertices() * 2);
-        child._vertEdgeIndices.resize(         childVertEdgeIndexSizeEstimate);
-        child._vertEdgeLocalIndices.resize(    childVertEdgeIndexSizeEstimate);
-
-        populateVertexEdgesFromParentFaces();
-        populateVertexEdgesFromParentEdges();
-        populateVertexEdgesFromParentVertices();
-
-        //  Revise the over-allocated estimate based on what is used (as indicated in the
-        //  count/offset for the last vertex) and trim the index vectors accordingly:
-        childVertEdgeIndexSizeEstimate = child.getNumVertexEdges(child.getNumVertices()-1) +
-                                         child.getOffsetOfVertexEdges(child.getNumVertices()-1);
-        child._vertEdgeIndices.resize(     childVertEdgeIndexSizeEstimate);
-        child._vertEdgeLocalIndices.resize(childVertEdgeIndexSizeEstimate);
+        populateInParallel(&Refinement::populateVertexEdgesFromParentFaces,    parent.getNumFaces());
+        populateInParallel(&Refinement::populateVertexEdgesFromParentEdges,    parent.getNumEdges());
+        populateInParallel(&Refinement::populateVertexEdgesFromParentVertices, parent.getNumVertices());
     }
     child._maxValence = parent._maxValence;
 }
 
+//
+//  Each of the count and populate methods is applied to chunks of the range of
+//  its parent components:
+//
+void
+Refinement::populateInParallel(PopulateMethod method, int numParentComponents) {
+
+    parallelFor(_threading, 0, numParentComponents, populateGrainSize,
+                ParallelMethodKernel<Refinement>(*this, method));
+}
+
 
 //
 //  Sharpness subdivision methods:
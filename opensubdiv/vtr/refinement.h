@@ -30,6 +30,7 @@
 #include "../sdc/options.h"
 #include "../vtr/types.h"
 #include "../vtr/level.h"
+#include "../vtr/parallel.h"
 
 #include <vector>
 
@@ -92,6 +93,11 @@ public:
     //          This is only one of the six possible topological relations that
     //          can be generated -- we may eventually want a flag for each.
     //
+    //      "threading": the threading backend (a ThreadingType) used to distribute the
+    //          subdivision of the topology across threads -- each of the passes that
+    //          populate the child relations is partitioned into ranges of the parent
+    //          components.  The result is identical to that of the serial case.
+    //
     //      "compute masks": this is intended to be temporary, along with the data
     //          members associated with it -- it will trigger the computation and
     //          storage of mask weights for all child vertices.  This is naively
@@ -103,11 +109,13 @@ public:
     //
     struct Options {
         Options() : _sparse(0),
-                    _faceTopologyOnly(0)
+                    _faceTopologyOnly(0),
+                    _threading(THREADING_SERIAL)
                     { }
 
         unsigned int _sparse           : 1;
         unsigned int _faceTopologyOnly : 1;
+        unsigned int _threading        : 2;
 
         //  Currently under consideration:
         //unsigned int _childToParentMap : 1;
@@ -269,27 +277,42 @@ private:
     void initializeVertexFaceCountsAndOffsets();
     void initializeVertexEdgeCountsAndOffsets();
 
+    //  Methods for counting the incident components of the child components for the
+    //  above -- one for each origin of the three relations with variable counts:
+    void countEdgeFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void countEdgeFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd);
+    void countVertexFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void countVertexFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd);
+    void countVertexFacesFromParentVertices(Index pVertBegin, Index pVertEnd);
+    void countVertexEdgesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void countVertexEdgesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd);
+    void countVertexEdgesFromParentVertices(Index pVertBegin, Index pVertEnd);
+
     //  Methods for populating sections of child topology relations based on their origin
     //  in the parent -- 12 in all
     //
-    //  These iterate through all components -- currently iterating through the parents
-    //  and updating only those children marked valid.  We may want to change the iteration
-    //  strategy here, particularly for sparse refinement.  Plans are to factor these out
-    //  to work between a specific parent and child pair and control the iteration through
-    //  other means.
-    //
-    void populateFaceVerticesFromParentFaces();
-    void populateFaceEdgesFromParentFaces();
-    void populateEdgeVerticesFromParentFaces();
-    void populateEdgeVerticesFromParentEdges();
-    void populateEdgeFacesFromParentFaces();
-    void populateEdgeFacesFromParentEdges();
-    void populateVertexFacesFromParentFaces();
-    void populateVertexFacesFromParentEdges();
-    void populateVertexFacesFromParentVertices();
-    void populateVertexEdgesFromParentFaces();
-    void populateVertexEdgesFromParentEdges();
-    void populateVertexEdgesFromParentVertices();
+    //  These iterate through a range [begin, end) of parent components -- currently
+    //  updating only those children marked valid.  We may want to change the iteration
+    //  strategy here, particularly for sparse refinement.  Each only writes to the child
+    //  components of the parents in its range, so disjoint ranges can be populated
+    //  concurrently (see populateInParallel() below).
+    //
+    void populateFaceVerticesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void populateFaceEdgesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void populateEdgeVerticesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void populateEdgeVerticesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd);
+    void populateEdgeFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void populateEdgeFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd);
+    void populateVertexFacesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void populateVertexFacesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd);
+    void populateVertexFacesFromParentVertices(Index pVertBegin, Index pVertEnd);
+    void populateVertexEdgesFromParentFaces(Index pFaceBegin, Index pFaceEnd);
+    void populateVertexEdgesFromParentEdges(Index pEdgeBegin, Index pEdgeEnd);
+    void populateVertexEdgesFromParentVertices(Index pVertBegin, Index pVertEnd);
+
+    typedef void (Refinement::*PopulateMethod)(Index begin, Index end);
+
+    void populateInParallel(PopulateMethod method, int numParentComponents);
 
 private:
     friend class Level;  //  Access for some debugging information
@@ -303,6 +326,8 @@ private:
     bool _quadSplit;  // generalize this to Sdc::Split later
     bool _uniform;
 
+    ThreadingType _threading;
+
     //
     //  Inventory of the types of child components:
     //      There are six types of child components:  child faces can only originate from
@@ -0,0 +1,1216 @@
+//
+//   Copyright 2013 Pixar
+//
+//   Licensed under the Apache License, Version 2.0 (the "Apache License")
+//   with the following modification; you may not use this file except in
+//   compliance with the Apache License and the following modification to it:
+//   Section 6. Trademarks. is deleted and replaced with:
+//
+//   6. Trademarks. This License does not grant permission to use the trade
+//      names, trademarks, service marks, or product names of the Licensor
+//      and its affiliates, except as required to comply with Section 4(c) of
+//      the License and to reproduce the content of the NOTICE file.
+//
+//   You may obtain a copy of the Apache License at
+//
+//       http://www.apache.org/licenses/LICENSE-2.0
+//
+//   Unless required by applicable law or agreed to in writing, software
+//   distributed under the Apache License with the above modification is
+//   distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+//   KIND, either express or implied. See the Apache License for the specific
+//   language governing permissions and limitations under the Apache License.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../../examples/common/stopwatch.h"
+#include "../../regression/common/vtr_utils.h"
+
+#include <far/patchMap.h>
+#include <far/patchTablesFactory.h>
+#include <far/patchTablesSerializer.h>
+#include <far/stencilTables.h>
+#include <far/stencilTablesFactory.h>
+#include <far/stencilTablesSerializer.h>
+
+#include "init_shapes.h"
+
+//
+// Performance comparison of the vertex interpolation paths of Far:
+//
+// - TopologyRefiner::Interpolate() in serial and with each of the supported
+//   threading back-ends
+//
+// - stencil tables creation, serial and threaded, and evaluation (the cost of
+//   creating the tables is reported separately, as it is amortized over
+//   successive evaluations)
+//
+// - loading serialized stencil tables, copied or mapped in memory
+//
+// - evaluation of compact stencil tables (16 bits indices and/or half
+//   precision weights) : throughput, memory and accuracy compared to the
+//   full precision tables
+//
+// - reordering stencils & control vertices for locality : evaluation time
+//   and cache lines missed by the control vertex gathers (simulated)
+//
+// - creating adaptive patch tables versus loading them serialized, copied or
+//   mapped in memory
+//
+// - creating the base level of a TopologyRefiner from a TopologyDescriptor
+//   (the edges and incident components being inferred from the face-vertices)
+//   with each of the threading back-ends, for the shapes and for synthetic
+//   large meshes : a regular grid and a fan of triangles around two vertices
+//   of high valence
+//
+// - selective refinement of a region of interest moving across the shape :
+//   incremental updates of the refinement and stencil tables versus their
+//   full re-creation (which must give the same tables)
+//
+// - PatchMap lookups of random locations on the ptex faces, one at a time
+//   and batched, for each isolation level up to 10 (the batched lookups must
+//   return the same patches)
+//
+// The threaded results are compared to the serial ones, which they must match
+// exactly as each vertex (and stencil) is computed the same way regardless of
+// threading.
+//
+
+using namespace OpenSubdiv;
+
+static int g_level = 4,
+           g_repeats = 10;
+
+static int const g_maxPatchMapLevel = 10,
+                 g_patchMapLocations = 64, // locations per ptex face
+                 g_gridSize = 1024,        // quads per side of the synthetic grid
+                 g_fanValence = 40000;     // triangles per side of the synthetic fan
+
+//------------------------------------------------------------------------------
+// Vertex class implementation
+struct Vertex {
+
+    Vertex() { }
+
+    void Clear( void * =0 ) { _pos[0]=_pos[1]=_pos[2]=0.0f; }
+
+    void AddWithWeight(Vertex const & src, float weight) {
+        _pos[0]+=weight*src._pos[0];
+        _pos[1]+=weight*src._pos[1];
+        _pos[2]+=weight*src._pos[2];
+    }
+
+    void AddVaryingWithWeight(Vertex const &, float) { }
+
+    void SetPosition(float x, float y, float z) { _pos[0]=x; _pos[1]=y; _pos[2]=z; }
+
+    const float * GetPos() const { return _pos; }
+
+private:
+    float _pos[3];
+};
+
+//------------------------------------------------------------------------------
+static char const *
+getThreadingName(Far::ThreadingType threading) {
+    switch (threading) {
+        case Far::THREADING_SERIAL : return "serial";
+        case Far::THREADING_TBB    : return "tbb";
+        case Far::THREADING_OMP    : return "omp";
+    }
+    return "unknown";
+}
+
+//------------------------------------------------------------------------------
+static bool
+compareVertexData(std::vector<Vertex> const & a, std::vector<Vertex> const & b) {
+
+    assert(a.size()==b.size());
+    for (int i=0; i<(int)a.size(); ++i) {
+        if (memcmp(a[i].GetPos(), b[i].GetPos(), 3*sizeof(float))!=0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+static bool
+compareStencilTables(Far::StencilTables const & a, Far::StencilTables const & b) {
+
+    return a.GetSizes()==b.GetSizes() and
+           a.GetOffsets()==b.GetOffsets() and
+           a.GetControlIndices()==b.GetControlIndices() and
+           a.GetWeights()==b.GetWeights();
+}
+
+//------------------------------------------------------------------------------
+static bool
+compareMappedStencilTables(Far::StencilTables const & a, Far::MappedStencilTables const & b) {
+
+    int nstencils = a.GetNumStencils(),
+        nelems = (int)a.GetControlIndices().size();
+
+    return nstencils==b.GetNumStencils() and
+           a.GetNumControlVertices()==b.GetNumControlVertices() and
+           memcmp(&a.GetSizes()[0], b.GetSizes(), nstencils)==0 and
+           memcmp(&a.GetOffsets()[0], b.GetOffsets(), nstencils*sizeof(int))==0 and
+           memcmp(&a.GetControlIndices()[0], b.GetControlIndices(), nelems*sizeof(int))==0 and
+           memcmp(&a.GetWeights()[0], b.GetWeights(), nelems*sizeof(float))==0;
+}
+
+//------------------------------------------------------------------------------
+// Overwrites the word at 'offset' in a file (to corrupt serialized tables)
+static bool
+overwriteFileWord(char const * filename, long offset, int value) {
+
+    FILE * fp = fopen(filename, "r+b");
+    if (not fp) {
+        return false;
+    }
+    bool success = fseek(fp, offset, SEEK_SET)==0 and
+                   fwrite(&value, sizeof(int), 1, fp)==1;
+    return (fclose(fp)==0) and success;
+}
+
+//------------------------------------------------------------------------------
+template <class INDEX, class WEIGHT> static void
+benchCompactStencils(char const * name, Far::StencilTables const & stencils,
+    std::vector<Vertex> const & reference) {
+
+    Stopwatch s;
+
+    Far::CompactStencilTables<INDEX, WEIGHT> const * tables =
+        Far::StencilTablesFactory::CreateCompact<INDEX, WEIGHT>(stencils);
+
+    if (not tables) {
+        printf("    StencilTables %-9s     (too many control vertices)\n", name);
+        return;
+    }
+
+    int ncoarse = stencils.GetNumControlVertices(),
+        nstencils = tables->GetNumStencils();
+
+    std::vector<Vertex> data(ncoarse+nstencils);
+    std::copy(reference.begin(), reference.begin()+ncoarse, data.begin());
+
+    double elapsed = 0.0;
+    for (int j=0; j<g_repeats; ++j) {
+        s.Start();
+        tables->UpdateValues(&data[0], &data[ncoarse]);
+        s.Stop();
+        elapsed += s.GetElapsed();
+    }
+
+    float error = 0.0f;
+    for (int i=ncoarse; i<(int)data.size(); ++i) {
+        for (int k=0; k<3; ++k) {
+            error = std::max(error,
+                std::abs(data[i].GetPos()[k]-reference[i].GetPos()[k]));
+        }
+    }
+
+    size_t nelems = tables->GetControlIndices().size(),
+           size = nstencils*(sizeof(unsigned char)+sizeof(int)) +
+                  nelems*(sizeof(INDEX)+sizeof(WEIGHT));
+
+    printf("    StencilTables %-9s     %10.3f ms %8.1f KB  error %g\n",
+        name, 1000.0*elapsed/g_repeats, size/1024.0, error);
+
+    delete tables;
+}
+
+//------------------------------------------------------------------------------
+static bool
+comparePatchArrays(Far::PatchTables::PatchArrayVector const & a,
+                   Far::PatchTables::PatchArrayVector const & b) {
+
+    if (a.size()!=b.size()) {
+        return false;
+    }
+    for (int i=0; i<(int)a.size(); ++i) {
+        if (not (a[i].GetDescriptor()==b[i].GetDescriptor()) or
+            a[i].GetVertIndex()!=b[i].GetVertIndex() or
+            a[i].GetPatchIndex()!=b[i].GetPatchIndex() or
+            a[i].GetNumPatches()!=b[i].GetNumPatches() or
+            a[i].GetQuadOffsetIndex()!=b[i].GetQuadOffsetIndex()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T, class TABLE> static bool
+compareTable(std::vector<T> const & a, TABLE const & b) {
+
+    return (int)a.size()==(int)b.size() and
+           (a.empty() or memcmp(&a[0], &b[0], a.size()*sizeof(T))==0);
+}
+
+template <class TABLES> static bool
+comparePatchTables(Far::PatchTables const & a, TABLES const & b) {
+
+    return comparePatchArrays(a.GetPatchArrayVector(), b.GetPatchArrayVector()) and
+           compareTable(a.GetPatchTable(), b.GetPatchTable()) and
+           compareTable(a.GetPatchParamTable(), b.GetPatchParamTable()) and
+           compareTable(a.GetVertexValenceTable(), b.GetVertexValenceTable()) and
+           compareTable(a.GetQuadOffsetTable(), b.GetQuadOffsetTable()) and
+           a.GetMaxValence()==b.GetMaxValence() and
+           a.GetNumPtexFaces()==b.GetNumPtexFaces() and
+           a.IsFeatureAdaptive()==b.IsFeatureAdaptive();
+}
+
+//------------------------------------------------------------------------------
+// Counts the cache lines missed by the control vertex gathers of the stencils
+// in a simulated LRU cache (64 bytes lines, 8 ways)
+static int
+countGatherMisses(Far::StencilTables const & stencils, int cacheSize) {
+
+    int const lineSize = 64,
+              numWays = 8,
+              numSets = cacheSize / (lineSize*numWays);
+
+    // lines of each set, most recently used first
+    std::vector<long> lines(numSets*numWays, -1);
+
+    std::vector<int> const & indices = stencils.GetControlIndices();
+
+    int misses = 0;
+    for (int i=0; i<(int)indices.size(); ++i) {
+
+        long first = (long)indices[i]*sizeof(Vertex) / lineSize,
+             last = ((long)(indices[i]+1)*sizeof(Vertex) - 1) / lineSize;
+
+        for (long line=first; line<=last; ++line) {
+
+            long * set = &lines[(line % numSets)*numWays];
+
+            int way = 0;
+            while (way<numWays and set[way]!=line) {
+                ++way;
+            }
+            if (way==numWays) {
+                ++misses;
+                --way;
+            }
+            for (; way>0; --way) {
+                set[way] = set[way-1];
+            }
+            set[0] = line;
+        }
+    }
+    return misses;
+}
+
+//------------------------------------------------------------------------------
+static int
+benchReorderedStencils(Far::TopologyRefiner const & refiner,
+    Far::StencilTables const & stencils, std::vector<Vertex> const & reference) {
+
+    Stopwatch s;
+
+    std::vector<int> remap;
+
+    s.Start();
+    Far::StencilTables const * tables =
+        Far::StencilTablesFactory::Reorder(refiner, stencils, remap);
+    s.Stop();
+    printf("    StencilTables reorder       %10.3f ms\n", 1000.0*s.GetElapsed());
+
+    int ncoarse = stencils.GetNumControlVertices(),
+        ntotal = ncoarse + stencils.GetNumStencils();
+
+    // Control vertices at their new locations
+    std::vector<Vertex> data(ntotal);
+    for (int i=0; i<ncoarse; ++i) {
+        data[remap[i]] = reference[i];
+    }
+
+    double elapsed = 0.0;
+    for (int j=0; j<g_repeats; ++j) {
+        s.Start();
+        tables->UpdateValues(&data[0], &data[ncoarse]);
+        s.Stop();
+        elapsed += s.GetElapsed();
+    }
+    printf("    StencilTables reordered     %10.3f ms\n", 1000.0*elapsed/g_repeats);
+
+    // Gathers in 4KB & 32KB caches
+    int cacheSizes[2] = { 4*1024, 32*1024 };
+    for (int i=0; i<2; ++i) {
+        printf("    Gather misses %2d KB    %9d -> %d\n", cacheSizes[i]/1024,
+            countGatherMisses(stencils, cacheSizes[i]),
+                countGatherMisses(*tables, cacheSizes[i]));
+    }
+
+    delete tables;
+
+    // Reordering must not change the interpolated values
+    for (int i=0; i<ntotal; ++i) {
+        if (memcmp(data[remap[i]].GetPos(), reference[i].GetPos(), 3*sizeof(float))) {
+            printf("    Reordered StencilTables do not match\n");
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// Factorized stencils of the highest level of an adaptive or sparse refinement
+// (the levels do not grow monotonically) : they must interpolate the same
+// values as the last level of the full tables, within round-off
+static int
+benchAdaptiveFactorizedStencils(Far::TopologyRefiner const & refiner,
+    Shape const & shape) {
+
+    Stopwatch s;
+
+    int maxlevel = refiner.GetMaxLevel(),
+        ncoarse = refiner.GetNumVertices(0),
+        nlast = refiner.GetNumVertices(maxlevel);
+
+    Far::StencilTables const * stencils =
+        Far::StencilTablesFactory::Create(refiner);
+
+    Far::StencilTablesFactory::Options options;
+    options.generateAllLevels = false;
+    options.factorizeLevels = true;
+
+    s.Start();
+    Far::StencilTables const * factorized =
+        Far::StencilTablesFactory::Create(refiner, options);
+    s.Stop();
+    printf("    StencilTables adaptive fact. %9.3f ms\n", 1000.0*s.GetElapsed());
+
+    int failures = 0;
+
+    if (factorized->GetNumStencils()!=nlast) {
+        printf("    Adaptive factorized StencilTables have %d stencils (expected %d)\n",
+            factorized->GetNumStencils(), nlast);
+        ++failures;
+    } else if (nlast>0) {
+
+        std::vector<Vertex> data(ncoarse+stencils->GetNumStencils()),
+                            last(ncoarse+nlast);
+        for (int i=0; i<ncoarse; ++i) {
+            data[i].SetPosition(shape.verts[i*3+0],
+                                shape.verts[i*3+1],
+                                shape.verts[i*3+2]);
+            last[i] = data[i];
+        }
+        stencils->UpdateValues(&data[0], &data[ncoarse]);
+        factorized->UpdateValues(&last[0], &last[ncoarse]);
+
+        Vertex const * reference = &data[data.size()-nlast];
+
+        float error = 0.0f;
+        for (int i=0; i<nlast; ++i) {
+            for (int k=0; k<3; ++k) {
+                error = std::max(error, std::abs(reference[i].GetPos()[k] -
+                                                 last[ncoarse+i].GetPos()[k]));
+            }
+        }
+        if (error>1e-4f) {
+            printf("    Adaptive factorized StencilTables do not match (error %g)\n",
+                error);
+            ++failures;
+        }
+    }
+
+    delete factorized;
+    delete stencils;
+
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+static int
+benchPatchTables(Shape const & shape) {
+
+    Stopwatch s;
+
+    int failures = 0;
+
+    Far::TopologyRefiner * refiner =
+        Far::TopologyRefinerFactory<Shape>::Create(GetSdcType(shape),
+                                                   GetSdcOptions(shape),
+                                                   shape);
+    assert(refiner);
+
+    refiner->RefineAdaptive(g_level, true /*full topology*/);
+
+    failures += benchAdaptiveFactorizedStencils(*refiner, shape);
+
+    s.Start();
+    Far::PatchTables const * patchTables =
+        Far::PatchTablesFactory::Create(*refiner);
+    s.Stop();
+    printf("    PatchTables create          %10.3f ms\n", 1000.0*s.GetElapsed());
+
+    char const * filename = "far_perf.patches";
+
+    s.Start();
+    bool written = Far::PatchTablesSerializer::Write(*patchTables, filename);
+    s.Stop();
+    printf("    PatchTables write           %10.3f ms\n", 1000.0*s.GetElapsed());
+
+    if (written) {
+        s.Start();
+        Far::PatchTables const * tables =
+            Far::PatchTablesSerializer::Read(filename);
+        s.Stop();
+        printf("    PatchTables read            %10.3f ms\n", 1000.0*s.GetElapsed());
+
+        if (not tables or not comparePatchTables(*patchTables, *tables)) {
+            printf("    PatchTables read does not match written tables\n");
+            ++failures;
+        }
+        delete tables;
+
+        s.Start();
+        Far::MappedPatchTables const * mapped =
+            Far::MappedPatchTables::Open(filename);
+        s.Stop();
+        printf("    PatchTables map             %10.3f ms\n", 1000.0*s.GetElapsed());
+
+        if (not mapped or not comparePatchTables(*patchTables, *mapped) or
+            mapped->GetNumPatches()!=patchTables->GetNumPatches() or
+            mapped->GetNumControlVertices()!=patchTables->GetNumControlVertices()) {
+            printf("    PatchTables map does not match written tables\n");
+            ++failures;
+        }
+        delete mapped;
+
+        // a patch array referencing patches beyond the tables, then a header
+        // declaring more patch vertices than the file holds, must be rejected
+        // by both paths (the first patch array record follows the 64 bytes
+        // header, the number of patch vertices is the 6th word of the header)
+        long offsets[2] = { 64 + 12, 20 };
+        for (int i=0; i<2; ++i) {
+            if (patchTables->GetPatchArrayVector().empty() or
+                not Far::PatchTablesSerializer::Write(*patchTables, filename) or
+                not overwriteFileWord(filename, offsets[i], 0x0fffffff)) {
+                continue;
+            }
+            Far::PatchTables const * corrupt =
+                Far::PatchTablesSerializer::Read(filename);
+            Far::MappedPatchTables const * corruptMapped =
+                Far::MappedPatchTables::Open(filename);
+            if (corrupt or corruptMapped) {
+                printf("    PatchTables corrupt file was not rejected\n");
+                ++failures;
+            }
+            delete corrupt;
+            delete corruptMapped;
+        }
+
+        remove(filename);
+    } else {
+        printf("    PatchTables could not be written to %s\n", filename);
+        ++failures;
+    }
+
+    delete patchTables;
+    delete refiner;
+
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+static int
+benchPatchMap(Shape & shape) {
+
+    Stopwatch s;
+
+    int failures = 0;
+
+    // the face-varying data is not needed to locate patches : it is removed
+    // so that the deeper levels do not refine it
+    std::vector<int> faceuvs;
+    faceuvs.swap(shape.faceuvs);
+
+    Far::TopologyRefiner * refiner =
+        Far::TopologyRefinerFactory<Shape>::Create(GetSdcType(shape),
+                                                   GetSdcOptions(shape),
+                                                   shape);
+    assert(refiner);
+
+    // random locations, sorted by ptex face
+    int nptex = refiner->GetNumPtexFaces(),
+        nlocations = nptex * g_patchMapLocations;
+
+    std::vector<int> faces(nlocations);
+    std::vector<float> u(nlocations), v(nlocations);
+
+    srand(1);
+    for (int i=0; i<nlocations; ++i) {
+        faces[i] = i / g_patchMapLocations;
+        u[i] = (float)rand() / (float)RAND_MAX;
+        v[i] = (float)rand() / (float)RAND_MAX;
+    }
+
+    std::vector<Far::PatchMap::Handle const *> handles(nlocations),
+                                               batched(nlocations);
+
+    printf("    PatchMap %d locations       create     FindPatch   FindPatches\n",
+        nlocations);
+
+    for (int level=1; level<=g_maxPatchMapLevel; ++level) {
+
+        refiner->Unrefine();
+        refiner->RefineAdaptive(level, true /*full topology*/);
+
+        Far::PatchTables const * patchTables =
+            Far::PatchTablesFactory::Create(*refiner);
+
+        s.Start();
+        Far::PatchMap const * patchMap = new Far::PatchMap(*patchTables);
+        s.Stop();
+        double create = s.GetElapsed();
+
+        double single = 0.0;
+        for (int j=0; j<g_repeats; ++j) {
+            s.Start();
+            for (int i=0; i<nlocations; ++i) {
+                handles[i] = patchMap->FindPatch(faces[i], u[i], v[i]);
+            }
+            s.Stop();
+            single += s.GetElapsed();
+        }
+
+        double batch = 0.0;
+        for (int j=0; j<g_repeats; ++j) {
+            s.Start();
+            patchMap->FindPatches(&faces[0], &u[0], &v[0], nlocations, &batched[0]);
+            s.Stop();
+            batch += s.GetElapsed();
+        }
+
+        if (handles!=batched) {
+            printf("    PatchMap FindPatches does not match FindPatch (level %d)\n",
+                level);
+            ++failures;
+        }
+
+        printf("      level %-2d %8d patches%10.3f ms %10.3f ms %10.3f ms\n",
+            level, patchTables->GetNumPatches(), 1000.0*create,
+                1000.0*single/g_repeats, 1000.0*batch/g_repeats);
+
+        delete patchMap;
+        delete patchTables;
+    }
+
+    delete refiner;
+
+    faceuvs.swap(shape.faceuvs);
+
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+// Moves a region of interest (refined to the full level, with the rest of
+// the faces one level coarser per face-index distance) across the faces of
+// the shape, by a quarter of its width per step : the sparse refinement, the
+// stencils and the patches are updated incrementally and compared to those
+// created from scratch
+static int
+benchSparseRefinement(Shape const & shape) {
+
+    Stopwatch s;
+
+    int failures = 0;
+
+    Far::TopologyRefiner * refiner =
+        Far::TopologyRefinerFactory<Shape>::Create(GetSdcType(shape),
+                                                   GetSdcOptions(shape),
+                                                   shape);
+    assert(refiner);
+
+    int nfaces = refiner->GetNumFaces(0),
+        width = std::max(1, nfaces/10),
+        nsteps = 10;
+
+    std::vector<int> faceLevels(nfaces);
+
+    Far::StencilTablesFactory::Options options;
+    options.generateOffsets = true;
+
+    Far::StencilTables const * stencils = 0;
+    Far::PatchTables * patchTables = 0;
+
+    double update = 0.0,
+           create = 0.0,
+           updatePatches = 0.0,
+           createPatches = 0.0;
+    int kept = 0;
+    long carriedVerts = 0, numVerts = 0,
+         carriedPatches = 0, numPatches = 0;
+
+    for (int step=0; step<=nsteps; ++step) {
+
+        int center = nfaces/3 + step*std::max(1, width/4);
+        for (int i=0; i<nfaces; ++i) {
+            faceLevels[i] = std::max(1, g_level - std::abs(i-center)/width);
+        }
+
+        std::vector<Far::Index> vertexOrigins,
+                                patchOrigins;
+
+        s.Start();
+        if (step==0) {
+            refiner->RefineSparse(g_level, &faceLevels[0]);
+            stencils = Far::StencilTablesFactory::Create(*refiner, options);
+        } else {
+            kept += refiner->UpdateSparse(&faceLevels[0], vertexOrigins);
+
+            Far::StencilTables const * tables =
+                Far::StencilTablesFactory::Update(*refiner, *stencils,
+                    vertexOrigins, options);
+            delete stencils;
+            stencils = tables;
+        }
+        s.Stop();
+        if (step) {
+            update += s.GetElapsed();
+        }
+
+        s.Start();
+        if (step==0) {
+            patchTables = Far::PatchTablesFactory::Create(*refiner);
+        } else {
+            Far::PatchTables * tables =
+                Far::PatchTablesFactory::Update(*refiner, *patchTables,
+                    vertexOrigins, patchOrigins);
+            delete patchTables;
+            patchTables = tables;
+        }
+        s.Stop();
+        if (step) {
+            updatePatches += s.GetElapsed();
+        }
+
+        for (int i=0; i<(int)vertexOrigins.size(); ++i) {
+            carriedVerts += vertexOrigins[i]>=0;
+        }
+        numVerts += (int)vertexOrigins.size();
+
+        for (int i=0; i<(int)patchOrigins.size(); ++i) {
+            carriedPatches += patchOrigins[i]>=0;
+        }
+        numPatches += (int)patchOrigins.size();
+
+        s.Start();
+        Far::TopologyRefiner * reference =
+            Far::TopologyRefinerFactory<Shape>::Create(GetSdcType(shape),
+                                                       GetSdcOptions(shape),
+                                                       shape);
+        reference->RefineSparse(g_level, &faceLevels[0]);
+
+        Far::StencilTables const * tables =
+            Far::StencilTablesFactory::Create(*reference, options);
+        s.Stop();
+        if (step) {
+            create += s.GetElapsed();
+        }
+
+        s.Start();
+        Far::PatchTables const * referencePatches =
+            Far::PatchTablesFactory::Create(*reference);
+        s.Stop();
+        if (step) {
+            createPatches += s.GetElapsed();
+        }
+
+        if (not compareStencilTables(*stencils, *tables)) {
+            printf("    Sparse update does not match created tables (step %d)\n",
+                step);
+            ++failures;
+        }
+        if (not comparePatchTables(*patchTables, *referencePatches)) {
+            printf("    Sparse update does not match created patches (step %d)\n",
+                step);
+            ++failures;
+        }
+        delete referencePatches;
+        delete tables;
+        delete reference;
+    }
+
+    printf("    Sparse update               %10.3f ms (%.1f levels kept, %.1f%% vertices carried)\n",
+        1000.0*update/nsteps, (float)kept/nsteps,
+            100.0*carriedVerts/std::max(1L, numVerts));
+    printf("    Sparse create               %10.3f ms\n", 1000.0*create/nsteps);
+    printf("    Sparse update patches       %10.3f ms (%.1f%% patches carried)\n",
+        1000.0*updatePatches/nsteps, 100.0*carriedPatches/std::max(1L, numPatches));
+    printf("    Sparse create patches       %10.3f ms\n", 1000.0*createPatches/nsteps);
+
+    // scattered targets : feature isolation makes the deeper levels smaller
+    // than the intermediate ones
+    for (int i=0; i<nfaces; ++i) {
+        faceLevels[i] = (i%3)==0 ? g_level/2 : 0;
+    }
+    refiner->RefineSparse(g_level, &faceLevels[0]);
+
+    failures += benchAdaptiveFactorizedStencils(*refiner, shape);
+
+    delete patchTables;
+    delete stencils;
+    delete refiner;
+
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+static int
+benchShape(ShapeDesc const & desc) {
+
+    Shape * shape = Shape::parseObj(desc.data.c_str(), desc.scheme);
+
+    Far::TopologyRefiner * refiner =
+        Far::TopologyRefinerFactory<Shape>::Create(GetSdcType(*shape),
+                                                   GetSdcOptions(*shape),
+                                                   *shape);
+    assert(refiner);
+
+    refiner->RefineUniform(g_level, true /*full topology*/);
+
+    int ncoarse = refiner->GetNumVertices(0),
+        ntotal = refiner->GetNumVerticesTotal();
+
+    std::vector<Vertex> coarse(ncoarse);
+    for (int i=0; i<ncoarse; ++i) {
+        coarse[i].SetPosition(shape->verts[i*3+0],
+                              shape->verts[i*3+1],
+                              shape->verts[i*3+2]);
+    }
+
+    printf("%-24s %8d verts\n", desc.name.c_str(), ntotal-ncoarse);
+
+    Stopwatch s;
+
+    // Interpolate (serial result kept as the reference)
+    std::vector<Vertex> reference;
+
+    int failures = 0;
+
+    Far::ThreadingType threadings[] = { Far::THREADING_SERIAL,
+                                        Far::THREADING_TBB,
+                                        Far::THREADING_OMP };
+
+    for (int i=0; i<(int)(sizeof(threadings)/sizeof(threadings[0])); ++i) {
+
+        Far::ThreadingType threading = threadings[i];
+
+        if (not Vtr::isThreadingSupported((Vtr::ThreadingType)threading)) {
+            continue;
+        }
+
+        std::vector<Vertex> data(ntotal);
+        std::copy(coarse.begin(), coarse.end(), data.begin());
+
+        double elapsed = 0.0;
+        for (int j=0; j<g_repeats; ++j) {
+            Vertex * verts = &data[0];
+            s.Start();
+            refiner->Interpolate(verts, verts+ncoarse, threading);
+            s.Stop();
+            elapsed += s.GetElapsed();
+        }
+
+        if (threading==Far::THREADING_SERIAL) {
+            reference = data;
+        } else if (not compareVertexData(reference, data)) {
+            printf("    Interpolate (%s) does not match serial results\n",
+                getThreadingName(threading));
+            ++failures;
+        }
+
+        printf("    Interpolate %-8s        %10.3f ms\n",
+            getThreadingName(threading), 1000.0*elapsed/g_repeats);
+    }
+
+    // Stencils (the serial tables are kept for evaluation)
+    Far::StencilTables const * stencils = 0;
+
+    for (int i=0; i<(int)(sizeof(threadings)/sizeof(threadings[0])); ++i) {
+
+        Far::ThreadingType threading = threadings[i];
+
+        if (not Vtr::isThreadingSupported((Vtr::ThreadingType)threading)) {
+            continue;
+        }
+
+        Far::StencilTablesFactory::Options options;
+        options.generateOffsets = true;
+        options.threading = threading;
+
+        s.Start();
+        Far::StencilTables const * tables =
+            Far::StencilTablesFactory::Create(*refiner, options);
+        s.Stop();
+
+        assert(tables->GetNumStencils()==ntotal-ncoarse);
+
+        if (threading==Far::THREADING_SERIAL) {
+            stencils = tables;
+        } else {
+            if (not compareStencilTables(*stencils, *tables)) {
+                printf("    StencilTables (%s) do not match serial tables\n",
+                    getThreadingName(threading));
+                ++failures;
+            }
+            delete tables;
+        }
+
+        printf("    StencilTables create %-7s%10.3f ms\n",
+            getThreadingName(threading), 1000.0*s.GetElapsed());
+    }
+
+    {   // Factorized stencils of the highest level only
+        Far::StencilTablesFactory::Options options;
+        options.generateAllLevels = false;
+        options.factorizeLevels = true;
+
+        s.Start();
+        Far::StencilTables const * tables =
+            Far::StencilTablesFactory::Create(*refiner, options);
+        s.Stop();
+
+        assert(tables->GetNumStencils()==refiner->GetNumVertices(g_level));
+        delete tables;
+
+        printf("    StencilTables factorized    %10.3f ms\n", 1000.0*s.GetElapsed());
+    }
+
+    {   // Serialized stencils
+        char const * filename = "far_perf.stencils";
+
+        s.Start();
+        bool written = Far::StencilTablesSerializer::Write(*stencils, filename);
+        s.Stop();
+        printf("    StencilTables write         %10.3f ms\n", 1000.0*s.GetElapsed());
+
+        if (written) {
+            s.Start();
+            Far::StencilTables const * tables =
+                Far::StencilTablesSerializer::Read(filename);
+            s.Stop();
+            printf("    StencilTables read          %10.3f ms\n", 1000.0*s.GetElapsed());
+
+            if (not tables or not compareStencilTables(*stencils, *tables)) {
+                printf("    StencilTables read does not match written tables\n");
+                ++failures;
+            }
+            delete tables;
+
+            s.Start();
+            Far::MappedStencilTables const * mapped =
+                Far::MappedStencilTables::Open(filename);
+            s.Stop();
+            printf("    StencilTables map           %10.3f ms\n", 1000.0*s.GetElapsed());
+
+            if (not mapped or not compareMappedStencilTables(*stencils, *mapped)) {
+                printf("    StencilTables map does not match written tables\n");
+                ++failures;
+            }
+
+            if (mapped) {
+                Far::StencilTables const * copied = mapped->CreateStencilTables();
+                if (not compareStencilTables(*stencils, *copied)) {
+                    printf("    StencilTables copied from the map do not match written tables\n");
+                    ++failures;
+                }
+                delete copied;
+            }
+            delete mapped;
+
+            // an out of range stencil offset must be rejected by both paths
+            // (the offsets follow the 32 bytes header and the sizes, on 16
+            // bytes boundaries)
+            long offsetsOffset = (32 + stencils->GetNumStencils() + 15) & ~15L;
+            if (stencils->GetNumStencils()>0 and
+                overwriteFileWord(filename, offsetsOffset, 0x7fffffff)) {
+                Far::StencilTables const * corrupt =
+                    Far::StencilTablesSerializer::Read(filename);
+                Far::MappedStencilTables const * corruptMapped =
+                    Far::MappedStencilTables::Open(filename);
+                if (corrupt or corruptMapped) {
+                    printf("    StencilTables corrupt file was not rejected\n");
+                    ++failures;
+                }
+                delete corrupt;
+                delete corruptMapped;
+            }
+
+            remove(filename);
+        } else {
+            printf("    StencilTables could not be written to %s\n", filename);
+            ++failures;
+        }
+    }
+
+    std::vector<Vertex> data(ntotal);
+    std::copy(coarse.begin(), coarse.end(), data.begin());
+
+    double elapsed = 0.0;
+    for (int j=0; j<g_repeats; ++j) {
+        s.Start();
+        stencils->UpdateValues(&data[0], &data[ncoarse]);
+        s.Stop();
+        elapsed += s.GetElapsed();
+    }
+    printf("    StencilTables update        %10.3f ms\n", 1000.0*elapsed/g_repeats);
+
+    benchCompactStencils<int, Far::Half>("i32/f16", *stencils, data);
+    benchCompactStencils<unsigned short, float>("i16/f32", *stencils, data);
+    benchCompactStencils<unsigned short, Far::Half>("i16/f16", *stencils, data);
+
+    failures += benchReorderedStencils(*refiner, *stencils, data);
+
+    failures += benchPatchTables(*shape);
+
+    failures += benchPatchMap(*shape);
+
+    failures += benchSparseRefinement(*shape);
+
+    delete stencils;
+    delete refiner;
+    delete shape;
+
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+template <class ARRAY> static bool
+compareArrays(ARRAY const & a, ARRAY const & b) {
+
+    if (a.size()!=b.size()) {
+        return false;
+    }
+    for (int i=0; i<(int)a.size(); ++i) {
+        if (a[i]!=b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+compareBaseLevels(Far::TopologyRefiner const & a, Far::TopologyRefiner const & b) {
+
+    if (a.GetNumVertices(0)!=b.GetNumVertices(0) or
+        a.GetNumEdges(0)!=b.GetNumEdges(0) or
+        a.GetNumFaces(0)!=b.GetNumFaces(0)) {
+        return false;
+    }
+    for (int i=0; i<a.GetNumFaces(0); ++i) {
+        if (not compareArrays(a.GetFaceVertices(0, i), b.GetFaceVertices(0, i)) or
+            not compareArrays(a.GetFaceEdges(0, i), b.GetFaceEdges(0, i))) {
+            return false;
+        }
+    }
+    for (int i=0; i<a.GetNumEdges(0); ++i) {
+        if (not compareArrays(a.GetEdgeVertices(0, i), b.GetEdgeVertices(0, i)) or
+            not compareArrays(a.GetEdgeFaces(0, i), b.GetEdgeFaces(0, i))) {
+            return false;
+        }
+    }
+    for (int i=0; i<a.GetNumVertices(0); ++i) {
+        if (not compareArrays(a.GetVertexFaces(0, i), b.GetVertexFaces(0, i)) or
+            not compareArrays(a.GetVertexEdges(0, i), b.GetVertexEdges(0, i)) or
+            not compareArrays(a.VertexFaceLocalIndices(0, i), b.VertexFaceLocalIndices(0, i)) or
+            not compareArrays(a.VertexEdgeLocalIndices(0, i), b.VertexEdgeLocalIndices(0, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Creates the base level of a refiner from the face-vertices of a mesh alone,
+// serially and with each threading back-end
+static int
+benchTopology(char const * name, Sdc::Type type, int nverts,
+    std::vector<int> const & vertsPerFace, std::vector<int> const & vertIndices) {
+
+    typedef Far::TopologyRefinerFactoryBase::TopologyDescriptor Descriptor;
+
+    Descriptor desc;
+    desc.numVertices = nverts;
+    desc.numFaces = (int)vertsPerFace.size();
+    desc.vertsPerFace = &vertsPerFace[0];
+    desc.vertIndices = &vertIndices[0];
+
+    printf("%-24s %8d faces\n", name, desc.numFaces);
+
+    Stopwatch s;
+
+    int failures = 0;
+
+    Far::TopologyRefiner * reference = 0;
+
+    Far::ThreadingType threadings[] = { Far::THREADING_SERIAL,
+                                        Far::THREADING_TBB,
+                                        Far::THREADING_OMP };
+
+    for (int i=0; i<(int)(sizeof(threadings)/sizeof(threadings[0])); ++i) {
+
+        Far::ThreadingType threading = threadings[i];
+
+        if (not Vtr::isThreadingSupported((Vtr::ThreadingType)threading)) {
+            continue;
+        }
+
+        Far::TopologyRefiner * refiner = 0;
+
+        double elapsed = 0.0;
+        for (int j=0; j<g_repeats; ++j) {
+            delete refiner;
+            s.Start();
+            refiner = Far::TopologyRefinerFactory<Descriptor>::Create(type,
+                Sdc::Options(), desc, threading);
+            s.Stop();
+            elapsed += s.GetElapsed();
+        }
+        assert(refiner);
+
+        if (threading==Far::THREADING_SERIAL) {
+            reference = refiner;
+        } else {
+            if (not compareBaseLevels(*reference, *refiner)) {
+                printf("    Topology (%s) does not match serial topology\n",
+                    getThreadingName(threading));
+                ++failures;
+            }
+            delete refiner;
+        }
+
+        elapsed /= g_repeats;
+        printf("    Topology create %-8s    %10.3f ms %8.2f Mfaces/s\n",
+            getThreadingName(threading), 1000.0*elapsed,
+                desc.numFaces / (1000000.0*elapsed));
+    }
+
+    delete reference;
+
+    return failures;
+}
+
+static int
+benchTopologies() {
+
+    int failures = 0;
+
+    for (int i=0; i<(int)g_shapes.size(); ++i) {
+
+        ShapeDesc const & desc = g_shapes[i];
+
+        Shape * shape = Shape::parseObj(desc.data.c_str(), desc.scheme);
+
+        failures += benchTopology(desc.name.c_str(), GetSdcType(*shape),
+            shape->GetNumVertices(), shape->nvertsPerFace, shape->faceverts);
+
+        delete shape;
+    }
+
+    std::vector<int> vertsPerFace,
+                     vertIndices;
+
+    {   // Regular grid of quads
+        int n = g_gridSize;
+
+        vertsPerFace.assign(n*n, 4);
+        vertIndices.resize(4*n*n);
+
+        for (int y=0, k=0; y<n; ++y) {
+            for (int x=0; x<n; ++x) {
+                int v = y*(n+1) + x;
+                vertIndices[k++] = v;
+                vertIndices[k++] = v+1;
+                vertIndices[k++] = v+n+2;
+                vertIndices[k++] = v+n+1;
+            }
+        }
+        failures += benchTopology("grid", Sdc::TYPE_CATMARK, (n+1)*(n+1),
+            vertsPerFace, vertIndices);
+    }
+
+    {   // Closed fan of triangles around two poles (vertices 0 and 1) sharing
+        // a ring of n vertices
+        int n = g_fanValence;
+
+        vertsPerFace.assign(2*n, 3);
+        vertIndices.resize(6*n);
+
+        for (int i=0, k=0; i<n; ++i) {
+            int v0 = 2 + i,
+                v1 = 2 + (i+1)%n;
+            vertIndices[k++] = 0;
+            vertIndices[k++] = v0;
+            vertIndices[k++] = v1;
+
+            vertIndices[k++] = 1;
+            vertIndices[k++] = v1;
+            vertIndices[k++] = v0;
+        }
+        failures += benchTopology("fan", Sdc::TYPE_CATMARK, n+2,
+            vertsPerFace, vertIndices);
+    }
+    return failures;
+}
+
+//------------------------------------------------------------------------------
+static void
+usage(char const * appname) {
+    printf("Usage : %s [-l <isolation level>] [-r <repeats>]\n", appname);
+}
+
+//------------------------------------------------------------------------------
+int
+main(int argc, char ** argv) {
+
+    for (int i=1; i<argc; ++i) {
+        if ((not strcmp(argv[i],"-l")) and (i+1<argc)) {
+            g_level = atoi(argv[++i]);
+        } else if ((not strcmp(argv[i],"-r")) and (i+1<argc)) {
+            g_repeats = atoi(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (g_level<1 or g_repeats<1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    initShapes();
+
+    printf("Uniform refinement to level %d, %d repeats (average times)\n",
+        g_level, g_repeats);
+
+    int failures = 0;
+    for (int i=0; i<(int)g_shapes.size(); ++i) {
+        failures += benchShape(g_shapes[i]);
+    }
+
+    printf("Base level topology from face-vertices, %d repeats (average times)\n",
+        g_repeats);
+
+    failures += benchTopologies();
+
+    if (failures) {
+        printf("Total failures : %d\n", failures);
+    }
+    return failures ? 1 : 0;
+}
+
+//------------------------------------------------------------------------------